@@ -0,0 +1,243 @@
+/**
+ * BioSentinel Frame Aligner
+ * Merges the PPG, IMU and skin temperature streams into time-aligned frames
+ *
+ * Each sensor runs on its own oscillator at its own rate, and every sample
+ * arrives stamped on the ESP32 micros() timebase (ppg_acquisition.h,
+ * imu_acquisition.h). Frames follow the PPG stream, one per PPG sample:
+ *   IMU          linearly interpolated to the PPG timestamp between the two
+ *                IMU samples that bracket it, so a 99.3 Hz IMU lines up
+ *                with a 100.5 Hz PPG without drift or repeated samples
+ *   temperature  the latest reading taken at or before the PPG timestamp
+ *                (1 Hz, changes far slower than that)
+ * Sensors drain in bursts, so a PPG sample waits until the IMU has
+ * delivered a sample past it. If that takes more than ALIGN_MAX_WAIT_US
+ * (IMU stalled or absent), or the bracketing IMU samples straddle a FIFO
+ * overflow, the frame goes out with motionValid false rather than a guess.
+ *
+ * Pure C++ (no Arduino dependencies) so it can be exercised on the host.
+ */
+
+#ifndef FRAME_ALIGNER_H
+#define FRAME_ALIGNER_H
+
+#include <math.h>
+#include <stdint.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef ALIGN_IMU_HISTORY
+  #define ALIGN_IMU_HISTORY 64          // IMU samples kept for interpolation (power of two)
+#endif
+
+#ifndef ALIGN_PPG_QUEUE
+  #define ALIGN_PPG_QUEUE 64            // PPG samples waiting for IMU coverage (power of two)
+#endif
+
+#ifndef ALIGN_MAX_WAIT_US
+  #define ALIGN_MAX_WAIT_US 400000UL    // Longest a frame waits for the IMU (two bursts)
+#endif
+
+static_assert((ALIGN_IMU_HISTORY & (ALIGN_IMU_HISTORY - 1)) == 0, "ALIGN_IMU_HISTORY must be a power of two");
+static_assert((ALIGN_PPG_QUEUE & (ALIGN_PPG_QUEUE - 1)) == 0, "ALIGN_PPG_QUEUE must be a power of two");
+
+struct SensorFrame {
+  uint32_t index;                       // PPG stream index
+  uint32_t timestampUs;                 // PPG sample time
+  uint32_t red;
+  uint32_t ir;
+  int16_t accel[3];                     // At timestampUs (IMU counts), valid if motionValid
+  int16_t gyro[3];
+  bool motionValid;
+  float skinTemperature;                // Celsius, NAN until the first reading
+};
+
+struct AlignerStats {
+  uint32_t frames;
+  uint32_t interpolated;                // Frames with motion data
+  uint32_t timedOut;                    // IMU did not catch up within ALIGN_MAX_WAIT_US
+  uint32_t imuGaps;                     // Bracketing IMU samples not consecutive
+  uint32_t tooOld;                      // PPG older than the IMU history
+};
+
+// =============================================================================
+// Frame Aligner
+// =============================================================================
+
+class FrameAligner {
+public:
+  FrameAligner() : _imuEnabled(false) { reset(); }
+
+  // @param imuEnabled False: frames go out as soon as they arrive, without motion data
+  void begin(bool imuEnabled) {
+    _imuEnabled = imuEnabled;
+    reset();
+  }
+  void reset();
+
+  void addImu(uint32_t index, uint32_t timestampUs, const int16_t accel[3], const int16_t gyro[3]);
+  void addPpg(uint32_t index, uint32_t timestampUs, uint32_t red, uint32_t ir);
+  void setTemperature(float celsius, uint32_t timestampUs);
+
+  bool ppgFull() const { return _ppgHead - _ppgTail >= ALIGN_PPG_QUEUE; }
+
+  /**
+   * Next complete frame, oldest first
+   * @param nowUs Current micros(), for the IMU wait limit
+   */
+  bool pop(SensorFrame& frame, uint32_t nowUs);
+
+  const AlignerStats& getStats() const { return _stats; }
+
+private:
+  struct Imu {
+    uint32_t index;
+    uint32_t timestampUs;
+    int16_t accel[3];
+    int16_t gyro[3];
+  };
+  struct Ppg {
+    uint32_t index;
+    uint32_t timestampUs;
+    uint32_t red;
+    uint32_t ir;
+  };
+
+  bool _imuEnabled;
+  Imu _imu[ALIGN_IMU_HISTORY];
+  uint32_t _imuHead;                    // Total IMU samples added
+  Ppg _ppg[ALIGN_PPG_QUEUE];
+  uint32_t _ppgHead;
+  uint32_t _ppgTail;
+
+  // Two newest readings: the newer may postdate queued PPG samples
+  float _temperature[2];
+  uint32_t _temperatureUs[2];
+  uint8_t _temperatures;
+
+  AlignerStats _stats;
+
+  // Timestamps wrap every ~71 min: compare by signed difference
+  static int32_t since(uint32_t a, uint32_t b) { return (int32_t)(a - b); }
+  static int16_t lerp(int16_t a, int16_t b, int32_t num, int32_t den) {
+    int32_t delta = (int32_t)(b - a) * num;
+    return (int16_t)(a + (delta >= 0 ? delta + den / 2 : delta - den / 2) / den);
+  }
+  bool interpolate(uint32_t timestampUs, SensorFrame& frame);
+  float temperatureAt(uint32_t timestampUs) const;
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+inline void FrameAligner::reset() {
+  _imuHead = 0;
+  _ppgHead = 0;
+  _ppgTail = 0;
+  _temperatures = 0;
+  _stats = AlignerStats();
+}
+
+inline void FrameAligner::addImu(uint32_t index, uint32_t timestampUs, const int16_t accel[3],
+                                 const int16_t gyro[3]) {
+  Imu& imu = _imu[_imuHead & (ALIGN_IMU_HISTORY - 1)];
+  imu.index = index;
+  imu.timestampUs = timestampUs;
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    imu.accel[axis] = accel[axis];
+    imu.gyro[axis] = gyro[axis];
+  }
+  _imuHead++;
+}
+
+inline void FrameAligner::addPpg(uint32_t index, uint32_t timestampUs, uint32_t red, uint32_t ir) {
+  if (ppgFull()) return;                // Caller checks ppgFull() first
+  _ppg[_ppgHead & (ALIGN_PPG_QUEUE - 1)] = {index, timestampUs, red, ir};
+  _ppgHead++;
+}
+
+inline void FrameAligner::setTemperature(float celsius, uint32_t timestampUs) {
+  if (_temperatures && _temperatureUs[1] == timestampUs) return;
+  _temperature[0] = _temperature[1];
+  _temperatureUs[0] = _temperatureUs[1];
+  _temperature[1] = celsius;
+  _temperatureUs[1] = timestampUs;
+  if (_temperatures < 2) _temperatures++;
+}
+
+inline float FrameAligner::temperatureAt(uint32_t timestampUs) const {
+  if (_temperatures >= 1 && since(timestampUs, _temperatureUs[1]) >= 0) return _temperature[1];
+  if (_temperatures == 2) return _temperature[0];
+  return _temperatures ? _temperature[1] : NAN; // Only a newer reading: better than none
+}
+
+inline bool FrameAligner::pop(SensorFrame& frame, uint32_t nowUs) {
+  if (_ppgHead == _ppgTail) return false;
+  const Ppg& ppg = _ppg[_ppgTail & (ALIGN_PPG_QUEUE - 1)];
+
+  frame.motionValid = false;
+  if (_imuEnabled) {
+    bool covered = _imuHead > 0 &&
+                   since(_imu[(_imuHead - 1) & (ALIGN_IMU_HISTORY - 1)].timestampUs, ppg.timestampUs) >= 0;
+    if (covered) {
+      frame.motionValid = interpolate(ppg.timestampUs, frame);
+    } else if (since(nowUs, ppg.timestampUs) < (int32_t)ALIGN_MAX_WAIT_US) {
+      return false;                     // IMU burst still to come
+    } else {
+      _stats.timedOut++;
+    }
+  }
+  if (!frame.motionValid) {
+    for (uint8_t axis = 0; axis < 3; axis++) frame.accel[axis] = frame.gyro[axis] = 0;
+  } else {
+    _stats.interpolated++;
+  }
+
+  frame.index = ppg.index;
+  frame.timestampUs = ppg.timestampUs;
+  frame.red = ppg.red;
+  frame.ir = ppg.ir;
+  frame.skinTemperature = temperatureAt(ppg.timestampUs);
+  _ppgTail++;
+  _stats.frames++;
+  return true;
+}
+
+inline bool FrameAligner::interpolate(uint32_t timestampUs, SensorFrame& frame) {
+  // Newest to oldest: the first sample at or before the PPG time, with its successor
+  uint32_t held = _imuHead < ALIGN_IMU_HISTORY ? _imuHead : ALIGN_IMU_HISTORY;
+  for (uint32_t age = 1; age < held; age++) {
+    const Imu& before = _imu[(_imuHead - 1 - age) & (ALIGN_IMU_HISTORY - 1)];
+    if (since(timestampUs, before.timestampUs) < 0) continue;
+    const Imu& after = _imu[(_imuHead - age) & (ALIGN_IMU_HISTORY - 1)];
+    if (after.index != before.index + 1) {
+      _stats.imuGaps++;
+      return false;
+    }
+    int32_t span = since(after.timestampUs, before.timestampUs);
+    int32_t offset = since(timestampUs, before.timestampUs);
+    if (span <= 0) span = 1;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      frame.accel[axis] = lerp(before.accel[axis], after.accel[axis], offset, span);
+      frame.gyro[axis] = lerp(before.gyro[axis], after.gyro[axis], offset, span);
+    }
+    return true;
+  }
+
+  // Exactly on the first IMU sample, or older than the history
+  const Imu& newest = _imu[(_imuHead - 1) & (ALIGN_IMU_HISTORY - 1)];
+  if (held == 1 && newest.timestampUs == timestampUs) {
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      frame.accel[axis] = newest.accel[axis];
+      frame.gyro[axis] = newest.gyro[axis];
+    }
+    return true;
+  }
+  _stats.tooOld++;
+  return false;
+}
+
+#endif
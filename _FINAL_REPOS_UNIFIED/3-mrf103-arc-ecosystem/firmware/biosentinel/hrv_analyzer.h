@@ -0,0 +1,255 @@
+/**
+ * BioSentinel HRV Analyzer
+ * Sliding-window heart rate variability from beat-to-beat (RR) intervals
+ *
+ * Keeps the last HRV_WINDOW accepted intervals in a ring together with
+ * running integer sums, so every beat is O(1) regardless of window length
+ * and the sums never drift:
+ *   SDNN  - standard deviation of the intervals      (sum, sum of squares)
+ *   RMSSD - RMS of successive interval differences   (sum of squared diffs)
+ *   pNN50 - % of successive differences over 50 ms  (count)
+ * An interval entering the window adds its terms, the one leaving takes its
+ * terms back out.
+ *
+ * Artifact rejection: an interval outside HRV_MIN_RR_MS..HRV_MAX_RR_MS,
+ * one flagged by the caller (poor signal quality), or one more than
+ * HRV_ARTIFACT_PCT away from the running reference interval is dropped.
+ * A dropped or missing beat breaks the chain, so the next difference is
+ * not taken across the gap. The first plausible interval after a reset
+ * only seeds the reference: a half beat at contact would otherwise be
+ * accepted unchecked and sit in the window, inflating SDNN, until it is
+ * evicted HRV_WINDOW beats later. HRV_REANCHOR consecutive rejections
+ * re-seed the reference, so a genuine step in heart rate is followed; the
+ * window and its sums are kept, since SDNN over a rate step is meant to
+ * include it.
+ *
+ * Pure C++ so tools/ppg_replay.cpp can replay traces through it.
+ */
+
+#ifndef HRV_ANALYZER_H
+#define HRV_ANALYZER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef HRV_WINDOW
+  #define HRV_WINDOW 256                // Intervals (~4 min at 64 bpm)
+#endif
+
+#ifndef HRV_MIN_BEATS
+  #define HRV_MIN_BEATS 30              // Intervals before metrics are reported
+#endif
+
+#ifndef HRV_MIN_RR_MS
+  #define HRV_MIN_RR_MS 300             // 200 bpm
+#endif
+
+#ifndef HRV_MAX_RR_MS
+  #define HRV_MAX_RR_MS 2000            // 30 bpm
+#endif
+
+#ifndef HRV_ARTIFACT_PCT
+  #define HRV_ARTIFACT_PCT 20           // Max deviation from the reference interval
+#endif
+
+#ifndef HRV_REANCHOR
+  #define HRV_REANCHOR 5                // Consecutive rejections before re-seeding
+#endif
+
+#define HRV_NN50_MS 50
+
+struct HrvMetrics {
+  float meanRr;                         // ms
+  float sdnn;                           // ms
+  float rmssd;                          // ms
+  float pnn50;                          // %
+  uint16_t intervals;                   // In the window
+};
+
+// =============================================================================
+// HRV Analyzer
+// =============================================================================
+
+class HrvAnalyzer {
+public:
+  HrvAnalyzer() { reset(); }
+
+  void reset();
+
+  /**
+   * Feed one beat
+   * @param rrMs     Interval since the previous beat, 0 after a gap
+   * @param reliable False if the signal was poor when the beat was detected
+   * @return true if the interval was accepted into the window
+   */
+  bool addBeat(uint16_t rrMs, bool reliable);
+
+  bool valid() const { return _count >= HRV_MIN_BEATS; }
+  HrvMetrics metrics() const;
+
+  uint32_t accepted() const { return _accepted; }
+  uint32_t rejected() const { return _rejected; }
+
+  /**
+   * Copy out intervals accepted since the last call (oldest first)
+   * @return Number copied; older ones are skipped if more than max arrived
+   */
+  uint8_t takeRecent(uint16_t* out, uint8_t max);
+
+private:
+  struct Entry {
+    uint16_t rr;
+    int16_t diff;                       // From the previous interval
+    bool hasDiff;                       // False across a gap / rejection
+  };
+
+  Entry _ring[HRV_WINDOW];
+  uint16_t _head;                       // Next write
+  uint16_t _count;
+
+  // Window sums (exact)
+  uint32_t _sum;
+  uint64_t _sumSq;
+  uint64_t _diffSq;
+  uint16_t _diffs;
+  uint16_t _nn50;
+
+  uint16_t _last;                       // Previous accepted interval, 0 = chain broken
+  uint32_t _reference;                  // Reference interval, Q4 ms
+  uint8_t _rejectRun;
+  uint32_t _accepted;
+  uint32_t _rejected;
+  uint32_t _taken;                      // _accepted at the last takeRecent()
+
+  bool artifact(uint16_t rrMs, bool reliable);
+  void push(const Entry& entry);
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+inline void HrvAnalyzer::reset() {
+  memset(_ring, 0, sizeof(_ring));
+  _head = 0;
+  _count = 0;
+  _sum = 0;
+  _sumSq = 0;
+  _diffSq = 0;
+  _diffs = 0;
+  _nn50 = 0;
+  _last = 0;
+  _reference = 0;
+  _rejectRun = 0;
+  _accepted = 0;
+  _rejected = 0;
+  _taken = 0;
+}
+
+inline bool HrvAnalyzer::artifact(uint16_t rrMs, bool reliable) {
+  if (!reliable || rrMs < HRV_MIN_RR_MS || rrMs > HRV_MAX_RR_MS) return true;
+
+  uint32_t rr = (uint32_t)rrMs << 4;
+  uint32_t deviation = rr > _reference ? rr - _reference : _reference - rr;
+  return deviation * 100 > _reference * HRV_ARTIFACT_PCT;
+}
+
+inline bool HrvAnalyzer::addBeat(uint16_t rrMs, bool reliable) {
+  if (rrMs == 0) {
+    _last = 0;                          // Gap in detection
+    return false;
+  }
+
+  if (_reference == 0 && reliable && rrMs >= HRV_MIN_RR_MS && rrMs <= HRV_MAX_RR_MS) {
+    // Nothing to check the first interval against: it only seeds the reference
+    _reference = (uint32_t)rrMs << 4;
+    return false;
+  }
+
+  if (artifact(rrMs, reliable)) {
+    _rejected++;
+    _last = 0;
+    // A run of "artifacts" inside the plausible range is a new rhythm
+    bool plausible = reliable && rrMs >= HRV_MIN_RR_MS && rrMs <= HRV_MAX_RR_MS;
+    if (plausible && ++_rejectRun >= HRV_REANCHOR) {
+      _reference = (uint32_t)rrMs << 4;
+      _rejectRun = 0;
+    }
+    return false;
+  }
+  _rejectRun = 0;
+
+  // Reference follows accepted intervals over ~8 beats
+  uint32_t rr = (uint32_t)rrMs << 4;
+  _reference += (int32_t)(rr - _reference) >> 3;
+
+  Entry entry = {rrMs, 0, _last != 0};
+  if (entry.hasDiff) entry.diff = (int16_t)((int32_t)rrMs - _last);
+  push(entry);
+
+  _last = rrMs;
+  _accepted++;
+  return true;
+}
+
+inline void HrvAnalyzer::push(const Entry& entry) {
+  if (_count == HRV_WINDOW) {
+    // Oldest leaves the window
+    const Entry& old = _ring[_head];
+    _sum -= old.rr;
+    _sumSq -= (uint32_t)old.rr * old.rr;
+    if (old.hasDiff) {
+      _diffSq -= (uint32_t)((int32_t)old.diff * old.diff);
+      _diffs--;
+      if (old.diff > HRV_NN50_MS || old.diff < -HRV_NN50_MS) _nn50--;
+    }
+  } else {
+    _count++;
+  }
+
+  _ring[_head] = entry;
+  _head = (_head + 1) % HRV_WINDOW;
+  _sum += entry.rr;
+  _sumSq += (uint32_t)entry.rr * entry.rr;
+  if (entry.hasDiff) {
+    _diffSq += (uint32_t)((int32_t)entry.diff * entry.diff);
+    _diffs++;
+    if (entry.diff > HRV_NN50_MS || entry.diff < -HRV_NN50_MS) _nn50++;
+  }
+}
+
+inline HrvMetrics HrvAnalyzer::metrics() const {
+  HrvMetrics m = {0, 0, 0, 0, _count};
+  if (_count == 0) return m;
+
+  double mean = (double)_sum / _count;
+  m.meanRr = (float)mean;
+  if (_count > 1) {
+    double var = ((double)_sumSq - mean * _sum) / (_count - 1);
+    m.sdnn = var > 0 ? (float)sqrt(var) : 0;
+  }
+  if (_diffs > 0) {
+    m.rmssd = (float)sqrt((double)_diffSq / _diffs);
+    m.pnn50 = 100.0f * _nn50 / _diffs;
+  }
+  return m;
+}
+
+inline uint8_t HrvAnalyzer::takeRecent(uint16_t* out, uint8_t max) {
+  uint32_t pending = _accepted - _taken;
+  if (pending > _count) pending = _count;
+  if (pending > max) pending = max;
+  _taken = _accepted;
+
+  // The newest `pending` entries end just before _head
+  uint16_t start = (_head + HRV_WINDOW - pending) % HRV_WINDOW;
+  for (uint32_t i = 0; i < pending; i++) out[i] = _ring[(start + i) % HRV_WINDOW].rr;
+  return (uint8_t)pending;
+}
+
+#endif
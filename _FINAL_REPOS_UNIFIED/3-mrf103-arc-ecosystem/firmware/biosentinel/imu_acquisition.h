@@ -0,0 +1,335 @@
+/**
+ * BioSentinel IMU Acquisition
+ * Fixed-rate MPU6050 accelerometer + gyro sampling through its FIFO
+ *
+ * The MPU6050 samples at 1 kHz / (1 + SMPLRT_DIV) on its own oscillator and
+ * writes accel + gyro (12 bytes) into its 1024-byte FIFO. The sensor hub
+ * task drains it in burst reads every IMU_BURST_SAMPLES samples, so the
+ * bus sees a few long transfers instead of one per sample.
+ *
+ * Timestamps are exact rather than smoothed: INT is set to pulse on every
+ * DATA_RDY, and the interrupt only records micros() and counts edges (it
+ * wakes the hub once per burst). A sample enters the FIFO at its DATA_RDY
+ * edge, so when the FIFO count is read between two snapshots of the edge
+ * counter that agree, the newest sample in the FIFO is exactly the last
+ * edge. Older samples in the burst are back-dated by the measured period
+ * (edge spacing between bursts), and the edge count is the sample index,
+ * so a FIFO overflow shows up as a gap in the index.
+ *
+ * Without an INT pin the FIFO is polled and the newest sample is stamped
+ * with the read time (up to one period late); a FIFO reset skips an index,
+ * so the aligner still does not interpolate across the lost samples.
+ */
+
+#ifndef IMU_ACQUISITION_H
+#define IMU_ACQUISITION_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "overwrite_ring.h"
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef IMU_BURST_SAMPLES
+  #define IMU_BURST_SAMPLES 20          // Samples per FIFO drain (200 ms at 100 Hz)
+#endif
+
+#ifndef IMU_RING_SIZE
+  #define IMU_RING_SIZE 128             // Samples buffered for loop() (power of two)
+#endif
+
+#ifndef IMU_READ_CHUNK
+  #define IMU_READ_CHUNK 10             // Samples per I2C read (120 bytes, inside the Wire buffer)
+#endif
+
+#ifndef IMU_TIMELINE_GAIN
+  #define IMU_TIMELINE_GAIN 8
+#endif
+
+#define MPU6050_ADDRESS 0x68
+#define MPU6050_REG_SMPLRT_DIV 0x19
+#define MPU6050_REG_CONFIG 0x1A
+#define MPU6050_REG_GYRO_CONFIG 0x1B
+#define MPU6050_REG_ACCEL_CONFIG 0x1C
+#define MPU6050_REG_FIFO_EN 0x23
+#define MPU6050_REG_INT_PIN_CFG 0x37
+#define MPU6050_REG_INT_ENABLE 0x38
+#define MPU6050_REG_INT_STATUS 0x3A
+#define MPU6050_REG_USER_CTRL 0x6A
+#define MPU6050_REG_PWR_MGMT_1 0x6B
+#define MPU6050_REG_FIFO_COUNTH 0x72
+#define MPU6050_REG_FIFO_R_W 0x74
+#define MPU6050_REG_WHO_AM_I 0x75
+#define MPU6050_FIFO_BYTES 1024
+#define MPU6050_SAMPLE_BYTES 12         // Accel X/Y/Z then gyro X/Y/Z, big endian
+#define MPU6050_INT_FIFO_OFLOW 0x10
+
+#define IMU_ACCEL_LSB_PER_G 8192        // +-4 g
+#define IMU_GYRO_LSB_PER_DPS 65.5f      // +-500 dps
+
+struct ImuSample {
+  int16_t accel[3];                     // IMU_ACCEL_LSB_PER_G
+  int16_t gyro[3];                      // IMU_GYRO_LSB_PER_DPS
+  uint32_t timestampUs;                 // micros() of the sample's DATA_RDY
+  uint32_t index;                       // Sample number - jumps on FIFO overflow
+};
+
+struct ImuStats {
+  uint32_t samples;                     // Read from the FIFO
+  uint32_t bursts;
+  uint32_t fifoOverflows;               // FIFO resets after an overflow
+  uint32_t ringDrops;                   // Samples loop() did not collect in time
+  uint32_t unanchored;                  // Bursts stamped from the read time instead of DATA_RDY
+  float rateHz;                         // Sample rate measured on the ESP32 clock
+};
+
+// =============================================================================
+// IMU Acquisition
+// =============================================================================
+
+class ImuAcquisition {
+public:
+  /**
+   * Configure the MPU6050 (+-4 g, +-500 dps, FIFO on) and arm DATA_RDY
+   * @param intPin     GPIO wired to INT, or -1 to poll
+   * @param sampleRate Hz, a divisor of 1000 between 50 and 200
+   * @return false if the sensor does not answer or the rate is unsupported
+   */
+  bool begin(int intPin, int sampleRate);
+
+  // Bus side (sensor hub task)
+  void setNotifyTask(TaskHandle_t task) { _notify = task; }
+  void service();
+
+  // Consumer side (loop task)
+  bool pop(ImuSample& sample) { return _ring.pop(sample); }
+
+  ImuStats getStats() const;
+  uint32_t periodUs() const { return _periodUs; }
+
+private:
+  TaskHandle_t _notify = nullptr;
+  int _intPin = -1;
+  uint32_t _periodUs = 10000;
+
+  // DATA_RDY edges (interrupt)
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  volatile uint32_t _edges = 0;
+  volatile uint32_t _edgeUs = 0;
+
+  OverwriteRing<ImuSample, IMU_RING_SIZE> _ring;
+
+  // Sensor hub task only
+  uint32_t _drainedEdges = 0;           // Edge count at the last drain
+  uint32_t _lastPollUs = 0;
+  uint32_t _polled = 0;                 // Sample index in polled mode
+  uint32_t _prevEdges = 0;              // Last anchored burst, for the period
+  uint32_t _prevEdgeUs = 0;
+  bool _havePrev = false;
+  bool _stepMeasured = false;
+  float _stepUs = 10000;
+
+  ImuStats _stats = {};
+
+  static ImuAcquisition* _instance;
+  static void IRAM_ATTR onInterrupt();
+
+  void drain();
+  void resetFifo();
+  uint16_t fifoCount();
+  void writeRegister(uint8_t reg, uint8_t value);
+  uint8_t readRegister(uint8_t reg);
+
+  // Big-endian word (separate statements: operand order is unspecified)
+  static int16_t readWord() {
+    uint16_t value = (uint16_t)Wire.read() << 8;
+    value |= (uint16_t)Wire.read();
+    return (int16_t)value;
+  }
+};
+
+ImuAcquisition* ImuAcquisition::_instance = nullptr;
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+bool ImuAcquisition::begin(int intPin, int sampleRate) {
+  if (sampleRate < 50 || sampleRate > 200 || 1000 % sampleRate != 0) {
+    Serial.printf("[IMU] %d Hz is not a supported rate\n", sampleRate);
+    return false;
+  }
+  if (readRegister(MPU6050_REG_WHO_AM_I) != MPU6050_ADDRESS) return false;
+
+  _instance = this;
+  _intPin = intPin;
+  _periodUs = 1000000UL / sampleRate;
+  _stepUs = _periodUs;
+
+  writeRegister(MPU6050_REG_PWR_MGMT_1, 0x80); // Device reset
+  delay(100);
+  writeRegister(MPU6050_REG_PWR_MGMT_1, 0x01); // Wake, clock from the X gyro PLL
+  writeRegister(MPU6050_REG_CONFIG, sampleRate >= 100 ? 0x03 : 0x04); // DLPF 44 / 21 Hz, 1 kHz internal
+  writeRegister(MPU6050_REG_SMPLRT_DIV, (uint8_t)(1000 / sampleRate - 1));
+  writeRegister(MPU6050_REG_GYRO_CONFIG, 0x08);  // +-500 dps
+  writeRegister(MPU6050_REG_ACCEL_CONFIG, 0x08); // +-4 g
+  writeRegister(MPU6050_REG_INT_PIN_CFG, 0x00);  // Active high, push-pull, 50 us pulse
+  writeRegister(MPU6050_REG_INT_ENABLE, intPin >= 0 ? 0x01 : 0x00); // DATA_RDY
+  writeRegister(MPU6050_REG_FIFO_EN, 0x78);      // Accel + gyro X/Y/Z
+  resetFifo();
+
+  if (intPin >= 0) {
+    pinMode(intPin, INPUT);
+    attachInterrupt(digitalPinToInterrupt(intPin), onInterrupt, RISING);
+  }
+
+  Serial.printf("[IMU] %d Hz, burst %d, %s\n", sampleRate, IMU_BURST_SAMPLES,
+                intPin >= 0 ? "DATA_RDY timestamps" : "polled");
+  return true;
+}
+
+void IRAM_ATTR ImuAcquisition::onInterrupt() {
+  ImuAcquisition* self = _instance;
+  portENTER_CRITICAL_ISR(&self->_mux);
+  self->_edgeUs = micros();
+  uint32_t edges = ++self->_edges;
+  portEXIT_CRITICAL_ISR(&self->_mux);
+
+  if (!self->_notify || edges - self->_drainedEdges < IMU_BURST_SAMPLES) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(self->_notify, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void ImuAcquisition::service() {
+  if (_intPin >= 0) {
+    if (_edges - _drainedEdges < IMU_BURST_SAMPLES) return;
+  } else {
+    uint32_t now = micros();
+    if (now - _lastPollUs < _periodUs * IMU_BURST_SAMPLES) return;
+    _lastPollUs = now;
+  }
+  drain();
+}
+
+void ImuAcquisition::drain() {
+  // FIFO count between two agreeing edge snapshots: the newest sample is that edge
+  uint32_t edges = 0, edgeUs = 0;
+  uint16_t bytes = 0;
+  bool anchored = false;
+  for (uint8_t attempt = 0; attempt < 3 && !anchored; attempt++) {
+    portENTER_CRITICAL(&_mux);
+    edges = _edges;
+    edgeUs = _edgeUs;
+    portEXIT_CRITICAL(&_mux);
+    bytes = fifoCount();
+    anchored = _intPin >= 0 && edges == _edges;
+  }
+  if (_intPin >= 0) _drainedEdges = edges;
+  if (!anchored) {
+    edgeUs = micros();
+    if (_intPin >= 0) _stats.unanchored++;
+  }
+
+  uint8_t status = readRegister(MPU6050_REG_INT_STATUS);
+  if ((status & MPU6050_INT_FIFO_OFLOW) || bytes >= MPU6050_FIFO_BYTES || bytes % MPU6050_SAMPLE_BYTES) {
+    // Overflowed or misaligned: what is left is not a whole-sample sequence
+    _stats.fifoOverflows++;
+    _havePrev = false;
+    resetFifo();
+    return;
+  }
+  uint16_t count = bytes / MPU6050_SAMPLE_BYTES;
+  if (count == 0) return;
+
+  // Period: DATA_RDY spacing between anchored bursts, clamped to +-5 % of nominal.
+  // The first spacing is taken as is, as in ppg_acquisition.h: filtering from nominal
+  // back-dates the oldest sample of a burst by up to 4 ms at 2 % skew for ~5 s.
+  if (anchored) {
+    if (_havePrev && edges != _prevEdges) {
+      float measured = (float)(edgeUs - _prevEdgeUs) / (edges - _prevEdges);
+      _stepUs = _stepMeasured ? _stepUs + (measured - _stepUs) / IMU_TIMELINE_GAIN : measured;
+      _stepUs = constrain(_stepUs, _periodUs * 0.95f, _periodUs * 1.05f);
+      _stepMeasured = true;
+    }
+    _prevEdges = edges;
+    _prevEdgeUs = edgeUs;
+    _havePrev = true;
+  }
+  _stats.rateHz = 1e6f / _stepUs;
+
+  // Sample numbers: DATA_RDY edges when anchored, a running count when polled
+  uint32_t lastIndex = _intPin >= 0 ? edges : _polled + count;
+  _polled += count;
+
+  uint16_t remaining = count;
+  uint16_t position = 0;
+  while (remaining) {
+    uint8_t chunk = remaining < IMU_READ_CHUNK ? remaining : IMU_READ_CHUNK;
+    uint8_t want = chunk * MPU6050_SAMPLE_BYTES;
+    Wire.beginTransmission(MPU6050_ADDRESS);
+    Wire.write(MPU6050_REG_FIFO_R_W);
+    Wire.endTransmission(false);
+    uint8_t got = Wire.requestFrom((uint8_t)MPU6050_ADDRESS, want);
+    if (got != want) {
+      Serial.printf("[IMU] Short FIFO read (%u of %u bytes)\n", got, want);
+      _havePrev = false;
+      resetFifo();
+      return;
+    }
+
+    for (uint8_t i = 0; i < chunk; i++, position++) {
+      ImuSample sample;
+      for (uint8_t axis = 0; axis < 3; axis++) sample.accel[axis] = readWord();
+      for (uint8_t axis = 0; axis < 3; axis++) sample.gyro[axis] = readWord();
+      uint16_t age = count - 1 - position;  // Samples newer than this one
+      sample.timestampUs = edgeUs - (uint32_t)(age * _stepUs);
+      sample.index = lastIndex - age;
+      _ring.push(sample);
+    }
+    remaining -= chunk;
+  }
+
+  _stats.samples += count;
+  _stats.bursts++;
+}
+
+void ImuAcquisition::resetFifo() {
+  _polled++;                            // Polled: whatever was lost, leave a gap in the index
+  writeRegister(MPU6050_REG_USER_CTRL, 0x04);    // FIFO_RESET
+  writeRegister(MPU6050_REG_USER_CTRL, 0x40);    // FIFO_EN
+  readRegister(MPU6050_REG_INT_STATUS);
+}
+
+uint16_t ImuAcquisition::fifoCount() {
+  Wire.beginTransmission(MPU6050_ADDRESS);
+  Wire.write(MPU6050_REG_FIFO_COUNTH);
+  Wire.endTransmission(false);
+  if (Wire.requestFrom((uint8_t)MPU6050_ADDRESS, (uint8_t)2) != 2) return 0;
+  return (uint16_t)readWord();
+}
+
+void ImuAcquisition::writeRegister(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(MPU6050_ADDRESS);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
+}
+
+uint8_t ImuAcquisition::readRegister(uint8_t reg) {
+  Wire.beginTransmission(MPU6050_ADDRESS);
+  Wire.write(reg);
+  Wire.endTransmission(false);
+  Wire.requestFrom((uint8_t)MPU6050_ADDRESS, (uint8_t)1);
+  return Wire.available() ? Wire.read() : 0;
+}
+
+ImuStats ImuAcquisition::getStats() const {
+  ImuStats stats = _stats;
+  stats.ringDrops = _ring.dropped();
+  return stats;
+}
+
+#endif
@@ -10,7 +10,11 @@
  * 
  * Features:
  * - Real-time biometric monitoring
- * - WiFi connectivity
+ * - Synchronized PPG / motion / skin temperature frames on one timebase
+ * - Heart rate variability (RMSSD, SDNN, pNN50)
+ * - Raw waveform streaming (binary WebSocket frames, opt-in)
+ * - Non-blocking WiFi (NVS credentials, backoff) and WebSocket reconnect
+ * - Degraded mode: keeps reporting health when the PPG sensor is missing
  * - MQTT/WebSocket data transmission
  * - Low power mode support
  * - OTA updates
@@ -21,15 +25,22 @@
 #include <ArduinoJson.h>
 #include <Wire.h>
 #include "MAX30105.h"
-#include "heartRate.h"
+#include "ppg_acquisition.h"
+#include "imu_acquisition.h"
+#include "skin_temperature.h"
+#include "sensor_hub.h"
+#include "ppg_dsp.h"
+#include "hrv_analyzer.h"
+#include "waveform_stream.h"
+#include "wifi_manager.h"
 
 // =============================================================================
 // Configuration
 // =============================================================================
 
-// WiFi Credentials
-const char* WIFI_SSID = "YOUR_WIFI_SSID";
-const char* WIFI_PASSWORD = "YOUR_WIFI_PASSWORD";
+// WiFi Credentials - first boot only; NVS ("wifi <ssid> <password>" on serial) takes over
+const char* WIFI_SSID = "";
+const char* WIFI_PASSWORD = "";
 
 // Server Configuration
 const char* WS_HOST = "api.mrf103.com";
@@ -40,23 +51,72 @@ const char* WS_PATH = "/biosentinel/ws";
 const char* DEVICE_ID = "biosentinel-001";
 const int SAMPLE_RATE = 100;  // Hz
 const int REPORT_INTERVAL = 1000;  // ms
+const int IMU_SAMPLE_RATE = 100;  // Hz (50-200, a divisor of 1000)
+const float MOTION_LIMIT = 0.05;  // g - above this, beats are not used for HRV
+
+static_assert(SAMPLE_RATE == PPG_DSP_RATE, "PpgDsp filters are designed for its own sample rate");
+
+// Hardware
+const int PPG_INT_PIN = 19;  // MAX30102 INT (open drain, active low)
+const int IMU_INT_PIN = 18;  // MPU6050 INT (push-pull, active high)
 
 // =============================================================================
 // Global Objects
 // =============================================================================
 
 MAX30105 particleSensor;
+PpgAcquisition ppg;
+ImuAcquisition imu;
+SkinTemperature skinTemp;
+SensorHub sensors;
+PpgDsp dsp;
+HrvAnalyzer hrv;
+WaveformEncoder waveform;
 WebSocketsClient webSocket;
+BioWiFiManager wifiManager;
 
 // Sensor Data
 float heartRate = 0;
 float spO2 = 0;
-float temperature = 0;
+float temperature = NAN;  // Skin, NAN until the MLX90614 has a reading
 bool fingerDetected = false;
+uint8_t signalQuality = 0;  // 0-100, HR / SpO2 reported from PPG_DSP_MIN_QUALITY
+float perfusionIndex = 0;
+float motionLevel = 0;  // g, smoothed deviation of |accel| from 1 g
+bool imuPresent = false;
+
+// Sensor presence: without the PPG the device runs degraded, reporting health only
+bool ppgPresent = false;
+bool tempPresent = false;
+bool sensorsRunning = false;
+
+// Raw waveform mode (off until the server asks for it)
+bool rawMode = false;
+uint32_t waveformDropped = 0;  // Frames completed while disconnected
 
 // Timing
 unsigned long lastReport = 0;
 unsigned long lastHeartbeat = 0;
+bool wsStarted = false;
+
+// Boot milestones (millis(), 0 = not reached yet)
+unsigned long firstSampleMs = 0;
+unsigned long onlineMs = 0;
+
+// =============================================================================
+// Forward Declarations
+// =============================================================================
+
+bool isDegraded();
+void onWiFiChanged(bool connected);
+void webSocketEvent(WStype_t type, uint8_t * payload, size_t length);
+void readSensors();
+void sendSensorData();
+void sendWaveformFrame();
+void sendDeviceInfo();
+void sendHeartbeat();
+void handleCommand(char* payload);
+void handleSerial();
 
 // =============================================================================
 // Setup
@@ -72,25 +132,36 @@ void setup() {
   // Initialize I2C
   Wire.begin();
 
-  // Initialize MAX30102
+  // Initialize MAX30102 - fixed-rate sampling: the sensor clocks SAMPLE_RATE, INT triggers FIFO burst reads
   if (!particleSensor.begin(Wire, I2C_SPEED_FAST)) {
-    Serial.println("[ERROR] MAX30102 not found!");
-    while (1);
+    Serial.println("[WARN] MAX30102 not found - degraded mode, reporting health only");
+  } else if (!ppg.begin(particleSensor, PPG_INT_PIN, SAMPLE_RATE, 0x1F)) {
+    Serial.println("[WARN] PPG acquisition not started - degraded mode, reporting health only");
+  } else {
+    particleSensor.setPulseAmplitudeRed(0x0A);
+    ppgPresent = true;
+    Serial.println("[OK] MAX30102 initialized");
   }
-  Serial.println("[OK] MAX30102 initialized");
-
-  // Configure sensor
-  particleSensor.setup();
-  particleSensor.setPulseAmplitudeRed(0x0A);
-  particleSensor.setPulseAmplitudeGreen(0);
 
-  // Connect WiFi
-  connectWiFi();
+  // Motion and skin temperature are optional: without them frames carry PPG only
+  imuPresent = imu.begin(IMU_INT_PIN, IMU_SAMPLE_RATE);
+  Serial.println(imuPresent ? "[OK] MPU6050 initialized" : "[WARN] MPU6050 not found - no motion data");
+  tempPresent = skinTemp.begin();
+  Serial.println(tempPresent ? "[OK] MLX90614 initialized" : "[WARN] MLX90614 not found - no temperature");
+
+  // From here on only the sensor hub task touches the I2C bus
+  if (ppgPresent || imuPresent || tempPresent) {
+    sensorsRunning = sensors.begin(ppgPresent ? &ppg : nullptr, imuPresent ? &imu : nullptr,
+                                   tempPresent ? &skinTemp : nullptr);
+    if (!sensorsRunning) Serial.println("[WARN] Sensor task not started - degraded mode");
+  }
 
-  // Connect WebSocket
-  connectWebSocket();
+  // Connect in the background: WebSocket starts once WiFi is up
+  wifiManager.setConnectionCallback(onWiFiChanged);
+  wifiManager.begin(DEVICE_ID, WIFI_SSID, WIFI_PASSWORD);
 
-  Serial.println("\n[READY] BioSentinel Online");
+  Serial.printf("\n[READY] BioSentinel started in %lu ms%s\n", millis(),
+                isDegraded() ? " (degraded)" : "");
 }
 
 // =============================================================================
@@ -98,10 +169,12 @@ void setup() {
 // =============================================================================
 
 void loop() {
-  webSocket.loop();
+  wifiManager.loop();
+  if (wsStarted) webSocket.loop();
+  handleSerial();
 
   // Read sensors
-  readSensors();
+  if (sensorsRunning) readSensors();
 
   // Send data at interval
   if (millis() - lastReport >= REPORT_INTERVAL) {
@@ -117,41 +190,24 @@ void loop() {
 }
 
 // =============================================================================
-// WiFi Connection
+// Connectivity
 // =============================================================================
 
-void connectWiFi() {
-  Serial.print("[WIFI] Connecting to ");
-  Serial.println(WIFI_SSID);
-
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\n[WIFI] Connected!");
-    Serial.print("[WIFI] IP: ");
-    Serial.println(WiFi.localIP());
-  } else {
-    Serial.println("\n[WIFI] Connection failed!");
-  }
+bool isDegraded() {
+  return !ppgPresent || !sensorsRunning;
 }
 
-// =============================================================================
-// WebSocket Connection
-// =============================================================================
-
-void connectWebSocket() {
-  Serial.println("[WS] Connecting to server...");
-  
-  webSocket.beginSSL(WS_HOST, WS_PORT, WS_PATH);
-  webSocket.onEvent(webSocketEvent);
-  webSocket.setReconnectInterval(5000);
+void onWiFiChanged(bool connected) {
+  if (connected && !wsStarted) {
+    // The client reconnects on its own from here, from webSocket.loop()
+    Serial.println("[WS] Connecting to server...");
+    webSocket.beginSSL(WS_HOST, WS_PORT, WS_PATH);
+    webSocket.onEvent(webSocketEvent);
+    webSocket.setReconnectInterval(5000);
+    wsStarted = true;
+  } else if (!connected && wsStarted) {
+    webSocket.disconnect();
+  }
 }
 
 void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
@@ -162,6 +218,11 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
       
     case WStype_CONNECTED:
       Serial.println("[WS] Connected!");
+      if (!onlineMs) {
+        onlineMs = millis();
+        Serial.printf("[BOOT] Online after %lu ms (WiFi %lu ms)\n", onlineMs,
+                      (unsigned long)wifiManager.firstConnectMs());
+      }
       sendDeviceInfo();
       break;
       
@@ -180,40 +241,47 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
 // =============================================================================
 
 void readSensors() {
-  long irValue = particleSensor.getIR();
-  
-  // Check if finger is on sensor
-  fingerDetected = irValue > 50000;
-  
-  if (fingerDetected) {
-    // Calculate heart rate (simplified)
-    static long lastBeat = 0;
-    static int beatCount = 0;
-    
-    if (checkForBeat(irValue)) {
-      long delta = millis() - lastBeat;
-      lastBeat = millis();
-      
-      if (delta > 250 && delta < 2000) {
-        heartRate = 60000.0 / delta;
-        beatCount++;
-      }
+  // Aligned frames from the sensor hub, in order: PPG with motion and temperature at the same instant
+  SensorFrame frame;
+  bool any = false;
+
+  while (sensors.nextFrame(frame)) {
+    if (!any && !firstSampleMs) {
+      firstSampleMs = millis();
+      Serial.printf("[BOOT] First sample after %lu ms\n", firstSampleMs);
     }
-    
-    // SpO2 calculation (simplified)
-    long redValue = particleSensor.getRed();
-    if (redValue > 0 && irValue > 0) {
-      float ratio = (float)redValue / (float)irValue;
-      spO2 = 110 - 25 * ratio;  // Simplified formula
-      spO2 = constrain(spO2, 0, 100);
+    any = true;
+    if (frame.motionValid) {
+      // ~0.3 s smoothing of how far |accel| is from gravity
+      float ax = frame.accel[0], ay = frame.accel[1], az = frame.accel[2];
+      float g = sqrtf(ax * ax + ay * ay + az * az) / IMU_ACCEL_LSB_PER_G;
+      motionLevel += (fabsf(g - 1.0f) - motionLevel) * 0.03f;
+    }
+    if (dsp.update(frame.red, frame.ir, frame.timestampUs)) {
+      bool reliable = dsp.quality() >= PPG_DSP_MIN_QUALITY && motionLevel < MOTION_LIMIT;
+      hrv.addBeat(dsp.lastRrMs(), reliable);
     }
+    if (rawMode && waveform.add(frame.index, frame.timestampUs, frame.red, frame.ir, frame.accel)) {
+      sendWaveformFrame();
+    }
+    temperature = frame.skinTemperature;
+  }
+  if (!any) return;
+
+  // A new placement may be a different wearer - start the HRV window over
+  if (fingerDetected && !dsp.fingerDetected()) hrv.reset();
+  fingerDetected = dsp.fingerDetected();
+  signalQuality = dsp.quality();
+  perfusionIndex = dsp.perfusionIndex();
+
+  // Below the quality floor the numbers are motion or noise - report none
+  if (signalQuality >= PPG_DSP_MIN_QUALITY) {
+    heartRate = dsp.heartRate();
+    spO2 = dsp.spo2();
   } else {
     heartRate = 0;
     spO2 = 0;
   }
-  
-  // Temperature (placeholder - would use MLX90614)
-  temperature = 36.5 + (random(0, 10) / 10.0);
 }
 
 // =============================================================================
@@ -223,7 +291,7 @@ void readSensors() {
 void sendSensorData() {
   if (!fingerDetected) return;
   
-  StaticJsonDocument<256> doc;
+  StaticJsonDocument<512> doc;
   
   doc["type"] = "sensor_data";
   doc["deviceId"] = DEVICE_ID;
@@ -232,26 +300,67 @@ void sendSensorData() {
   JsonObject data = doc.createNestedObject("data");
   data["heartRate"] = heartRate;
   data["spO2"] = spO2;
-  data["temperature"] = temperature;
+  if (!isnan(temperature)) data["temperature"] = temperature;
   data["fingerDetected"] = fingerDetected;
+  data["signalQuality"] = signalQuality;
+  data["perfusionIndex"] = perfusionIndex;
+  if (imuPresent) data["motion"] = motionLevel;
+
+  // Accepted RR intervals since the last report, and the window metrics
+  uint16_t rr[8];
+  uint8_t rrCount = hrv.takeRecent(rr, 8);
+  JsonArray rrArray = data.createNestedArray("rr");
+  for (uint8_t i = 0; i < rrCount; i++) rrArray.add(rr[i]);
+
+  if (hrv.valid()) {
+    HrvMetrics metrics = hrv.metrics();
+    JsonObject hrvData = data.createNestedObject("hrv");
+    hrvData["rmssd"] = metrics.rmssd;
+    hrvData["sdnn"] = metrics.sdnn;
+    hrvData["pnn50"] = metrics.pnn50;
+    hrvData["meanRr"] = metrics.meanRr;
+    hrvData["intervals"] = metrics.intervals;
+  }
   
-  String json;
-  serializeJson(doc, json);
+  char json[512];
+  size_t length = serializeJson(doc, json, sizeof(json));
   
-  webSocket.sendTXT(json);
+  webSocket.sendTXT(json, length);
   
-  Serial.printf("[DATA] HR: %.1f bpm, SpO2: %.1f%%, Temp: %.1f°C\n", 
-                heartRate, spO2, temperature);
+  Serial.printf("[DATA] HR: %.1f bpm, SpO2: %.1f%%, Temp: %.1f°C, SQI: %u\n", 
+                heartRate, spO2, temperature, signalQuality);
+}
+
+void sendWaveformFrame() {
+  // The frame sequence still advances, so the server sees what was missed
+  if (!webSocket.isConnected()) {
+    waveformDropped++;
+    return;
+  }
+  webSocket.sendBIN(waveform.frame(), waveform.frameSize());
 }
 
 void sendDeviceInfo() {
-  StaticJsonDocument<256> doc;
+  StaticJsonDocument<512> doc;
   
   doc["type"] = "device_info";
   doc["deviceId"] = DEVICE_ID;
   doc["firmware"] = "1.0.0";
   doc["ip"] = WiFi.localIP().toString();
   doc["rssi"] = WiFi.RSSI();
+  doc["rawMode"] = rawMode;
+  doc["degraded"] = isDegraded();
+  
+  JsonObject present = doc.createNestedObject("sensors");
+  present["ppg"] = ppgPresent;
+  present["imu"] = imuPresent;
+  present["temperature"] = tempPresent;
+  
+  // Boot milestones, ms since reset (0 = not reached)
+  JsonObject boot = doc.createNestedObject("boot");
+  boot["firstSampleMs"] = firstSampleMs;
+  boot["wifiMs"] = wifiManager.firstConnectMs();
+  boot["onlineMs"] = onlineMs;
   
   String json;
   serializeJson(doc, json);
@@ -260,17 +369,67 @@ void sendDeviceInfo() {
 }
 
 void sendHeartbeat() {
-  StaticJsonDocument<128> doc;
+  StaticJsonDocument<768> doc;
   
   doc["type"] = "heartbeat";
   doc["deviceId"] = DEVICE_ID;
   doc["uptime"] = millis() / 1000;
   doc["freeHeap"] = ESP.getFreeHeap();
+  doc["wifiDrops"] = wifiManager.disconnects();
   
-  String json;
-  serializeJson(doc, json);
+  // Degraded: no PPG stats to report, but the device is alive and says why
+  if (isDegraded()) {
+    doc["degraded"] = true;
+    float celsius;
+    uint32_t timestampUs;
+    if (tempPresent && skinTemp.read(celsius, timestampUs)) doc["temperature"] = celsius;
+  }
   
-  webSocket.sendTXT(json);
+  // Acquisition health: sample clock, timing jitter, lost samples
+  if (ppgPresent) {
+    PpgStats stats = ppg.getStats();
+    JsonObject acq = doc.createNestedObject("acquisition");
+    acq["rateHz"] = stats.rateHz;
+    acq["samples"] = stats.samples;
+    acq["jitterUs"] = stats.jitterUs;
+    acq["maxJitterUs"] = stats.maxJitterUs;
+    acq["maxLatencyUs"] = stats.maxLatencyUs;
+    acq["maxBurst"] = stats.maxBurst;
+    acq["fifoOverflows"] = stats.fifoOverflows;
+    acq["ringDrops"] = stats.ringDrops;
+    
+    Serial.printf("[PPG] %.2f Hz, jitter %u/%u us, latency max %u us, overflows %u, drops %u\n",
+                  stats.rateHz, stats.jitterUs, stats.maxJitterUs, stats.maxLatencyUs,
+                  stats.fifoOverflows, stats.ringDrops);
+  }
+  if (sensorsRunning) doc["busMaxUs"] = sensors.maxServiceUs();
+  
+  if (imuPresent) {
+    ImuStats imuStats = imu.getStats();
+    const AlignerStats& align = sensors.getAlignerStats();
+    JsonObject motion = doc.createNestedObject("imu");
+    motion["rateHz"] = imuStats.rateHz;
+    motion["fifoOverflows"] = imuStats.fifoOverflows;
+    motion["ringDrops"] = imuStats.ringDrops;
+    motion["aligned"] = align.interpolated;
+    motion["unaligned"] = align.frames - align.interpolated;
+  }
+  const SkinTemperatureStats& temp = skinTemp.getStats();
+  if (temp.reads) doc["tempErrors"] = temp.errors + temp.outOfRange;
+  
+  if (rawMode) {
+    const WaveformStats& wave = waveform.getStats();
+    JsonObject raw = doc.createNestedObject("waveform");
+    raw["frames"] = wave.frames;
+    raw["bytes"] = wave.bytes;
+    raw["gaps"] = wave.gaps;
+    raw["dropped"] = waveformDropped;
+  }
+  
+  char json[768];
+  size_t length = serializeJson(doc, json, sizeof(json));
+  
+  webSocket.sendTXT(json, length);
 }
 
 // =============================================================================
@@ -293,8 +452,53 @@ void handleCommand(char* payload) {
     ESP.restart();
   } else if (strcmp(command, "status") == 0) {
     sendDeviceInfo();
+  } else if (strcmp(command, "raw") == 0) {
+    // {"command":"raw","enable":true,"batchMs":250}
+    bool enable = doc["enable"] | false;
+    if (enable && !rawMode) {
+      uint8_t channels = WAVEFORM_CH_RED | WAVEFORM_CH_IR | (imuPresent ? WAVEFORM_CH_ACCEL : 0);
+      waveform.begin(channels, SAMPLE_RATE, doc["batchMs"] | WAVEFORM_BATCH_MS);
+      Serial.printf("[RAW] Streaming %u samples per frame\n", waveform.batchSamples());
+    } else if (!enable && rawMode) {
+      if (waveform.flush()) sendWaveformFrame();
+      Serial.println("[RAW] Stopped");
+    }
+    rawMode = enable;
+  } else if (strcmp(command, "wifi") == 0) {
+    // {"command":"wifi","ssid":"...","password":"..."} - takes effect now, survives reboots
+    const char* ssid = doc["ssid"];
+    if (ssid && ssid[0]) wifiManager.setCredentials(ssid, doc["password"] | "");
   } else if (strcmp(command, "calibrate") == 0) {
     Serial.println("[CMD] Calibrating sensors...");
     // Calibration logic here
   }
 }
+
+// Serial console: "wifi <ssid> <password>" / "wifi clear" (no spaces in the SSID)
+void handleSerial() {
+  static char line[128];
+  static size_t length = 0;
+  
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (length < sizeof(line) - 1) line[length++] = c;
+      continue;
+    }
+    if (length == 0) continue;
+    line[length] = '\0';
+    length = 0;
+    
+    char* verb = strtok(line, " ");
+    char* ssid = strtok(nullptr, " ");
+    char* password = strtok(nullptr, "");
+    if (!verb || strcmp(verb, "wifi") != 0 || !ssid) {
+      Serial.println("[CMD] Usage: wifi <ssid> <password> | wifi clear");
+    } else if (strcmp(ssid, "clear") == 0) {
+      wifiManager.clearCredentials();
+      Serial.println("[WIFI] Credentials cleared");
+    } else {
+      wifiManager.setCredentials(ssid, password ? password : "");
+    }
+  }
+}
@@ -0,0 +1,87 @@
+/**
+ * BioSentinel Overwrite Ring
+ * Single-producer / single-consumer sample ring that never blocks the producer
+ *
+ * The sensor hub task pushes; loop() pops at its own pace. A producer that
+ * laps the consumer overwrites the oldest samples instead of waiting, and
+ * the consumer counts what it missed. push() writes slot head before it
+ * publishes head + 1, so once head - tail reaches N the slot at tail may be
+ * mid-write: pop() never copies it, and re-checks after the copy in case the
+ * producer got there while it was copying.
+ *
+ * Pure C++ (no Arduino dependencies); tools/ppg_ring_stress.cpp runs it on
+ * two threads.
+ */
+
+#ifndef OVERWRITE_RING_H
+#define OVERWRITE_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// =============================================================================
+// Overwrite Ring
+// =============================================================================
+
+template <typename T, uint32_t N>
+class OverwriteRing {
+  static_assert((N & (N - 1)) == 0, "OverwriteRing size must be a power of two");
+
+public:
+  // Producer side
+  void push(const T& item);
+
+  /**
+   * Consumer side: oldest intact item
+   * @param position Set to the item's position in the stream (jumps on drops)
+   */
+  bool pop(T& item, uint32_t* position = nullptr);
+  uint32_t available() const { return _head.load(std::memory_order_acquire) - _tail; }
+
+  uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+  T _slots[N];
+  std::atomic<uint32_t> _head{0};       // Written by the producer
+  uint32_t _tail = 0;                   // Written by the consumer
+  std::atomic<uint32_t> _dropped{0};
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+template <typename T, uint32_t N>
+void OverwriteRing<T, N>::push(const T& item) {
+  uint32_t head = _head.load(std::memory_order_relaxed);
+  _slots[head & (N - 1)] = item;
+  _head.store(head + 1, std::memory_order_release);
+}
+
+template <typename T, uint32_t N>
+bool OverwriteRing<T, N>::pop(T& item, uint32_t* position) {
+  for (;;) {
+    uint32_t head = _head.load(std::memory_order_acquire);
+    if (head == _tail) return false;
+
+    // A whole ring behind: skip to the oldest slot push() cannot be writing
+    if (head - _tail >= N) {
+      _dropped.fetch_add(head - _tail - N + 1, std::memory_order_relaxed);
+      _tail = head - N + 1;
+    }
+    item = _slots[_tail & (N - 1)];
+
+    // Keep the copy ahead of the re-check, then drop the slot if push() reached it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_head.load(std::memory_order_relaxed) - _tail >= N) {
+      _tail++;
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (position) *position = _tail;
+    _tail++;
+    return true;
+  }
+}
+
+#endif
@@ -0,0 +1,327 @@
+/**
+ * BioSentinel PPG Acquisition
+ * Fixed-rate MAX30102 sampling with interrupt-driven FIFO burst reads
+ *
+ * The MAX30102 samples on its own clock (SAMPLE_RATE x PPG_AVERAGE internal
+ * rate, averaged down in hardware) into its 32-deep FIFO. Its INT pin fires
+ * when the FIFO is almost full (PPG_BURST_SAMPLES unread); the sensor hub
+ * task (sensor_hub.h), which owns the I2C bus, then calls service() to
+ * drain everything in one burst read and push the samples, timestamped,
+ * into a single-producer / single-consumer ring (overwrite_ring.h) that
+ * loop() drains at its own pace. Rollover is enabled, so a stalled reader
+ * loses the oldest samples and the FIFO overflow counter says how many.
+ *
+ * Timestamps: the interrupt marks when the PPG_BURST_SAMPLES-th sample
+ * landed. Samples are stamped on a timeline that advances one period per
+ * sample; at every burst it is pulled towards that mark by
+ * 1/PPG_TIMELINE_GAIN of the error, and the period towards the measured
+ * interrupt spacing by the same factor (the first spacing is taken as is).
+ * That follows the sensor's own oscillator (a few % off nominal) without
+ * copying the interrupt latency into every sample. The error is the
+ * reported jitter. tools/ppg_fifo_sim.cpp runs this against a model of the
+ * FIFO.
+ */
+
+#ifndef PPG_ACQUISITION_H
+#define PPG_ACQUISITION_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "MAX30105.h"
+#include "overwrite_ring.h"
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef PPG_AVERAGE
+  #define PPG_AVERAGE 4                 // Hardware averaging (1, 2, 4, 8, 16, 32)
+#endif
+
+#ifndef PPG_BURST_SAMPLES
+  #define PPG_BURST_SAMPLES 17          // Unread samples that raise INT (17..32)
+#endif
+
+#ifndef PPG_RING_SIZE
+  #define PPG_RING_SIZE 256             // Samples buffered for loop() (power of two)
+#endif
+
+#ifndef PPG_TIMELINE_GAIN
+  #define PPG_TIMELINE_GAIN 8
+#endif
+
+#ifndef PPG_READ_CHUNK
+  #define PPG_READ_CHUNK 16             // Samples per I2C read (96 bytes, inside the Wire buffer)
+#endif
+
+static_assert(PPG_BURST_SAMPLES >= 17 && PPG_BURST_SAMPLES <= 32, "FIFO_A_FULL covers 17..32 unread samples");
+
+#define MAX30102_ADDRESS 0x57
+#define MAX30102_REG_INT_STATUS1 0x00
+#define MAX30102_REG_FIFO_WR_PTR 0x04
+#define MAX30102_REG_OVF_COUNTER 0x05
+#define MAX30102_REG_FIFO_RD_PTR 0x06
+#define MAX30102_REG_FIFO_DATA 0x07
+#define MAX30102_FIFO_DEPTH 32
+#define MAX30102_SAMPLE_BYTES 6         // Red + IR, 3 bytes each (18-bit)
+
+struct PpgSample {
+  uint32_t red;
+  uint32_t ir;
+  uint32_t timestampUs;                 // micros() on the smoothed sample timeline
+  uint32_t index;                       // Position in the stream (set by pop) - jumps on ring drops
+};
+
+struct PpgStats {
+  uint32_t samples;                     // Read from the FIFO
+  uint32_t bursts;
+  uint32_t fifoOverflows;               // Samples the sensor dropped (from the timeline once the counter saturates)
+  uint32_t ringDrops;                   // Samples loop() did not collect in time
+  uint8_t maxBurst;                     // Largest burst (32 = FIFO was full)
+  uint32_t maxLatencyUs;                // Interrupt to start of the burst read
+  uint32_t jitterUs;                    // Mean |interrupt - timeline| per burst
+  uint32_t maxJitterUs;
+  float rateHz;                         // Sample rate measured on the ESP32 clock
+};
+
+// =============================================================================
+// PPG Acquisition
+// =============================================================================
+
+class PpgAcquisition {
+public:
+  /**
+   * Configure the sensor for fixed-rate red + IR sampling and arm the
+   * interrupt (call before the sensor hub starts)
+   * @return false if the rate / averaging combination is not supported
+   */
+  bool begin(MAX30105& sensor, int intPin, int sampleRate, uint8_t ledAmplitude);
+
+  // Bus side (sensor hub task): the interrupt wakes `task`, which calls service()
+  void setNotifyTask(TaskHandle_t task) { _notify = task; }
+  void service();
+  uint32_t burstIntervalUs() const { return _periodUs * PPG_BURST_SAMPLES; }
+
+  // Consumer side (loop task)
+  bool pop(PpgSample& sample) { return _ring.pop(sample, &sample.index); }
+  uint16_t available() const { return (uint16_t)_ring.available(); }
+
+  PpgStats getStats() const;
+  uint32_t periodUs() const { return _periodUs; }
+
+private:
+  TaskHandle_t _notify = nullptr;
+  int _intPin = -1;
+  uint32_t _periodUs = 10000;
+
+  volatile uint32_t _irqUs = 0;
+  volatile bool _pending = false;       // Interrupt not yet serviced
+
+  OverwriteRing<PpgSample, PPG_RING_SIZE> _ring;
+
+  // Timeline (sensor hub task only)
+  bool _locked = false;
+  uint32_t _nextUs = 0;                 // Timestamp the next sample read gets
+  float _fracUs = 0;                    // Sub-microsecond part of _nextUs
+  float _stepUs = 10000;                // Tracked sample period
+  uint32_t _prevIrqUs = 0;              // Last anchoring interrupt ...
+  uint16_t _prevCount = 0;              // ... and the samples read since, 0 = none
+  bool _stepMeasured = false;
+  uint32_t _anchored = 0;               // Bursts that measured jitter
+  uint64_t _jitterSum = 0;
+
+  PpgStats _stats = {};
+
+  static PpgAcquisition* _instance;
+  static void IRAM_ATTR onInterrupt();
+
+  void drain(uint32_t irqUs, bool fromInterrupt);
+  uint8_t readRegister(uint8_t reg);
+
+  // One 18-bit channel, MSB first (separate statements: operand order is unspecified)
+  static uint32_t readChannel() {
+    uint32_t value = (uint32_t)Wire.read() << 16;
+    value |= (uint32_t)Wire.read() << 8;
+    value |= (uint32_t)Wire.read();
+    return value & 0x3FFFF;
+  }
+};
+
+PpgAcquisition* PpgAcquisition::_instance = nullptr;
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+bool PpgAcquisition::begin(MAX30105& sensor, int intPin, int sampleRate, uint8_t ledAmplitude) {
+  int internalRate = sampleRate * PPG_AVERAGE;
+  const int rates[] = {50, 100, 200, 400, 800, 1000, 1600, 3200};
+  bool supported = false;
+  for (int rate : rates) supported |= rate == internalRate;
+  if (!supported) {
+    Serial.printf("[PPG] %d Hz x %d averaging is not a MAX30102 rate\n", sampleRate, PPG_AVERAGE);
+    return false;
+  }
+
+  _instance = this;
+  _intPin = intPin;
+  _periodUs = 1000000UL / sampleRate;
+  _stepUs = _periodUs;
+
+  // Red + IR (ledMode 2), 411 us pulses (18-bit), 4096 nA full scale
+  sensor.setup(ledAmplitude, PPG_AVERAGE, 2, internalRate, 411, 4096);
+  sensor.enableFIFORollover();
+  sensor.setFIFOAlmostFull(MAX30102_FIFO_DEPTH - PPG_BURST_SAMPLES);
+  sensor.enableAFULL();
+  sensor.clearFIFO();
+  readRegister(MAX30102_REG_INT_STATUS1); // Clear any pending interrupt
+
+  pinMode(intPin, INPUT_PULLUP);        // INT is open drain, active low
+  attachInterrupt(digitalPinToInterrupt(intPin), onInterrupt, FALLING);
+
+  Serial.printf("[PPG] %d Hz (%d x %d avg), burst %d, INT on GPIO %d\n",
+                sampleRate, internalRate, PPG_AVERAGE, PPG_BURST_SAMPLES, intPin);
+  return true;
+}
+
+void IRAM_ATTR PpgAcquisition::onInterrupt() {
+  _instance->_irqUs = micros();
+  _instance->_pending = true;
+  if (!_instance->_notify) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(_instance->_notify, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void PpgAcquisition::service() {
+  // INT stays low until serviced, which also catches a missed edge
+  bool pending = _pending;
+  if (!pending && digitalRead(_intPin) == HIGH) return;
+  _pending = false;
+  drain(pending ? _irqUs : micros(), pending);
+}
+
+void PpgAcquisition::drain(uint32_t irqUs, bool fromInterrupt) {
+  uint32_t startUs = micros();
+  if (fromInterrupt && startUs - irqUs > _stats.maxLatencyUs) _stats.maxLatencyUs = startUs - irqUs;
+
+  readRegister(MAX30102_REG_INT_STATUS1);
+  uint8_t overflow = readRegister(MAX30102_REG_OVF_COUNTER);
+  uint8_t write = readRegister(MAX30102_REG_FIFO_WR_PTR);
+  uint32_t writeUs = micros();
+  uint8_t read = readRegister(MAX30102_REG_FIFO_RD_PTR);
+  uint8_t count = (write - read) & (MAX30102_FIFO_DEPTH - 1);
+  if (count == 0 && overflow) count = MAX30102_FIFO_DEPTH; // Full: pointers meet
+  if (count == 0) return;
+
+  // The counter saturates at 31; past that the timeline says how many landed up to the WR_PTR read
+  uint32_t lost = overflow;
+  if (overflow == 31 && _locked) {
+    uint32_t landed = (uint32_t)((int32_t)(writeUs - _nextUs) / _stepUs) + 1;
+    if (landed > count + lost) lost = landed - count;
+  }
+  _stats.fifoOverflows += lost;
+
+  // An interrupt with nothing lost marks the PPG_BURST_SAMPLES-th sample of this burst.
+  // Without one (missed edge, read on the poll) the timeline carries on if nothing was lost
+  // and its last sample lands within a couple of periods of now.
+  bool anchored = fromInterrupt && !overflow;
+  int32_t error = 0;
+  bool restart = !_locked || overflow;
+  if (!restart && anchored) {
+    error = (int32_t)(irqUs - (_nextUs + (uint32_t)((PPG_BURST_SAMPLES - 1) * _stepUs)));
+    restart = abs(error) > (int32_t)_periodUs * 2;
+  } else if (!restart) {
+    int32_t lag = (int32_t)(startUs - (_nextUs + (uint32_t)((count - 1) * _stepUs)));
+    restart = lag < -(int32_t)_periodUs || lag > (int32_t)_periodUs * 2;
+  }
+
+  // The first period measurement re-anchors the timeline instead of counting as jitter
+  bool seeding = anchored && !restart && _prevCount && !_stepMeasured;
+
+  if (restart) {
+    // Restart the timeline: from the interrupt, or back from now for a full / late FIFO
+    _nextUs = anchored ? irqUs - (uint32_t)((PPG_BURST_SAMPLES - 1) * _stepUs)
+                       : startUs - (uint32_t)((count - 1) * _stepUs);
+    _fracUs = 0;
+    _locked = true;
+    _prevCount = 0;
+  } else if (anchored && !seeding) {
+    _nextUs += error / PPG_TIMELINE_GAIN;
+    uint32_t jitter = (uint32_t)abs(error);
+    _jitterSum += jitter;
+    _anchored++;
+    _stats.jitterUs = (uint32_t)(_jitterSum / _anchored);
+    if (jitter > _stats.maxJitterUs) _stats.maxJitterUs = jitter;
+  }
+
+  // Period: interrupt spacing over the samples in between, clamped to +-5 % of nominal.
+  // The first spacing is taken as is; filtering from nominal instead leaves a 1 % clock
+  // error several ms out of phase for ~10 s.
+  if (anchored) {
+    if (_prevCount) {
+      float measured = (float)(irqUs - _prevIrqUs) / _prevCount;
+      _stepUs = _stepMeasured ? _stepUs + (measured - _stepUs) / PPG_TIMELINE_GAIN : measured;
+      _stepUs = constrain(_stepUs, _periodUs * 0.95f, _periodUs * 1.05f);
+      _stepMeasured = true;
+    }
+    if (seeding) {
+      _nextUs = irqUs - (uint32_t)((PPG_BURST_SAMPLES - 1) * _stepUs);
+      _fracUs = 0;
+    }
+    _prevIrqUs = irqUs;
+    _prevCount = count;
+  } else if (_prevCount) {
+    _prevCount += count;                // Next anchor's spacing covers this burst too
+  }
+  _stats.rateHz = 1e6f / _stepUs;
+
+  // Burst read in chunks; FIFO_DATA does not auto-increment, so each chunk rereads it
+  uint8_t remaining = count;
+  while (remaining) {
+    uint8_t chunk = remaining < PPG_READ_CHUNK ? remaining : PPG_READ_CHUNK;
+    uint8_t want = chunk * MAX30102_SAMPLE_BYTES;
+    Wire.beginTransmission(MAX30102_ADDRESS);
+    Wire.write(MAX30102_REG_FIFO_DATA);
+    Wire.endTransmission(false);
+    uint8_t bytes = Wire.requestFrom((uint8_t)MAX30102_ADDRESS, want);
+    if (bytes != want) {
+      Serial.printf("[PPG] Short FIFO read (%u of %u bytes)\n", bytes, want);
+      _locked = false;
+      return;
+    }
+
+    for (uint8_t i = 0; i < chunk; i++) {
+      PpgSample sample;
+      sample.red = readChannel();
+      sample.ir = readChannel();
+      sample.timestampUs = _nextUs;
+      _fracUs += _stepUs;
+      uint32_t whole = (uint32_t)_fracUs;
+      _nextUs += whole;
+      _fracUs -= whole;
+      _ring.push(sample);
+    }
+    remaining -= chunk;
+  }
+
+  _stats.samples += count;
+  _stats.bursts++;
+  if (count > _stats.maxBurst) _stats.maxBurst = count;
+}
+
+uint8_t PpgAcquisition::readRegister(uint8_t reg) {
+  Wire.beginTransmission(MAX30102_ADDRESS);
+  Wire.write(reg);
+  Wire.endTransmission(false);
+  Wire.requestFrom((uint8_t)MAX30102_ADDRESS, (uint8_t)1);
+  return Wire.available() ? Wire.read() : 0;
+}
+
+PpgStats PpgAcquisition::getStats() const {
+  PpgStats stats = _stats;
+  stats.ringDrops = _ring.dropped();
+  return stats;
+}
+
+#endif
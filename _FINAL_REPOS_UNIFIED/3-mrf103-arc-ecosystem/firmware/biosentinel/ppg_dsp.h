@@ -0,0 +1,348 @@
+/**
+ * BioSentinel PPG DSP
+ * Streaming heart rate, SpO2 and signal quality from fixed-rate red / IR samples
+ *
+ * Per sample and channel, in 32-bit integer arithmetic:
+ *   1. DC removal - one-pole tracker, corner ~0.5 Hz (the bandpass high side)
+ *   2. Low-pass   - 15-tap symmetric FIR, -3 dB at ~5 Hz (the low side)
+ *   3. Extremes   - filtered maximum / minimum since the last beat
+ * and on the inverted IR signal (systole = maximum):
+ *   4. Peaks      - adaptive threshold at half the tracked pulse amplitude,
+ *                   300 ms refractory; a peak earlier than 0.6 of the usual
+ *                   interval must be near full amplitude, which rejects the
+ *                   dicrotic wave at low heart rates
+ *
+ * Floating point is only used once per beat and by the getters:
+ * HR is 60000 / median of the last PPG_DSP_RR_HISTORY intervals, SpO2 the
+ * ratio of ratios R = (AC/DC red) / (AC/DC IR) through the calibration line
+ * the firmware already used (110 - 25 R), smoothed per beat. AC is each
+ * beat's peak-to-trough, so slow baseline wander (which moves both channels
+ * alike and drags R towards 1) stays out of it.
+ *
+ * quality() is a 0-100 signal-quality index: finger present and not
+ * saturated, a beat seen recently, perfusion index above the noise, and the
+ * recent beats consistent in interval, amplitude and red / IR ratio (motion
+ * shows up as irregular, uneven "beats" that move both channels alike). HR
+ * and SpO2 are only meaningful above PPG_DSP_MIN_QUALITY.
+ *
+ * The FIR is designed for PPG_DSP_RATE; the acquisition must run at it.
+ * Pure C++ so tools/ppg_replay.cpp replays recorded traces through it.
+ */
+
+#ifndef PPG_DSP_H
+#define PPG_DSP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#define PPG_DSP_RATE 100                // Hz - the FIR taps below assume this
+
+#ifndef PPG_DSP_DC_SHIFT
+  #define PPG_DSP_DC_SHIFT 5            // DC tracker: fc = rate / (2 pi 2^shift) ~ 0.5 Hz
+#endif
+
+#ifndef PPG_DSP_AC_SHIFT
+  #define PPG_DSP_AC_SHIFT 8            // |AC| average over 2^shift samples (perfusion index)
+#endif
+
+#ifndef PPG_DSP_FINGER_DC
+  #define PPG_DSP_FINGER_DC 50000       // IR DC below this: no finger on the sensor
+#endif
+
+#ifndef PPG_DSP_SATURATION_DC
+  #define PPG_DSP_SATURATION_DC 250000  // ... above this: ADC close to full scale
+#endif
+
+#ifndef PPG_DSP_MIN_AMPLITUDE
+  #define PPG_DSP_MIN_AMPLITUDE 20      // Smallest pulse (counts) the detector accepts
+#endif
+
+#ifndef PPG_DSP_REFRACTORY_MS
+  #define PPG_DSP_REFRACTORY_MS 300     // 200 bpm
+#endif
+
+#ifndef PPG_DSP_MAX_RR_MS
+  #define PPG_DSP_MAX_RR_MS 2000        // 30 bpm
+#endif
+
+#ifndef PPG_DSP_RR_HISTORY
+  #define PPG_DSP_RR_HISTORY 5          // Beats behind HR (median) and the consistency scores
+#endif
+
+#ifndef PPG_DSP_MIN_QUALITY
+  #define PPG_DSP_MIN_QUALITY 50
+#endif
+
+#define PPG_DSP_FIR_TAPS 15
+
+// Q10 low-pass taps (sum 1024), Hamming-windowed sinc, fc 5 Hz at 100 Hz
+static constexpr int16_t PPG_DSP_FIR[PPG_DSP_FIR_TAPS] = {
+  4, 10, 25, 51, 84, 118, 144, 152, 144, 118, 84, 51, 25, 10, 4
+};
+
+// =============================================================================
+// PPG DSP
+// =============================================================================
+
+class PpgDsp {
+public:
+  PpgDsp() { reset(); }
+
+  void reset();
+
+  /**
+   * Feed one sample
+   * @return true if it completed a beat (lastBeatUs() / lastRrMs() updated)
+   */
+  bool update(uint32_t red, uint32_t ir, uint32_t timestampUs);
+
+  bool fingerDetected() const { return _ir.dc >> 8 > PPG_DSP_FINGER_DC; }
+  float heartRate() const;              // bpm, 0 until PPG_DSP_RR_HISTORY intervals
+  float spo2() const { return _spo2; }  // %, 0 until the first interval
+  float perfusionIndex() const;         // AC/DC IR in %
+  uint8_t quality() const;              // 0-100
+
+  uint32_t lastBeatUs() const { return _lastBeatUs; }
+  uint16_t lastRrMs() const { return _lastRrMs; } // 0 after a gap
+  uint32_t beats() const { return _beats; }
+
+private:
+  struct Channel {
+    int32_t dc;                         // Q8 counts
+    int32_t taps[PPG_DSP_FIR_TAPS];     // Delay line, AC counts
+    int32_t acMean;                     // Q8 mean |filtered AC|
+    int32_t hi;                         // Filtered extremes since the last beat
+    int32_t lo;
+  };
+
+  Channel _ir;
+  Channel _red;
+  uint8_t _pos;                         // Delay line write index (shared)
+  uint32_t _samples;
+
+  // Peak detector (inverted filtered IR)
+  int32_t _envelope;                    // Tracked pulse amplitude, Q8
+  bool _above;
+  int32_t _peak;
+  uint32_t _peakUs;
+  uint32_t _sampleUs;                   // Last sample time, for recency
+  uint32_t _lastBeatUs;
+  bool _haveBeat;
+
+  uint16_t _rr[PPG_DSP_RR_HISTORY];
+  int32_t _amp[PPG_DSP_RR_HISTORY];     // IR peak-to-trough per interval
+  float _ratio[PPG_DSP_RR_HISTORY];     // Ratio of ratios per interval
+  uint8_t _rrCount;
+  uint8_t _rrHead;
+  uint16_t _lastRrMs;
+  uint32_t _beats;
+  float _spo2;
+
+  int32_t filter(Channel& ch, uint32_t x);
+  void beat(uint32_t timestampUs);
+  uint16_t medianRr() const;
+
+  template <typename T>
+  static T median(const T* values, uint8_t count);
+
+  // Mean absolute deviation from the median, as a fraction of it
+  template <typename T>
+  static float spread(const T* values, uint8_t count);
+
+  // 1 up to good, falling linearly to 0 at bad
+  static float score(float x, float good, float bad) {
+    return x <= good ? 1.0f : x >= bad ? 0.0f : (bad - x) / (bad - good);
+  }
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+inline void PpgDsp::reset() {
+  memset(&_ir, 0, sizeof(_ir));
+  memset(&_red, 0, sizeof(_red));
+  _pos = 0;
+  _samples = 0;
+  _envelope = 0;
+  _above = false;
+  _peak = 0;
+  _peakUs = 0;
+  _sampleUs = 0;
+  _lastBeatUs = 0;
+  _haveBeat = false;
+  memset(_rr, 0, sizeof(_rr));
+  memset(_amp, 0, sizeof(_amp));
+  memset(_ratio, 0, sizeof(_ratio));
+  _rrCount = 0;
+  _rrHead = 0;
+  _lastRrMs = 0;
+  _beats = 0;
+  _spo2 = 0;
+}
+
+inline int32_t PpgDsp::filter(Channel& ch, uint32_t x) {
+  int32_t q = (int32_t)(x << 8);
+  if (_samples == 0) ch.dc = q;         // Start on the signal, not from zero
+  ch.dc += (q - ch.dc) >> PPG_DSP_DC_SHIFT;
+
+  // |AC| is clamped so 15 Q10 products stay inside 32 bits
+  int32_t ac = (q - ch.dc) >> 8;
+  if (ac > (1 << 19)) ac = 1 << 19;
+  if (ac < -(1 << 19)) ac = -(1 << 19);
+  ch.taps[_pos] = ac;
+
+  int32_t acc = 0;
+  uint8_t i = _pos;
+  for (uint8_t k = 0; k < PPG_DSP_FIR_TAPS; k++) {
+    acc += PPG_DSP_FIR[k] * ch.taps[i];
+    i = i ? i - 1 : PPG_DSP_FIR_TAPS - 1;
+  }
+  int32_t y = acc >> 10;
+
+  int32_t mag = (y < 0 ? -y : y) << 8;
+  ch.acMean += (mag - ch.acMean) >> PPG_DSP_AC_SHIFT;
+  if (y > ch.hi) ch.hi = y;
+  if (y < ch.lo) ch.lo = y;
+  return y;
+}
+
+inline bool PpgDsp::update(uint32_t red, uint32_t ir, uint32_t timestampUs) {
+  int32_t yIr = filter(_ir, ir);
+  filter(_red, red);
+  _pos = (_pos + 1) % PPG_DSP_FIR_TAPS;
+  _samples++;
+  _sampleUs = timestampUs;
+
+  if (!fingerDetected()) {
+    _above = false;
+    _envelope = 0;
+    _haveBeat = false;
+    _rrCount = 0;
+    return false;
+  }
+  if (_samples < PPG_DSP_FIR_TAPS) return false; // Delay line still filling
+
+  // Blood volume rises -> IR falls; invert so systole is a maximum
+  int32_t y = -yIr;
+  _envelope -= _envelope >> 9;          // Lets the threshold follow a weakening pulse
+  int32_t threshold = _envelope >> 9;   // Half the envelope
+  if (threshold < PPG_DSP_MIN_AMPLITUDE) threshold = PPG_DSP_MIN_AMPLITUDE;
+
+  if (y > threshold) {
+    if (!_above || y > _peak) {
+      _peak = y;
+      _peakUs = timestampUs;
+    }
+    _above = true;
+    return false;
+  }
+  if (!_above) return false;
+  _above = false;
+
+  // Fell back under: the maximum of the excursion is a beat candidate
+  if (_haveBeat) {
+    uint32_t sinceUs = _peakUs - _lastBeatUs;
+    if (sinceUs < PPG_DSP_REFRACTORY_MS * 1000UL) return false;
+    bool early = _rrCount >= 2 && sinceUs < medianRr() * 600UL;
+    if (early && (_peak << 8) < _envelope / 4 * 3) return false;
+  }
+  _envelope += ((_peak << 8) - _envelope) >> 2;
+  beat(_peakUs - (PPG_DSP_FIR_TAPS / 2) * (1000000UL / PPG_DSP_RATE)); // FIR group delay
+  return true;
+}
+
+inline void PpgDsp::beat(uint32_t timestampUs) {
+  uint32_t rrMs = (timestampUs - _lastBeatUs) / 1000;
+  bool first = !_haveBeat;
+  int32_t ampIr = _ir.hi - _ir.lo;
+  int32_t ampRed = _red.hi - _red.lo;
+  _ir.hi = _ir.lo = _red.hi = _red.lo = 0;
+
+  _haveBeat = true;
+  _lastBeatUs = timestampUs;
+  _beats++;
+  if (first || rrMs > PPG_DSP_MAX_RR_MS) {
+    _lastRrMs = 0;                      // Gap: restart the interval chain
+    return;
+  }
+
+  // Ratio of ratios over this interval
+  float r = ampIr > 0 ? ((float)ampRed / _red.dc) / ((float)ampIr / _ir.dc) : 0;
+
+  _lastRrMs = (uint16_t)rrMs;
+  _rr[_rrHead] = _lastRrMs;
+  _amp[_rrHead] = ampIr;
+  _ratio[_rrHead] = r;
+  _rrHead = (_rrHead + 1) % PPG_DSP_RR_HISTORY;
+  if (_rrCount < PPG_DSP_RR_HISTORY) _rrCount++;
+
+  // SpO2, smoothed over a few beats
+  if (r <= 0) return;
+  float spo2 = 110.0f - 25.0f * r;
+  if (spo2 > 100.0f) spo2 = 100.0f;
+  if (spo2 < 50.0f) return;             // Not a physiological reading - skip it
+  _spo2 = _spo2 == 0 ? spo2 : _spo2 + (spo2 - _spo2) * 0.25f;
+}
+
+template <typename T>
+inline T PpgDsp::median(const T* values, uint8_t count) {
+  T sorted[PPG_DSP_RR_HISTORY];
+  for (uint8_t i = 0; i < count; i++) {
+    T v = values[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  return sorted[count / 2];
+}
+
+template <typename T>
+inline float PpgDsp::spread(const T* values, uint8_t count) {
+  T mid = median(values, count);
+  if (mid <= 0) return 1.0f;
+  float deviation = 0;
+  for (uint8_t i = 0; i < count; i++) deviation += values[i] > mid ? values[i] - mid : mid - values[i];
+  return deviation / count / mid;
+}
+
+inline uint16_t PpgDsp::medianRr() const {
+  return median(_rr, _rrCount);
+}
+
+inline float PpgDsp::heartRate() const {
+  if (_rrCount < PPG_DSP_RR_HISTORY) return 0;
+  return 60000.0f / medianRr();
+}
+
+inline float PpgDsp::perfusionIndex() const {
+  return _ir.dc ? 100.0f * _ir.acMean / _ir.dc : 0;
+}
+
+inline uint8_t PpgDsp::quality() const {
+  if (!fingerDetected() || _ir.dc >> 8 > PPG_DSP_SATURATION_DC) return 0;
+  if (!_haveBeat || _sampleUs - _lastBeatUs > PPG_DSP_MAX_RR_MS * 1000UL) return 0;
+  if (_rrCount < 2) return 0;
+
+  // Perfusion: mean |AC| is ~0.3x the pulse amplitude; below 0.05 % is noise
+  float pi = perfusionIndex();
+  float perfusion = 1.0f - score(pi, 0.05f, 0.2f);
+
+  // Consistency: mean deviation from the median of the recent beats, full
+  // score up to `good`, none from `bad`
+  float consistency = score(spread(_rr, _rrCount), 0.1f, 0.4f) *
+                      score(spread(_amp, _rrCount), 0.1f, 0.5f) *
+                      score(spread(_ratio, _rrCount), 0.05f, 0.2f);
+
+  return (uint8_t)(100.0f * perfusion * consistency + 0.5f);
+}
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * BioSentinel Sensor Hub
+ * One task owns the I2C bus and schedules every sensor on it
+ *
+ * PPG (MAX30102, 100 Hz), IMU (MPU6050, 50-200 Hz) and skin temperature
+ * (MLX90614, 1 Hz) share one bus. Rather than each driver locking it, a
+ * single "sensors" task is the only code that touches Wire after setup():
+ * sensor interrupts just record the time and notify it, and it services
+ * whatever is due in turn, so bursts queue behind each other instead of
+ * colliding. The order is by FIFO headroom, tightest first.
+ *
+ * Bus budget at 400 kHz (~25 us per byte with addressing):
+ *   PPG   17 samples x 6 B + registers   ~2.8 ms every 170 ms
+ *   IMU   20 samples x 12 B + count      ~6.3 ms every 200 ms (100 Hz)
+ *   Temp  3 B at 100 kHz                 ~0.7 ms every 1 s
+ * Worst case all three line up: ~10 ms of bus time, against 150 ms of
+ * headroom left in the PPG FIFO (32 - 17 samples) and 700+ ms in the
+ * IMU's 1 KB FIFO. Roughly 5 % bus load.
+ *
+ * loop() collects time-aligned frames with nextFrame() (frame_aligner.h).
+ */
+
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include <Arduino.h>
+#include "ppg_acquisition.h"
+#include "imu_acquisition.h"
+#include "skin_temperature.h"
+#include "frame_aligner.h"
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef SENSOR_TASK_PRIORITY
+  #define SENSOR_TASK_PRIORITY 5        // Above loop() (1) and the WiFi stack's app-side work
+#endif
+
+#ifndef SENSOR_TASK_STACK
+  #define SENSOR_TASK_STACK 4096
+#endif
+
+#ifndef SENSOR_TASK_CORE
+  #define SENSOR_TASK_CORE 1            // Same core as loop(); WiFi runs on core 0
+#endif
+
+#ifndef SENSOR_POLL_MS
+  #define SENSOR_POLL_MS 50             // Wake without an interrupt (temperature, missed edges)
+#endif
+
+// =============================================================================
+// Sensor Hub
+// =============================================================================
+
+class SensorHub {
+public:
+  /**
+   * Start the bus task (after each sensor's begin())
+   * @param ppg  nullptr if absent - no frames, the others still run
+   * @param imu  nullptr if absent
+   * @param temp nullptr if absent
+   */
+  bool begin(PpgAcquisition* ppg, ImuAcquisition* imu, SkinTemperature* temp);
+
+  // Consumer side (loop task): next aligned frame, oldest first
+  bool nextFrame(SensorFrame& frame);
+
+  const AlignerStats& getAlignerStats() const { return _aligner.getStats(); }
+  uint32_t maxServiceUs() const { return _maxServiceUs; }
+
+private:
+  PpgAcquisition* _ppg = nullptr;
+  ImuAcquisition* _imu = nullptr;
+  SkinTemperature* _temp = nullptr;
+  TaskHandle_t _task = nullptr;
+  FrameAligner _aligner;                // Loop task only
+  volatile uint32_t _maxServiceUs = 0;
+
+  static void taskEntry(void* arg);
+  void run();
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+bool SensorHub::begin(PpgAcquisition* ppg, ImuAcquisition* imu, SkinTemperature* temp) {
+  _ppg = ppg;
+  _imu = imu;
+  _temp = temp;
+  _aligner.begin(imu != nullptr);
+
+  if (xTaskCreatePinnedToCore(taskEntry, "sensors", SENSOR_TASK_STACK, this, SENSOR_TASK_PRIORITY, &_task,
+                              SENSOR_TASK_CORE) != pdPASS) {
+    Serial.println("[SENSORS] Failed to start task");
+    return false;
+  }
+  if (_ppg) _ppg->setNotifyTask(_task);
+  if (_imu) _imu->setNotifyTask(_task);
+
+  Serial.printf("[SENSORS] Bus task on core %d:%s%s%s\n", SENSOR_TASK_CORE, _ppg ? " PPG" : "",
+                _imu ? " IMU" : "", _temp ? " skin temperature" : "");
+  return true;
+}
+
+void SensorHub::taskEntry(void* arg) {
+  static_cast<SensorHub*>(arg)->run();
+}
+
+void SensorHub::run() {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SENSOR_POLL_MS));
+
+    uint32_t startUs = micros();
+    if (_ppg) _ppg->service();
+    if (_imu) _imu->service();
+    if (_temp) _temp->service(startUs);
+
+    uint32_t elapsed = micros() - startUs;
+    if (elapsed > _maxServiceUs) _maxServiceUs = elapsed;
+  }
+}
+
+bool SensorHub::nextFrame(SensorFrame& frame) {
+  // IMU first, so every PPG sample queued below can find its bracket
+  if (_imu) {
+    ImuSample imu;
+    while (_imu->pop(imu)) _aligner.addImu(imu.index, imu.timestampUs, imu.accel, imu.gyro);
+  }
+  if (_temp) {
+    float celsius;
+    uint32_t timestampUs;
+    if (_temp->read(celsius, timestampUs)) _aligner.setTemperature(celsius, timestampUs);
+  }
+
+  if (!_ppg) return false;
+  PpgSample sample;
+  while (!_aligner.ppgFull() && _ppg->pop(sample)) {
+    _aligner.addPpg(sample.index, sample.timestampUs, sample.red, sample.ir);
+  }
+  return _aligner.pop(frame, micros());
+}
+
+#endif
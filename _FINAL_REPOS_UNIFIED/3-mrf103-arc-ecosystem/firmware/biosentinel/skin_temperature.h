@@ -0,0 +1,161 @@
+/**
+ * BioSentinel Skin Temperature
+ * MLX90614 infrared thermometer read once per second over SMBus
+ *
+ * The MLX90614 is an SMBus device limited to 100 kHz, sharing the bus with
+ * the 400 kHz PPG and IMU. The sensor hub task owns the bus, so service()
+ * drops the clock for the one 6-byte object-temperature read (~0.7 ms) and
+ * restores it; nothing else can be mid-transfer at that point. Every read
+ * is checked with the SMBus packet error code (CRC-8 over the whole
+ * transaction), so a corrupted read never reaches sensor_data.
+ */
+
+#ifndef SKIN_TEMPERATURE_H
+#define SKIN_TEMPERATURE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef SKIN_TEMP_INTERVAL_US
+  #define SKIN_TEMP_INTERVAL_US 1000000UL // 1 Hz
+#endif
+
+#ifndef SKIN_TEMP_BUS_HZ
+  #define SKIN_TEMP_BUS_HZ 100000       // SMBus maximum
+#endif
+
+#ifndef SENSOR_BUS_HZ
+  #define SENSOR_BUS_HZ 400000          // Clock the rest of the bus runs at
+#endif
+
+#define MLX90614_ADDRESS 0x5A
+#define MLX90614_REG_TOBJ1 0x07
+#define MLX90614_MIN_C 15.0f            // Readings outside this are not skin
+#define MLX90614_MAX_C 45.0f
+
+struct SkinTemperatureStats {
+  uint32_t reads;
+  uint32_t errors;                      // NACK, short read, bad PEC or error flag
+  uint32_t outOfRange;
+};
+
+// =============================================================================
+// Skin Temperature
+// =============================================================================
+
+class SkinTemperature {
+public:
+  // @return false if the sensor does not answer
+  bool begin();
+
+  // Bus side (sensor hub task): reads when a new value is due
+  void service(uint32_t nowUs);
+
+  /**
+   * Latest valid reading (any task)
+   * @return false until the first valid read
+   */
+  bool read(float& celsius, uint32_t& timestampUs);
+
+  const SkinTemperatureStats& getStats() const { return _stats; }
+
+private:
+  bool _present = false;
+  uint32_t _lastUs = 0;
+  bool _started = false;
+
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  float _celsius = NAN;
+  uint32_t _timestampUs = 0;
+  bool _valid = false;
+
+  SkinTemperatureStats _stats = {};
+
+  bool readObject(float& celsius);
+  static uint8_t crc8(const uint8_t* data, uint8_t length);
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+bool SkinTemperature::begin() {
+  Wire.setClock(SKIN_TEMP_BUS_HZ);
+  Wire.beginTransmission(MLX90614_ADDRESS);
+  _present = Wire.endTransmission() == 0;
+  Wire.setClock(SENSOR_BUS_HZ);
+  if (_present) Serial.println("[TEMP] MLX90614 skin temperature, 1 Hz");
+  return _present;
+}
+
+void SkinTemperature::service(uint32_t nowUs) {
+  if (!_present) return;
+  if (_started && nowUs - _lastUs < SKIN_TEMP_INTERVAL_US) return;
+  _started = true;
+  _lastUs = nowUs;
+
+  float celsius;
+  _stats.reads++;
+  if (!readObject(celsius)) {
+    _stats.errors++;
+    return;
+  }
+  if (celsius < MLX90614_MIN_C || celsius > MLX90614_MAX_C) {
+    _stats.outOfRange++;
+    return;
+  }
+
+  portENTER_CRITICAL(&_mux);
+  _celsius = celsius;
+  _timestampUs = nowUs;
+  _valid = true;
+  portEXIT_CRITICAL(&_mux);
+}
+
+bool SkinTemperature::read(float& celsius, uint32_t& timestampUs) {
+  portENTER_CRITICAL(&_mux);
+  bool valid = _valid;
+  celsius = _celsius;
+  timestampUs = _timestampUs;
+  portEXIT_CRITICAL(&_mux);
+  return valid;
+}
+
+bool SkinTemperature::readObject(float& celsius) {
+  Wire.setClock(SKIN_TEMP_BUS_HZ);
+  Wire.beginTransmission(MLX90614_ADDRESS);
+  Wire.write(MLX90614_REG_TOBJ1);
+  bool ok = Wire.endTransmission(false) == 0 &&
+            Wire.requestFrom((uint8_t)MLX90614_ADDRESS, (uint8_t)3) == 3;
+  uint8_t packet[6] = {MLX90614_ADDRESS << 1, MLX90614_REG_TOBJ1, (MLX90614_ADDRESS << 1) | 1, 0, 0, 0};
+  if (ok) {
+    packet[3] = Wire.read();            // LSB
+    packet[4] = Wire.read();            // MSB
+    packet[5] = Wire.read();            // PEC
+  }
+  Wire.setClock(SENSOR_BUS_HZ);
+  if (!ok || crc8(packet, 5) != packet[5]) return false;
+
+  uint16_t raw = (uint16_t)packet[4] << 8 | packet[3];
+  if (raw & 0x8000) return false;       // Sensor error flag
+  celsius = raw * 0.02f - 273.15f;
+  return true;
+}
+
+uint8_t SkinTemperature::crc8(const uint8_t* data, uint8_t length) {
+  // SMBus PEC: x^8 + x^2 + x + 1
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? (uint8_t)(crc << 1) ^ 0x07 : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+#endif
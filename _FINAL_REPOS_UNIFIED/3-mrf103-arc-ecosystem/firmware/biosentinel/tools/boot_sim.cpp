@@ -0,0 +1,184 @@
+/**
+ * BioSentinel boot simulation (host)
+ * Runs the real firmware setup() and loop() (main.cpp) on the virtual clock
+ * against the MAX30102 and MPU6050 FIFO models and the WiFi / Preferences /
+ * WebSocketsClient stand-ins in host/, and reports the boot milestones the
+ * device sends in device_info: firstSampleMs, wifiMs and onlineMs.
+ *
+ *   g++ -std=c++17 -O2 -Ihost -I.. boot_sim.cpp -o boot_sim
+ *
+ *   ./boot_sim [-v]                     (-v: firmware serial log)
+ *
+ * The sensor hub task is played from the clock: it wakes 20-400 us after a
+ * notification or on the 50 ms poll and services every sensor, whenever
+ * virtual time passes - including while loop() is blocked in a WebSocket
+ * handshake, as it would on the ESP32. loop() itself runs once per ms.
+ * WiFi joins 2 s after WiFi.begin() once the AP is up; the WebSocket
+ * handshake (DNS + TCP + TLS + upgrade) blocks loop() for 1.2 s. No
+ * MLX90614 is on the bus. Each case runs in its own process, so every
+ * case starts from a fresh set of firmware globals.
+ *
+ * Cases: AP present; AP up 20 s after boot; no MAX30102 (degraded mode);
+ * WebSocket server down. Sampling must not wait for the network, the
+ * network must not wait for the sensors, and no case may lose a sample.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "MPU6050.h"
+#include "main.cpp"
+
+#define SIM_POLL_US 50000               // SENSOR_POLL_MS
+#define SIM_LOOP_US 1000                // One loop() pass
+#define SIM_RUN_US 90000000ULL          // Long enough for two WiFi timeouts
+
+struct BootCase {
+  const char* name;
+  uint64_t apUpUs;
+  bool ppgPresent;
+  bool serverUp;
+};
+
+static std::mt19937 hubRng(5);
+static uint64_t hubPollUs = 0;
+static uint64_t hubWakeUs = UINT64_MAX;
+static bool inHub = false;
+
+static void advanceSensors(uint64_t toUs) {
+  for (;;) {
+    uint64_t next = std::min(hostMax30102.nextSampleUs(), hostMpu6050.nextSampleUs());
+    if (next > toUs) break;
+    hostMax30102.advanceTo(next);
+    hostMpu6050.advanceTo(next);
+  }
+  hostMax30102.advanceTo(toUs);
+  hostMpu6050.advanceTo(toUs);
+}
+
+// SensorHub::run() between its ulTaskNotifyTake() calls
+static void runHub() {
+  inHub = true;
+  hostsim::notifications = 0;
+  hubWakeUs = UINT64_MAX;
+  uint32_t startUs = micros();
+  if (ppgPresent) ppg.service();
+  if (imuPresent) imu.service();
+  if (tempPresent) skinTemp.service(startUs);
+  hubPollUs = hostsim::nowUs + SIM_POLL_US;
+  inHub = false;
+}
+
+// Virtual time passes: sensors sample, and the hub task preempts whatever is running
+static void advanceBoard(uint64_t toUs) {
+  if (inHub || !sensorsRunning) {
+    advanceSensors(toUs);
+    return;
+  }
+  std::uniform_int_distribution<uint32_t> wakeLatency(20, 400);
+  for (;;) {
+    if (hostsim::notifications && hubWakeUs == UINT64_MAX) {
+      hubWakeUs = hostsim::notifiedUs + wakeLatency(hubRng);
+    }
+    uint64_t due = std::min(hubWakeUs, hubPollUs);
+    uint64_t next = std::min({due, hostMax30102.nextSampleUs(), hostMpu6050.nextSampleUs()});
+    if (next > toUs) break;
+    advanceSensors(next);
+    if (hostsim::nowUs >= due && !(hostsim::notifications && hubWakeUs == UINT64_MAX)) runHub();
+  }
+  advanceSensors(toUs);
+}
+
+static void gravity(uint64_t, int16_t out[6]) {
+  for (int axis = 0; axis < 6; axis++) out[axis] = 0;
+  out[2] = IMU_ACCEL_LSB_PER_G;
+}
+
+static bool runCase(const BootCase& bc, bool verbose) {
+  hostMax30102.present = bc.ppgPresent;
+  hostMpu6050.motion = gravity;
+  Wire.attach(MPU6050_ADDRESS, &hostMpu6050);
+  WiFi.apUpUs = bc.apUpUs;
+  webSocket.serverUp = bc.serverUp;
+  hostNvs["wifi"]["ssid"] = "ward-3";
+  hostNvs["wifi"]["password"] = "sensors";
+  hostsim::advanceHook = advanceBoard;
+  Serial.quiet = !verbose;
+
+  setup();
+  while (hostsim::nowUs < SIM_RUN_US) {
+    loop();
+    hostsim::advance(SIM_LOOP_US);
+  }
+
+  // What the server was told, from the first device_info
+  long sentFirstSample = -1, sentWifi = -1, sentOnline = -1;
+  for (const std::string& message : webSocket.sent) {
+    StaticJsonDocument<512> info;
+    if (deserializeJson(info, message.c_str()) || strcmp(info["type"] | "", "device_info") != 0) continue;
+    sentFirstSample = info["boot"]["firstSampleMs"] | -1L;
+    sentWifi = info["boot"]["wifiMs"] | -1L;
+    sentOnline = info["boot"]["onlineMs"] | -1L;
+    break;
+  }
+
+  PpgStats ppgStats = ppg.getStats();
+  ImuStats imuStats = imu.getStats();
+  uint32_t wifiMs = wifiManager.firstConnectMs();
+  printf("\n%s\n", bc.name);
+  printf("  firstSampleMs %lu, wifiMs %u, onlineMs %lu%s\n", firstSampleMs, wifiMs, onlineMs,
+         isDegraded() ? " (degraded)" : "");
+  if (sentOnline >= 0) {
+    printf("  device_info boot: firstSampleMs %ld, wifiMs %ld, onlineMs %ld\n", sentFirstSample, sentWifi,
+           sentOnline);
+  } else {
+    printf("  device_info never sent\n");
+  }
+  printf("  WiFi attempts %u, WebSocket attempts %u, %zu messages sent\n", WiFi.attempts, webSocket.attempts,
+         webSocket.sent.size());
+  printf("  PPG: %u samples, %u FIFO overflows, %u ring drops; IMU: %u samples, %u FIFO overflows, %u ring drops\n",
+         ppgStats.samples, ppgStats.fifoOverflows, ppgStats.ringDrops, imuStats.samples, imuStats.fifoOverflows,
+         imuStats.ringDrops);
+
+  // Sampling never waits for the network, and nothing is lost while loop() blocks
+  bool ok = ppgStats.fifoOverflows == 0 && ppgStats.ringDrops == 0 && imuStats.fifoOverflows == 0 &&
+            imuStats.ringDrops == 0;
+  if (bc.ppgPresent) ok &= firstSampleMs > 0 && (wifiMs == 0 || firstSampleMs < wifiMs);
+  else ok &= firstSampleMs == 0 && isDegraded();
+  if (bc.serverUp) {
+    ok &= onlineMs > 0 && wifiMs > 0 && onlineMs >= wifiMs && (uint64_t)wifiMs * 1000 >= bc.apUpUs;
+    ok &= sentOnline == (long)onlineMs && sentWifi == (long)wifiMs && sentFirstSample == (long)firstSampleMs;
+  } else {
+    ok &= onlineMs == 0 && wifiMs > 0 && webSocket.attempts > 1;
+  }
+  printf("  %s\n", ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+  const BootCase cases[] = {
+      {"AP present", 0, true, true},
+      {"AP up 20 s after boot", 20000000, true, true},
+      {"No MAX30102 (degraded)", 0, false, true},
+      {"WebSocket server down", 0, true, false},
+  };
+
+  printf("Boot simulation: WiFi join %u ms, WebSocket handshake %u ms, %llu s per case\n", WiFi.joinMs,
+         webSocket.handshakeMs, SIM_RUN_US / 1000000);
+  bool ok = true;
+  for (const BootCase& bc : cases) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+      bool passed = runCase(bc, verbose);
+      fflush(stdout);
+      _exit(passed ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ok &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+/**
+ * BioSentinel frame alignment simulation (host)
+ * Runs the firmware SensorHub - PpgAcquisition, ImuAcquisition and the
+ * FrameAligner behind nextFrame() - against the MAX30102 and MPU6050 FIFO
+ * models (host/MAX30105.h, host/MPU6050.h) on one virtual clock, each
+ * sensor on its own skewed oscillator, and scores the motion data of every
+ * frame against the true motion at the time the PPG sample was written.
+ *
+ *   g++ -std=c++17 -O2 -Ihost -I.. frame_align_sim.cpp -o frame_align_sim
+ *
+ *   ./frame_align_sim [seconds per scenario]
+ *
+ * The MPU6050 model samples a known motion (sines on every axis), so the
+ * accel / gyro a frame should carry is known exactly; the PPG sample's true
+ * write time comes from the MAX30102 model. The sensor hub task and loop()
+ * are played as in ppg_fifo_sim.cpp: the task wakes 20-400 us after a
+ * notification or on the 50 ms poll and services both sensors, loop()
+ * drains nextFrame() every 10 ms.
+ *
+ * Scenarios: PPG and IMU clocks skewed against each other both ways; the
+ * sensor hub task stalled 2 s (both FIFOs overflow, so frames around the
+ * gap must go out without motion rather than with a wrong bracket); and
+ * the IMU polled without its INT pin, where samples are stamped up to a
+ * period late and the bound is loosened to match, with and without a stall.
+ *
+ * Motion error is the worst axis of a frame, in IMU counts, for frames the
+ * aligner marked motionValid; after warm-up every frame outside a
+ * disturbance must carry motion.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "MPU6050.h"
+#include "sensor_hub.h"
+
+#define SIM_POLL_US 50000               // SENSOR_POLL_MS
+#define SIM_CONSUMER_US 10000           // loop() drains every 10 ms
+#define SIM_WARMUP_US 2000000           // First anchored bursts lock both timelines
+#define SIM_RECOVERY_US 3000000         // Excluded from steady state after a disturbance
+#define SIM_IMU_RATE 100
+
+#define SIM_ACCEL_AMPLITUDE 3000        // Counts (~0.37 g at +-4 g)
+#define SIM_ACCEL_HZ 1.3                // Walking cadence
+#define SIM_GYRO_AMPLITUDE 2000         // Counts (~30 dps at +-500 dps)
+#define SIM_GYRO_HZ 0.7
+
+struct Scenario {
+  const char* name;
+  double ppgSkew;
+  double imuSkew;
+  bool imuInterrupt;                    // False: IMU polled
+  double stallAtS;                      // Sensor hub task blocked (0 = none)
+  double stallS;
+  int32_t bound;                        // Worst allowed motion error (counts)
+};
+
+// Known motion: what the MPU6050 measures at a true time
+static void motionAt(uint64_t timeUs, int16_t out[6]) {
+  double t = timeUs * 1e-6;
+  for (int axis = 0; axis < 3; axis++) {
+    out[axis] = (int16_t)lround(SIM_ACCEL_AMPLITUDE * sin(2 * M_PI * SIM_ACCEL_HZ * t + axis * 2.1));
+    out[3 + axis] = (int16_t)lround(SIM_GYRO_AMPLITUDE * sin(2 * M_PI * SIM_GYRO_HZ * t + axis * 1.7));
+  }
+}
+
+// Both sensors run on the virtual clock, samples landing in time order
+static void advanceSensors(uint64_t toUs) {
+  for (;;) {
+    uint64_t next = std::min(hostMax30102.nextSampleUs(), hostMpu6050.nextSampleUs());
+    if (next > toUs) break;
+    hostMax30102.advanceTo(next);
+    hostMpu6050.advanceTo(next);
+  }
+  hostMax30102.advanceTo(toUs);
+  hostMpu6050.advanceTo(toUs);
+}
+
+static uint32_t percentile(std::vector<int32_t> values, double p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  return (uint32_t)values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+static bool runScenario(const Scenario& sc, double seconds) {
+  hostsim::nowUs = 0;
+  hostsim::notifications = 0;
+  std::fill(std::begin(hostsim::isr), std::end(hostsim::isr), nullptr);
+  hostMax30102 = HostMax30102();
+  hostMax30102.skew = sc.ppgSkew;
+  hostMpu6050 = HostMpu6050();
+  hostMpu6050.skew = sc.imuSkew;
+  hostMpu6050.motion = motionAt;
+  hostsim::advanceHook = advanceSensors;
+  Serial.quiet = true;
+
+  MAX30105 sensor;
+  std::unique_ptr<PpgAcquisition> ppg(new PpgAcquisition());
+  std::unique_ptr<ImuAcquisition> imu(new ImuAcquisition());
+  std::unique_ptr<SensorHub> hub(new SensorHub());
+  sensor.begin(Wire, I2C_SPEED_FAST);
+  Wire.attach(MPU6050_ADDRESS, &hostMpu6050);
+  if (!ppg->begin(sensor, 19, 100, 0x1F)) return false;
+  if (!imu->begin(sc.imuInterrupt ? hostMpu6050.intPin : -1, SIM_IMU_RATE)) return false;
+  if (!hub->begin(ppg.get(), imu.get(), nullptr)) return false;
+
+  uint64_t endUs = (uint64_t)(seconds * 1e6);
+  uint64_t stallAtUs = (uint64_t)(sc.stallAtS * 1e6);
+  uint64_t stallUs = (uint64_t)(sc.stallS * 1e6);
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<uint32_t> wakeLatency(20, 400);
+
+  // loop(): every frame, motion checked against the truth at the PPG write time
+  std::vector<int32_t> errors;
+  uint32_t frames = 0, scored = 0, withoutMotion = 0, badMotion = 0, disturbedFrames = 0;
+  int32_t worst = 0;
+  auto consume = [&]() {
+    SensorFrame frame;
+    while (hub->nextFrame(frame)) {
+      frames++;
+      uint32_t k = frame.red | (frame.ir << 18);
+      uint64_t truthUs = hostMax30102.writeUs[k];
+      if (truthUs < SIM_WARMUP_US) continue;
+      bool disturbed = stallUs && truthUs + SIM_RECOVERY_US >= stallAtUs &&
+                       truthUs < stallAtUs + stallUs + SIM_RECOVERY_US;
+      if (!frame.motionValid) {
+        if (disturbed) disturbedFrames++;
+        else withoutMotion++;
+        continue;
+      }
+      int16_t truth[6];
+      motionAt(truthUs, truth);
+      int32_t error = 0;
+      for (int axis = 0; axis < 3; axis++) {
+        error = std::max(error, std::abs(frame.accel[axis] - truth[axis]));
+        error = std::max(error, std::abs(frame.gyro[axis] - truth[3 + axis]));
+      }
+      worst = std::max(worst, error);
+      if (error > sc.bound) badMotion++;
+      if (disturbed) continue;
+      errors.push_back(error);
+      scored++;
+    }
+  };
+
+  uint64_t nextConsumeUs = SIM_CONSUMER_US;
+  auto runUntil = [&](uint64_t toUs) {
+    while (nextConsumeUs <= toUs) {
+      hostsim::advance(nextConsumeUs > hostsim::nowUs ? nextConsumeUs - hostsim::nowUs : 0);
+      consume();
+      nextConsumeUs += SIM_CONSUMER_US;
+    }
+    if (toUs > hostsim::nowUs) hostsim::advance(toUs - hostsim::nowUs);
+  };
+
+  // Sensor hub task (SensorHub::run)
+  while (hostsim::nowUs < endUs) {
+    uint64_t deadline = hostsim::nowUs + SIM_POLL_US;
+    while (hostsim::notifications == 0 && hostsim::nowUs < deadline) {
+      uint64_t next = std::min(hostMax30102.nextSampleUs(), hostMpu6050.nextSampleUs());
+      runUntil(std::min(deadline, next));
+    }
+    if (hostsim::notifications) {
+      runUntil(std::max(hostsim::nowUs, hostsim::notifiedUs + wakeLatency(rng)));
+      hostsim::notifications = 0;
+    }
+    if (stallAtUs && hostsim::nowUs >= stallAtUs && hostsim::nowUs < stallAtUs + stallUs) {
+      runUntil(stallAtUs + stallUs);
+    }
+    ppg->service();
+    imu->service();
+  }
+  runUntil(hostsim::nowUs);
+
+  const AlignerStats& aligner = hub->getAlignerStats();
+  ImuStats imuStats = imu->getStats();
+  PpgStats ppgStats = ppg->getStats();
+
+  printf("\n%s\n", sc.name);
+  printf("  Rates: PPG true %.2f / tracked %.2f Hz, IMU true %.2f / tracked %.2f Hz\n",
+         1e6 / hostMax30102.periodUs(), ppgStats.rateHz, 1e6 / hostMpu6050.periodUs(), imuStats.rateHz);
+  printf("  Frames: %u, %u scored, %u without motion in steady state, %u around the disturbance\n", frames,
+         scored, withoutMotion, disturbedFrames);
+  printf("  Motion error, steady: p50 %u, p99 %u, max %u counts (bound %d)\n", percentile(errors, 0.5),
+         percentile(errors, 0.99), percentile(errors, 1.0), sc.bound);
+  printf("  Aligner: %u interpolated, %u timed out, %u IMU gaps, %u too old\n", aligner.interpolated,
+         aligner.timedOut, aligner.imuGaps, aligner.tooOld);
+  printf("  IMU: %u samples, %u FIFO overflows (%u samples dropped by the model), %u unanchored bursts\n",
+         imuStats.samples, imuStats.fifoOverflows, hostMpu6050.overflows, imuStats.unanchored);
+  if (stallUs) printf("  Worst motion error anywhere, stall included: %d counts\n", worst);
+
+  // Every frame with motion is right, and only a disturbance leaves frames without it
+  bool ok = badMotion == 0 && withoutMotion == 0 && scored > 0;
+  if (badMotion) printf("  %u frames carried motion past the bound\n", badMotion);
+  printf("  %s\n", ok ? "OK" : "FAIL");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 60;
+  if (seconds < 10) seconds = 10;
+
+  const Scenario scenarios[] = {
+      {"PPG 1 % fast, IMU 0.7 % slow", 0.01, -0.007, true, 0, 0, 6},
+      {"PPG 3 % slow, IMU 2 % fast", -0.03, 0.02, true, 0, 0, 6},
+      {"PPG 1 % fast, IMU 0.7 % slow, sensor hub task stalled 2 s", 0.01, -0.007, true, seconds / 2, 2, 6},
+      // Polled: a sample up to a period (10 ms) late is ~245 counts of this motion
+      {"PPG 1 % fast, IMU 0.7 % slow, IMU polled", 0.01, -0.007, false, 0, 0, 300},
+      {"PPG 1 % fast, IMU 0.7 % slow, IMU polled, sensor hub task stalled 2 s", 0.01, -0.007, false, seconds / 2,
+       2, 300},
+  };
+
+  printf("Frame alignment simulation: PPG 100 Hz, IMU %d Hz burst %d, %.0f s per scenario\n", SIM_IMU_RATE,
+         IMU_BURST_SAMPLES, seconds);
+  bool ok = true;
+  for (const Scenario& sc : scenarios) ok &= runScenario(sc, seconds);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+/**
+ * BioSentinel host stand-in: Arduino core
+ * Just enough of the ESP32 Arduino API for the acquisition drivers to run in
+ * the host simulations under tools/. Time is virtual (hostsim::nowUs), moved
+ * by the simulation and by bus transfers (Wire.h); attachInterrupt() and
+ * task notifications are recorded for the simulation to act on, and a
+ * created task is not run: the simulation plays it. Serial input comes
+ * from Serial.input.
+ */
+
+#ifndef BIOSENTINEL_HOST_ARDUINO_H
+#define BIOSENTINEL_HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+#define IRAM_ATTR
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define pdMS_TO_TICKS(ms) (ms)
+#define digitalPinToInterrupt(pin) (pin)
+#define portYIELD_FROM_ISR() do {} while (0)
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL(mux) do { (void)(mux); } while (0)
+#define portENTER_CRITICAL_ISR(mux) do { (void)(mux); } while (0)
+#define portEXIT_CRITICAL_ISR(mux) do { (void)(mux); } while (0)
+#define HOST_PINS 40
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : (x) > (hi) ? (hi) : (x))
+
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef int portMUX_TYPE;
+typedef void (*TaskFunction_t)(void*);
+
+namespace hostsim {
+  inline uint64_t nowUs = 0;                    // Virtual ESP32 clock
+  inline void (*isr[HOST_PINS])() = {};        // attachInterrupt() handler per pin
+  inline int (*pinLevel)(int pin) = nullptr;    // digitalRead() source (sensor model)
+  inline uint32_t notifications = 0;            // vTaskNotifyGiveFromISR() calls not yet taken
+  inline uint64_t notifiedUs = 0;               // ... and when the latest one was made
+
+  // Move virtual time forward; the simulation hooks this to run its sensor models
+  inline void (*advanceHook)(uint64_t toUs) = nullptr;
+  inline void advance(uint64_t us) {
+    if (advanceHook) advanceHook(nowUs + us);
+    else nowUs += us;
+  }
+
+  // A sensor model drives its INT line: run the handler if one is attached
+  inline void interrupt(int pin) {
+    if (pin >= 0 && pin < HOST_PINS && isr[pin]) isr[pin]();
+  }
+}
+
+inline unsigned long micros() { return (unsigned long)(uint32_t)hostsim::nowUs; }
+inline unsigned long millis() { return (unsigned long)(uint32_t)(hostsim::nowUs / 1000); }
+
+inline void delay(unsigned long ms) { hostsim::advance((uint64_t)ms * 1000); }
+
+inline void pinMode(int, int) {}
+inline int digitalRead(int pin) { return hostsim::pinLevel ? hostsim::pinLevel(pin) : HIGH; }
+inline void attachInterrupt(int pin, void (*handler)(), int) {
+  if (pin >= 0 && pin < HOST_PINS) hostsim::isr[pin] = handler;
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t* woken) {
+  hostsim::notifications++;
+  hostsim::notifiedUs = hostsim::nowUs;
+  if (woken) *woken = pdTRUE;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, uint32_t) {
+  uint32_t taken = hostsim::notifications;
+  hostsim::notifications = clear ? 0 : (taken ? taken - 1 : 0);
+  return taken;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, int, TaskHandle_t* task,
+                                          int) {
+  if (task) *task = (TaskHandle_t)1;
+  return pdPASS;
+}
+
+// Arduino String, on std::string
+class String {
+public:
+  String(const char* text = "") : _text(text ? text : "") {}
+  String(const std::string& text) : _text(text) {}
+  const char* c_str() const { return _text.c_str(); }
+  unsigned int length() const { return (unsigned int)_text.size(); }
+  String& operator+=(const char* text) { _text += text; return *this; }
+  String& operator+=(char c) { _text += c; return *this; }
+  bool operator==(const char* text) const { return _text == text; }
+
+private:
+  std::string _text;
+};
+
+struct HostSerial {
+  bool quiet = false;
+  std::string input;                    // What the simulation typed on the console
+  void begin(unsigned long) {}
+  int available() { return (int)input.size(); }
+  int read() {
+    if (input.empty()) return -1;
+    char c = input[0];
+    input.erase(0, 1);
+    return (unsigned char)c;
+  }
+  void printf(const char* format, ...) {
+    if (quiet) return;
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+  }
+  void println(const char* line = "") { if (!quiet) puts(line); }
+};
+inline HostSerial Serial;
+
+struct HostEsp {
+  uint32_t restarts = 0;
+  uint32_t getFreeHeap() { return 200000; }
+  void restart() { restarts++; }
+};
+inline HostEsp ESP;
+
+#endif // BIOSENTINEL_HOST_ARDUINO_H
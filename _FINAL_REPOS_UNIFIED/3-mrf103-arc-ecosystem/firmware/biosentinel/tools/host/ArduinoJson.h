@@ -0,0 +1,339 @@
+/**
+ * BioSentinel host stand-in: ArduinoJson 6 subset
+ * The document API main.cpp uses - StaticJsonDocument, nested objects and
+ * arrays, `variant | default`, serializeJson() and deserializeJson() - on a
+ * plain heap tree. Capacity is not enforced, and serialized numbers are not
+ * byte-for-byte what the library prints; the structure and values are.
+ */
+
+#ifndef BIOSENTINEL_HOST_ARDUINOJSON_H
+#define BIOSENTINEL_HOST_ARDUINOJSON_H
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Arduino.h"
+
+struct HostJsonNode {
+  enum Type { NUL, OBJECT, ARRAY, NUMBER, STRING, BOOLEAN } type = NUL;
+  double number = 0;
+  bool integer = false;
+  bool boolean = false;
+  std::string text;
+  std::vector<std::pair<std::string, std::unique_ptr<HostJsonNode>>> children;
+
+  HostJsonNode* member(const char* key, bool create) {
+    if (type != OBJECT) {
+      if (!create) return nullptr;
+      type = OBJECT;
+      children.clear();
+    }
+    for (auto& child : children) {
+      if (child.first == key) return child.second.get();
+    }
+    if (!create) return nullptr;
+    children.emplace_back(key, std::make_unique<HostJsonNode>());
+    return children.back().second.get();
+  }
+  HostJsonNode* append() {
+    children.emplace_back("", std::make_unique<HostJsonNode>());
+    return children.back().second.get();
+  }
+
+  void write(std::string& out) const {
+    char buffer[32];
+    switch (type) {
+      case NUL: out += "null"; break;
+      case BOOLEAN: out += boolean ? "true" : "false"; break;
+      case NUMBER:
+        if (!std::isfinite(number)) out += "null";
+        else {
+          snprintf(buffer, sizeof(buffer), integer ? "%.0f" : "%.9g", number);
+          out += buffer;
+        }
+        break;
+      case STRING:
+        out += '"';
+        for (char c : text) {
+          if (c == '"' || c == '\\') out += '\\';
+          out += c;
+        }
+        out += '"';
+        break;
+      case OBJECT:
+      case ARRAY:
+        out += type == OBJECT ? '{' : '[';
+        for (size_t i = 0; i < children.size(); i++) {
+          if (i) out += ',';
+          if (type == OBJECT) {
+            out += '"';
+            out += children[i].first;
+            out += "\":";
+          }
+          children[i].second->write(out);
+        }
+        out += type == OBJECT ? '}' : ']';
+        break;
+    }
+  }
+};
+
+class JsonArray;
+class JsonObject;
+
+class JsonVariant {
+public:
+  explicit JsonVariant(HostJsonNode* node, HostJsonNode* parent = nullptr, const char* key = nullptr)
+      : _node(node), _parent(parent), _key(key ? key : "") {}
+
+  template <typename T> JsonVariant& operator=(const T& value) {
+    set(value);
+    return *this;
+  }
+  JsonVariant operator[](const char* key) {
+    return JsonVariant(_node ? _node->member(key, false) : nullptr, _node, key);
+  }
+
+  // Reading: missing or mistyped members give the type's default
+  operator const char*() const { return _node && _node->type == HostJsonNode::STRING ? _node->text.c_str() : nullptr; }
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  operator T() const { return as<T>(T()); }
+
+  const char* operator|(const char* fallback) const {
+    return _node && _node->type == HostJsonNode::STRING ? _node->text.c_str() : fallback;
+  }
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  T operator|(T fallback) const { return as<T>(fallback); }
+
+  bool isNull() const { return !_node || _node->type == HostJsonNode::NUL; }
+
+private:
+  HostJsonNode* _node;
+  HostJsonNode* _parent;
+  std::string _key;
+
+  // A member is created on first write, as in the library
+  HostJsonNode* node() {
+    if (!_node && _parent) _node = _parent->member(_key.c_str(), true);
+    return _node;
+  }
+
+  template <typename T> T as(T fallback) const {
+    if (!_node) return fallback;
+    if (std::is_same<T, bool>::value) return _node->type == HostJsonNode::BOOLEAN ? (T)_node->boolean : fallback;
+    return _node->type == HostJsonNode::NUMBER ? (T)_node->number : fallback;
+  }
+
+  void set(bool value) {
+    node()->type = HostJsonNode::BOOLEAN;
+    _node->boolean = value;
+  }
+  void set(const char* value) {
+    node()->type = HostJsonNode::STRING;
+    _node->text = value ? value : "";
+  }
+  void set(char* value) { set((const char*)value); }
+  void set(const String& value) { set(value.c_str()); }
+  template <typename T> typename std::enable_if<std::is_arithmetic<T>::value>::type set(T value) {
+    node()->type = HostJsonNode::NUMBER;
+    _node->number = (double)value;
+    _node->integer = std::is_integral<T>::value;
+  }
+  template <size_t N> void set(const char (&value)[N]) { set((const char*)value); }
+  template <size_t N> void set(char (&value)[N]) { set((const char*)value); }
+};
+
+class JsonArray {
+public:
+  explicit JsonArray(HostJsonNode* node) : _node(node) {}
+  template <typename T> bool add(const T& value) {
+    JsonVariant(_node->append()) = value;
+    return true;
+  }
+  size_t size() const { return _node->children.size(); }
+
+private:
+  HostJsonNode* _node;
+};
+
+class JsonObject {
+public:
+  explicit JsonObject(HostJsonNode* node) : _node(node) {}
+  JsonVariant operator[](const char* key) { return JsonVariant(_node->member(key, false), _node, key); }
+  JsonObject createNestedObject(const char* key) {
+    HostJsonNode* child = _node->member(key, true);
+    child->type = HostJsonNode::OBJECT;
+    child->children.clear();
+    return JsonObject(child);
+  }
+  JsonArray createNestedArray(const char* key) {
+    HostJsonNode* child = _node->member(key, true);
+    child->type = HostJsonNode::ARRAY;
+    child->children.clear();
+    return JsonArray(child);
+  }
+
+protected:
+  HostJsonNode* _node;
+};
+
+class JsonDocument : public JsonObject {
+public:
+  JsonDocument() : JsonObject(&_root) { _root.type = HostJsonNode::OBJECT; }
+  JsonDocument(const JsonDocument&) = delete;
+  void clear() {
+    _root.type = HostJsonNode::OBJECT;
+    _root.children.clear();
+  }
+  const HostJsonNode& root() const { return _root; }
+  HostJsonNode& root() { return _root; }
+
+private:
+  HostJsonNode _root;
+};
+
+template <size_t Capacity> class StaticJsonDocument : public JsonDocument {};
+
+inline size_t serializeJson(const JsonDocument& doc, char* output, size_t size) {
+  std::string text;
+  doc.root().write(text);
+  if (!size) return 0;
+  size_t length = text.size() < size ? text.size() : size - 1;
+  memcpy(output, text.data(), length);
+  output[length] = '\0';
+  return length;
+}
+
+inline size_t serializeJson(const JsonDocument& doc, String& output) {
+  std::string text;
+  doc.root().write(text);
+  output = String(text);
+  return text.size();
+}
+
+class DeserializationError {
+public:
+  enum Code { Ok, InvalidInput, EmptyInput };
+  DeserializationError(Code code = Ok) : _code(code) {}
+  explicit operator bool() const { return _code != Ok; }
+  const char* c_str() const { return _code == Ok ? "Ok" : _code == EmptyInput ? "EmptyInput" : "InvalidInput"; }
+
+private:
+  Code _code;
+};
+
+// Recursive-descent parser for the documents the server sends
+class HostJsonParser {
+public:
+  explicit HostJsonParser(const char* input) : _p(input) {}
+
+  bool value(HostJsonNode& node) {
+    skip();
+    if (*_p == '{') return object(node);
+    if (*_p == '[') return array(node);
+    if (*_p == '"') {
+      node.type = HostJsonNode::STRING;
+      return string(node.text);
+    }
+    if (literal("true")) return setBoolean(node, true);
+    if (literal("false")) return setBoolean(node, false);
+    if (literal("null")) return true;
+    char* end;
+    double number = strtod(_p, &end);
+    if (end == _p) return false;
+    node.type = HostJsonNode::NUMBER;
+    node.number = number;
+    _p = end;
+    return true;
+  }
+  bool atEnd() {
+    skip();
+    return *_p == '\0';
+  }
+
+private:
+  const char* _p;
+
+  void skip() {
+    while (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r') _p++;
+  }
+  bool literal(const char* word) {
+    size_t length = strlen(word);
+    if (strncmp(_p, word, length) != 0) return false;
+    _p += length;
+    return true;
+  }
+  static bool setBoolean(HostJsonNode& node, bool value) {
+    node.type = HostJsonNode::BOOLEAN;
+    node.boolean = value;
+    return true;
+  }
+  bool string(std::string& out) {
+    _p++;
+    while (*_p && *_p != '"') {
+      if (*_p == '\\' && _p[1]) _p++;
+      out += *_p++;
+    }
+    if (*_p != '"') return false;
+    _p++;
+    return true;
+  }
+  bool object(HostJsonNode& node) {
+    node.type = HostJsonNode::OBJECT;
+    _p++;
+    skip();
+    if (*_p == '}') {
+      _p++;
+      return true;
+    }
+    for (;;) {
+      skip();
+      std::string key;
+      if (*_p != '"' || !string(key)) return false;
+      skip();
+      if (*_p++ != ':') return false;
+      if (!value(*node.member(key.c_str(), true))) return false;
+      skip();
+      if (*_p == ',') {
+        _p++;
+        continue;
+      }
+      if (*_p != '}') return false;
+      _p++;
+      return true;
+    }
+  }
+  bool array(HostJsonNode& node) {
+    node.type = HostJsonNode::ARRAY;
+    _p++;
+    skip();
+    if (*_p == ']') {
+      _p++;
+      return true;
+    }
+    for (;;) {
+      if (!value(*node.append())) return false;
+      skip();
+      if (*_p == ',') {
+        _p++;
+        continue;
+      }
+      if (*_p != ']') return false;
+      _p++;
+      return true;
+    }
+  }
+};
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+  doc.clear();
+  if (!input || !*input) return DeserializationError::EmptyInput;
+  HostJsonParser parser(input);
+  if (!parser.value(doc.root()) || !parser.atEnd()) return DeserializationError::InvalidInput;
+  return DeserializationError::Ok;
+}
+
+#endif // BIOSENTINEL_HOST_ARDUINOJSON_H
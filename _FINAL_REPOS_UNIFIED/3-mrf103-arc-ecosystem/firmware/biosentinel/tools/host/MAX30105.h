@@ -0,0 +1,197 @@
+/**
+ * BioSentinel host stand-in: MAX30105 driver + MAX30102 FIFO model
+ * The driver methods configure hostMax30102, a register-level model of the
+ * sensor's FIFO on the I2C bus (Wire.h):
+ *
+ * - Samples land every 1e6 / rate us of the sensor's own clock, which runs
+ *   `skew` off nominal (0.01 = 1 % fast).
+ * - 32-deep FIFO, write / read pointers mod 32. With rollover a write to a
+ *   full FIFO drops the oldest sample and bumps OVF_COUNTER (saturates at
+ *   31); reading a sample from FIFO_DATA resets it.
+ * - A_FULL is set by any write that leaves at least 32 - setFIFOAlmostFull()
+ *   samples unread; reading INT_STATUS1 or FIFO_DATA clears it. INT is low
+ *   while it is set, and its falling edge runs the attachInterrupt() handler
+ *   `isrLatencyMinUs..isrLatencyMaxUs` after the write (unless the edge is
+ *   dropped, `missEdgeRate`).
+ *
+ * Sample k carries k in its data (red = low 18 bits, IR = the next 18) and
+ * its write time is kept in writeUs[k], so a consumer can check both the
+ * timestamp and the sequence of everything it pops. With `checksumIr` the
+ * IR channel is hostPpgChecksum(red) instead, so a sample torn between two
+ * writes shows up (tools/ppg_ring_stress.cpp).
+ */
+
+#ifndef BIOSENTINEL_HOST_MAX30105_H
+#define BIOSENTINEL_HOST_MAX30105_H
+
+#include <random>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+
+#define I2C_SPEED_STANDARD 100000
+#define I2C_SPEED_FAST 400000
+
+inline uint32_t hostPpgChecksum(uint32_t red) {
+  return ((red * 2654435761u) >> 11) & 0x3FFFF;
+}
+
+class HostMax30102 : public HostI2CDevice {
+public:
+  // Simulation knobs
+  double skew = 0;                      // Sensor clock error (+0.01 = 1 % fast)
+  uint32_t isrLatencyMinUs = 2;         // INT edge to micros() in the handler
+  uint32_t isrLatencyMaxUs = 20;
+  double missEdgeRate = 0;              // Fraction of falling edges the ESP32 never sees
+  int intPin = 19;                      // GPIO the INT line is wired to
+  bool checksumIr = false;              // IR = hostPpgChecksum(red) instead of k's high bits
+  bool present = true;                  // False: nothing answers at 0x57
+  std::mt19937 rng{41};
+
+  // Truth
+  std::vector<uint64_t> writeUs;        // Write time of sample k
+  uint32_t edges = 0;
+  uint32_t missedEdges = 0;
+
+  void configure(int rate, uint8_t almostFull) {
+    _periodUs = 1e6 / rate / (1 + skew);
+    _threshold = 32 - almostFull;
+    _nextUs = (double)hostsim::nowUs + _periodUs;
+  }
+  void enableAFull(bool enable) { _aFullEnabled = enable; }
+  void clear() { _write = _read = _count = _overflow = 0; }
+  double periodUs() const { return _periodUs; }
+  uint64_t nextSampleUs() const { return _periodUs > 0 ? (uint64_t)_nextUs + 1 : UINT64_MAX; }
+  bool intLow() const { return _aFull && _aFullEnabled; }
+  uint32_t unread() const { return _count; }
+
+  // Run the sensor up to `toUs`, landing samples and firing INT on the way
+  void advanceTo(uint64_t toUs) {
+    while (_periodUs > 0 && _nextUs <= (double)toUs) {
+      hostsim::nowUs = (uint64_t)_nextUs;
+      writeSample();
+      _nextUs += _periodUs;
+    }
+    if (toUs > hostsim::nowUs) hostsim::nowUs = toUs;
+  }
+
+  void select(uint8_t reg) override {
+    _reg = reg;
+    _byte = 0;
+  }
+
+  uint8_t readByte() override {
+    switch (_reg) {
+      case 0x00: {                      // INT_STATUS1: A_FULL is bit 7, read clears
+        uint8_t status = _aFull ? 0x80 : 0x00;
+        _aFull = false;
+        return status;
+      }
+      case 0x04: return _write;
+      case 0x05: return _overflow;
+      case 0x06: return _read;
+      case 0x07: return readFifoByte();
+      default: return 0;
+    }
+  }
+
+private:
+  double _periodUs = 0;
+  double _nextUs = 0;
+  uint32_t _slots[32] = {};
+  uint8_t _write = 0;
+  uint8_t _read = 0;
+  uint8_t _count = 0;
+  uint8_t _overflow = 0;
+  uint8_t _threshold = 32;
+  bool _aFull = false;
+  bool _aFullEnabled = false;
+  uint8_t _reg = 0;
+  uint8_t _byte = 0;                    // Byte within the current FIFO sample
+
+  void writeSample() {
+    uint32_t k = (uint32_t)writeUs.size();
+    writeUs.push_back(hostsim::nowUs);
+    if (_count == 32) {                 // Rollover: the oldest sample goes
+      _read = (_read + 1) & 31;
+      _count--;
+      if (_overflow < 31) _overflow++;
+    }
+    _slots[_write] = k;
+    _write = (_write + 1) & 31;
+    _count++;
+
+    if (_count >= _threshold && !_aFull) {
+      _aFull = true;
+      if (_aFullEnabled) edge();
+    }
+  }
+
+  void edge() {
+    edges++;
+    if (missEdgeRate > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < missEdgeRate) {
+      missedEdges++;
+      return;
+    }
+    uint64_t landed = hostsim::nowUs;
+    hostsim::nowUs += std::uniform_int_distribution<uint32_t>(isrLatencyMinUs, isrLatencyMaxUs)(rng);
+    hostsim::interrupt(intPin);
+    hostsim::nowUs = landed;
+  }
+
+  uint8_t readFifoByte() {
+    if (_count == 0) return 0;
+    uint64_t data = (uint64_t)_slots[_read];
+    uint32_t red = (uint32_t)(data & 0x3FFFF);
+    uint32_t ir = checksumIr ? hostPpgChecksum(red) : (uint32_t)((data >> 18) & 0x3FFFF);
+    uint32_t channel = _byte < 3 ? red : ir;
+    int shift = 16 - 8 * (_byte % 3);
+    uint8_t value = (uint8_t)(channel >> shift);
+    if (++_byte == 6) {
+      _byte = 0;
+      _read = (_read + 1) & 31;
+      _count--;
+      _overflow = 0;
+      _aFull = false;
+    }
+    return value;
+  }
+};
+
+inline HostMax30102 hostMax30102;
+
+inline int hostMax30102Pin(int) {
+  return hostMax30102.intLow() ? LOW : HIGH;
+}
+
+// SparkFun MAX3010x library subset used by the firmware
+class MAX30105 {
+public:
+  bool begin(TwoWire& wire, uint32_t speed = I2C_SPEED_STANDARD, uint8_t address = 0x57) {
+    (void)speed;
+    if (!hostMax30102.present) return false;
+    wire.attach(address, &hostMax30102);
+    hostsim::pinLevel = hostMax30102Pin;
+    return true;
+  }
+  void setup(uint8_t power, uint8_t average, uint8_t ledMode, int sampleRate, int pulseWidth, int adcRange) {
+    (void)power; (void)ledMode; (void)pulseWidth; (void)adcRange;
+    _rate = sampleRate / average;
+    hostMax30102.configure(_rate, _almostFull);
+  }
+  void enableFIFORollover() {}
+  void setFIFOAlmostFull(uint8_t samples) {
+    _almostFull = samples;
+    if (_rate) hostMax30102.configure(_rate, _almostFull);
+  }
+  void enableAFULL() { hostMax30102.enableAFull(true); }
+  void clearFIFO() { hostMax30102.clear(); }
+  void setPulseAmplitudeRed(uint8_t) {}
+  void setPulseAmplitudeIR(uint8_t) {}
+
+private:
+  int _rate = 0;
+  uint8_t _almostFull = 0;
+};
+
+#endif // BIOSENTINEL_HOST_MAX30105_H
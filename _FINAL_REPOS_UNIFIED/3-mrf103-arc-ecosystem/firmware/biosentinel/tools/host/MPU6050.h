@@ -0,0 +1,173 @@
+/**
+ * BioSentinel host stand-in: MPU6050 FIFO model
+ * Register-level model of the MPU6050 on the I2C bus (Wire.h), for the
+ * firmware ImuAcquisition:
+ *
+ * - Once woken (PWR_MGMT_1), a sample lands every (1 + SMPLRT_DIV) ms of
+ *   the sensor's own clock, which runs `skew` off nominal.
+ * - Each sample is accel X/Y/Z then gyro X/Y/Z, big endian, from the
+ *   `motion` callback at the sample's true time. With the FIFO enabled
+ *   (USER_CTRL FIFO_EN and FIFO_EN) its 12 bytes go into the 1024-byte
+ *   FIFO; a full FIFO drops its oldest bytes, which can leave it out of
+ *   sample alignment, and sets FIFO_OFLOW in INT_STATUS (read clears).
+ *   USER_CTRL FIFO_RESET empties it.
+ * - Reading FIFO_COUNTH latches the count for FIFO_COUNTL, so the pair
+ *   (auto-increment) never tears as a sample lands; FIFO_R_W pops.
+ * - With DATA_RDY enabled (INT_ENABLE bit 0) every sample pulses INT and
+ *   runs the attachInterrupt() handler isrLatencyMinUs..isrLatencyMaxUs
+ *   later.
+ *
+ * The firmware numbers samples by the DATA_RDY edges its handler has seen,
+ * so edge n's true time is kept in edgeUs[n] (edgeUs[0] unused): a sample
+ * the firmware stamps with index n was written at edgeUs[n].
+ */
+
+#ifndef BIOSENTINEL_HOST_MPU6050_H
+#define BIOSENTINEL_HOST_MPU6050_H
+
+#include <deque>
+#include <random>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+
+class HostMpu6050 : public HostI2CDevice {
+public:
+  // Simulation knobs
+  double skew = 0;                      // Sensor clock error (+0.01 = 1 % fast)
+  uint32_t isrLatencyMinUs = 2;         // DATA_RDY edge to micros() in the handler
+  uint32_t isrLatencyMaxUs = 20;
+  int intPin = 18;                      // GPIO the INT line is wired to
+  void (*motion)(uint64_t timeUs, int16_t out[6]) = nullptr; // Accel + gyro at a true time
+  std::mt19937 rng{43};
+
+  // Truth
+  std::vector<uint64_t> edgeUs{0};      // True time of the n-th edge a handler saw
+  uint32_t overflows = 0;               // Samples written into a full FIFO
+
+  double periodUs() const { return _periodUs; }
+  uint64_t nextSampleUs() const { return _awake ? (uint64_t)_nextUs + 1 : UINT64_MAX; }
+  size_t fifoBytes() const { return _fifo.size(); }
+
+  // Run the sensor up to `toUs`, landing samples and pulsing INT on the way
+  void advanceTo(uint64_t toUs) {
+    while (_awake && _nextUs <= (double)toUs) {
+      hostsim::nowUs = (uint64_t)_nextUs;
+      writeSample();
+      _nextUs += _periodUs;
+    }
+    if (toUs > hostsim::nowUs) hostsim::nowUs = toUs;
+  }
+
+  void select(uint8_t reg) override {
+    _reg = reg;
+  }
+
+  void writeByte(uint8_t value) override {
+    switch (_reg) {
+      case 0x19: _divider = value; configure(); break;                // SMPLRT_DIV
+      case 0x23: _fifoSources = value; break;                         // FIFO_EN
+      case 0x38: _dataReady = (value & 0x01) != 0; break;             // INT_ENABLE
+      case 0x6A:                                                      // USER_CTRL
+        if (value & 0x04) _fifo.clear();
+        _fifoEnabled = (value & 0x40) != 0;
+        break;
+      case 0x6B:                                                      // PWR_MGMT_1
+        if (value & 0x80) {
+          powerOnReset();
+        } else {
+          bool wake = !(value & 0x40);
+          if (wake && !_awake) _nextUs = (double)hostsim::nowUs + _periodUs;
+          _awake = wake;
+        }
+        break;
+      default: break;
+    }
+    _reg++;
+  }
+
+  uint8_t readByte() override {
+    uint8_t reg = _reg;
+    if (reg != 0x74) _reg++;            // FIFO_R_W does not auto-increment
+    switch (reg) {
+      case 0x3A: {                      // INT_STATUS: FIFO_OFLOW bit 4, DATA_RDY bit 0, read clears
+        uint8_t status = _status;
+        _status = 0;
+        return status;
+      }
+      case 0x72:
+        _countLatch = (uint16_t)_fifo.size();
+        return (uint8_t)(_countLatch >> 8);
+      case 0x73: return (uint8_t)(_countLatch & 0xFF);
+      case 0x74: {
+        if (_fifo.empty()) return 0;
+        uint8_t value = _fifo.front();
+        _fifo.pop_front();
+        return value;
+      }
+      case 0x75: return 0x68;           // WHO_AM_I
+      default: return 0;
+    }
+  }
+
+private:
+  double _periodUs = 1000;
+  double _nextUs = 0;
+  uint8_t _divider = 0;
+  uint8_t _fifoSources = 0;
+  bool _fifoEnabled = false;
+  bool _dataReady = false;
+  bool _awake = false;
+  uint8_t _status = 0;
+  uint8_t _reg = 0;
+  uint16_t _countLatch = 0;
+  std::deque<uint8_t> _fifo;
+
+  // DEVICE_RESET: registers back to defaults, asleep
+  void powerOnReset() {
+    _divider = 0;
+    _fifoSources = 0;
+    _fifoEnabled = false;
+    _dataReady = false;
+    _awake = false;
+    _status = 0;
+    _fifo.clear();
+    configure();
+  }
+
+  void configure() {
+    _periodUs = 1000.0 * (1 + _divider) / (1 + skew);
+  }
+
+  void writeSample() {
+    _status |= 0x01;
+
+    if (_fifoEnabled && _fifoSources == 0x78) {
+      int16_t values[6] = {};
+      if (motion) motion(hostsim::nowUs, values);
+      if (_fifo.size() + 12 > MPU6050_MODEL_FIFO_BYTES) {
+        overflows++;
+        _status |= 0x10;
+        while (_fifo.size() + 12 > MPU6050_MODEL_FIFO_BYTES) _fifo.pop_front();
+      }
+      for (int16_t v : values) {
+        _fifo.push_back((uint8_t)((uint16_t)v >> 8));
+        _fifo.push_back((uint8_t)(v & 0xFF));
+      }
+    }
+
+    if (_dataReady && intPin >= 0 && intPin < HOST_PINS && hostsim::isr[intPin]) {
+      edgeUs.push_back(hostsim::nowUs);
+      uint64_t landed = hostsim::nowUs;
+      hostsim::nowUs += std::uniform_int_distribution<uint32_t>(isrLatencyMinUs, isrLatencyMaxUs)(rng);
+      hostsim::interrupt(intPin);
+      hostsim::nowUs = landed;
+    }
+  }
+
+  static constexpr size_t MPU6050_MODEL_FIFO_BYTES = 1024;
+};
+
+inline HostMpu6050 hostMpu6050;
+
+#endif // BIOSENTINEL_HOST_MPU6050_H
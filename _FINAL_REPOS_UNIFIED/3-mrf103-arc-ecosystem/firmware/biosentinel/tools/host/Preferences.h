@@ -0,0 +1,47 @@
+/**
+ * BioSentinel host stand-in: Preferences (NVS)
+ * String values only, kept in hostNvs[namespace][key] so a simulation can
+ * provision the device before setup() and read back what it saved.
+ */
+
+#ifndef BIOSENTINEL_HOST_PREFERENCES_H
+#define BIOSENTINEL_HOST_PREFERENCES_H
+
+#include <map>
+#include <string>
+#include "Arduino.h"
+
+inline std::map<std::string, std::map<std::string, std::string>> hostNvs;
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false) {
+    _name = name;
+    _readOnly = readOnly;
+    return true;
+  }
+  void end() { _name.clear(); }
+
+  String getString(const char* key, const String& defaultValue = String()) {
+    auto space = hostNvs.find(_name);
+    if (space == hostNvs.end()) return defaultValue;
+    auto value = space->second.find(key);
+    return value == space->second.end() ? defaultValue : String(value->second);
+  }
+  size_t putString(const char* key, const char* value) {
+    if (_readOnly || _name.empty()) return 0;
+    hostNvs[_name][key] = value;
+    return strlen(value);
+  }
+  bool clear() {
+    if (_readOnly || _name.empty()) return false;
+    hostNvs.erase(_name);
+    return true;
+  }
+
+private:
+  std::string _name;
+  bool _readOnly = false;
+};
+
+#endif // BIOSENTINEL_HOST_PREFERENCES_H
@@ -0,0 +1,103 @@
+/**
+ * BioSentinel host stand-in: WebSocketsClient (arduinoWebSockets)
+ * Connects from loop() the way the library does: the first attempt right
+ * after beginSSL(), then one per reconnect interval, each blocking loop()
+ * for the TCP + TLS + upgrade time (handshakeMs) or, with the server down,
+ * until the connection is refused (refusedMs). Text frames the firmware
+ * sends are kept in `sent`.
+ */
+
+#ifndef BIOSENTINEL_HOST_WEBSOCKETSCLIENT_H
+#define BIOSENTINEL_HOST_WEBSOCKETSCLIENT_H
+
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "WiFi.h"
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT
+} WStype_t;
+
+class WebSocketsClient {
+public:
+  typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t* payload, size_t length);
+
+  // Simulation knobs
+  bool serverUp = true;
+  uint32_t handshakeMs = 1200;          // DNS + TCP + TLS + HTTP upgrade on the ESP32
+  uint32_t refusedMs = 150;             // Connection refused
+
+  // Truth
+  uint32_t attempts = 0;
+  std::vector<std::string> sent;
+
+  void beginSSL(const char* host, uint16_t port, const char* url = "/") {
+    (void)host; (void)port;
+    _url = url;
+    _begun = true;
+    _failedMs = 0;
+    _retryNow = true;
+  }
+  void onEvent(WebSocketClientEvent event) { _event = event; }
+  void setReconnectInterval(unsigned long ms) { _intervalMs = ms; }
+
+  void loop() {
+    if (!_begun) return;
+    if (_connected) {
+      if (WiFi.status() != WL_CONNECTED) drop();
+      return;
+    }
+    if (WiFi.status() != WL_CONNECTED) return;
+    if (!_retryNow && millis() - _failedMs < _intervalMs) return;
+
+    attempts++;
+    _retryNow = false;
+    if (!serverUp) {
+      hostsim::advance((uint64_t)refusedMs * 1000);
+      _failedMs = millis();
+      emit(WStype_DISCONNECTED, nullptr, 0);
+      return;
+    }
+    hostsim::advance((uint64_t)handshakeMs * 1000);
+    _connected = true;
+    emit(WStype_CONNECTED, (uint8_t*)_url.c_str(), _url.size());
+  }
+
+  void disconnect() {
+    if (_connected) drop();
+  }
+  bool isConnected() const { return _connected; }
+
+  bool sendTXT(const char* payload, size_t length = 0) {
+    if (!_connected) return false;
+    sent.emplace_back(payload, length ? length : strlen(payload));
+    return true;
+  }
+  bool sendTXT(char* payload, size_t length = 0) { return sendTXT((const char*)payload, length); }
+  bool sendTXT(String& payload) { return sendTXT(payload.c_str(), payload.length()); }
+  bool sendBIN(const uint8_t*, size_t) { return _connected; }
+
+private:
+  WebSocketClientEvent _event = nullptr;
+  std::string _url;
+  bool _begun = false;
+  bool _connected = false;
+  bool _retryNow = false;
+  unsigned long _intervalMs = 500;
+  unsigned long _failedMs = 0;
+
+  void drop() {
+    _connected = false;
+    _failedMs = millis();
+    emit(WStype_DISCONNECTED, nullptr, 0);
+  }
+  void emit(WStype_t type, uint8_t* payload, size_t length) {
+    if (_event) _event(type, payload, length);
+  }
+};
+
+#endif // BIOSENTINEL_HOST_WEBSOCKETSCLIENT_H
@@ -0,0 +1,83 @@
+/**
+ * BioSentinel host stand-in: WiFi (station)
+ * WiFi.begin() associates joinMs of virtual time later, or as soon after
+ * that as the AP is up (apUpUs); an attempt stays pending until then, or
+ * until disconnect(). The knobs live on the WiFi object itself.
+ */
+
+#ifndef BIOSENTINEL_HOST_WIFI_H
+#define BIOSENTINEL_HOST_WIFI_H
+
+#include "Arduino.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1 } wifi_mode_t;
+
+class IPAddress {
+public:
+  IPAddress(uint32_t address = 0) : _address(address) {}
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (unsigned)(_address >> 24), (unsigned)(_address >> 16) & 0xFF,
+             (unsigned)(_address >> 8) & 0xFF, (unsigned)_address & 0xFF);
+    return String(text);
+  }
+
+private:
+  uint32_t _address;
+};
+
+class WiFiClass {
+public:
+  // Simulation knobs
+  uint64_t apUpUs = 0;                  // When the AP comes up (UINT64_MAX = never)
+  uint32_t joinMs = 2000;               // Association + DHCP
+
+  // Truth
+  uint32_t attempts = 0;
+
+  bool mode(wifi_mode_t) { return true; }
+  bool setHostname(const char*) { return true; }
+  bool setAutoReconnect(bool) { return true; }
+
+  wl_status_t begin(const char*, const char* = nullptr) {
+    attempts++;
+    _connected = false;
+    _joining = true;
+    _joinAtUs = hostsim::nowUs + (uint64_t)joinMs * 1000;
+    return status();
+  }
+  bool disconnect(bool = false) {
+    _connected = false;
+    _joining = false;
+    return true;
+  }
+
+  wl_status_t status() {
+    if (_joining && hostsim::nowUs >= _joinAtUs && hostsim::nowUs >= apUpUs) {
+      _joining = false;
+      _connected = true;
+    }
+    if (_connected) return WL_CONNECTED;
+    return _joining ? WL_IDLE_STATUS : WL_DISCONNECTED;
+  }
+
+  IPAddress localIP() { return status() == WL_CONNECTED ? IPAddress(0xC0A8010A) : IPAddress(); }
+  int8_t RSSI() { return status() == WL_CONNECTED ? -58 : 0; }
+
+private:
+  bool _joining = false;
+  bool _connected = false;
+  uint64_t _joinAtUs = 0;
+};
+
+inline WiFiClass WiFi;
+
+#endif // BIOSENTINEL_HOST_WIFI_H
@@ -0,0 +1,74 @@
+/**
+ * BioSentinel host stand-in: Wire (I2C master)
+ * Register-addressed devices attach by address. The first byte written after
+ * beginTransmission() selects a register, requestFrom() reads from it. Each
+ * byte on the bus (address bytes included) costs HOST_I2C_BYTE_US of virtual
+ * time, so sensors keep sampling while a burst read is in progress.
+ */
+
+#ifndef BIOSENTINEL_HOST_WIRE_H
+#define BIOSENTINEL_HOST_WIRE_H
+
+#include "Arduino.h"
+
+#ifndef HOST_I2C_BYTE_US
+  #define HOST_I2C_BYTE_US 25           // 400 kHz, 9 clocks per byte plus gaps (sensor_hub.h)
+#endif
+
+struct HostI2CDevice {
+  virtual ~HostI2CDevice() {}
+  virtual void select(uint8_t reg) = 0;
+  virtual void writeByte(uint8_t value) { (void)value; }
+  virtual uint8_t readByte() = 0;       // From the selected register (auto-increment is the device's business)
+};
+
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { (void)sda; (void)scl; (void)frequency; return true; }
+  void setClock(uint32_t) {}
+  void attach(uint8_t address, HostI2CDevice* device) { _devices[address & 0x7F] = device; }
+
+  void beginTransmission(uint8_t address) {
+    _device = _devices[address & 0x7F];
+    _first = true;
+    hostsim::advance(HOST_I2C_BYTE_US);
+  }
+  size_t write(uint8_t value) {
+    hostsim::advance(HOST_I2C_BYTE_US);
+    if (!_device) return 0;
+    if (_first) _device->select(value);
+    else _device->writeByte(value);
+    _first = false;
+    return 1;
+  }
+  uint8_t endTransmission(bool stop = true) {
+    (void)stop;
+    return _device ? 0 : 2;             // 2 = address NACK
+  }
+  uint8_t requestFrom(uint8_t address, uint8_t count) {
+    hostsim::advance(HOST_I2C_BYTE_US);
+    HostI2CDevice* device = _devices[address & 0x7F];
+    _length = 0;
+    _position = 0;
+    if (!device) return 0;
+    for (uint8_t i = 0; i < count && _length < sizeof(_buffer); i++) {
+      hostsim::advance(HOST_I2C_BYTE_US);
+      _buffer[_length++] = device->readByte();
+    }
+    return (uint8_t)_length;
+  }
+  int available() { return (int)(_length - _position); }
+  int read() { return _position < _length ? _buffer[_position++] : -1; }
+
+private:
+  HostI2CDevice* _devices[128] = {};
+  HostI2CDevice* _device = nullptr;
+  bool _first = false;
+  uint8_t _buffer[128];
+  size_t _length = 0;
+  size_t _position = 0;
+};
+
+inline TwoWire Wire;
+
+#endif // BIOSENTINEL_HOST_WIRE_H
@@ -0,0 +1,190 @@
+/**
+ * BioSentinel PPG FIFO simulation (host)
+ * Runs the firmware PpgAcquisition against a register-level MAX30102 FIFO
+ * model (host/MAX30105.h) on a virtual clock, with the sensor hub task and
+ * loop() played by the simulation, and scores every sample loop() pops
+ * against the time the sensor wrote it.
+ *
+ *   g++ -std=c++17 -O2 -Ihost -I.. ppg_fifo_sim.cpp -o ppg_fifo_sim
+ *
+ *   ./ppg_fifo_sim [seconds per scenario]
+ *
+ * The sensor hub task sleeps in ulTaskNotifyTake(SENSOR_POLL_MS); an
+ * interrupt wakes it 20-400 us later (scheduling plus whatever else core 1
+ * is doing), then service() runs with every I2C byte costing 25 us while
+ * the sensor keeps sampling. The handler itself sees the INT edge 2-20 us
+ * late. loop() pops the ring every 10 ms.
+ *
+ * Scenarios: the sensor clock on nominal, 1 % fast and 3 % slow; a 4 s
+ * reader stall (FIFO overflows); 20 % of INT edges lost (the poll catches
+ * them); and loop() stalling for 4 s (ring drops).
+ *
+ * Timestamp error is reported in steady state and separately for the
+ * first 3 s after each disturbance, while the timeline re-locks.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "ppg_acquisition.h"
+
+#define SIM_POLL_US 50000               // SENSOR_POLL_MS
+#define SIM_CONSUMER_US 10000           // loop() drains every 10 ms
+#define SIM_WARMUP_US 2000000           // First anchored bursts lock the timeline
+#define SIM_RECOVERY_US 3000000         // Excluded from steady state after a disturbance
+
+struct Scenario {
+  const char* name;
+  double skew;                          // Sensor clock error
+  double missEdgeRate;
+  double readerStallAtS;                // Sensor hub task blocked (0 = none)
+  double consumerStallAtS;              // loop() blocked (0 = none)
+  double stallS;
+};
+
+struct ErrorStats {
+  std::vector<int32_t> errors;
+  void add(int32_t e) { errors.push_back(e); }
+  double mean() const {
+    double sum = 0;
+    for (int32_t e : errors) sum += e;
+    return errors.empty() ? 0 : sum / errors.size();
+  }
+  uint32_t percentileAbs(double p) {
+    if (errors.empty()) return 0;
+    std::vector<uint32_t> a;
+    for (int32_t e : errors) a.push_back((uint32_t)std::abs(e));
+    std::sort(a.begin(), a.end());
+    return a[std::min(a.size() - 1, (size_t)(p * a.size()))];
+  }
+};
+
+static bool runScenario(const Scenario& sc, double seconds) {
+  hostsim::nowUs = 0;
+  hostsim::notifications = 0;
+  std::fill(std::begin(hostsim::isr), std::end(hostsim::isr), nullptr);
+  hostMax30102 = HostMax30102();
+  hostMax30102.skew = sc.skew;
+  hostMax30102.missEdgeRate = sc.missEdgeRate;
+  hostsim::advanceHook = [](uint64_t toUs) { hostMax30102.advanceTo(toUs); };
+  Serial.quiet = true;
+
+  MAX30105 sensor;
+  std::unique_ptr<PpgAcquisition> ppg(new PpgAcquisition());
+  sensor.begin(Wire, I2C_SPEED_FAST);
+  if (!ppg->begin(sensor, 19, 100, 0x1F)) return false;
+  ppg->setNotifyTask((TaskHandle_t)1);
+
+  uint64_t endUs = (uint64_t)(seconds * 1e6);
+  uint64_t readerStallUs = (uint64_t)(sc.readerStallAtS * 1e6);
+  uint64_t consumerStallUs = (uint64_t)(sc.consumerStallAtS * 1e6);
+  uint64_t stallUs = (uint64_t)(sc.stallS * 1e6);
+  uint64_t disturbanceUs = sc.readerStallAtS ? readerStallUs : sc.consumerStallAtS ? consumerStallUs : 0;
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<uint32_t> wakeLatency(20, 400);
+
+  // loop(): pop everything, check sequence and timestamp against the write time
+  ErrorStats steady, recovery;
+  uint32_t expected = 0, lost = 0, misordered = 0, popped = 0, missedEdgeBursts = 0;
+  auto consume = [&]() {
+    PpgSample sample;
+    while (ppg->pop(sample)) {
+      uint32_t k = sample.red | (sample.ir << 18);
+      if (k < expected) {
+        misordered++;
+        continue;
+      }
+      lost += k - expected;
+      expected = k + 1;
+      popped++;
+      uint64_t truth = hostMax30102.writeUs[k];
+      int32_t error = (int32_t)(sample.timestampUs - (uint32_t)truth);
+      if (truth < SIM_WARMUP_US) continue;
+      bool disturbed = disturbanceUs && truth >= disturbanceUs && truth < disturbanceUs + stallUs + SIM_RECOVERY_US;
+      (disturbed ? recovery : steady).add(error);
+    }
+  };
+
+  uint64_t nextConsumeUs = SIM_CONSUMER_US;
+  auto runUntil = [&](uint64_t toUs) {
+    while (nextConsumeUs <= toUs) {
+      hostsim::advance(nextConsumeUs > hostsim::nowUs ? nextConsumeUs - hostsim::nowUs : 0);
+      bool stalled = consumerStallUs && nextConsumeUs >= consumerStallUs && nextConsumeUs < consumerStallUs + stallUs;
+      if (!stalled) consume();
+      nextConsumeUs += SIM_CONSUMER_US;
+    }
+    if (toUs > hostsim::nowUs) hostsim::advance(toUs - hostsim::nowUs);
+  };
+
+  // Sensor hub task
+  while (hostsim::nowUs < endUs) {
+    uint64_t deadline = hostsim::nowUs + SIM_POLL_US;
+    while (hostsim::notifications == 0 && hostsim::nowUs < deadline) {
+      runUntil(std::min(deadline, hostMax30102.nextSampleUs()));
+    }
+    if (hostsim::notifications) {
+      runUntil(std::max(hostsim::nowUs, hostsim::notifiedUs + wakeLatency(rng)));
+      hostsim::notifications = 0;
+    } else if (hostMax30102.intLow()) {
+      missedEdgeBursts++;
+    }
+    if (readerStallUs && hostsim::nowUs >= readerStallUs && hostsim::nowUs < readerStallUs + stallUs) {
+      runUntil(readerStallUs + stallUs);
+    }
+    ppg->service();
+  }
+  runUntil(hostsim::nowUs);
+
+  PpgStats stats = ppg->getStats();
+  double trueRate = 1e6 / hostMax30102.periodUs();
+  uint32_t written = (uint32_t)hostMax30102.writeUs.size();
+  uint32_t accounted = stats.fifoOverflows + stats.ringDrops;
+
+  printf("\n%s\n", sc.name);
+  printf("  Samples: %u written, %u popped, %u lost (FIFO overflow %u + ring drops %u), %u out of order\n",
+         written, popped, lost, stats.fifoOverflows, stats.ringDrops, misordered);
+  printf("  Rate: true %.2f Hz, tracked %.2f Hz\n", trueRate, stats.rateHz);
+  printf("  Timestamp error, steady: mean %+.1f us, p99 %u us, max %u us (%zu samples)\n", steady.mean(),
+         steady.percentileAbs(0.99), steady.percentileAbs(1.0), steady.errors.size());
+  if (!recovery.errors.empty()) {
+    printf("  Timestamp error, %.0f s after the disturbance: p99 %u us, max %u us (%zu samples)\n",
+           SIM_RECOVERY_US / 1e6, recovery.percentileAbs(0.99), recovery.percentileAbs(1.0),
+           recovery.errors.size());
+  }
+  printf("  Stats: %u bursts, max burst %u, max latency %u us, jitter mean %u / max %u us\n", stats.bursts,
+         stats.maxBurst, stats.maxLatencyUs, stats.jitterUs, stats.maxJitterUs);
+  if (hostMax30102.missedEdges) {
+    printf("  INT edges: %u, %u lost, %u bursts picked up by the %d ms poll\n", hostMax30102.edges,
+           hostMax30102.missedEdges, missedEdgeBursts, SIM_POLL_US / 1000);
+  }
+
+  // Every sample either reaches loop() or is counted as lost, in order
+  bool ok = misordered == 0 && lost == accounted && popped + lost + (written - expected) == written;
+  printf("  %s\n", ok ? "OK: every loss counted" : "MISMATCH: losses not accounted for");
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 60;
+  if (seconds < 10) seconds = 10;
+
+  const Scenario scenarios[] = {
+      {"Nominal clock", 0, 0, 0, 0, 0},
+      {"Sensor clock 1 % fast", 0.01, 0, 0, 0, 0},
+      {"Sensor clock 3 % slow", -0.03, 0, 0, 0, 0},
+      {"1 % fast, sensor hub task stalled 4 s", 0.01, 0, seconds / 2, 0, 4},
+      {"1 % fast, 20 % of INT edges lost", 0.01, 0.2, 0, 0, 0},
+      {"1 % fast, loop() stalled 4 s", 0.01, 0, 0, seconds / 2, 4},
+  };
+
+  printf("PPG FIFO simulation: 100 Hz, burst %d, gain %d, %.0f s per scenario\n", PPG_BURST_SAMPLES,
+         PPG_TIMELINE_GAIN, seconds);
+  bool ok = true;
+  for (const Scenario& sc : scenarios) ok &= runScenario(sc, seconds);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+/**
+ * BioSentinel PPG replay (host)
+ * Runs a recorded red / IR trace through the firmware PpgDsp and
+ * HrvAnalyzer, scores heart rate, SpO2, beat detection, the quality index
+ * and HRV against the trace's reference columns, and measures per-sample
+ * cost.
+ *
+ *   g++ -std=c++17 -O2 -I.. ppg_replay.cpp -o ppg_replay
+ *
+ *   ./ppg_replay synth trace.csv        # labelled synthetic trace
+ *   ./ppg_replay replay trace.csv
+ *
+ * Trace CSV (header line optional, one 100 Hz sample per line):
+ *   timestamp_us,red,ir[,hr,spo2,valid,beat]
+ *   hr / spo2 are the reference (e.g. from a clinical monitor), valid 0
+ *   marks motion / no-contact stretches, beat 1 marks a reference systole
+ *   (reference HRV is computed from these; both analyzers are reset when
+ *   the firmware would drop its window, on finger loss).
+ *   Traces without reference columns still get timing and quality output.
+ *
+ * The synthetic trace is a systolic + dicrotic pulse shape on a breathing
+ * baseline with sensor noise, stepping through heart rate / SpO2 plateaus,
+ * with a motion-artifact stretch and a finger-off gap.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hrv_analyzer.h"
+#include "ppg_dsp.h"
+
+struct Sample {
+  uint32_t timestampUs;
+  uint32_t red;
+  uint32_t ir;
+  float hr;                             // Reference, NAN if unknown
+  float spo2;
+  bool valid;
+  bool beat;
+};
+
+// =============================================================================
+// Synthetic trace
+// =============================================================================
+
+struct Segment {
+  float seconds;
+  float hr;
+  float spo2;
+  bool motion;
+  bool fingerOff;
+};
+
+static const Segment SEGMENTS[] = {
+  {60, 62, 98, false, false},
+  {60, 75, 97, false, false},
+  {60, 96, 94, false, false},
+  {30, 96, 94, true, false},            // Walking with the sensor on
+  {60, 118, 91, false, false},
+  {10, 0, 0, false, true},              // Finger lifted
+  {60, 54, 99, false, false},
+  {60, 82, 88, false, false},
+};
+
+static float pulseShape(float phase) {
+  float systolic = expf(-powf((phase - 0.15f) / 0.06f, 2));
+  float dicrotic = 0.4f * expf(-powf((phase - 0.45f) / 0.08f, 2));
+  return systolic + dicrotic;
+}
+
+static std::vector<Sample> synthesize() {
+  std::mt19937 rng(11);
+  std::normal_distribution<float> gauss(0.0f, 1.0f);
+  std::vector<Sample> trace;
+
+  const float dcIr = 120000, dcRed = 90000, piIr = 0.015f;
+  double t = 0;                         // Seconds
+  double nextBeat = 0.3, beatStart = 0, rr = 1.0;
+  double nextStep = 0, stepStart = 0;
+  float stepGain = 0;
+  uint32_t index = 0;
+
+  for (const Segment& seg : SEGMENTS) {
+    double end = t + seg.seconds;
+    for (; t < end; t = ++index / (double)PPG_DSP_RATE) {
+      Sample s = {};
+      s.timestampUs = (uint32_t)(t * 1e6);
+      if (seg.fingerOff) {
+        s.ir = 1500 + (uint32_t)(50 * fabsf(gauss(rng)));
+        s.red = 1200 + (uint32_t)(50 * fabsf(gauss(rng)));
+        s.hr = s.spo2 = NAN;
+        trace.push_back(s);
+        nextBeat = t + 0.5;
+        continue;
+      }
+
+      if (t >= nextBeat) {
+        // RR: plateau mean, respiratory sinus arrhythmia, beat-to-beat noise
+        beatStart = nextBeat;
+        rr = 60.0 / seg.hr * (1 + 0.04 * sin(2 * M_PI * 0.25 * t) + 0.015 * gauss(rng));
+        nextBeat += rr;
+      }
+      float phase = (float)((t - beatStart) / rr);
+      float pulse = phase < 1 ? pulseShape(phase) : 0;
+      float breathing = 0.004f * sinf(2 * M_PI * 0.25f * t);
+      float motion = 0;
+      if (seg.motion) {
+        // Footsteps: a decaying jolt every ~0.6 s, uneven strength and timing
+        if (t >= nextStep) {
+          stepStart = nextStep;
+          stepGain = 0.02f * (0.5f + fabsf(gauss(rng)));
+          nextStep += 0.6 * (1 + 0.15 * gauss(rng));
+        }
+        float since = (float)(t - stepStart);
+        motion = stepGain * expf(-since / 0.12f) * sinf(2 * M_PI * 3.0f * since) + 0.002f * gauss(rng);
+      }
+
+      float r = (110.0f - seg.spo2) / 25.0f;
+      s.ir = (uint32_t)(dcIr * (1 + breathing + motion - piIr * pulse) + 25 * gauss(rng));
+      s.red = (uint32_t)(dcRed * (1 + breathing + motion - piIr * r * pulse) + 25 * gauss(rng));
+      s.hr = seg.hr;
+      s.spo2 = seg.spo2;
+      s.valid = !seg.motion;
+      // Reference systole: the sample nearest the pulse maximum (phase 0.15)
+      double sample = 1.0 / PPG_DSP_RATE;
+      double systole = beatStart + 0.15 * rr;
+      s.beat = !seg.motion && fabs(t - systole) <= sample / 2;
+      trace.push_back(s);
+    }
+  }
+  return trace;
+}
+
+// =============================================================================
+// CSV
+// =============================================================================
+
+static bool save(const char* path, const std::vector<Sample>& trace) {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "timestamp_us,red,ir,hr,spo2,valid,beat\n");
+  for (const Sample& s : trace) {
+    fprintf(f, "%u,%u,%u,%.1f,%.1f,%d,%d\n", s.timestampUs, s.red, s.ir, s.hr, s.spo2, s.valid, s.beat);
+  }
+  return fclose(f) == 0;
+}
+
+static bool load(const char* path, std::vector<Sample>& trace) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    Sample s = {};
+    s.hr = s.spo2 = NAN;
+    int valid = 1, beat = 0;
+    int n = sscanf(line, "%u,%u,%u,%f,%f,%d,%d", &s.timestampUs, &s.red, &s.ir, &s.hr, &s.spo2, &valid, &beat);
+    if (n < 3) continue;                // Header / blank
+    s.valid = valid != 0;
+    s.beat = beat != 0;
+    trace.push_back(s);
+  }
+  fclose(f);
+  return true;
+}
+
+// =============================================================================
+// Replay
+// =============================================================================
+
+int main(int argc, char** argv) {
+  std::string mode = argc > 1 ? argv[1] : "";
+
+  if (mode == "synth" && argc == 3) {
+    std::vector<Sample> trace = synthesize();
+    if (!save(argv[2], trace)) {
+      fprintf(stderr, "Cannot write %s\n", argv[2]);
+      return 1;
+    }
+    printf("Wrote %zu samples (%.0f s)\n", trace.size(), trace.size() / (double)PPG_DSP_RATE);
+    return 0;
+  }
+
+  if (mode != "replay" || argc != 3) {
+    fprintf(stderr, "Usage: %s synth <trace.csv> | replay <trace.csv>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<Sample> trace;
+  if (!load(argv[2], trace) || trace.empty()) return 1;
+
+  // Timing: the whole trace, several passes
+  PpgDsp dsp;
+  const int passes = 20;
+  auto start = std::chrono::steady_clock::now();
+  uint32_t sink = 0;
+  for (int p = 0; p < passes; p++) {
+    dsp.reset();
+    for (const Sample& s : trace) sink += dsp.update(s.red, s.ir, s.timestampUs);
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+              (trace.size() * (double)passes);
+
+  // Accuracy: one pass, scored once per second as the firmware reports
+  dsp.reset();
+  HrvAnalyzer hrv, hrvRef;
+  std::vector<uint32_t> detected;
+  uint32_t refBeatUs = 0;
+  bool finger = false;
+  uint32_t hrvAccepted = 0, hrvRejected = 0;   // Across finger-loss resets
+  double hrErr = 0, spo2Err = 0, rmssdErr = 0, sdnnErr = 0, pnn50Err = 0;
+  int scored = 0, validSeconds = 0, confident = 0, invalidSeconds = 0, falseConfident = 0, hrvScored = 0;
+  for (size_t i = 0; i < trace.size(); i++) {
+    const Sample& s = trace[i];
+    if (dsp.update(s.red, s.ir, s.timestampUs)) {
+      detected.push_back(dsp.lastBeatUs());
+      hrv.addBeat(dsp.lastRrMs(), dsp.quality() >= PPG_DSP_MIN_QUALITY);
+    }
+    if (s.beat) {
+      uint32_t rrMs = refBeatUs ? (s.timestampUs - refBeatUs) / 1000 : 0;
+      hrvRef.addBeat(rrMs <= HRV_MAX_RR_MS ? rrMs : 0, true);
+      refBeatUs = s.timestampUs;
+    }
+    // The firmware drops the HRV window when the finger lifts; score the reference over the same beats
+    if (finger && !dsp.fingerDetected()) {
+      hrvAccepted += hrv.accepted();
+      hrvRejected += hrv.rejected();
+      hrv.reset();
+      hrvRef.reset();
+    }
+    finger = dsp.fingerDetected();
+    if (i % PPG_DSP_RATE != PPG_DSP_RATE - 1 || !(s.hr == s.hr)) continue;
+
+    if (hrv.valid() && hrvRef.valid()) {
+      HrvMetrics m = hrv.metrics(), ref = hrvRef.metrics();
+      rmssdErr += fabs(m.rmssd - ref.rmssd);
+      sdnnErr += fabs(m.sdnn - ref.sdnn);
+      pnn50Err += fabs(m.pnn50 - ref.pnn50);
+      hrvScored++;
+    }
+
+    bool good = dsp.quality() >= PPG_DSP_MIN_QUALITY;
+    if (!s.valid) {
+      invalidSeconds++;
+      if (good) falseConfident++;
+      continue;
+    }
+    validSeconds++;
+    if (!good) continue;
+    confident++;
+    if (dsp.heartRate() > 0 && dsp.spo2() > 0) {
+      hrErr += fabs(dsp.heartRate() - s.hr);
+      spo2Err += fabs(dsp.spo2() - s.spo2);
+      scored++;
+    }
+  }
+
+  // Beats: a reference systole matched by a detection within 60 ms (valid stretches only)
+  int reference = 0, matched = 0;
+  size_t d = 0;
+  for (const Sample& s : trace) {
+    if (!s.beat || !s.valid) continue;
+    reference++;
+    while (d < detected.size() && (int32_t)(detected[d] - s.timestampUs) < -60000) d++;
+    if (d < detected.size() && abs((int32_t)(detected[d] - s.timestampUs)) <= 60000) matched++;
+  }
+
+  printf("Trace: %zu samples, %.0f s\n\n", trace.size(), trace.size() / (double)PPG_DSP_RATE);
+  printf("cost            %.1f ns/sample (%u)\n", ns, sink & 1);
+  printf("beats           %zu detected, %d/%d reference matched (+-60 ms)\n", detected.size(), matched, reference);
+  if (scored) {
+    printf("heart rate      MAE %.2f bpm over %d s\n", hrErr / scored, scored);
+    printf("SpO2            MAE %.2f %%\n", spo2Err / scored);
+  }
+  printf("coverage        quality >= %d for %d/%d clean seconds\n", PPG_DSP_MIN_QUALITY, confident, validSeconds);
+  printf("artifacts       quality >= %d for %d/%d motion seconds\n", PPG_DSP_MIN_QUALITY, falseConfident,
+         invalidSeconds);
+  if (hrvScored) {
+    HrvMetrics m = hrv.metrics(), ref = hrvRef.metrics();
+    printf("HRV             MAE RMSSD %.1f ms, SDNN %.1f ms, pNN50 %.1f %% over %d s\n", rmssdErr / hrvScored,
+           sdnnErr / hrvScored, pnn50Err / hrvScored, hrvScored);
+    printf("HRV (end)       RMSSD %.1f / %.1f ms, SDNN %.1f / %.1f ms, pNN50 %.1f / %.1f %% (reference)\n",
+           m.rmssd, ref.rmssd, m.sdnn, ref.sdnn, m.pnn50, ref.pnn50);
+    printf("HRV intervals   %u accepted, %u rejected\n", hrvAccepted + hrv.accepted(),
+           hrvRejected + hrv.rejected());
+  }
+  return 0;
+}
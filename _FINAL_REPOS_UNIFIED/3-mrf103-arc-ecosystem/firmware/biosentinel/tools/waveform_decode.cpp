@@ -0,0 +1,289 @@
+/**
+ * BioSentinel waveform decoder (host)
+ * Decodes raw-mode binary WebSocket frames (waveform_stream.h) back into
+ * samples, checks frame sequence / stream index continuity, and measures
+ * the encoder's bandwidth and cost on a PPG trace.
+ *
+ *   g++ -std=c++17 -O2 -I.. waveform_decode.cpp -o waveform_decode
+ *
+ *   ./waveform_decode encode trace.csv frames.bin [batch_ms]
+ *   ./waveform_decode decode frames.bin [samples.csv]
+ *
+ * frames.bin is a capture: each frame as a little-endian u32 length
+ * followed by the frame bytes, the way the server stores binary messages.
+ * trace.csv is the ppg_replay format (timestamp_us,red,ir,...); encode
+ * round-trips it through the decoder and reports any mismatch.
+ *
+ * WaveformDecoder has no dependencies beyond the standard library so it
+ * can be lifted into server-side tooling as is.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "waveform_stream.h"
+
+// =============================================================================
+// Decoder
+// =============================================================================
+
+struct WaveformSample {
+  uint32_t index;
+  uint32_t timestampUs;
+  uint32_t red;
+  uint32_t ir;
+  int16_t accel[3];
+};
+
+struct WaveformFrameInfo {
+  uint8_t channels;
+  uint32_t sequence;
+  uint32_t firstIndex;
+  uint32_t firstUs;
+  uint16_t periodUs;
+  uint8_t count;
+};
+
+class WaveformDecoder {
+public:
+  /**
+   * Decode one frame, appending its samples to out
+   * @return false (and nothing appended) if the frame is malformed
+   */
+  bool decode(const uint8_t* data, size_t size, WaveformFrameInfo& info, std::vector<WaveformSample>& out);
+
+  // Continuity across the frames decoded so far
+  uint32_t frames() const { return _frames; }
+  uint32_t lostFrames() const { return _lostFrames; }
+  uint32_t lostSamples() const { return _lostSamples; }
+
+private:
+  bool _started = false;
+  uint32_t _nextSequence = 0;
+  uint32_t _nextIndex = 0;
+  uint32_t _frames = 0;
+  uint32_t _lostFrames = 0;
+  uint32_t _lostSamples = 0;
+
+  static bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value);
+  static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+};
+
+bool WaveformDecoder::getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 7 * WAVEFORM_MAX_VARINT; shift += 7) {
+    if (p >= end) return false;
+    uint8_t byte = *p++;
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+bool WaveformDecoder::decode(const uint8_t* data, size_t size, WaveformFrameInfo& info,
+                             std::vector<WaveformSample>& out) {
+  if (size < WAVEFORM_HEADER_BYTES || data[0] != 'B' || data[1] != 'W' || data[2] != WAVEFORM_VERSION) {
+    return false;
+  }
+  info.channels = data[3];
+  memcpy(&info.sequence, data + 4, 4);
+  memcpy(&info.firstIndex, data + 8, 4);
+  memcpy(&info.firstUs, data + 12, 4);
+  memcpy(&info.periodUs, data + 16, 2);
+  info.count = data[18];
+  if (info.count == 0 || info.count > WAVEFORM_MAX_BATCH) return false;
+
+  std::vector<WaveformSample> samples(info.count);
+  for (uint8_t i = 0; i < info.count; i++) {
+    samples[i] = {};
+    samples[i].index = info.firstIndex + i;
+    samples[i].timestampUs = info.firstUs + i * info.periodUs;
+  }
+
+  const uint8_t* p = data + WAVEFORM_HEADER_BYTES;
+  const uint8_t* end = data + size;
+  for (uint8_t ch = 0; ch < 5; ch++) {
+    uint8_t bit = ch < 2 ? (1 << ch) : WAVEFORM_CH_ACCEL;
+    if (!(info.channels & bit)) continue;
+    int32_t value = 0;
+    for (uint8_t i = 0; i < info.count; i++) {
+      uint32_t raw;
+      if (!getVarint(p, end, raw)) return false;
+      value += unzigzag(raw);
+      if (ch == 0) samples[i].red = (uint32_t)value;
+      else if (ch == 1) samples[i].ir = (uint32_t)value;
+      else samples[i].accel[ch - 2] = (int16_t)value;
+    }
+  }
+  if (p != end) return false;           // Trailing bytes: not a frame this version wrote
+
+  if (_started) {
+    _lostFrames += info.sequence - _nextSequence;
+    _lostSamples += info.firstIndex - _nextIndex;
+  }
+  _started = true;
+  _nextSequence = info.sequence + 1;
+  _nextIndex = info.firstIndex + info.count;
+  _frames++;
+
+  out.insert(out.end(), samples.begin(), samples.end());
+  return true;
+}
+
+// =============================================================================
+// Capture / trace files
+// =============================================================================
+
+static bool loadTrace(const char* path, std::vector<WaveformSample>& trace) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    WaveformSample s = {};
+    if (sscanf(line, "%u,%u,%u", &s.timestampUs, &s.red, &s.ir) != 3) continue;
+    s.index = (uint32_t)trace.size();
+    trace.push_back(s);
+  }
+  fclose(f);
+  return true;
+}
+
+static std::vector<std::vector<uint8_t>> loadCapture(const char* path) {
+  std::vector<std::vector<uint8_t>> frames;
+  FILE* f = fopen(path, "rb");
+  if (!f) return frames;
+  uint32_t length;
+  while (fread(&length, 4, 1, f) == 1) {
+    std::vector<uint8_t> frame(length);
+    if (fread(frame.data(), 1, length, f) != length) break;
+    frames.push_back(std::move(frame));
+  }
+  fclose(f);
+  return frames;
+}
+
+// =============================================================================
+// Modes
+// =============================================================================
+
+static int encode(const char* tracePath, const char* capturePath, uint16_t batchMs) {
+  std::vector<WaveformSample> trace;
+  if (!loadTrace(tracePath, trace) || trace.empty()) {
+    fprintf(stderr, "Cannot read %s\n", tracePath);
+    return 1;
+  }
+  FILE* out = fopen(capturePath, "wb");
+  if (!out) {
+    fprintf(stderr, "Cannot write %s\n", capturePath);
+    return 1;
+  }
+
+  WaveformEncoder encoder;
+  encoder.begin(WAVEFORM_CH_RED | WAVEFORM_CH_IR, 100, batchMs);
+  auto write = [&]() {
+    uint32_t length = (uint32_t)encoder.frameSize();
+    fwrite(&length, 4, 1, out);
+    fwrite(encoder.frame(), 1, length, out);
+  };
+  for (const WaveformSample& s : trace) {
+    if (encoder.add(s.index, s.timestampUs, s.red, s.ir)) write();
+  }
+  if (encoder.flush()) write();
+  fclose(out);
+
+  // Encoder cost alone, several passes
+  const int passes = 50;
+  size_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int p = 0; p < passes; p++) {
+    WaveformEncoder timed;
+    timed.begin(WAVEFORM_CH_RED | WAVEFORM_CH_IR, 100, batchMs);
+    for (const WaveformSample& s : trace) {
+      if (timed.add(s.index, s.timestampUs, s.red, s.ir)) sink += timed.frameSize();
+    }
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+              ((double)trace.size() * passes);
+
+  // Round trip
+  WaveformDecoder decoder;
+  std::vector<WaveformSample> decoded;
+  WaveformFrameInfo info;
+  size_t mismatches = 0;
+  for (const std::vector<uint8_t>& frame : loadCapture(capturePath)) {
+    if (!decoder.decode(frame.data(), frame.size(), info, decoded)) mismatches++;
+  }
+  for (size_t i = 0; i < trace.size(); i++) {
+    if (i >= decoded.size() || decoded[i].red != trace[i].red || decoded[i].ir != trace[i].ir) mismatches++;
+  }
+
+  const WaveformStats& stats = encoder.getStats();
+  double seconds = (trace.back().timestampUs - trace.front().timestampUs) / 1e6 + 0.01;
+  printf("Encoded %u samples into %u frames (%u samples / frame)\n", stats.samples, stats.frames,
+         encoder.batchSamples());
+  printf("payload         %.0f B/s, %.2f B per channel-sample (raw 3.00)\n", stats.bytes / seconds,
+         (stats.bytes - stats.frames * (double)WAVEFORM_HEADER_BYTES) / (2.0 * stats.samples));
+  printf("wire (est.)     %.0f B/s with 6 B WebSocket + ~30 B TLS per frame\n",
+         (stats.bytes + stats.frames * 36.0) / seconds);
+  printf("encoder         %.1f ns/sample (%zu)\n", ns, sink & 1);
+  printf("round trip      %s (%zu mismatches)\n", mismatches ? "FAILED" : "exact", mismatches);
+  return mismatches ? 1 : 0;
+}
+
+static int decode(const char* capturePath, const char* csvPath) {
+  std::vector<std::vector<uint8_t>> frames = loadCapture(capturePath);
+  if (frames.empty()) {
+    fprintf(stderr, "No frames in %s\n", capturePath);
+    return 1;
+  }
+
+  WaveformDecoder decoder;
+  std::vector<WaveformSample> samples;
+  WaveformFrameInfo info = {};
+  uint32_t malformed = 0;
+  uint8_t channels = 0;
+  for (const std::vector<uint8_t>& frame : frames) {
+    if (!decoder.decode(frame.data(), frame.size(), info, samples)) {
+      malformed++;
+      continue;
+    }
+    channels |= info.channels;
+  }
+
+  printf("frames          %u decoded, %u malformed, %u missing (sequence gaps)\n", decoder.frames(), malformed,
+         decoder.lostFrames());
+  printf("samples         %zu decoded, %u missing (stream index gaps)\n", samples.size(), decoder.lostSamples());
+
+  if (!csvPath) return 0;
+  FILE* f = fopen(csvPath, "w");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s\n", csvPath);
+    return 1;
+  }
+  bool accel = channels & WAVEFORM_CH_ACCEL;
+  fprintf(f, "index,timestamp_us,red,ir%s\n", accel ? ",ax,ay,az" : "");
+  for (const WaveformSample& s : samples) {
+    fprintf(f, "%u,%u,%u,%u", s.index, s.timestampUs, s.red, s.ir);
+    if (accel) fprintf(f, ",%d,%d,%d", s.accel[0], s.accel[1], s.accel[2]);
+    fprintf(f, "\n");
+  }
+  fclose(f);
+  printf("Wrote %s\n", csvPath);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "encode" && (argc == 4 || argc == 5)) {
+    return encode(argv[2], argv[3], argc == 5 ? (uint16_t)atoi(argv[4]) : WAVEFORM_BATCH_MS);
+  }
+  if (mode == "decode" && (argc == 3 || argc == 4)) {
+    return decode(argv[2], argc == 4 ? argv[3] : nullptr);
+  }
+  fprintf(stderr, "Usage: %s encode <trace.csv> <frames.bin> [batch_ms] | decode <frames.bin> [samples.csv]\n",
+          argv[0]);
+  return 2;
+}
@@ -0,0 +1,215 @@
+/**
+ * BioSentinel Waveform Stream
+ * Batches raw samples into compact binary WebSocket frames
+ *
+ * sensor_data carries one derived reading per second; raw mode sends the
+ * waveform itself so the server can re-analyse it. Samples are collected
+ * for WAVEFORM_BATCH_MS, then written channel by channel as zigzag varint
+ * deltas (the first value of each channel absolute). PPG moves by tens of
+ * counts per sample, so most deltas take one or two bytes instead of the
+ * three an 18-bit value needs raw.
+ *
+ * Frame layout (little endian):
+ *    0  u8[2]  magic "BW"
+ *    2  u8     version (WAVEFORM_VERSION)
+ *    3  u8     channels (WAVEFORM_CH_* bits)
+ *    4  u32    frame sequence - a jump means frames were not sent
+ *    8  u32    stream index of the first sample - a jump means samples were dropped
+ *   12  u32    timestamp of the first sample, us (sensor timeline)
+ *   16  u16    sample period, us (measured over the frame)
+ *   18  u8     sample count
+ *   19  u8     reserved (0)
+ *   20  per channel, in bit order: count varints (absolute, then deltas)
+ * A frame never spans a gap in the stream index, so every frame decodes to
+ * consecutive samples.
+ *
+ * Cost per second of waveform, 100 Hz red + IR, 250 ms batches (measured
+ * with tools/waveform_decode.cpp on the synthetic PPG trace):
+ *   payload  ~360 B/s (1.4 B per channel-sample vs 3 B raw, 600 B/s)
+ *   frames   4/s; +6 B WebSocket header (masked client frame) and ~30 B
+ *            TLS record each -> ~510 B/s, ~4 kbit/s on the wire
+ *            (100 ms batches: ~860 B/s, 500 ms: ~390 B/s)
+ *   CPU      ~16 ns per sample on the host; a few us per 100 samples on
+ *            the ESP32, negligible next to the TLS write of each frame
+ * The 1 Hz sensor_data JSON alone is ~250 B/s.
+ *
+ * Pure C++ so the host decoder can round-trip it.
+ */
+
+#ifndef WAVEFORM_STREAM_H
+#define WAVEFORM_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef WAVEFORM_BATCH_MS
+  #define WAVEFORM_BATCH_MS 250         // Default batch length
+#endif
+
+#define WAVEFORM_MAX_BATCH 64           // Samples per frame (640 ms at 100 Hz)
+#define WAVEFORM_VERSION 1
+#define WAVEFORM_HEADER_BYTES 20
+#define WAVEFORM_MAX_VARINT 5
+
+#define WAVEFORM_CH_RED 0x01
+#define WAVEFORM_CH_IR 0x02
+#define WAVEFORM_CH_ACCEL 0x04          // X, Y, Z (int16, raw counts)
+
+// Worst case: every value a full-length varint
+#define WAVEFORM_MAX_FRAME (WAVEFORM_HEADER_BYTES + 5 * WAVEFORM_MAX_BATCH * WAVEFORM_MAX_VARINT)
+
+struct WaveformStats {
+  uint32_t frames;                      // Completed
+  uint32_t samples;
+  uint32_t bytes;                       // Frame bytes produced
+  uint32_t gaps;                        // Stream index jumps seen
+};
+
+// =============================================================================
+// Waveform Encoder
+// =============================================================================
+
+class WaveformEncoder {
+public:
+  WaveformEncoder() : _sequence(0), _stats() { begin(WAVEFORM_CH_RED | WAVEFORM_CH_IR, 100, WAVEFORM_BATCH_MS); }
+
+  /**
+   * Select channels and batch length; discards a partial batch (the frame
+   * sequence carries on)
+   * @param batchMs Clamped to 1 .. WAVEFORM_MAX_BATCH samples
+   */
+  void begin(uint8_t channels, uint16_t sampleRate, uint16_t batchMs);
+
+  /**
+   * Add one sample
+   * @param accel X / Y / Z, required if WAVEFORM_CH_ACCEL is selected
+   * @return true if a frame is ready - send frame() / frameSize() before the next add()
+   */
+  bool add(uint32_t index, uint32_t timestampUs, uint32_t red, uint32_t ir, const int16_t* accel = nullptr);
+
+  // Close a partial batch (e.g. raw mode switched off)
+  bool flush();
+
+  const uint8_t* frame() const { return _frame; }
+  size_t frameSize() const { return _frameSize; }
+  uint8_t channels() const { return _channels; }
+  uint16_t batchSamples() const { return _batch; }
+  const WaveformStats& getStats() const { return _stats; }
+
+private:
+  uint8_t _channels;
+  uint16_t _batch;
+
+  uint32_t _values[5][WAVEFORM_MAX_BATCH]; // Red, IR, accel X / Y / Z (as uint32)
+  uint32_t _firstIndex;
+  uint32_t _firstUs;
+  uint32_t _lastUs;
+  uint8_t _count;
+  uint32_t _sequence;
+
+  uint8_t _frame[WAVEFORM_MAX_FRAME];
+  size_t _frameSize;
+  WaveformStats _stats;
+
+  bool finish();
+  static size_t putVarint(uint8_t* out, uint32_t value);
+  static uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+inline void WaveformEncoder::begin(uint8_t channels, uint16_t sampleRate, uint16_t batchMs) {
+  _channels = channels;
+  uint32_t batch = (uint32_t)batchMs * sampleRate / 1000;
+  if (batch < 1) batch = 1;
+  if (batch > WAVEFORM_MAX_BATCH) batch = WAVEFORM_MAX_BATCH;
+  _batch = (uint16_t)batch;
+  _count = 0;
+  _frameSize = 0;
+}
+
+inline bool WaveformEncoder::add(uint32_t index, uint32_t timestampUs, uint32_t red, uint32_t ir,
+                                 const int16_t* accel) {
+  // A frame holds consecutive samples only: close it at a gap, then start
+  // the next one with this sample
+  bool ready = false;
+  if (_count > 0 && index != _firstIndex + _count) {
+    _stats.gaps++;
+    ready = finish();
+  }
+
+  if (_count == 0) {
+    _firstIndex = index;
+    _firstUs = timestampUs;
+  }
+  _lastUs = timestampUs;
+  _values[0][_count] = red;
+  _values[1][_count] = ir;
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    _values[2 + axis][_count] = accel ? (uint32_t)(int32_t)accel[axis] : 0;
+  }
+  _count++;
+  _stats.samples++;
+
+  // A gap frame already waits to be sent; this batch closes on a later call
+  if (ready) return true;
+  return _count >= _batch ? finish() : false;
+}
+
+inline bool WaveformEncoder::flush() {
+  return _count > 0 ? finish() : false;
+}
+
+inline bool WaveformEncoder::finish() {
+  uint8_t* out = _frame;
+  uint16_t periodUs = _count > 1 ? (uint16_t)((_lastUs - _firstUs) / (_count - 1)) : 0;
+
+  out[0] = 'B';
+  out[1] = 'W';
+  out[2] = WAVEFORM_VERSION;
+  out[3] = _channels;
+  memcpy(out + 4, &_sequence, 4);       // Xtensa and x86 are little endian
+  memcpy(out + 8, &_firstIndex, 4);
+  memcpy(out + 12, &_firstUs, 4);
+  memcpy(out + 16, &periodUs, 2);
+  out[18] = _count;
+  out[19] = 0;
+  size_t size = WAVEFORM_HEADER_BYTES;
+
+  for (uint8_t ch = 0; ch < 5; ch++) {
+    uint8_t bit = ch < 2 ? (1 << ch) : WAVEFORM_CH_ACCEL;
+    if (!(_channels & bit)) continue;
+    const uint32_t* v = _values[ch];
+    int32_t prev = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      size += putVarint(out + size, zigzag((int32_t)v[i] - prev));
+      prev = (int32_t)v[i];
+    }
+  }
+
+  _frameSize = size;
+  _sequence++;
+  _count = 0;
+  _stats.frames++;
+  _stats.bytes += size;
+  return true;
+}
+
+inline size_t WaveformEncoder::putVarint(uint8_t* out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * BioSentinel WiFi Manager
+ * Non-blocking WiFi connection state machine with NVS credentials
+ *
+ * Same model as the xBio WiFi manager: credentials live in the "wifi" NVS
+ * namespace, and loop() moves DISCONNECTED -> CONNECTING -> CONNECTED
+ * without ever waiting, so sampling and reporting start at boot whether or
+ * not a network is there. Failed attempts back off from WIFI_RETRY_INTERVAL
+ * up to WIFI_RETRY_MAX. There is no AP / BLE provisioning on this board:
+ * credentials come from the serial console or the server ("wifi" command),
+ * with the compiled-in defaults used until NVS holds a pair.
+ */
+
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+#ifndef WIFI_CONNECT_TIMEOUT
+  #define WIFI_CONNECT_TIMEOUT 15000    // ms per attempt
+#endif
+
+#ifndef WIFI_RETRY_INTERVAL
+  #define WIFI_RETRY_INTERVAL 2000      // ms before the first retry
+#endif
+
+#ifndef WIFI_RETRY_MAX
+  #define WIFI_RETRY_MAX 60000          // Backoff ceiling
+#endif
+
+enum class WiFiState {
+  NO_CREDENTIALS,
+  DISCONNECTED,
+  CONNECTING,
+  CONNECTED
+};
+
+// =============================================================================
+// WiFi Manager
+// =============================================================================
+
+class BioWiFiManager {
+public:
+  typedef void (*ConnectionCallback)(bool connected);
+
+  /**
+   * Load credentials and start the first attempt (returns immediately)
+   * @param defaultSsid Used while NVS holds no credentials; nullptr or "" for none
+   */
+  void begin(const char* hostname, const char* defaultSsid = nullptr, const char* defaultPassword = nullptr);
+
+  // Advance the state machine - call every loop(), never blocks
+  void loop();
+
+  bool isConnected() const { return _state == WiFiState::CONNECTED; }
+  WiFiState getState() const { return _state; }
+  const char* getSSID() const { return _ssid; }
+
+  // Save to NVS and reconnect with them
+  void setCredentials(const char* ssid, const char* password);
+  void clearCredentials();
+
+  void setConnectionCallback(ConnectionCallback callback) { _callback = callback; }
+
+  // millis() of the first connection since boot, 0 until then
+  uint32_t firstConnectMs() const { return _firstConnectMs; }
+  uint32_t disconnects() const { return _disconnects; }
+
+  static const char* stateName(WiFiState state);
+
+private:
+  char _ssid[33] = {};
+  char _password[65] = {};
+  WiFiState _state = WiFiState::NO_CREDENTIALS;
+  uint32_t _attemptMs = 0;              // Start of the current / last attempt
+  uint32_t _retryMs = WIFI_RETRY_INTERVAL;
+  uint32_t _firstConnectMs = 0;
+  uint32_t _disconnects = 0;
+  ConnectionCallback _callback = nullptr;
+  Preferences _prefs;
+
+  void attempt();
+};
+
+// =============================================================================
+// Implementation
+// =============================================================================
+
+void BioWiFiManager::begin(const char* hostname, const char* defaultSsid, const char* defaultPassword) {
+  WiFi.mode(WIFI_STA);
+  WiFi.setHostname(hostname);
+  WiFi.setAutoReconnect(false);         // Retries are ours, with backoff
+
+  _prefs.begin("wifi", true);
+  String ssid = _prefs.getString("ssid", "");
+  String password = _prefs.getString("password", "");
+  _prefs.end();
+
+  if (ssid.length() > 0) {
+    strncpy(_ssid, ssid.c_str(), sizeof(_ssid) - 1);
+    strncpy(_password, password.c_str(), sizeof(_password) - 1);
+    Serial.printf("[WIFI] Saved credentials for %s\n", _ssid);
+  } else if (defaultSsid && defaultSsid[0]) {
+    strncpy(_ssid, defaultSsid, sizeof(_ssid) - 1);
+    strncpy(_password, defaultPassword ? defaultPassword : "", sizeof(_password) - 1);
+    Serial.printf("[WIFI] Using built-in credentials for %s\n", _ssid);
+  }
+
+  if (_ssid[0]) {
+    attempt();
+  } else {
+    Serial.println("[WIFI] No credentials - send \"wifi <ssid> <password>\" on the serial console");
+  }
+}
+
+void BioWiFiManager::loop() {
+  uint32_t now = millis();
+
+  switch (_state) {
+    case WiFiState::NO_CREDENTIALS:
+      break;
+
+    case WiFiState::DISCONNECTED:
+      if (now - _attemptMs >= _retryMs) {
+        _retryMs = _retryMs * 2 > WIFI_RETRY_MAX ? WIFI_RETRY_MAX : _retryMs * 2; // Next failure waits longer
+        attempt();
+      }
+      break;
+
+    case WiFiState::CONNECTING:
+      if (WiFi.status() == WL_CONNECTED) {
+        _state = WiFiState::CONNECTED;
+        _retryMs = WIFI_RETRY_INTERVAL;
+        if (!_firstConnectMs) _firstConnectMs = now ? now : 1;
+        Serial.printf("[WIFI] Connected to %s, IP %s (%lu ms)\n", _ssid, WiFi.localIP().toString().c_str(),
+                      (unsigned long)(now - _attemptMs));
+        if (_callback) _callback(true);
+      } else if (now - _attemptMs >= WIFI_CONNECT_TIMEOUT) {
+        WiFi.disconnect();
+        _state = WiFiState::DISCONNECTED;
+        _attemptMs = now;
+        Serial.printf("[WIFI] Connection timeout, retry in %lu s\n", (unsigned long)(_retryMs / 1000));
+      }
+      break;
+
+    case WiFiState::CONNECTED:
+      if (WiFi.status() != WL_CONNECTED) {
+        _state = WiFiState::DISCONNECTED;
+        _disconnects++;
+        Serial.println("[WIFI] Connection lost");
+        if (_callback) _callback(false);
+        attempt();                        // Retry straight away once
+      }
+      break;
+  }
+}
+
+void BioWiFiManager::attempt() {
+  Serial.printf("[WIFI] Connecting to %s...\n", _ssid);
+  WiFi.begin(_ssid, _password);
+  _state = WiFiState::CONNECTING;
+  _attemptMs = millis();
+}
+
+void BioWiFiManager::setCredentials(const char* ssid, const char* password) {
+  memset(_ssid, 0, sizeof(_ssid));
+  memset(_password, 0, sizeof(_password));
+  strncpy(_ssid, ssid, sizeof(_ssid) - 1);
+  strncpy(_password, password ? password : "", sizeof(_password) - 1);
+
+  _prefs.begin("wifi", false);
+  _prefs.putString("ssid", _ssid);
+  _prefs.putString("password", _password);
+  _prefs.end();
+  Serial.printf("[WIFI] Saved credentials for %s\n", _ssid);
+
+  bool wasConnected = _state == WiFiState::CONNECTED;
+  WiFi.disconnect();
+  _retryMs = WIFI_RETRY_INTERVAL;
+  if (wasConnected && _callback) _callback(false);
+  attempt();
+}
+
+void BioWiFiManager::clearCredentials() {
+  memset(_ssid, 0, sizeof(_ssid));
+  memset(_password, 0, sizeof(_password));
+  _prefs.begin("wifi", false);
+  _prefs.clear();
+  _prefs.end();
+
+  bool wasConnected = _state == WiFiState::CONNECTED;
+  WiFi.disconnect();
+  _state = WiFiState::NO_CREDENTIALS;
+  if (wasConnected && _callback) _callback(false);
+}
+
+const char* BioWiFiManager::stateName(WiFiState state) {
+  switch (state) {
+    case WiFiState::NO_CREDENTIALS: return "no_credentials";
+    case WiFiState::DISCONNECTED:   return "disconnected";
+    case WiFiState::CONNECTING:     return "connecting";
+    case WiFiState::CONNECTED:      return "connected";
+  }
+  return "unknown";
+}
+
+#endif
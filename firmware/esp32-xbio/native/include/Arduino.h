@@ -0,0 +1,221 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🖥️ xBio native HAL - Arduino core shim
+ * millis() / delay() on the virtual clock, Serial on stdout, GPIO, ESP.*,
+ * and the handful of FreeRTOS calls the firmware makes (tasks are threads).
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef HAL_ARDUINO_H
+#define HAL_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "hal_native.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "esp_attr.h"
+#include "esp32-hal-psram.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+
+using std::max;
+using std::min;
+
+#ifndef PI
+  #define PI 3.1415926535897932384626433832795
+#endif
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * PI / 180.0)
+#define degrees(rad) ((rad) * 180.0 / PI)
+#define sq(x) ((x) * (x))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Time
+// ═══════════════════════════════════════════════════════════════════════════════
+inline unsigned long millis() { return (unsigned long)(uint32_t)(hal::Clock::nowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)(uint32_t)hal::Clock::nowUs(); }
+inline void delay(uint32_t ms) { hal::Clock::sleepUs((uint64_t)ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { hal::Clock::sleepUs(us); }
+inline void yield() { if (!hal::Clock::isOwner()) hal::Clock::sleepUs(0); }
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// GPIO
+// ═══════════════════════════════════════════════════════════════════════════════
+inline void pinMode(uint8_t pin, uint8_t mode) { hal::Gpio::setMode(pin, mode); }
+inline void digitalWrite(uint8_t pin, uint8_t value) { hal::Gpio::write(pin, value); }
+inline int digitalRead(uint8_t pin) { return hal::Gpio::read(pin); }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int mode) { hal::Gpio::attach(pin, isr, mode); }
+inline void detachInterrupt(uint8_t pin) { hal::Gpio::detach(pin); }
+inline uint16_t analogRead(uint8_t) { return 0; }
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Random
+// ═══════════════════════════════════════════════════════════════════════════════
+inline void randomSeed(unsigned long seed) { if (seed) hal::System::seed((uint32_t)seed); }
+inline long random(long howBig) { return howBig <= 0 ? 0 : (long)(hal::System::random() % (uint32_t)howBig); }
+inline long random(long howSmall, long howBig) {
+  return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+// SNTP is not simulated: time(nullptr) stays host wall-clock time
+inline void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                       const char* server2 = nullptr, const char* server3 = nullptr) {
+  (void)gmtOffsetSec; (void)daylightOffsetSec; (void)server1; (void)server2; (void)server3;
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Serial
+// ═══════════════════════════════════════════════════════════════════════════════
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end() {}
+  operator bool() const { return true; }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    hal::Console::written += size;
+    if (hal::Console::echo) fwrite(buffer, 1, size, stdout);
+    return size;
+  }
+  using Print::write;
+  void flush() override { fflush(stdout); }
+
+  int available() override { return hal::Console::available(); }
+  int read() override { return hal::Console::read(); }
+  int peek() override { return hal::Console::peek(); }
+};
+
+inline HardwareSerial Serial;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// ESP
+// ═══════════════════════════════════════════════════════════════════════════════
+class EspClass {
+public:
+  [[noreturn]] void restart() { hal::System::reset("ESP.restart()"); }
+
+  uint32_t getFreeHeap() { return hal::System::freeHeap; }
+  uint32_t getMinFreeHeap() { return hal::System::freeHeap; }
+  uint32_t getMaxAllocHeap() { return hal::System::freeHeap / 2; }
+  uint32_t getHeapSize() { return 320 * 1024; }
+  uint32_t getPsramSize() { return hal::System::psramSize; }
+  uint32_t getFreePsram() { return hal::System::psramSize; }
+
+  // Host time at the nominal clock, so cycle deltas are real measurements
+  uint32_t getCycleCount() { return (uint32_t)(hal::hostNs() * hal::System::cpuMHz / 1000); }
+  uint32_t getCpuFreqMHz() { return hal::System::cpuMHz; }
+
+  const char* getChipModel() { return "ESP32-S3 (native)"; }
+  uint8_t getChipRevision() { return 0; }
+  uint8_t getChipCores() { return 2; }
+  const char* getSdkVersion() { return "native"; }
+  uint32_t getFlashChipSize() { return 16 * 1024 * 1024; }
+  uint32_t getSketchSize() { return (uint32_t)hal::Flash::running.size(); }
+  uint32_t getFreeSketchSpace() { return (uint32_t)hal::Flash::partitionSize; }
+  uint64_t getEfuseMac() {
+    uint64_t mac = 0;
+    for (int i = 5; i >= 0; i--) mac = (mac << 8) | hal::System::mac[i];
+    return mac;
+  }
+};
+
+inline EspClass ESP;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// FreeRTOS (tasks run as host threads, ticks are 1 ms of virtual time)
+// ═══════════════════════════════════════════════════════════════════════════════
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+namespace hal {
+// Thrown by vTaskDelete(nullptr) to unwind the task thread
+struct TaskExit {};
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  int slot = hal::Clock::reserveTask();
+  if (slot < 0) return pdFAIL;
+  std::thread([fn, arg, slot]() {
+    hal::Clock::enterTask(slot);
+    try {
+      fn(arg);
+    } catch (const hal::TaskExit&) {
+    }
+    hal::Clock::exitTask();
+  }).detach();
+  if (handle) *handle = (TaskHandle_t)1;
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, handle, tskNO_AFFINITY);
+}
+
+inline void vTaskDelete(TaskHandle_t handle) {
+  if (handle == nullptr) throw hal::TaskExit();
+}
+
+inline void vTaskDelay(TickType_t ticks) { hal::Clock::sleepUs((uint64_t)ticks * 1000); }
+inline TickType_t xTaskGetTickCount() { return (TickType_t)(hal::Clock::nowUs() / 1000); }
+inline void taskYIELD() { yield(); }
+inline BaseType_t xPortGetCoreID() { return hal::Clock::isOwner() ? 1 : 0; }
+
+typedef std::recursive_mutex portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->lock()
+#define portEXIT_CRITICAL(mux) (mux)->unlock()
+#define portENTER_CRITICAL_ISR(mux) (mux)->lock()
+#define portEXIT_CRITICAL_ISR(mux) (mux)->unlock()
+
+#endif // HAL_ARDUINO_H
@@ -0,0 +1,51 @@
+/**
+ * Native shim: ArduinoOTA (no espota listener on the host; handlers are kept)
+ */
+
+#ifndef HAL_ARDUINOOTA_H
+#define HAL_ARDUINOOTA_H
+
+#include <functional>
+#include "Arduino.h"
+
+typedef enum {
+  OTA_AUTH_ERROR,
+  OTA_BEGIN_ERROR,
+  OTA_CONNECT_ERROR,
+  OTA_RECEIVE_ERROR,
+  OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+  typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+  ArduinoOTAClass& setHostname(const char* hostname) { _hostname = hostname ? hostname : ""; return *this; }
+  ArduinoOTAClass& setPassword(const char*) { return *this; }
+  ArduinoOTAClass& setPort(uint16_t) { return *this; }
+  ArduinoOTAClass& onStart(THandlerFunction fn) { _start = fn; return *this; }
+  ArduinoOTAClass& onEnd(THandlerFunction fn) { _end = fn; return *this; }
+  ArduinoOTAClass& onError(THandlerFunction_Error fn) { _error = fn; return *this; }
+  ArduinoOTAClass& onProgress(THandlerFunction_Progress fn) { _progress = fn; return *this; }
+
+  void begin() { _started = true; }
+  void end() { _started = false; }
+  void handle() {}
+
+  const char* getHostname() const { return _hostname.c_str(); }
+  bool started() const { return _started; }
+
+private:
+  std::string _hostname;
+  bool _started = false;
+  THandlerFunction _start;
+  THandlerFunction _end;
+  THandlerFunction_Error _error;
+  THandlerFunction_Progress _progress;
+};
+
+inline ArduinoOTAClass ArduinoOTA;
+
+#endif // HAL_ARDUINOOTA_H
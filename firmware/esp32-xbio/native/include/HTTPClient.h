@@ -0,0 +1,104 @@
+/**
+ * Native shim: HTTPClient (GET only)
+ * Requests go out as HTTP/1.0 so the body is never chunked: it is either
+ * Content-Length bytes or runs to connection close, read through
+ * getStreamPtr() exactly as on the device.
+ */
+
+#ifndef HAL_HTTPCLIENT_H
+#define HAL_HTTPCLIENT_H
+
+#include "WiFiClient.h"
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+public:
+  ~HTTPClient() { end(); }
+
+  void setTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+  void useHTTP10(bool) {} // Always HTTP/1.0
+
+  bool begin(WiFiClient& client, const String& url) {
+    end();
+    std::string u = url.c_str();
+    size_t scheme = u.find("://");
+    if (scheme == std::string::npos) return false;
+    _port = u.compare(0, scheme, "https") == 0 ? 443 : 80;
+    std::string rest = u.substr(scheme + 3);
+    size_t slash = rest.find('/');
+    std::string hostPort = rest.substr(0, slash);
+    _path = slash == std::string::npos ? "/" : rest.substr(slash);
+    size_t colon = hostPort.find(':');
+    if (colon != std::string::npos) {
+      _port = (uint16_t)atoi(hostPort.c_str() + colon + 1);
+      hostPort.resize(colon);
+    }
+    if (hostPort.empty()) return false;
+    _host = hostPort;
+    _client = &client;
+    return true;
+  }
+
+  int GET() {
+    if (!_client) return HTTPC_ERROR_NOT_CONNECTED;
+    if (!_client->connect(_host.c_str(), _port)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    std::string request = "GET " + _path + " HTTP/1.0\r\nHost: " + _host +
+                          "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: close\r\n\r\n";
+    if (_client->write((const uint8_t*)request.data(), request.size()) != request.size()) {
+      return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    int code = HTTPC_ERROR_READ_TIMEOUT;
+    std::string line;
+    bool statusLine = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeoutMs);
+    while (std::chrono::steady_clock::now() < deadline) {
+      int c = _client->read();
+      if (c < 0) {
+        if (!_client->connected()) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      if (c != '\n') {
+        if (c != '\r') line += (char)c;
+        continue;
+      }
+      if (statusLine) {
+        size_t space = line.find(' ');
+        code = space == std::string::npos ? HTTPC_ERROR_READ_TIMEOUT : atoi(line.c_str() + space + 1);
+        statusLine = false;
+      } else if (line.empty()) {
+        return code; // Body follows
+      } else if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+        _size = atoi(line.c_str() + 15);
+      }
+      line.clear();
+    }
+    return statusLine ? HTTPC_ERROR_READ_TIMEOUT : code;
+  }
+
+  int getSize() const { return _size; }
+  WiFiClient* getStreamPtr() { return _client; }
+  WiFiClient& getStream() { return *_client; }
+
+  void end() {
+    if (_client) _client->stop();
+    _client = nullptr;
+    _size = -1;
+  }
+
+private:
+  WiFiClient* _client = nullptr;
+  std::string _host;
+  std::string _path;
+  uint16_t _port = 80;
+  int _size = -1;
+  uint32_t _timeoutMs = 5000;
+};
+
+#endif // HAL_HTTPCLIENT_H
@@ -0,0 +1,50 @@
+/**
+ * Native shim: Arduino IPAddress (IPv4)
+ */
+
+#ifndef HAL_IPADDRESS_H
+#define HAL_IPADDRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "WString.h"
+
+class IPAddress {
+public:
+  IPAddress() : _bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+  IPAddress(uint32_t address) { memcpy(_bytes, &address, 4); }  // Network order, as the core stores it
+  IPAddress(const uint8_t* address) { memcpy(_bytes, address, 4); }
+
+  operator uint32_t() const {
+    uint32_t v;
+    memcpy(&v, _bytes, 4);
+    return v;
+  }
+  uint8_t operator[](int i) const { return _bytes[i]; }
+  uint8_t& operator[](int i) { return _bytes[i]; }
+  bool operator==(const IPAddress& other) const { return memcmp(_bytes, other._bytes, 4) == 0; }
+  bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+  bool fromString(const char* s) {
+    unsigned a, b, c, d;
+    char tail;
+    if (sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+      return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(buf);
+  }
+
+private:
+  uint8_t _bytes[4];
+};
+
+#endif // HAL_IPADDRESS_H
@@ -0,0 +1,189 @@
+/**
+ * Native shim: NimBLE peripheral as an in-memory GATT table
+ * No radio: a test plays the central through NimBLEServer::simulateConnect()
+ * / simulateDisconnect() and NimBLECharacteristic::simulateWrite(), and reads
+ * what the firmware published with getValue() / notifyCount().
+ */
+
+#ifndef HAL_NIMBLEDEVICE_H
+#define HAL_NIMBLEDEVICE_H
+
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+
+typedef enum { ESP_PWR_LVL_N12 = 0, ESP_PWR_LVL_N9, ESP_PWR_LVL_N6, ESP_PWR_LVL_N3, ESP_PWR_LVL_N0,
+               ESP_PWR_LVL_P3, ESP_PWR_LVL_P6, ESP_PWR_LVL_P9 } esp_power_level_t;
+
+namespace NIMBLE_PROPERTY {
+enum : uint16_t {
+  BROADCAST = 0x0001,
+  READ = 0x0002,
+  WRITE_NR = 0x0004,
+  WRITE = 0x0008,
+  NOTIFY = 0x0010,
+  INDICATE = 0x0020
+};
+}
+
+class NimBLEAttValue {
+public:
+  NimBLEAttValue() {}
+  NimBLEAttValue(const uint8_t* data, size_t length) : _bytes((const char*)data, length) {}
+
+  const uint8_t* data() const { return (const uint8_t*)_bytes.data(); }
+  size_t length() const { return _bytes.size(); }
+  size_t size() const { return _bytes.size(); }
+  const char* c_str() const { return _bytes.c_str(); }
+  operator std::string() const { return _bytes; }
+
+private:
+  std::string _bytes;
+};
+
+class NimBLECharacteristic;
+class NimBLEServer;
+
+class NimBLECharacteristicCallbacks {
+public:
+  virtual ~NimBLECharacteristicCallbacks() {}
+  virtual void onRead(NimBLECharacteristic*) {}
+  virtual void onWrite(NimBLECharacteristic*) {}
+};
+
+class NimBLEServerCallbacks {
+public:
+  virtual ~NimBLEServerCallbacks() {}
+  virtual void onConnect(NimBLEServer*) {}
+  virtual void onDisconnect(NimBLEServer*) {}
+};
+
+class NimBLECharacteristic {
+public:
+  NimBLECharacteristic(const char* uuid, uint16_t properties) : _uuid(uuid), _properties(properties) {}
+
+  void setValue(const uint8_t* data, size_t length) { _value = NimBLEAttValue(data, length); }
+  void setValue(const char* s) { setValue((const uint8_t*)s, strlen(s)); }
+  void setValue(const String& s) { setValue((const uint8_t*)s.c_str(), s.length()); }
+  void setValue(const std::string& s) { setValue((const uint8_t*)s.data(), s.size()); }
+  NimBLEAttValue getValue() const { return _value; }
+
+  void setCallbacks(NimBLECharacteristicCallbacks* callbacks) { _callbacks = callbacks; }
+  void notify(bool = true) { if (_properties & NIMBLE_PROPERTY::NOTIFY) _notifies++; }
+
+  const std::string& getUUID() const { return _uuid; }
+  uint16_t getProperties() const { return _properties; }
+  uint32_t notifyCount() const { return _notifies; }
+
+  // Central side: a write from the connected client
+  void simulateWrite(const uint8_t* data, size_t length) {
+    setValue(data, length);
+    if (_callbacks) _callbacks->onWrite(this);
+  }
+  void simulateWrite(const char* s) { simulateWrite((const uint8_t*)s, strlen(s)); }
+
+private:
+  std::string _uuid;
+  uint16_t _properties;
+  NimBLEAttValue _value;
+  NimBLECharacteristicCallbacks* _callbacks = nullptr;
+  uint32_t _notifies = 0;
+};
+
+class NimBLEService {
+public:
+  explicit NimBLEService(const char* uuid) : _uuid(uuid) {}
+
+  NimBLECharacteristic* createCharacteristic(const char* uuid, uint16_t properties) {
+    _characteristics.emplace_back(new NimBLECharacteristic(uuid, properties));
+    return _characteristics.back().get();
+  }
+  NimBLECharacteristic* getCharacteristic(const char* uuid) {
+    for (auto& c : _characteristics) if (c->getUUID() == uuid) return c.get();
+    return nullptr;
+  }
+  bool start() { _started = true; return true; }
+  bool isStarted() const { return _started; }
+  const std::string& getUUID() const { return _uuid; }
+
+private:
+  std::string _uuid;
+  std::vector<std::unique_ptr<NimBLECharacteristic>> _characteristics;
+  bool _started = false;
+};
+
+class NimBLEServer {
+public:
+  void setCallbacks(NimBLEServerCallbacks* callbacks) { _callbacks = callbacks; }
+  NimBLEService* createService(const char* uuid) {
+    _services.emplace_back(new NimBLEService(uuid));
+    return _services.back().get();
+  }
+  NimBLEService* getServiceByUUID(const char* uuid) {
+    for (auto& s : _services) if (s->getUUID() == uuid) return s.get();
+    return nullptr;
+  }
+  size_t getConnectedCount() const { return _connected; }
+
+  void simulateConnect() {
+    _connected++;
+    if (_callbacks) _callbacks->onConnect(this);
+  }
+  void simulateDisconnect() {
+    if (_connected) _connected--;
+    if (_callbacks) _callbacks->onDisconnect(this);
+  }
+
+private:
+  NimBLEServerCallbacks* _callbacks = nullptr;
+  std::vector<std::unique_ptr<NimBLEService>> _services;
+  size_t _connected = 0;
+};
+
+class NimBLEAdvertising {
+public:
+  void addServiceUUID(const char*) {}
+  void setScanResponse(bool) {}
+  void setMinPreferred(uint16_t) {}
+  void setMaxPreferred(uint16_t) {}
+  bool start() { _advertising = true; return true; }
+  bool stop() { _advertising = false; return true; }
+  bool isAdvertising() const { return _advertising; }
+
+private:
+  bool _advertising = false;
+};
+
+class NimBLEDevice {
+public:
+  static void init(const std::string& name) { _name = name; _initialized = true; }
+  static void init(const String& name) { init(std::string(name.c_str())); }
+  static void init(const char* name) { init(std::string(name ? name : "")); }
+  static void deinit(bool clearAll = false) {
+    _initialized = false;
+    if (clearAll) {
+      _server.reset();
+      _advertising.reset();
+    }
+  }
+  static void setPower(esp_power_level_t) {}
+  static bool getInitialized() { return _initialized; }
+
+  static NimBLEServer* createServer() {
+    if (!_server) _server.reset(new NimBLEServer());
+    return _server.get();
+  }
+  static NimBLEServer* getServer() { return _server.get(); }
+  static NimBLEAdvertising* getAdvertising() {
+    if (!_advertising) _advertising.reset(new NimBLEAdvertising());
+    return _advertising.get();
+  }
+
+private:
+  static inline std::string _name;
+  static inline bool _initialized = false;
+  static inline std::unique_ptr<NimBLEServer> _server;
+  static inline std::unique_ptr<NimBLEAdvertising> _advertising;
+};
+
+#endif // HAL_NIMBLEDEVICE_H
@@ -0,0 +1,111 @@
+/**
+ * Native shim: Preferences on hal::Nvs
+ * Values are stored as raw bytes per key, so typed getters read what the
+ * matching putter wrote; the store outlives the object (and simulated reboots).
+ */
+
+#ifndef HAL_PREFERENCES_H
+#define HAL_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+  ~Preferences() { end(); }
+
+  bool begin(const char* name, bool readOnly = false, const char* partition = nullptr) {
+    (void)partition;
+    if (!name || strlen(name) > 15) return false;
+    _name = name;
+    _readOnly = readOnly;
+    _open = true;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    hal::Nvs::space(_name);
+    return true;
+  }
+  void end() { _open = false; }
+
+  bool clear() {
+    if (!writable()) return false;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    hal::Nvs::space(_name).clear();
+    return true;
+  }
+  bool remove(const char* key) {
+    if (!writable()) return false;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    return hal::Nvs::space(_name).erase(key) > 0;
+  }
+  bool isKey(const char* key) {
+    if (!_open) return false;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    return hal::Nvs::space(_name).count(key) > 0;
+  }
+
+  size_t putBytes(const char* key, const void* value, size_t length) {
+    if (!writable() || !key || strlen(key) > 15) return 0;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    const uint8_t* bytes = (const uint8_t*)value;
+    hal::Nvs::space(_name)[key].assign(bytes, bytes + length);
+    return length;
+  }
+  size_t getBytesLength(const char* key) {
+    if (!_open) return 0;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    hal::Nvs::Namespace& space = hal::Nvs::space(_name);
+    auto it = space.find(key);
+    return it == space.end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char* key, void* buffer, size_t maxLength) {
+    if (!_open) return 0;
+    std::lock_guard<std::mutex> guard(hal::Nvs::lock());
+    hal::Nvs::Namespace& space = hal::Nvs::space(_name);
+    auto it = space.find(key);
+    if (it == space.end() || it->second.size() > maxLength) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+  size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value)); }
+  size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+  String getString(const char* key, const String& defaultValue = String()) {
+    size_t length = getBytesLength(key);
+    if (!length && !isKey(key)) return defaultValue;
+    std::string value(length, '\0');
+    getBytes(key, &value[0], length);
+    return String(value);
+  }
+
+  size_t putBool(const char* key, bool value) { return put(key, (uint8_t)(value ? 1 : 0)); }
+  size_t putUChar(const char* key, uint8_t value) { return put(key, value); }
+  size_t putUShort(const char* key, uint16_t value) { return put(key, value); }
+  size_t putInt(const char* key, int32_t value) { return put(key, value); }
+  size_t putUInt(const char* key, uint32_t value) { return put(key, value); }
+  size_t putLong(const char* key, int32_t value) { return put(key, value); }
+  size_t putULong(const char* key, uint32_t value) { return put(key, value); }
+  size_t putFloat(const char* key, float value) { return put(key, value); }
+
+  bool getBool(const char* key, bool defaultValue = false) { return get<uint8_t>(key, defaultValue ? 1 : 0) != 0; }
+  uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return get(key, defaultValue); }
+  uint16_t getUShort(const char* key, uint16_t defaultValue = 0) { return get(key, defaultValue); }
+  int32_t getInt(const char* key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+  int32_t getLong(const char* key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+  uint32_t getULong(const char* key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+  float getFloat(const char* key, float defaultValue = 0) { return get(key, defaultValue); }
+
+private:
+  std::string _name;
+  bool _readOnly = false;
+  bool _open = false;
+
+  bool writable() const { return _open && !_readOnly; }
+
+  template <typename T> size_t put(const char* key, T value) { return putBytes(key, &value, sizeof(T)); }
+  template <typename T> T get(const char* key, T defaultValue) {
+    T value;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+  }
+};
+
+#endif // HAL_PREFERENCES_H
@@ -0,0 +1,58 @@
+/**
+ * Native shim: Arduino Stream
+ * Timed reads wait in virtual time (hal::Clock), like the core's millis() loop.
+ */
+
+#ifndef HAL_STREAM_H
+#define HAL_STREAM_H
+
+#include "Print.h"
+#include "hal_native.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { _timeout = timeoutMs; }
+  unsigned long getTimeout() const { return _timeout; }
+
+  virtual size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+  virtual size_t readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) break;
+      buffer[count++] = (uint8_t)c;
+    }
+    return count;
+  }
+
+  String readString() {
+    String out;
+    for (int c = timedRead(); c >= 0; c = timedRead()) out.concat((char)c);
+    return out;
+  }
+
+  String readStringUntil(char terminator) {
+    String out;
+    for (int c = timedRead(); c >= 0 && c != terminator; c = timedRead()) out.concat((char)c);
+    return out;
+  }
+
+protected:
+  unsigned long _timeout = 1000;
+
+  int timedRead() {
+    uint64_t start = hal::Clock::nowUs();
+    do {
+      int c = read();
+      if (c >= 0) return c;
+      hal::Clock::sleepUs(1000);
+    } while (hal::Clock::nowUs() - start < (uint64_t)_timeout * 1000);
+    return -1;
+  }
+};
+
+#endif // HAL_STREAM_H
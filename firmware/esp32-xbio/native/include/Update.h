@@ -0,0 +1,92 @@
+/**
+ * Native shim: Update writes the new image into hal::Flash::update
+ */
+
+#ifndef HAL_UPDATE_H
+#define HAL_UPDATE_H
+
+#include "Arduino.h"
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_ABORT 8
+#define UPDATE_ERROR_BAD_ARGUMENT 9
+
+class UpdateClass {
+public:
+  bool begin(size_t size = UPDATE_SIZE_UNKNOWN) {
+    if (_running) {
+      _error = UPDATE_ERROR_BAD_ARGUMENT;
+      return false;
+    }
+    if (size == 0 || (size != UPDATE_SIZE_UNKNOWN && size > hal::Flash::partitionSize)) {
+      _error = size == 0 ? UPDATE_ERROR_SIZE : UPDATE_ERROR_SPACE;
+      return false;
+    }
+    _size = size == UPDATE_SIZE_UNKNOWN ? hal::Flash::partitionSize : size;
+    _fixedSize = size != UPDATE_SIZE_UNKNOWN;
+    hal::Flash::update.clear();
+    hal::Flash::updateReady = false;
+    _error = UPDATE_ERROR_OK;
+    _running = true;
+    return true;
+  }
+
+  size_t write(uint8_t* data, size_t length) {
+    if (!_running || _error) return 0;
+    if (hal::Flash::update.size() + length > _size) {
+      _error = UPDATE_ERROR_SPACE;
+      return 0;
+    }
+    hal::Flash::update.insert(hal::Flash::update.end(), data, data + length);
+    return length;
+  }
+
+  bool end(bool evenIfRemaining = false) {
+    if (!_running || _error) return false;
+    _running = false;
+    if (_fixedSize && hal::Flash::update.size() != _size && !evenIfRemaining) {
+      _error = UPDATE_ERROR_SIZE;
+      return false;
+    }
+    hal::Flash::updateReady = true;
+    return true;
+  }
+
+  void abort() {
+    if (_running) _error = UPDATE_ERROR_ABORT;
+    _running = false;
+  }
+
+  bool isRunning() const { return _running; }
+  bool hasError() const { return _error != UPDATE_ERROR_OK; }
+  uint8_t getError() const { return _error; }
+  size_t size() const { return _size; }
+  size_t progress() const { return hal::Flash::update.size(); }
+  size_t remaining() const { return _size - progress(); }
+
+  const char* errorString() const {
+    switch (_error) {
+      case UPDATE_ERROR_OK: return "No Error";
+      case UPDATE_ERROR_WRITE: return "Flash Write Failed";
+      case UPDATE_ERROR_SPACE: return "Not Enough Space";
+      case UPDATE_ERROR_SIZE: return "Bad Size Given";
+      case UPDATE_ERROR_ABORT: return "Update Aborted";
+      default: return "Bad Argument";
+    }
+  }
+
+private:
+  bool _running = false;
+  bool _fixedSize = false;
+  size_t _size = 0;
+  uint8_t _error = UPDATE_ERROR_OK;
+};
+
+inline UpdateClass Update;
+
+#endif // HAL_UPDATE_H
@@ -0,0 +1,164 @@
+/**
+ * Native shim: Arduino String on top of std::string
+ * Same interface as the ESP32 core's String for everything the firmware and
+ * its libraries (ArduinoJson, PubSubClient) use.
+ */
+
+#ifndef HAL_WSTRING_H
+#define HAL_WSTRING_H
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+class __FlashStringHelper;
+#define F(s) (s)
+#define PSTR(s) (s)
+
+class String {
+public:
+  String(const char* s = "") : _s(s ? s : "") {}
+  String(const char* s, size_t length) : _s(s ? std::string(s, length) : std::string()) {}
+  String(const std::string& s) : _s(s) {}
+  String(const String& other) = default;
+  String(String&& other) noexcept = default;
+  explicit String(char c) : _s(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10) : String((unsigned long)value, base) {}
+  explicit String(int value, unsigned char base = 10) : String((long)value, base) {}
+  explicit String(unsigned int value, unsigned char base = 10) : String((unsigned long)value, base) {}
+  explicit String(long value, unsigned char base = 10) {
+    if (base == 10) {
+      _s = std::to_string(value);
+    } else {
+      _s = value < 0 ? "-" + digits((unsigned long)-value, base) : digits((unsigned long)value, base);
+    }
+  }
+  explicit String(unsigned long value, unsigned char base = 10) : _s(digits(value, base)) {}
+  explicit String(long long value, unsigned char base = 10) : String((long)value, base) {}
+  explicit String(unsigned long long value, unsigned char base = 10) : String((unsigned long)value, base) {}
+  explicit String(float value, unsigned int decimals = 2) : String((double)value, decimals) {}
+  explicit String(double value, unsigned int decimals = 2) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    _s = buf;
+  }
+
+  String& operator=(const String& other) = default;
+  String& operator=(String&& other) noexcept = default;
+  String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  bool reserve(unsigned int size) { _s.reserve(size); return true; }
+  char* begin() { return &_s[0]; }
+  char* end() { return &_s[0] + _s.size(); }
+  const char* begin() const { return _s.c_str(); }
+  const char* end() const { return _s.c_str() + _s.size(); }
+
+  // Concatenation
+  bool concat(const String& s) { _s += s._s; return true; }
+  bool concat(const char* s) { if (!s) return false; _s += s; return true; }
+  bool concat(const char* s, unsigned int length) { if (!s) return false; _s.append(s, length); return true; }
+  bool concat(char c) { _s += c; return true; }
+  bool concat(int v) { return concat(String(v)); }
+  bool concat(unsigned int v) { return concat(String(v)); }
+  bool concat(long v) { return concat(String(v)); }
+  bool concat(unsigned long v) { return concat(String(v)); }
+  bool concat(float v) { return concat(String(v)); }
+  bool concat(double v) { return concat(String(v)); }
+  template <typename T> String& operator+=(const T& v) { concat(v); return *this; }
+
+  // Comparison
+  int compareTo(const String& s) const { return _s.compare(s._s); }
+  bool equals(const String& s) const { return _s == s._s; }
+  bool equals(const char* s) const { return _s == (s ? s : ""); }
+  bool equalsIgnoreCase(const String& s) const { return strcasecmp(c_str(), s.c_str()) == 0; }
+  bool operator==(const String& s) const { return _s == s._s; }
+  bool operator==(const char* s) const { return equals(s); }
+  bool operator!=(const String& s) const { return _s != s._s; }
+  bool operator!=(const char* s) const { return !equals(s); }
+  bool operator<(const String& s) const { return _s < s._s; }
+  bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+  bool endsWith(const String& suffix) const {
+    return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+  }
+
+  // Characters
+  char charAt(unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  void setCharAt(unsigned int i, char c) { if (i < _s.size()) _s[i] = c; }
+  char operator[](unsigned int i) const { return charAt(i); }
+  char& operator[](unsigned int i) { return _s[i]; }
+  void toCharArray(char* buf, unsigned int size, unsigned int index = 0) const { getBytes((unsigned char*)buf, size, index); }
+  void getBytes(unsigned char* buf, unsigned int size, unsigned int index = 0) const {
+    if (!size || !buf) return;
+    size_t n = index < _s.size() ? std::min((size_t)size - 1, _s.size() - index) : 0;
+    memcpy(buf, _s.data() + (n ? index : 0), n);
+    buf[n] = 0;
+  }
+
+  // Search
+  int indexOf(char c, unsigned int from = 0) const { return found(_s.find(c, from)); }
+  int indexOf(const String& s, unsigned int from = 0) const { return found(_s.find(s._s, from)); }
+  int lastIndexOf(char c) const { return found(_s.rfind(c)); }
+  int lastIndexOf(const String& s) const { return found(_s.rfind(s._s)); }
+  String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, std::min((size_t)to, _s.size()) - from));
+  }
+
+  // Modification
+  void replace(char find, char with) { for (char& c : _s) if (c == find) c = with; }
+  void replace(const String& find, const String& with) {
+    if (find._s.empty()) return;
+    for (size_t at = _s.find(find._s); at != std::string::npos; at = _s.find(find._s, at + with._s.size())) {
+      _s.replace(at, find._s.size(), with._s);
+    }
+  }
+  void remove(unsigned int index) { if (index < _s.size()) _s.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < _s.size()) _s.erase(index, count); }
+  void toLowerCase() { for (char& c : _s) c = (char)tolower((unsigned char)c); }
+  void toUpperCase() { for (char& c : _s) c = (char)toupper((unsigned char)c); }
+  void trim() {
+    size_t a = _s.find_first_not_of(" \t\r\n");
+    size_t b = _s.find_last_not_of(" \t\r\n");
+    _s = a == std::string::npos ? std::string() : _s.substr(a, b - a + 1);
+  }
+
+  // Conversion
+  long toInt() const { return atol(c_str()); }
+  float toFloat() const { return (float)atof(c_str()); }
+  double toDouble() const { return atof(c_str()); }
+
+  const std::string& str() const { return _s; }
+
+private:
+  std::string _s;
+
+  static int found(size_t at) { return at == std::string::npos ? -1 : (int)at; }
+  static std::string digits(unsigned long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    std::string out;
+    do {
+      int d = (int)(value % base);
+      out.insert(out.begin(), (char)(d < 10 ? '0' + d : 'a' + d - 10));
+      value /= base;
+    } while (value);
+    return out;
+  }
+};
+
+inline String operator+(const String& a, const String& b) { String s(a); s.concat(b); return s; }
+inline String operator+(const String& a, const char* b) { String s(a); s.concat(b); return s; }
+inline String operator+(const char* a, const String& b) { String s(a); s.concat(b); return s; }
+inline String operator+(const String& a, char b) { String s(a); s.concat(b); return s; }
+template <typename T, typename = decltype(String(T()))>
+inline String operator+(const String& a, T b) { String s(a); s.concat(String(b)); return s; }
+inline bool operator==(const char* a, const String& b) { return b.equals(a); }
+
+#endif // HAL_WSTRING_H
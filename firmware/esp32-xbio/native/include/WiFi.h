@@ -0,0 +1,124 @@
+/**
+ * Native shim: WiFi station / soft-AP on hal::Network
+ * WiFi.begin() associates hal::Network::joinDelayMs of virtual time later if
+ * the AP is available (and the credentials match any expected ones); taking
+ * the AP away drops the link, as a real disconnect would.
+ */
+
+#ifndef HAL_WIFI_H
+#define HAL_WIFI_H
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6,
+  WL_NO_SHIELD = 255
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t mode) { _mode = mode; hal::Network::radioOn = mode != WIFI_OFF; return true; }
+  wifi_mode_t getMode() const { return _mode; }
+  bool setHostname(const char* hostname) { _hostname = hostname ? hostname : ""; return true; }
+  const char* getHostname() const { return _hostname.c_str(); }
+  bool setAutoReconnect(bool autoReconnect) { _autoReconnect = autoReconnect; return true; }
+  bool setSleep(bool) { return true; }
+
+  wl_status_t begin(const char* ssid, const char* password = nullptr) {
+    _ssid = ssid ? ssid : "";
+    _password = password ? password : "";
+    _joining = true;
+    _joinAtUs = hal::Clock::nowUs() + (uint64_t)hal::Network::joinDelayMs * 1000;
+    return status();
+  }
+
+  bool disconnect(bool wifiOff = false) {
+    if (_associated) hal::Network::dropLinks();
+    _joining = false;
+    setAssociated(false);
+    if (wifiOff) mode(WIFI_OFF);
+    return true;
+  }
+  bool reconnect() { return begin(_ssid.c_str(), _password.c_str()) != WL_CONNECT_FAILED; }
+
+  wl_status_t status() {
+    if (_associated && !hal::Network::apAvailable) {
+      setAssociated(false);
+      _lost = true;
+      if (_autoReconnect) {
+        _joining = true;
+        _joinAtUs = hal::Clock::nowUs() + (uint64_t)hal::Network::joinDelayMs * 1000;
+      }
+    }
+    if (!_associated && _joining && hal::Network::apAvailable && hal::Clock::nowUs() >= _joinAtUs) {
+      if (!credentialsMatch()) {
+        _joining = false;
+        return WL_CONNECT_FAILED;
+      }
+      setAssociated(true);
+      _joining = false;
+      _lost = false;
+    }
+    if (_associated) return WL_CONNECTED;
+    if (_lost) return WL_CONNECTION_LOST;
+    return _joining ? WL_IDLE_STATUS : WL_DISCONNECTED;
+  }
+  bool isConnected() { return status() == WL_CONNECTED; }
+
+  IPAddress localIP() { return status() == WL_CONNECTED ? IPAddress(hal::Network::ip) : IPAddress(); }
+  int8_t RSSI() { return status() == WL_CONNECTED ? hal::Network::rssi : 0; }
+  String SSID() { return String(_ssid.c_str()); }
+  String macAddress() {
+    char buf[18];
+    const uint8_t* m = hal::System::mac;
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+    return String(buf);
+  }
+
+  bool softAP(const char* ssid, const char* password = nullptr) {
+    (void)password;
+    _apSsid = ssid ? ssid : "";
+    return true;
+  }
+  bool softAPdisconnect(bool wifiOff = false) {
+    _apSsid.clear();
+    if (wifiOff) mode(WIFI_OFF);
+    return true;
+  }
+  IPAddress softAPIP() { return _apSsid.empty() ? IPAddress() : IPAddress(192, 168, 4, 1); }
+
+private:
+  wifi_mode_t _mode = WIFI_OFF;
+  std::string _hostname;
+  std::string _ssid;
+  std::string _password;
+  std::string _apSsid;
+  bool _autoReconnect = true;
+  bool _joining = false;
+  bool _associated = false;
+  bool _lost = false;
+  uint64_t _joinAtUs = 0;
+
+  void setAssociated(bool associated) {
+    _associated = associated;
+    hal::Network::associated = associated;
+  }
+
+  bool credentialsMatch() const {
+    if (!hal::Network::expectSsid.empty() && _ssid != hal::Network::expectSsid) return false;
+    return hal::Network::expectSsid.empty() || _password == hal::Network::expectPassword;
+  }
+};
+
+inline WiFiClass WiFi;
+
+#endif // HAL_WIFI_H
@@ -0,0 +1,279 @@
+/**
+ * Native shim: WiFiClient over host TCP sockets
+ * Copies share one socket (as the ESP32 core's client does). connect()
+ * blocks for real time up to the connect timeout. Reads do not block,
+ * except that an empty poll within hal::Network::replyWaitMs (real time)
+ * of a write waits up to 1 ms for the reply: a busy-wait that counts
+ * delay(1)s against a timeout then runs no faster than the real peer.
+ *
+ * A host:port with a hal::Network endpoint registered gets an in-process
+ * link instead: connect() costs a virtual round trip, bytes arrive after the
+ * one-way latency, and an idle poll repeated at the same virtual instant
+ * (a busy-wait for a reply) lets hal::Network::pollUs pass.
+ */
+
+#ifndef HAL_WIFICLIENT_H
+#define HAL_WIFICLIENT_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+
+#include "Client.h"
+
+class WiFiClient : public Client {
+public:
+  WiFiClient() {}
+
+  int connect(IPAddress ip, uint16_t port) override { return connect(ip.toString().c_str(), port); }
+  int connect(const char* host, uint16_t port) override {
+    stop();
+    if (hal::Endpoint* endpoint = hal::Network::find(host, port)) {
+      if (!hal::Network::apAvailable) return 0;
+      hal::Clock::sleepUs(2 * hal::Network::latencyUs);
+      _link = hal::Network::connect(endpoint);
+      return _link ? 1 : 0;
+    }
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, service, &hints, &result) != 0 || !result) return 0;
+
+    int fd = socket(result->ai_family, result->ai_socktype | SOCK_CLOEXEC, result->ai_protocol);
+    if (fd < 0) {
+      freeaddrinfo(result);
+      return 0;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int rc = ::connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (rc != 0 && errno == EINPROGRESS) {
+      pollfd p = {fd, POLLOUT, 0};
+      int error = 0;
+      socklen_t length = sizeof(error);
+      rc = (poll(&p, 1, (int)_connectTimeoutMs) == 1 &&
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) ? 0 : -1;
+    }
+    if (rc != 0) {
+      ::close(fd);
+      return 0;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    _socket = std::make_shared<Socket>(fd);
+    return 1;
+  }
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override {
+    if (_link) return linkWrite(buf, size);
+    if (!_socket || _socket->fd < 0) return 0;
+    size_t sent = 0;
+    while (sent < size) {
+      ssize_t n = ::send(_socket->fd, buf + sent, size - sent, MSG_NOSIGNAL);
+      if (n > 0) {
+        sent += (size_t)n;
+        _socket->writeNs = hal::hostNs();
+      } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        pollfd p = {_socket->fd, POLLOUT, 0};
+        if (poll(&p, 1, 5000) != 1) break;
+      } else {
+        _socket->closed = true;
+        break;
+      }
+    }
+    return sent;
+  }
+  using Print::write;
+
+  int available() override {
+    if (_link) return linkAvailable();
+    if (!_socket || _socket->fd < 0) return 0;
+    int pending = 0;
+    if (ioctl(_socket->fd, FIONREAD, &pending) != 0) return 0;
+    if (pending == 0 && _socket->peeked < 0 && awaitReply() && ioctl(_socket->fd, FIONREAD, &pending) != 0) return 0;
+    return (_socket->peeked >= 0 ? 1 : 0) + pending;
+  }
+
+  int read() override {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  int read(uint8_t* buf, size_t size) override {
+    if (_link) {
+      size_t n = size ? linkRead(buf, size, true) : 0;
+      return n ? (int)n : -1;
+    }
+    if (!_socket || _socket->fd < 0 || size == 0) return -1;
+    size_t count = 0;
+    if (_socket->peeked >= 0) {
+      buf[count++] = (uint8_t)_socket->peeked;
+      _socket->peeked = -1;
+    }
+    if (count < size) {
+      ssize_t n = ::recv(_socket->fd, buf + count, size - count, MSG_DONTWAIT);
+      if (n < 0 && count == 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && awaitReply()) {
+        n = ::recv(_socket->fd, buf, size, MSG_DONTWAIT);
+      }
+      if (n > 0) {
+        count += (size_t)n;
+      } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        _socket->closed = true;
+      }
+    }
+    return count ? (int)count : -1;
+  }
+  int peek() override {
+    if (_link) {
+      uint8_t b;
+      return linkRead(&b, 1, false) == 1 ? b : -1;
+    }
+    if (!_socket) return -1;
+    if (_socket->peeked < 0) {
+      uint8_t b;
+      if (read(&b, 1) == 1) _socket->peeked = b;
+    }
+    return _socket->peeked;
+  }
+
+  void flush() override {}
+  void stop() override {
+    if (_link) linkClose();
+    _socket.reset();
+    _link.reset();
+  }
+
+  uint8_t connected() override {
+    if (_link) return linkConnected();
+    if (!_socket || _socket->fd < 0) return 0;
+    if (_socket->peeked >= 0) return 1;
+    if (!_socket->closed) {
+      uint8_t b;
+      ssize_t n = ::recv(_socket->fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) _socket->closed = true;
+    }
+    return _socket->closed ? (available() > 0) : 1;
+  }
+  operator bool() override { return connected(); }
+
+  void setTimeout(uint32_t seconds) { _connectTimeoutMs = seconds * 1000; }
+  int setNoDelay(bool) { return 0; }
+  int fd() const { return _socket ? _socket->fd : -1; }
+
+private:
+  struct Socket {
+    explicit Socket(int f) : fd(f) {}
+    ~Socket() { if (fd >= 0) ::close(fd); }
+    int fd;
+    int peeked = -1;
+    bool closed = false;
+    uint64_t writeNs = 0;             // Host time of the latest write
+  };
+
+  // True if it waited: nothing to read shortly after a write
+  bool awaitReply() {
+    uint64_t windowNs = (uint64_t)hal::Network::replyWaitMs * 1000000;
+    if (_socket->closed || hal::hostNs() - _socket->writeNs >= windowNs) return false;
+    pollfd p = {_socket->fd, POLLIN, 0};
+    poll(&p, 1, 1);
+    return true;
+  }
+
+  std::shared_ptr<Socket> _socket;
+  std::shared_ptr<hal::Link> _link;
+  uint64_t _idlePollUs = UINT64_MAX;
+  uint32_t _connectTimeoutMs = 3000;
+
+  // ─────────────────────────────────────────────────────────────────────────────
+  // In-process link (hal::Network endpoint)
+  // ─────────────────────────────────────────────────────────────────────────────
+  size_t linkWrite(const uint8_t* buf, size_t size) {
+    std::lock_guard<std::recursive_mutex> guard(hal::Network::lock());
+    if (!_link->_open || _link->_deviceFin || size == 0) return 0;
+    _link->_up.push_back({hal::Clock::nowUs() + hal::Network::latencyUs, false, std::vector<uint8_t>(buf, buf + size)});
+    hal::Network::txBytes += size;
+    hal::Network::txSegments++;
+    return size;
+  }
+
+  // Copies (and with consume, removes) bytes that have arrived by now
+  size_t linkRead(uint8_t* buf, size_t size, bool consume) {
+    hal::Network::pump();
+    std::lock_guard<std::recursive_mutex> guard(hal::Network::lock());
+    uint64_t now = hal::Clock::nowUs();
+    size_t count = 0;
+    size_t offset = _link->_downOffset;
+    for (auto it = _link->_down.begin(); it != _link->_down.end() && count < size; ++it) {
+      if (it->atUs > now || it->fin) break;
+      size_t n = std::min(size - count, it->data.size() - offset);
+      memcpy(buf + count, it->data.data() + offset, n);
+      count += n;
+      offset = offset + n == it->data.size() ? 0 : offset + n;
+      if (offset) break;
+    }
+    if (consume) {
+      size_t left = count;
+      while (left) {
+        auto& front = _link->_down.front();
+        size_t n = std::min(left, front.data.size() - _link->_downOffset);
+        _link->_downOffset += n;
+        left -= n;
+        if (_link->_downOffset == front.data.size()) {
+          _link->_down.pop_front();
+          _link->_downOffset = 0;
+        }
+      }
+    }
+    return count;
+  }
+
+  int linkAvailable() {
+    hal::Network::pump();
+    uint64_t now = hal::Clock::nowUs();
+    uint64_t wait = 0;
+    int pending = 0;
+    {
+      std::lock_guard<std::recursive_mutex> guard(hal::Network::lock());
+      for (auto& segment : _link->_down) {
+        if (segment.atUs > now || segment.fin) break;
+        pending += (int)segment.data.size();
+      }
+      pending -= (int)_link->_downOffset;
+      if (pending == 0 && _link->_open && now == _idlePollUs) {
+        uint64_t next = hal::Network::nextDeliveryUs();
+        wait = next > now && next - now < hal::Network::pollUs ? next - now : hal::Network::pollUs;
+      }
+    }
+    _idlePollUs = now;
+    if (wait) hal::Clock::sleepUs(wait); // Outside the lock: the owner pumps while time moves
+    return pending;
+  }
+
+  uint8_t linkConnected() {
+    hal::Network::pump();
+    std::lock_guard<std::recursive_mutex> guard(hal::Network::lock());
+    if (_link->_deviceFin) return 0;
+    if (_link->_down.empty()) return _link->_open ? 1 : 0;
+    const auto& front = _link->_down.front();
+    return front.fin && front.atUs <= hal::Clock::nowUs() ? 0 : 1;
+  }
+
+  void linkClose() {
+    std::lock_guard<std::recursive_mutex> guard(hal::Network::lock());
+    if (_link->_deviceFin) return;
+    _link->_deviceFin = true;
+    if (_link->_open) _link->_up.push_back({hal::Clock::nowUs() + hal::Network::latencyUs, true, {}});
+  }
+};
+
+#endif // HAL_WIFICLIENT_H
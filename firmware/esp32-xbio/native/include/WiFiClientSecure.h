@@ -0,0 +1,24 @@
+/**
+ * Native shim: WiFiClientSecure
+ * There is no core TLS stack on the host, so connect() always fails and
+ * https:// downloads report an error; XBioTLSClient (host mbedtls) is the
+ * TLS path that works natively.
+ */
+
+#ifndef HAL_WIFICLIENTSECURE_H
+#define HAL_WIFICLIENTSECURE_H
+
+#include "WiFiClient.h"
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure() {}
+  void setCACert(const char*) {}
+  void setCertificate(const char*) {}
+  void setPrivateKey(const char*) {}
+
+  int connect(IPAddress, uint16_t) override { return 0; }
+  int connect(const char*, uint16_t) override { return 0; }
+};
+
+#endif // HAL_WIFICLIENTSECURE_H
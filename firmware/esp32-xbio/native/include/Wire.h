@@ -0,0 +1,82 @@
+/**
+ * Native shim: TwoWire on hal::I2CBus
+ * endTransmission() delivers the write to the device model at the address
+ * (2 = address NACK, 3 = data NACK, as the ESP32 core reports), requestFrom()
+ * runs one read transaction. Each transfer costs its bus time on the clock.
+ */
+
+#ifndef HAL_WIRE_H
+#define HAL_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+public:
+  static constexpr size_t BUFFER_LENGTH = 128;
+
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+    (void)sda;
+    (void)scl;
+    if (frequency) _clockHz = frequency;
+    return true;
+  }
+  void end() {}
+  bool setClock(uint32_t frequency) { _clockHz = frequency; return true; }
+  uint32_t getClock() const { return _clockHz; }
+
+  void beginTransmission(uint16_t address) {
+    _address = (uint8_t)address;
+    _txLength = 0;
+  }
+  void beginTransmission(int address) { beginTransmission((uint16_t)address); }
+
+  uint8_t endTransmission(bool sendStop = true) {
+    (void)sendStop;
+    hal::I2CBus::charge(_txLength, _clockHz);
+    hal::I2CDevice* device = hal::I2CBus::find(_address);
+    if (!device) return 2;
+    return device->write(_tx, _txLength) ? 0 : 3;
+  }
+
+  size_t requestFrom(uint16_t address, size_t quantity, bool sendStop = true) {
+    (void)sendStop;
+    if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+    _rxLength = 0;
+    _rxIndex = 0;
+    hal::I2CBus::charge(quantity, _clockHz);
+    hal::I2CDevice* device = hal::I2CBus::find((uint8_t)address);
+    if (device) _rxLength = device->read(_rx, quantity);
+    return _rxLength;
+  }
+  uint8_t requestFrom(uint8_t address, uint8_t quantity) { return (uint8_t)requestFrom((uint16_t)address, (size_t)quantity); }
+  uint8_t requestFrom(int address, int quantity) { return (uint8_t)requestFrom((uint16_t)address, (size_t)quantity); }
+
+  size_t write(uint8_t data) override {
+    if (_txLength >= BUFFER_LENGTH) return 0;
+    _tx[_txLength++] = data;
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t length) override {
+    size_t n = 0;
+    while (n < length && write(data[n])) n++;
+    return n;
+  }
+  using Print::write;
+
+  int available() override { return (int)(_rxLength - _rxIndex); }
+  int read() override { return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1; }
+  int peek() override { return _rxIndex < _rxLength ? _rx[_rxIndex] : -1; }
+
+private:
+  uint32_t _clockHz = 100000;
+  uint8_t _address = 0;
+  uint8_t _tx[BUFFER_LENGTH];
+  size_t _txLength = 0;
+  uint8_t _rx[BUFFER_LENGTH];
+  size_t _rxLength = 0;
+  size_t _rxIndex = 0;
+};
+
+inline TwoWire Wire;
+
+#endif // HAL_WIRE_H
@@ -0,0 +1,599 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧪 BME688 register-level simulator (native HAL)
+ * A virtual BME688 on hal::I2CBus, so BME688Driver runs unmodified on Linux:
+ *
+ *   BME688Sim sim;
+ *   sim.attach(0x77);
+ *   sim.loadTrace("trace.csv");         // or setEnvironment() / setSource()
+ *   driver.begin();                     // chip ID, NVM, config as on hardware
+ *
+ * Register map as on silicon: chip ID 0xD0 (0x61), variant 0xF0, calibration
+ * NVM at 0x8A-0xA2 / 0xE1-0xF0 / 0x00-0x04, control 0x50-0x75, soft reset
+ * 0xE0, field 0 data at 0x1D-0x2D. A forced-mode write starts a conversion
+ * whose length follows Bosch's formula (oversampling cycles, TPH switching,
+ * wake-up, heater wait); until it ends the data registers keep the previous
+ * result and ctrl_meas reads back forced mode.
+ *
+ * Raw ADC values are the inverse of the datasheet compensation against the
+ * NVM, so a correct driver reads back the environment source. Gas results
+ * land in the field run_gas selects: 0x10 (low range, BME680 formula) at
+ * 0x2A/0x2B, 0x20 (high range, BME688 formula) at 0x2C/0x2D. The heater
+ * plate warms with a first-order lag towards the res_heat_0 target, so a
+ * short gas_wait gives no heat_stab and a skewed resistance, and heater duty
+ * self-heats the temperature reading.
+ *
+ * Faults (faults.*) and bus counters (getStats()) make driver changes
+ * comparable by transactions, bytes and SCL clocks rather than by feel.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef BME688_SIM_H
+#define BME688_SIM_H
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "hal_native.h"
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Model Constants
+// ═══════════════════════════════════════════════════════════════════════════════
+#define BME688_SIM_CHIP_ID 0x61
+#define BME688_SIM_VARIANT_ID 0x01          // gas_h variant (BME688)
+#define BME688_SIM_RESET_US 2000            // Start-up after soft reset; transactions NACK meanwhile
+#define BME688_SIM_HEATER_TAU_MS 6.0f       // Hot plate first-order time constant
+#define BME688_SIM_HEAT_STAB_BAND 0.03f     // heat_stab when within 3 % of target
+#define BME688_SIM_GAS_NOMINAL_C 320.0f     // Plate temperature the source's gas resistance refers to
+#define BME688_SIM_GAS_TEMP_COEFF 0.012f    // ln(R) per degree below nominal
+#define BME688_SIM_SELF_HEAT_C 4.0f         // Temperature offset at 100 % heater duty
+#define BME688_SIM_DUTY_TAU_S 60.0f         // Heater duty averaging
+
+struct BME688Environment {
+  float temperature;            // °C
+  float humidity;               // %RH
+  float pressure;               // hPa
+  float gasResistance;          // Ohms at BME688_SIM_GAS_NOMINAL_C
+};
+
+struct BME688TracePoint {
+  uint32_t timeMs;
+  BME688Environment env;
+};
+
+struct BME688SimFaults {
+  uint8_t chipId = BME688_SIM_CHIP_ID;  // Anything else models a wrong / counterfeit part
+  float nackRate = 0.0f;                // Probability any transaction is NACKed
+  uint64_t absentUntilUs = 0;           // No ACK at all until then (unplugged, brown-out)
+  uint64_t stuckFromUs = 0;             // SDA held low in [from, until): every transaction times out
+  uint64_t stuckUntilUs = 0;
+  uint32_t stuckTimeoutUs = 50000;      // What a stuck transaction costs (Wire timeout)
+  bool freezeConversion = false;        // Forced conversions never complete
+  float noise = 0.0f;                   // Sensor noise scale (1 = datasheet RMS at 1x oversampling)
+};
+
+struct BME688SimStats {
+  uint32_t writes;              // Write transactions (pointer set or register writes)
+  uint32_t reads;               // Read transactions
+  uint32_t bytesWritten;        // Payload bytes, excluding the address byte
+  uint32_t bytesRead;
+  uint32_t nacks;               // Transactions refused (faults or reset in progress)
+  uint32_t triggers;            // Forced-mode writes
+  uint32_t conversions;         // Conversions completed
+  uint32_t staleReads;          // Data read while converting or already read once
+  uint64_t sclClocks;           // Bus clocks incl. address / ACK / start / stop
+
+  // Bus time these transactions took at a given SCL clock
+  double busTimeUs(uint32_t clockHz) const { return clockHz ? sclClocks * 1e6 / clockHz : 0; }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// BME688 Simulator Class
+// ═══════════════════════════════════════════════════════════════════════════════
+class BME688Sim : public hal::I2CDevice {
+public:
+  typedef std::function<BME688Environment(uint64_t nowUs)> Source;
+
+  explicit BME688Sim(uint32_t seed = 1);
+  ~BME688Sim() { if (_address) hal::I2CBus::detach(_address); }
+
+  void attach(uint8_t address = 0x77) {
+    _address = address;
+    hal::I2CBus::attach(address, this);
+  }
+
+  /**
+   * Environment the sensor sits in
+   */
+  void setEnvironment(const BME688Environment& env) {
+    _source = [env](uint64_t) { return env; };
+  }
+  void setSource(Source source) { _source = source; }
+  void setTrace(const std::vector<BME688TracePoint>& trace, bool loop = false);
+
+  /**
+   * Load a recorded trace (tools/anomaly_replay CSV:
+   * time_ms,second_of_day,temperature,humidity,pressure,iaq,gas[,label])
+   */
+  bool loadTrace(const char* path, bool loop = false);
+
+  BME688Environment environmentAt(uint64_t nowUs) const { return _source(nowUs); }
+
+  // Control state, for assertions
+  uint8_t reg(uint8_t address) const { return _regs[address]; }
+  bool isMeasuring() const { return _measuring; }
+  uint32_t conversionUs() const { return measurementUs(); }
+  float heaterTargetC() const { return heaterTarget(_lastAmbient); }
+
+  BME688SimStats getStats() const { return _stats; }
+  void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+  BME688SimFaults faults;
+
+  // hal::I2CDevice
+  bool write(const uint8_t* data, size_t length) override;
+  size_t read(uint8_t* data, size_t length) override;
+
+private:
+  uint8_t _address;
+  uint8_t _regs[256];
+  uint8_t _pointer;
+  std::mt19937 _rng;
+  Source _source;
+
+  bool _measuring;
+  uint64_t _doneAtUs;
+  uint64_t _resetUntilUs;
+  bool _unread;                 // A completed result nobody has read yet
+  bool _filterPrimed;
+  float _filteredTemp;
+  float _filteredPress;
+  float _lastAmbient;
+  float _duty;                  // Heater on-time fraction (EWMA)
+  uint64_t _dutyUs;
+
+  BME688SimStats _stats;
+
+  // Calibration (decoded from the NVM image, as the chip's own values)
+  struct Calib {
+    float t1, t2, t3;
+    float p1, p2, p3, p4, p5, p6, p7, p8, p9, p10;
+    float h1, h2, h3, h4, h5, h6, h7;
+    float g1, g2, g3;
+    float heatRange, heatVal, rangeSwErr;
+  } _c;
+
+  void writeNvm();
+  void softReset();
+  void update(uint64_t nowUs);
+  bool refuse();
+  void account(size_t bytes, bool isRead);
+  void startConversion(uint64_t nowUs);
+  void finishConversion(uint64_t atUs);
+  void runHeater(float ambient, float& plate, bool& stable) const;
+  uint32_t measurementUs() const;
+  uint32_t heaterWaitMs() const;
+  float heaterTarget(float ambient) const;
+  float gauss() { return std::normal_distribution<float>(0.0f, 1.0f)(_rng); }
+
+  // Datasheet compensation (float) and its inverse
+  float tempFine(uint32_t raw) const;
+  float pressure(uint32_t raw, float tFine) const;
+  float humidity(uint32_t raw, float temp) const;
+  uint32_t rawTemperature(float celsius, float& tFine) const;
+  uint32_t rawPressure(float hPa, float tFine) const;
+  uint16_t rawHumidity(float rh, float temp) const;
+  void encodeGasLow(float ohms, uint16_t& adc, uint8_t& range) const;
+  void encodeGasHigh(float ohms, uint16_t& adc, uint8_t& range) const;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+BME688Sim::BME688Sim(uint32_t seed) : _address(0), _pointer(0), _rng(seed) {
+  setEnvironment({22.0f, 45.0f, 1013.25f, 120000.0f});
+  memset(_regs, 0, sizeof(_regs));
+  memset(&_stats, 0, sizeof(_stats));
+  writeNvm();
+  softReset();
+  _resetUntilUs = 0; // Powered up before the test starts
+  _lastAmbient = 22.0f;
+  _duty = 0.0f;
+  _dutyUs = 0;
+}
+
+void BME688Sim::writeNvm() {
+  // Typical production part
+  const uint16_t t1 = 26209;  const int16_t t2 = 26374;  const int8_t t3 = 3;
+  const uint16_t p1 = 36481;  const int16_t p2 = -10510; const int8_t p3 = 88;
+  const int16_t p4 = 6788;    const int16_t p5 = -98;    const int8_t p6 = 30;
+  const int8_t p7 = 39;       const int16_t p8 = -3290;  const int16_t p9 = -2484;
+  const uint8_t p10 = 30;
+  const uint16_t h1 = 764;    const uint16_t h2 = 1012;  const int8_t h3 = 0;
+  const int8_t h4 = 45;       const int8_t h5 = 20;      const uint8_t h6 = 120;
+  const int8_t h7 = -100;
+  const int8_t g1 = -33;      const int16_t g2 = -10770; const int8_t g3 = 18;
+  const uint8_t heatRange = 1; const int8_t heatVal = 43; const int8_t rangeSwErr = 0;
+
+  uint8_t* c1 = &_regs[0x8A];   // 25 bytes
+  c1[1] = t2 & 0xFF;  c1[2] = (uint8_t)(t2 >> 8);  c1[3] = (uint8_t)t3;
+  c1[5] = p1 & 0xFF;  c1[6] = p1 >> 8;
+  c1[7] = p2 & 0xFF;  c1[8] = (uint8_t)(p2 >> 8);  c1[9] = (uint8_t)p3;
+  c1[11] = p4 & 0xFF; c1[12] = (uint8_t)(p4 >> 8);
+  c1[13] = p5 & 0xFF; c1[14] = (uint8_t)(p5 >> 8);
+  c1[15] = (uint8_t)p7; c1[16] = (uint8_t)p6;
+  c1[19] = p8 & 0xFF; c1[20] = (uint8_t)(p8 >> 8);
+  c1[21] = p9 & 0xFF; c1[22] = (uint8_t)(p9 >> 8);
+  c1[23] = p10;
+
+  uint8_t* c2 = &_regs[0xE1];   // 16 bytes
+  c2[0] = (uint8_t)(h2 >> 4); c2[1] = (uint8_t)(((h2 & 0x0F) << 4) | (h1 & 0x0F)); c2[2] = (uint8_t)(h1 >> 4);
+  c2[3] = (uint8_t)h3; c2[4] = (uint8_t)h4; c2[5] = (uint8_t)h5; c2[6] = h6; c2[7] = (uint8_t)h7;
+  c2[8] = t1 & 0xFF;   c2[9] = t1 >> 8;
+  c2[12] = g2 & 0xFF;  c2[13] = (uint8_t)(g2 >> 8); c2[14] = (uint8_t)g1; c2[15] = (uint8_t)g3;
+
+  _regs[0x00] = (uint8_t)heatVal;
+  _regs[0x02] = (uint8_t)(heatRange << 4);
+  _regs[0x04] = (uint8_t)(rangeSwErr << 4);     // Signed nibble in bits 7:4
+
+  _c = {t1, t2, t3, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10,
+        h1, h2, h3, h4, h5, h6, h7, g1, g2, g3, heatRange, heatVal, rangeSwErr};
+}
+
+void BME688Sim::softReset() {
+  memset(&_regs[0x1D], 0, 0x2E - 0x1D);
+  memset(&_regs[0x50], 0, 0x76 - 0x50);
+  // Skipped-measurement values until the first conversion
+  _regs[0x1F] = 0x80; _regs[0x22] = 0x80; _regs[0x25] = 0x80;
+  _measuring = false;
+  _doneAtUs = 0;
+  _unread = false;
+  _filterPrimed = false;
+  _resetUntilUs = hal::Clock::nowUs() + BME688_SIM_RESET_US;
+}
+
+void BME688Sim::setTrace(const std::vector<BME688TracePoint>& trace, bool loop) {
+  if (trace.empty()) return;
+  _source = [trace, loop](uint64_t nowUs) {
+    uint64_t span = (uint64_t)trace.back().timeMs * 1000;
+    uint64_t t = loop && span ? nowUs % span : nowUs;
+    if (t <= (uint64_t)trace.front().timeMs * 1000) return trace.front().env;
+    if (t >= span) return trace.back().env;
+    size_t hi = 1;
+    while ((uint64_t)trace[hi].timeMs * 1000 < t) hi++;
+    const BME688TracePoint& a = trace[hi - 1];
+    const BME688TracePoint& b = trace[hi];
+    float f = (float)(t - (uint64_t)a.timeMs * 1000) / (float)((uint64_t)(b.timeMs - a.timeMs) * 1000);
+    return BME688Environment{a.env.temperature + f * (b.env.temperature - a.env.temperature),
+                             a.env.humidity + f * (b.env.humidity - a.env.humidity),
+                             a.env.pressure + f * (b.env.pressure - a.env.pressure),
+                             a.env.gasResistance + f * (b.env.gasResistance - a.env.gasResistance)};
+  };
+}
+
+bool BME688Sim::loadTrace(const char* path, bool loop) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  std::vector<BME688TracePoint> trace;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    BME688TracePoint p;
+    int secondOfDay;
+    float iaq;
+    if (sscanf(line, "%u,%d,%f,%f,%f,%f,%f", &p.timeMs, &secondOfDay, &p.env.temperature, &p.env.humidity,
+               &p.env.pressure, &iaq, &p.env.gasResistance) < 7) {
+      continue; // Header / blank
+    }
+    if (!trace.empty() && p.timeMs <= trace.back().timeMs) continue;
+    trace.push_back(p);
+  }
+  fclose(f);
+  if (trace.empty()) return false;
+  setTrace(trace, loop);
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Bus
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool BME688Sim::refuse() {
+  uint64_t now = hal::Clock::nowUs();
+  if (now >= faults.stuckFromUs && now < faults.stuckUntilUs) {
+    _stats.nacks++;
+    hal::Clock::sleepUs(faults.stuckTimeoutUs);
+    return true;
+  }
+  bool nack = now < faults.absentUntilUs || now < _resetUntilUs ||
+              (faults.nackRate > 0 && std::uniform_real_distribution<float>(0, 1)(_rng) < faults.nackRate);
+  if (nack) {
+    _stats.nacks++;
+    _stats.sclClocks += 9 + 2; // Address byte, then stop
+  }
+  return nack;
+}
+
+void BME688Sim::account(size_t bytes, bool isRead) {
+  if (isRead) {
+    _stats.reads++;
+    _stats.bytesRead += bytes;
+  } else {
+    _stats.writes++;
+    _stats.bytesWritten += bytes;
+  }
+  _stats.sclClocks += (bytes + 1) * 9 + 2;
+}
+
+bool BME688Sim::write(const uint8_t* data, size_t length) {
+  if (refuse()) return false;
+  uint64_t now = hal::Clock::nowUs();
+  update(now);
+  account(length, false);
+  if (length == 0) return true;
+  _pointer = data[0];
+
+  // Register / value pairs
+  for (size_t i = 0; i + 1 < length; i += 2) {
+    uint8_t reg = data[i];
+    uint8_t value = data[i + 1];
+    if (reg == 0xE0) {
+      if (value == 0xB6) softReset();
+      continue;
+    }
+    if (reg < 0x50 || reg > 0x75) continue;   // Read-only: data, NVM, ID
+    if (reg == 0x74 && _measuring) continue;  // Ignored until the conversion ends
+    _regs[reg] = value;
+    if (reg == 0x74 && (value & 0x03) == 0x01) startConversion(now);
+  }
+  return true;
+}
+
+size_t BME688Sim::read(uint8_t* data, size_t length) {
+  if (refuse()) return 0;
+  update(hal::Clock::nowUs());
+  account(length, true);
+
+  // Burst over field 0 (0x1D-0x2D) counts once per result
+  if (_pointer <= 0x2D && _pointer + length > 0x1F) {
+    if (_measuring || !_unread) _stats.staleReads++;
+    if (!_measuring) _unread = false;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    uint8_t reg = _pointer++;
+    data[i] = reg == 0xD0 ? faults.chipId : reg == 0xF0 ? BME688_SIM_VARIANT_ID : _regs[reg];
+  }
+  return length;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Conversion
+// ═══════════════════════════════════════════════════════════════════════════════
+
+uint32_t BME688Sim::heaterWaitMs() const {
+  static const uint8_t multiplier[4] = {1, 4, 16, 64};
+  uint8_t code = _regs[0x64];
+  return code == 0xFF ? 4032 : (uint32_t)(code & 0x3F) * multiplier[code >> 6];
+}
+
+uint32_t BME688Sim::measurementUs() const {
+  static const uint8_t cycles[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+  uint8_t osT = _regs[0x74] >> 5;
+  uint8_t osP = (_regs[0x74] >> 2) & 0x07;
+  uint8_t osH = _regs[0x72] & 0x07;
+  uint32_t us = (uint32_t)(cycles[osT] + cycles[osP] + cycles[osH]) * 1963;
+  us += 477 * 4;  // TPH switching
+  us += 477 * 5;  // Gas measurement
+  us += 1000;     // Wake up
+  if (_regs[0x71] & 0x30) us += heaterWaitMs() * 1000;
+  return us;
+}
+
+void BME688Sim::startConversion(uint64_t nowUs) {
+  _stats.triggers++;
+  _measuring = true;
+  _doneAtUs = nowUs + measurementUs();
+  _regs[0x1D] = (_regs[0x1D] & 0x0F) | 0x20 | ((_regs[0x71] & 0x30) ? 0x40 : 0x00); // measuring, gas_measuring
+}
+
+void BME688Sim::update(uint64_t nowUs) {
+  if (_measuring && !faults.freezeConversion && nowUs >= _doneAtUs) finishConversion(_doneAtUs);
+}
+
+float BME688Sim::heaterTarget(float ambient) const {
+  // Inverse of the datasheet res_heat_x calculation
+  float var5 = ((float)_regs[0x5A] / 3.4f + 25.0f) * ((4.0f + _c.heatRange) / 4.0f) * (1.0f + _c.heatVal * 0.002f);
+  float var1 = _c.g1 / 16.0f + 49.0f;
+  float var2 = (_c.g2 / 32768.0f) * 0.0005f + 0.00235f;
+  float var4 = var5 - (_c.g3 / 1024.0f) * ambient;
+  float target = (var4 / var1 - 1.0f) / var2;
+  return target < ambient ? ambient : target > 400.0f ? 400.0f : target;
+}
+
+void BME688Sim::runHeater(float ambient, float& plate, bool& stable) const {
+  float target = heaterTarget(ambient);
+  float waitMs = (float)heaterWaitMs();
+  plate = target - (target - ambient) * expf(-waitMs / BME688_SIM_HEATER_TAU_MS);
+  stable = _regs[0x5A] != 0 && waitMs > 0 && (target - plate) <= BME688_SIM_HEAT_STAB_BAND * target;
+}
+
+void BME688Sim::finishConversion(uint64_t atUs) {
+  _measuring = false;
+  _regs[0x74] &= 0xFC; // Back to sleep
+  _stats.conversions++;
+
+  BME688Environment env = _source(atUs);
+  bool gas = (_regs[0x71] & 0x30) != 0;
+
+  // Heater duty self-heats the die (EWMA over BME688_SIM_DUTY_TAU_S)
+  float elapsedS = (float)(atUs - _dutyUs) / 1e6f;
+  float onS = gas ? heaterWaitMs() / 1000.0f : 0.0f;
+  if (elapsedS > 0) {
+    float alpha = 1.0f - expf(-elapsedS / BME688_SIM_DUTY_TAU_S);
+    float duty = onS / elapsedS > 1.0f ? 1.0f : onS / elapsedS;
+    _duty += alpha * (duty - _duty);
+  }
+  _dutyUs = atUs;
+  float temperature = env.temperature + BME688_SIM_SELF_HEAT_C * _duty;
+  _lastAmbient = env.temperature;
+
+  uint8_t osT = _regs[0x74] >> 5;
+  uint8_t osP = (_regs[0x74] >> 2) & 0x07;
+  uint8_t osH = _regs[0x72] & 0x07;
+  if (faults.noise > 0) {
+    temperature += faults.noise * 0.005f * gauss() / sqrtf((float)(1 << (osT ? osT - 1 : 0)));
+    env.pressure += faults.noise * 0.015f * gauss() / sqrtf((float)(1 << (osP ? osP - 1 : 0)));
+    env.humidity += faults.noise * 0.02f * gauss() / sqrtf((float)(1 << (osH ? osH - 1 : 0)));
+    env.gasResistance *= 1.0f + faults.noise * 0.01f * gauss();
+  }
+
+  // Temperature / pressure through the IIR filter (coefficients 0, 1, 3, ... 127)
+  static const uint8_t iir[8] = {0, 1, 3, 7, 15, 31, 63, 127};
+  float coeff = iir[(_regs[0x75] >> 2) & 0x07];
+  float tFine = 0;
+  uint32_t rawT = rawTemperature(temperature, tFine);
+  uint32_t rawP = rawPressure(env.pressure, tFine);
+  if (!_filterPrimed || coeff == 0) {
+    _filteredTemp = (float)rawT;
+    _filteredPress = (float)rawP;
+    _filterPrimed = true;
+  } else {
+    _filteredTemp = (_filteredTemp * coeff + rawT) / (coeff + 1);
+    _filteredPress = (_filteredPress * coeff + rawP) / (coeff + 1);
+  }
+  rawT = osT ? (uint32_t)lrintf(_filteredTemp) : 0x80000;
+  rawP = osP ? (uint32_t)lrintf(_filteredPress) : 0x80000;
+  uint16_t rawH = osH ? rawHumidity(env.humidity, tempFine(rawT) / 5120.0f) : 0x8000;
+
+  uint8_t* d = &_regs[0x1D];
+  d[1] = 0;                                   // sub_meas_index
+  d[2] = rawP >> 12; d[3] = (rawP >> 4) & 0xFF; d[4] = (rawP & 0x0F) << 4;
+  d[5] = rawT >> 12; d[6] = (rawT >> 4) & 0xFF; d[7] = (rawT & 0x0F) << 4;
+  d[8] = rawH >> 8;  d[9] = rawH & 0xFF;
+
+  if (gas) {
+    float plate;
+    bool stable;
+    runHeater(env.temperature, plate, stable);
+    float ohms = env.gasResistance * expf(BME688_SIM_GAS_TEMP_COEFF * (BME688_SIM_GAS_NOMINAL_C - plate));
+    uint16_t adc;
+    uint8_t range;
+    uint8_t* field = (_regs[0x71] & 0x20) ? &d[15] : &d[13];
+    if (_regs[0x71] & 0x20) {
+      encodeGasHigh(ohms, adc, range);
+    } else {
+      encodeGasLow(ohms, adc, range);
+    }
+    field[0] = adc >> 2;
+    field[1] = (uint8_t)(((adc & 0x03) << 6) | 0x20 | (stable ? 0x10 : 0) | range);  // gas_valid, heat_stab
+  } else {
+    d[14] &= 0x0F;
+    d[16] &= 0x0F;
+  }
+
+  d[0] = 0x80 | (_regs[0x71] & 0x0F);         // new_data, gas_meas_index = nb_conv
+  _unread = true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Compensation (datasheet float formulas) and inverses
+// ═══════════════════════════════════════════════════════════════════════════════
+
+float BME688Sim::tempFine(uint32_t raw) const {
+  float var1 = ((float)raw / 16384.0f - _c.t1 / 1024.0f) * _c.t2;
+  float var2 = ((float)raw / 131072.0f - _c.t1 / 8192.0f) * ((float)raw / 131072.0f - _c.t1 / 8192.0f) * (_c.t3 * 16.0f);
+  return var1 + var2;
+}
+
+float BME688Sim::pressure(uint32_t raw, float tFine) const {
+  float var1 = tFine / 2.0f - 64000.0f;
+  float var2 = var1 * var1 * (_c.p6 / 131072.0f);
+  var2 = var2 + var1 * _c.p5 * 2.0f;
+  var2 = var2 / 4.0f + _c.p4 * 65536.0f;
+  var1 = ((_c.p3 * var1 * var1) / 16384.0f + _c.p2 * var1) / 524288.0f;
+  var1 = (1.0f + var1 / 32768.0f) * _c.p1;
+  float p = 1048576.0f - (float)raw;
+  p = (p - var2 / 4096.0f) * 6250.0f / var1;
+  var1 = _c.p9 * p * p / 2147483648.0f;
+  var2 = p * (_c.p8 / 32768.0f);
+  float var3 = (p / 256.0f) * (p / 256.0f) * (p / 256.0f) * (_c.p10 / 131072.0f);
+  return (p + (var1 + var2 + var3 + _c.p7 * 128.0f) / 16.0f) / 100.0f;
+}
+
+float BME688Sim::humidity(uint32_t raw, float temp) const {
+  float var1 = raw - _c.h1 * 16.0f - (_c.h3 / 2.0f) * temp;
+  float var2 = var1 * (_c.h2 / 262144.0f) * (1.0f + (_c.h4 / 16384.0f) * temp + (_c.h5 / 1048576.0f) * temp * temp);
+  float var3 = _c.h6 / 16384.0f;
+  float var4 = _c.h7 / 2097152.0f;
+  return var2 + (var3 + var4 * temp) * var2 * var2;
+}
+
+// Compensated outputs are monotonic in the ADC value over the sensor's range: bisect
+uint32_t BME688Sim::rawTemperature(float celsius, float& tFine) const {
+  uint32_t lo = 0, hi = 0xFFFFF;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (tempFine(mid) / 5120.0f < celsius) lo = mid + 1; else hi = mid;
+  }
+  tFine = tempFine(lo);
+  return lo;
+}
+
+uint32_t BME688Sim::rawPressure(float hPa, float tFine) const {
+  uint32_t lo = 0, hi = 0xFFFFF;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (pressure(mid, tFine) > hPa) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+uint16_t BME688Sim::rawHumidity(float rh, float temp) const {
+  if (rh < 0) rh = 0;
+  if (rh > 100) rh = 100;
+  uint32_t lo = 0, hi = 0xFFFF;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (humidity(mid, temp) < rh) lo = mid + 1; else hi = mid;
+  }
+  return (uint16_t)lo;
+}
+
+// Low range (run_gas 0x10): R = k1 * k2[range] / (adc - 512 + k1); pick the range with the finest step
+void BME688Sim::encodeGasLow(float ohms, uint16_t& adc, uint8_t& range) const {
+  static const float k1Range[16] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.99f, 1.0f, 0.992f,
+                                    1.0f, 1.0f, 0.998f, 0.995f, 1.0f, 0.99f, 1.0f, 1.0f};
+  static const float k2Range[16] = {8000000.0f, 4000000.0f, 2000000.0f, 1000000.0f, 499500.4688f, 248262.1563f,
+                                    125000.0f, 63004.03906f, 31281.28125f, 15625.0f, 7812.5f, 3906.25f,
+                                    1953.125f, 976.5625f, 488.28125f, 244.140625f};
+  for (range = 0; range < 16; range++) {
+    float k1 = (1340.0f + 5.0f * _c.rangeSwErr) * k1Range[range];
+    float value = k1 * k2Range[range] / ohms - k1 + 512.0f;
+    if (value >= 0 && value <= 1023) {
+      adc = (uint16_t)lrintf(value);
+      return;
+    }
+  }
+  range = 15;
+  adc = 0;
+}
+
+// High range (run_gas 0x20): R = 1e6 * (262144 >> range) / (4096 + 3 * (adc - 512))
+void BME688Sim::encodeGasHigh(float ohms, uint16_t& adc, uint8_t& range) const {
+  for (range = 0; range < 16; range++) {
+    float value = (1e6f * (float)(262144 >> range) / ohms - 4096.0f) / 3.0f + 512.0f;
+    if (value >= 0 && value <= 1023) {
+      adc = (uint16_t)lrintf(value);
+      return;
+    }
+  }
+  range = 15;
+  adc = 0;
+}
+
+#endif // BME688_SIM_H
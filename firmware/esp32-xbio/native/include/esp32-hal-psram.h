@@ -0,0 +1,15 @@
+/**
+ * Native shim: PSRAM allocation (host heap)
+ */
+
+#ifndef HAL_ESP32_HAL_PSRAM_H
+#define HAL_ESP32_HAL_PSRAM_H
+
+#include <stdlib.h>
+#include "hal_native.h"
+
+inline bool psramFound() { return hal::System::psramSize > 0; }
+inline void* ps_malloc(size_t size) { return psramFound() ? malloc(size) : nullptr; }
+inline void* ps_calloc(size_t n, size_t size) { return psramFound() ? calloc(n, size) : nullptr; }
+
+#endif // HAL_ESP32_HAL_PSRAM_H
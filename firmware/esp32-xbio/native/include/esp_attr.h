@@ -0,0 +1,14 @@
+/**
+ * Native shim: ESP-IDF section attributes (plain storage on the host)
+ */
+
+#ifndef HAL_ESP_ATTR_H
+#define HAL_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define EXT_RAM_ATTR
+
+#endif // HAL_ESP_ATTR_H
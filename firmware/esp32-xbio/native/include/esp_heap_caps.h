@@ -0,0 +1,24 @@
+/**
+ * Native shim: heap capabilities (reports hal::System::freeHeap)
+ */
+
+#ifndef HAL_ESP_HEAP_CAPS_H
+#define HAL_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+#include "hal_native.h"
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline size_t heap_caps_get_free_size(uint32_t caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? hal::System::psramSize : hal::System::freeHeap;
+}
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return heap_caps_get_free_size(caps) / 2; }
+inline void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void heap_caps_free(void* ptr) { free(ptr); }
+
+#endif // HAL_ESP_HEAP_CAPS_H
@@ -0,0 +1,16 @@
+/**
+ * Native shim: esp_ota_ops (one running partition backed by hal::Flash)
+ */
+
+#ifndef HAL_ESP_OTA_OPS_H
+#define HAL_ESP_OTA_OPS_H
+
+#include "esp_partition.h"
+
+inline const esp_partition_t* esp_ota_get_running_partition() {
+  static esp_partition_t running = {0x10000, 0, "app0"};
+  running.size = (uint32_t)hal::Flash::partitionSize;
+  return &running;
+}
+
+#endif // HAL_ESP_OTA_OPS_H
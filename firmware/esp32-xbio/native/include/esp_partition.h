@@ -0,0 +1,22 @@
+/**
+ * Native shim: esp_partition (the running app partition reads hal::Flash::running)
+ */
+
+#ifndef HAL_ESP_PARTITION_H
+#define HAL_ESP_PARTITION_H
+
+#include "esp_system.h"
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+} esp_partition_t;
+
+inline esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+  if (!partition || offset + size > hal::Flash::running.size()) return ESP_ERR_INVALID_ARG;
+  memcpy(dst, hal::Flash::running.data() + offset, size);
+  return ESP_OK;
+}
+
+#endif // HAL_ESP_PARTITION_H
@@ -0,0 +1,20 @@
+/**
+ * Native shim: ROM CRC32 (IEEE 802.3, little-endian, same results as the ROM)
+ */
+
+#ifndef HAL_ESP_ROM_CRC_H
+#define HAL_ESP_ROM_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *buf++;
+    for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+#endif // HAL_ESP_ROM_CRC_H
@@ -0,0 +1,19 @@
+/**
+ * Native shim: deep sleep (ends the run through hal::System::reset)
+ */
+
+#ifndef HAL_ESP_SLEEP_H
+#define HAL_ESP_SLEEP_H
+
+#include "esp_system.h"
+
+inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs) {
+  hal::System::sleepTimerUs = timeUs;
+  return ESP_OK;
+}
+
+[[noreturn]] inline void esp_deep_sleep_start() {
+  hal::System::reset("deep sleep", hal::System::sleepTimerUs);
+}
+
+#endif // HAL_ESP_SLEEP_H
@@ -0,0 +1,40 @@
+/**
+ * Native shim: esp_system (random, MAC, restart)
+ */
+
+#ifndef HAL_ESP_SYSTEM_H
+#define HAL_ESP_SYSTEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "hal_native.h"
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_NOT_FOUND 0x105
+
+inline uint32_t esp_random() { return hal::System::random(); }
+
+inline void esp_fill_random(void* buf, size_t len) {
+  uint8_t* out = (uint8_t*)buf;
+  while (len) {
+    uint32_t word = hal::System::random();
+    size_t n = len < 4 ? len : 4;
+    memcpy(out, &word, n);
+    out += n;
+    len -= n;
+  }
+}
+
+inline esp_err_t esp_efuse_mac_get_default(uint8_t* mac) {
+  memcpy(mac, hal::System::mac, 6);
+  return ESP_OK;
+}
+
+[[noreturn]] inline void esp_restart() { hal::System::reset("esp_restart()"); }
+inline uint32_t esp_get_free_heap_size() { return hal::System::freeHeap; }
+
+#endif // HAL_ESP_SYSTEM_H
@@ -0,0 +1,15 @@
+/**
+ * Native shim: esp_wifi (power save is a no-op)
+ */
+
+#ifndef HAL_ESP_WIFI_H
+#define HAL_ESP_WIFI_H
+
+#include "esp_system.h"
+
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+
+inline esp_err_t esp_wifi_set_ps(wifi_ps_type_t) { return ESP_OK; }
+inline esp_err_t esp_wifi_stop() { return ESP_OK; }
+
+#endif // HAL_ESP_WIFI_H
@@ -0,0 +1,580 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🖥️ xBio native HAL - control surface
+ * State behind the Arduino / ESP-IDF shim headers in this directory, for
+ * building the firmware modules on Linux ([env:native] in platformio.ini).
+ *
+ * Time is virtual: millis() / micros() read hal::Clock, which only moves
+ * when the firmware waits (delay(), vTaskDelay(), I2C transfers) or a test
+ * advances it, so an hour of uptime takes milliseconds. Tasks are threads
+ * run in lockstep with it: the clock never passes a sleeping task's wake
+ * time before that task has run, so runs are repeatable. The cycle counter is the exception: ESP.getCycleCount()
+ * reads the host's monotonic clock (at the nominal 240 MHz), so the
+ * firmware's own ns / cycle measurements are real host timings and can
+ * back benchmarks and regression gates.
+ *
+ * Everything a test might want to control or observe lives here:
+ *   hal::Clock     virtual time, listeners called as it advances
+ *   hal::Gpio      pin levels, interrupts fired on simulated edges
+ *   hal::I2CBus    devices attached by address (sensor models)
+ *   hal::Network   whether the AP is reachable, join delay, RSSI, IP, and
+ *                  in-process endpoints (server models) WiFiClient reaches
+ *   hal::Nvs       Preferences storage, kept across simulated reboots
+ *   hal::Flash     running image / OTA target for Update and esp_partition
+ *   hal::System    what restart / deep sleep do (default: exit the process)
+ *   hal::Console   serial input queue, output on/off
+ * Other sockets (WiFiClient) are real host TCP, and TLS is the host's mbedtls.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+class WiFiClient;
+
+namespace hal {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Virtual Clock
+// ═══════════════════════════════════════════════════════════════════════════════
+class Clock {
+public:
+  typedef void (*Listener)(uint64_t nowUs, void* context);
+  static constexpr int MAX_TASKS = 16;
+
+  static uint64_t nowUs() { return _now.load(std::memory_order_acquire); }
+
+  /**
+   * Move time forward, calling listeners (sensor models, network events)
+   * Lockstep with task threads: waits until every task is blocked in
+   * sleepUs(), then steps through their wake times in order, letting each
+   * woken task run to its next sleep before time moves on. Only the owner
+   * (the thread running setup() / loop()) advances the clock.
+   */
+  static void advanceUs(uint64_t us) {
+    std::unique_lock<std::mutex> lock(mutex());
+    uint64_t target = nowUs() + us;
+    for (;;) {
+      waitTasksBlocked(lock);
+      uint64_t next = target;
+      for (int i = 0; i < MAX_TASKS; i++) {
+        if (_tasks[i].active && _tasks[i].wakeUs < next) next = _tasks[i].wakeUs;
+      }
+      if (next > nowUs()) {
+        _now.store(next, std::memory_order_release);
+        lock.unlock();
+        notifyListeners(next);
+        lock.lock();
+      }
+      bool woke = false;
+      for (int i = 0; i < MAX_TASKS; i++) {
+        if (_tasks[i].active && _tasks[i].sleeping && _tasks[i].wakeUs <= next) {
+          _tasks[i].sleeping = false;
+          woke = true;
+        }
+      }
+      if (woke) {
+        condition().notify_all();
+        continue;
+      }
+      if (next >= target) break;
+    }
+  }
+
+  /**
+   * Block for `us` of virtual time: the owner advances the clock, a task
+   * thread parks until the owner's clock reaches its wake time
+   */
+  static void sleepUs(uint64_t us) {
+    if (isOwner()) {
+      advanceUs(us);
+      return;
+    }
+    int slot = _slot;
+    if (slot < 0) {
+      // Unregistered host thread: follow the clock without holding it back
+      uint64_t until = nowUs() + us;
+      while (nowUs() < until) std::this_thread::sleep_for(std::chrono::microseconds(50));
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex());
+    _tasks[slot].wakeUs = nowUs() + (us ? us : 1); // Never wake at the same instant (yield loops)
+    _tasks[slot].sleeping = true;
+    condition().notify_all();
+    condition().wait(lock, [slot] { return !_tasks[slot].sleeping; });
+  }
+
+  // Task threads (FreeRTOS shim): claim a slot in the creating thread so the
+  // owner cannot run ahead before the new thread starts
+  static int reserveTask() {
+    std::lock_guard<std::mutex> guard(mutex());
+    for (int i = 0; i < MAX_TASKS; i++) {
+      if (!_tasks[i].active) {
+        _tasks[i] = {true, false, 0};
+        return i;
+      }
+    }
+    return -1;
+  }
+  static void enterTask(int slot) { _slot = slot; }
+  static void exitTask() {
+    if (_slot < 0) return;
+    std::lock_guard<std::mutex> guard(mutex());
+    _tasks[_slot].active = false;
+    _slot = -1;
+    condition().notify_all();
+  }
+
+  static bool addListener(Listener fn, void* context = nullptr) {
+    if (_listenerCount >= MAX_LISTENERS) return false;
+    _listeners[_listenerCount++] = {fn, context};
+    return true;
+  }
+  static void clearListeners() { _listenerCount = 0; }
+
+  static void reset(uint64_t us = 0) { _now.store(us, std::memory_order_release); }
+  static void claimOwnership() { _owner = std::this_thread::get_id(); }
+  static bool isOwner() { return std::this_thread::get_id() == _owner; }
+
+private:
+  static constexpr size_t MAX_LISTENERS = 16;
+  struct Entry { Listener fn; void* context; };
+  struct Task { bool active; bool sleeping; uint64_t wakeUs; };
+
+  static std::mutex& mutex() { static std::mutex m; return m; }
+  static std::condition_variable& condition() { static std::condition_variable c; return c; }
+
+  static void waitTasksBlocked(std::unique_lock<std::mutex>& lock) {
+    condition().wait(lock, [] {
+      for (int i = 0; i < MAX_TASKS; i++) {
+        if (_tasks[i].active && !_tasks[i].sleeping) return false;
+      }
+      return true;
+    });
+  }
+
+  static void notifyListeners(uint64_t now) {
+    for (size_t i = 0; i < _listenerCount; i++) _listeners[i].fn(now, _listeners[i].context);
+  }
+
+  static inline std::atomic<uint64_t> _now{0};
+  static inline std::thread::id _owner = std::this_thread::get_id(); // Main thread (static init)
+  static inline Entry _listeners[MAX_LISTENERS];
+  static inline size_t _listenerCount = 0;
+  static inline Task _tasks[MAX_TASKS] = {};
+  static inline thread_local int _slot = -1;
+};
+
+// Host monotonic time, for ESP.getCycleCount()
+inline uint64_t hostNs() {
+  static const auto start = std::chrono::steady_clock::now();
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// GPIO
+// ═══════════════════════════════════════════════════════════════════════════════
+class Gpio {
+public:
+  static constexpr int PINS = 64;
+  typedef void (*Isr)();
+
+  static int read(int pin) { return valid(pin) ? _level[pin] : 0; }
+
+  // Drive an input as external hardware would; fires an attached interrupt on a matching edge
+  static void set(int pin, int level) {
+    if (!valid(pin)) return;
+    int old = _level[pin];
+    _level[pin] = level ? 1 : 0;
+    Isr isr = _isr[pin];
+    if (!isr || old == _level[pin]) return;
+    bool rising = _level[pin] == 1;
+    int mode = _isrMode[pin];
+    if (mode == CHANGE || (mode == RISING && rising) || (mode == FALLING && !rising)) isr();
+  }
+
+  // Firmware side (pinMode / digitalWrite / attachInterrupt)
+  static void setMode(int pin, int mode) { if (valid(pin)) _mode[pin] = mode; }
+  static int mode(int pin) { return valid(pin) ? _mode[pin] : 0; }
+  static void write(int pin, int level) { if (valid(pin)) { _level[pin] = level ? 1 : 0; _writes[pin]++; } }
+  static uint32_t writes(int pin) { return valid(pin) ? _writes[pin] : 0; }
+  static void attach(int pin, Isr isr, int mode) { if (valid(pin)) { _isr[pin] = isr; _isrMode[pin] = mode; } }
+  static void detach(int pin) { if (valid(pin)) _isr[pin] = nullptr; }
+
+  // Interrupt modes (same values as the ESP32 core)
+  static constexpr int RISING = 0x01;
+  static constexpr int FALLING = 0x02;
+  static constexpr int CHANGE = 0x03;
+
+private:
+  static bool valid(int pin) { return pin >= 0 && pin < PINS; }
+  static inline int _level[PINS] = {};
+  static inline int _mode[PINS] = {};
+  static inline uint32_t _writes[PINS] = {};
+  static inline Isr _isr[PINS] = {};
+  static inline int _isrMode[PINS] = {};
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// I2C
+// ═══════════════════════════════════════════════════════════════════════════════
+
+// A device model on the bus. One call per transaction, as the wire sees it.
+class I2CDevice {
+public:
+  virtual ~I2CDevice() {}
+
+  // Write transaction (register pointer first); false = NACK
+  virtual bool write(const uint8_t* data, size_t length) = 0;
+
+  // Read transaction; returns bytes supplied (fewer = NACK part way)
+  virtual size_t read(uint8_t* data, size_t length) = 0;
+};
+
+class I2CBus {
+public:
+  static void attach(uint8_t address, I2CDevice* device) { _devices[address & 0x7F] = device; }
+  static void detach(uint8_t address) { _devices[address & 0x7F] = nullptr; }
+  static I2CDevice* find(uint8_t address) { return _devices[address & 0x7F]; }
+
+  // Transfers take virtual time like a blocking Wire call: 9 bits per byte plus address
+  static void charge(size_t bytes, uint32_t clockHz) {
+    transactions++;
+    if (!chargeTime || clockHz == 0) return;
+    Clock::sleepUs(((uint64_t)(bytes + 1) * 9 * 1000000 + clockHz - 1) / clockHz);
+  }
+
+  static inline bool chargeTime = true;
+  static inline uint32_t transactions = 0;
+
+private:
+  static inline I2CDevice* _devices[128] = {};
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Network (WiFi association, in-process links; other sockets are real)
+// ═══════════════════════════════════════════════════════════════════════════════
+class Link;
+
+// A server model (e.g. a broker stand-in) that WiFiClient can connect to in-process
+class Endpoint {
+public:
+  virtual ~Endpoint() {}
+  virtual void accept(Link& link) { (void)link; }
+
+  // Device bytes, handed over in order once their one-way latency has passed
+  virtual void receive(Link& link, const uint8_t* data, size_t length) = 0;
+
+  // Device closed (after its pending bytes) or the WiFi link dropped
+  virtual void closed(Link& link) { (void)link; }
+};
+
+// One in-process TCP connection. Each direction is a queue of segments that
+// become visible to the other side Network::latencyUs after they were sent.
+class Link {
+public:
+  bool isOpen() const { return _open; }
+
+  // Server side: queue bytes / a FIN for the device
+  void send(const uint8_t* data, size_t length);
+  void close();
+
+  void* context = nullptr;      // Endpoint's per-connection state
+
+private:
+  friend class Network;
+  friend class ::WiFiClient;
+  struct Segment { uint64_t atUs; bool fin; std::vector<uint8_t> data; };
+
+  Endpoint* _endpoint = nullptr;
+  std::deque<Segment> _up;      // Device -> endpoint
+  std::deque<Segment> _down;    // Endpoint -> device
+  size_t _downOffset = 0;       // Bytes of _down.front() already read
+  bool _open = true;            // Neither side closed, link not dropped
+  bool _deviceFin = false;
+  bool _serverFin = false;
+};
+
+class Network {
+public:
+  static inline bool apAvailable = true;        // False: WiFi.begin() never associates
+  static inline uint32_t joinDelayMs = 800;     // WiFi.begin() to WL_CONNECTED
+  static inline int8_t rssi = -58;
+  static inline uint8_t ip[4] = {127, 0, 0, 1}; // Loopback, so local brokers are reachable
+  static inline std::string expectSsid;         // Non-empty: only this SSID associates
+  static inline std::string expectPassword;
+
+  // Observed (set by the WiFi shim)
+  static inline bool radioOn = false;           // WiFi mode is not WIFI_OFF
+  static inline bool associated = false;        // Station link up
+
+  // Host sockets
+  static inline uint32_t replyWaitMs = 250;     // Real time an empty poll may wait for a reply (0: never)
+
+  // In-process links
+  static inline uint64_t latencyUs = 0;         // One-way, each direction
+  static inline uint32_t pollUs = 10;           // Charged to a repeated idle poll (busy-wait on a socket)
+  static inline uint64_t txBytes = 0;           // Device -> endpoints
+  static inline uint64_t rxBytes = 0;
+  static inline uint32_t txSegments = 0;
+  static inline uint32_t rxSegments = 0;
+
+  // Route connects to host:port (any host if nullptr) to an endpoint
+  static void listen(const char* host, uint16_t port, Endpoint* endpoint) {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    endpoints()[key(host, port)] = endpoint;
+  }
+  static void unlisten(const char* host, uint16_t port) {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    endpoints().erase(key(host, port));
+  }
+  static Endpoint* find(const char* host, uint16_t port) {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    auto it = endpoints().find(key(host, port));
+    if (it == endpoints().end()) it = endpoints().find(key(nullptr, port));
+    return it == endpoints().end() ? nullptr : it->second;
+  }
+
+  // Device side: open a link (nullptr while the AP is unreachable)
+  static std::shared_ptr<Link> connect(Endpoint* endpoint) {
+    if (!apAvailable) return nullptr;
+    std::shared_ptr<Link> link = std::make_shared<Link>();
+    link->_endpoint = endpoint;
+    {
+      std::lock_guard<std::recursive_mutex> guard(lock());
+      links().push_back(link);
+      endpoint->accept(*link);
+    }
+    return link;
+  }
+
+  /**
+   * Take the AP away (or bring it back). Losing it drops every in-process
+   * link at once, as the device's lwIP sockets die with the association.
+   */
+  static void setApAvailable(bool available) {
+    apAvailable = available;
+    if (!available) dropLinks();
+  }
+
+  // An endpoint going away: forget its links without calling back into it
+  static void detach(Endpoint* endpoint) {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    std::vector<std::shared_ptr<Link>>& all = links();
+    for (auto& link : all) {
+      if (link->_endpoint != endpoint) continue;
+      link->_open = false;
+      link->_up.clear();
+    }
+    all.erase(std::remove_if(all.begin(), all.end(), [endpoint](const std::shared_ptr<Link>& link) {
+      return link->_endpoint == endpoint;
+    }), all.end());
+  }
+
+  static void dropLinks() {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    for (auto& link : links()) {
+      if (!link->_open) continue;
+      link->_open = false;
+      link->_up.clear();
+      link->_down.clear();
+      link->_downOffset = 0;
+      link->_endpoint->closed(*link);
+    }
+  }
+
+  // Hand endpoints the device bytes that are due; drops links nobody holds
+  static void pump() {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    uint64_t now = Clock::nowUs();
+    std::vector<std::shared_ptr<Link>>& all = links();
+    for (size_t i = 0; i < all.size(); i++) {
+      Link& link = *all[i];
+      while (!link._up.empty() && link._up.front().atUs <= now) {
+        Link::Segment segment = std::move(link._up.front());
+        link._up.pop_front();
+        if (segment.fin) {
+          link._up.clear();
+          if (link._open) {
+            link._open = false;
+            link._endpoint->closed(link);
+          }
+          break;
+        }
+        if (link._open) link._endpoint->receive(link, segment.data.data(), segment.data.size());
+      }
+    }
+    for (auto& link : all) {
+      if (link.use_count() == 1 && link->_up.empty() && link->_open) {
+        link->_open = false; // Every device-side WiFiClient copy went away without stop()
+        link->_endpoint->closed(*link);
+      }
+    }
+    all.erase(std::remove_if(all.begin(), all.end(), [](const std::shared_ptr<Link>& link) {
+      return link.use_count() == 1 && link->_up.empty();
+    }), all.end());
+  }
+
+  // Earliest pending delivery in either direction (UINT64_MAX if none)
+  static uint64_t nextDeliveryUs() {
+    std::lock_guard<std::recursive_mutex> guard(lock());
+    uint64_t next = UINT64_MAX;
+    for (auto& link : links()) {
+      if (!link->_up.empty()) next = std::min(next, link->_up.front().atUs);
+      if (!link->_down.empty()) next = std::min(next, link->_down.front().atUs);
+    }
+    return next;
+  }
+
+  static std::recursive_mutex& lock() { static std::recursive_mutex m; return m; }
+
+private:
+  static std::string key(const char* host, uint16_t port) {
+    return std::string(host ? host : "*") + ":" + std::to_string(port);
+  }
+  static std::map<std::string, Endpoint*>& endpoints() {
+    static std::map<std::string, Endpoint*> e;
+    return e;
+  }
+  static std::vector<std::shared_ptr<Link>>& links() {
+    static std::vector<std::shared_ptr<Link>> l;
+    return l;
+  }
+};
+
+inline void Link::send(const uint8_t* data, size_t length) {
+  std::lock_guard<std::recursive_mutex> guard(Network::lock());
+  if (!_open || _serverFin || length == 0) return;
+  _down.push_back({Clock::nowUs() + Network::latencyUs, false, std::vector<uint8_t>(data, data + length)});
+  Network::rxBytes += length;
+  Network::rxSegments++;
+}
+
+inline void Link::close() {
+  std::lock_guard<std::recursive_mutex> guard(Network::lock());
+  if (!_open || _serverFin) return;
+  _serverFin = true;
+  _down.push_back({Clock::nowUs() + Network::latencyUs, true, {}});
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// NVS (Preferences)
+// ═══════════════════════════════════════════════════════════════════════════════
+class Nvs {
+public:
+  typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+  static Namespace& space(const std::string& name) { return store()[name]; }
+  static bool has(const std::string& name) { return store().count(name) > 0; }
+  static void clear() { store().clear(); }
+  static std::mutex& lock() { static std::mutex m; return m; }
+
+private:
+  static std::map<std::string, Namespace>& store() {
+    static std::map<std::string, Namespace> s;
+    return s;
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Flash (running image and OTA target)
+// ═══════════════════════════════════════════════════════════════════════════════
+struct Flash {
+  static inline std::vector<uint8_t> running;   // esp_partition_read() of the running app
+  static inline std::vector<uint8_t> update;    // Written by Update
+  static inline bool updateReady = false;       // Update.end(true) succeeded
+  static inline size_t partitionSize = 0x600000;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// System (reset, deep sleep, identity, heap)
+// ═══════════════════════════════════════════════════════════════════════════════
+class System {
+public:
+  // Replaces the process exit; must not return (e.g. longjmp / throw back into a reboot loop)
+  typedef void (*ResetHandler)(const char* reason, uint64_t sleepUs);
+
+  static void onReset(ResetHandler handler) { _handler = handler; }
+
+  [[noreturn]] static void reset(const char* reason, uint64_t sleepUs = 0) {
+    if (_handler) _handler(reason, sleepUs);
+    fflush(stdout);
+    fprintf(stderr, "[hal] %s at %.3f s (virtual) - exiting\n", reason, Clock::nowUs() / 1e6);
+    exit(0);
+  }
+
+  static inline uint64_t sleepTimerUs = 0;      // esp_sleep_enable_timer_wakeup()
+  static inline uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+  static inline uint32_t freeHeap = 280000;     // Internal RAM (heap_caps / ESP.getFreeHeap)
+  static inline uint32_t psramSize = 8 * 1024 * 1024;
+  static inline uint32_t cpuMHz = 240;
+
+  static uint32_t random() {
+    std::lock_guard<std::mutex> guard(rngLock());
+    return (uint32_t)rng()();
+  }
+  static void seed(uint32_t value) {
+    std::lock_guard<std::mutex> guard(rngLock());
+    rng().seed(value);
+  }
+
+private:
+  static inline ResetHandler _handler = nullptr;
+  static std::mt19937& rng() { static std::mt19937 r(0x78B10); return r; }
+  static std::mutex& rngLock() { static std::mutex m; return m; }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Console (Serial)
+// ═══════════════════════════════════════════════════════════════════════════════
+class Console {
+public:
+  static inline bool echo = true;               // False: Serial output discarded
+  static inline size_t written = 0;
+
+  static void push(const char* text) {
+    std::lock_guard<std::mutex> guard(lock());
+    input().append(text);
+  }
+  static int available() {
+    std::lock_guard<std::mutex> guard(lock());
+    return (int)input().size();
+  }
+  static int read() {
+    std::lock_guard<std::mutex> guard(lock());
+    if (input().empty()) return -1;
+    int c = (uint8_t)input()[0];
+    input().erase(0, 1);
+    return c;
+  }
+  static int peek() {
+    std::lock_guard<std::mutex> guard(lock());
+    return input().empty() ? -1 : (uint8_t)input()[0];
+  }
+
+private:
+  static std::string& input() { static std::string s; return s; }
+  static std::mutex& lock() { static std::mutex m; return m; }
+};
+
+} // namespace hal
+
+#endif // HAL_NATIVE_H
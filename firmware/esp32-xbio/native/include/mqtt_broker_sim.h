@@ -0,0 +1,512 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧪 In-process MQTT broker stand-in (native HAL)
+ * An MQTT 3.1.1 broker as a hal::Endpoint, so XBioMQTTClient / PubSubClient
+ * talk to it through WiFiClient with no sockets and in virtual time:
+ *
+ *   MQTTBrokerSim broker;
+ *   broker.listen("broker.sim", 1883);  // WiFiClient::connect() lands here
+ *   broker.onPublish = [](const MQTTSimMessage& m) { ... };
+ *
+ * Covers what the firmware and its server use: CONNECT (will, auth fields
+ * ignored) / CONNACK, PUBLISH QoS 0/1 with PUBACK, SUBSCRIBE / SUBACK with
+ * + and # filters, UNSUBSCRIBE, PINGREQ, DISCONNECT, retained messages and
+ * the will on an ungraceful close (WiFi drop, client vanished). A second
+ * CONNECT with the same client ID takes the session over, as on mosquitto.
+ * QoS 2 is granted as QoS 1; sessions are always clean.
+ *
+ * onPublish sees every PUBLISH the broker accepts (and the wills it sends)
+ * with its virtual arrival time, which is what latency and loss accounting
+ * hangs off. faults.* refuses connects or loses PUBACKs so the firmware's
+ * retransmit path runs.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef MQTT_BROKER_SIM_H
+#define MQTT_BROKER_SIM_H
+
+#include <string.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hal_native.h"
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Types
+// ═══════════════════════════════════════════════════════════════════════════════
+struct MQTTSimMessage {
+  const char* clientId;         // Publisher ("" for broker-injected messages)
+  const char* topic;
+  const uint8_t* payload;       // Valid only during the callback
+  size_t length;
+  uint8_t qos;
+  bool retain;
+  bool dup;                     // Retransmission flag as sent
+  bool will;                    // Published by the broker for a dropped client
+  uint64_t atUs;                // Virtual time the broker received it
+};
+
+struct MQTTBrokerSimFaults {
+  bool refuse = false;          // CONNACK 3 (server unavailable) to every CONNECT
+  float pubackLossRate = 0.0f;  // Probability a PUBACK is never sent
+};
+
+struct MQTTBrokerSimStats {
+  uint32_t connects;            // CONNACK 0 sent
+  uint32_t refused;
+  uint32_t takeovers;           // Session closed by a CONNECT with the same client ID
+  uint32_t disconnects;         // Clean DISCONNECT
+  uint32_t drops;               // Closed without DISCONNECT
+  uint32_t wills;
+  uint32_t publishes;           // PUBLISH packets received
+  uint32_t duplicates;          // ... with the DUP flag
+  uint32_t pubacks;
+  uint32_t pubacksLost;
+  uint32_t forwarded;           // PUBLISH packets sent to subscribers
+  uint32_t subscribes;
+  uint32_t pings;
+  uint32_t protocolErrors;      // Malformed packet (link closed)
+  uint64_t bytesIn;
+  uint64_t bytesOut;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// MQTT Broker Simulator Class
+// ═══════════════════════════════════════════════════════════════════════════════
+class MQTTBrokerSim : public hal::Endpoint {
+public:
+  typedef std::function<void(const MQTTSimMessage& message)> PublishCallback;
+
+  explicit MQTTBrokerSim(uint32_t seed = 1) : _rng(seed) { memset(&_stats, 0, sizeof(_stats)); }
+  ~MQTTBrokerSim() {
+    if (_port) hal::Network::unlisten(_host.empty() ? nullptr : _host.c_str(), _port);
+    hal::Network::detach(this);
+  }
+
+  // Serve host:port (any host if nullptr) on hal::Network
+  void listen(const char* host, uint16_t port) {
+    _host = host ? host : "";
+    _port = port;
+    hal::Network::listen(host, port, this);
+  }
+
+  /**
+   * Publish as the server would (e.g. a command to xbio/<id>/cmd)
+   */
+  void publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos = 0, bool retain = false);
+  void publish(const char* topic, const char* payload, uint8_t qos = 0, bool retain = false) {
+    publish(topic, (const uint8_t*)payload, strlen(payload), qos, retain);
+  }
+
+  // Retained payload for a topic ("" if none)
+  std::string retained(const char* topic) const {
+    auto it = _retained.find(topic);
+    return it == _retained.end() ? std::string() : it->second;
+  }
+
+  size_t sessionCount() const { return _sessions.size(); }
+  bool isConnected(const char* clientId) const;
+
+  static bool topicMatches(const char* filter, const char* topic);
+
+  MQTTBrokerSimStats getStats() const { return _stats; }
+  void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+  PublishCallback onPublish;
+  MQTTBrokerSimFaults faults;
+
+  // hal::Endpoint
+  void accept(hal::Link& link) override;
+  void receive(hal::Link& link, const uint8_t* data, size_t length) override;
+  void closed(hal::Link& link) override;
+
+private:
+  struct Session {
+    hal::Link* link;
+    std::vector<uint8_t> rx;    // Bytes of an incomplete packet
+    std::string clientId;
+    bool connected = false;
+    bool hasWill = false;
+    std::string willTopic;
+    std::string willPayload;
+    uint8_t willQos = 0;
+    bool willRetain = false;
+    std::vector<std::pair<std::string, uint8_t>> subscriptions;
+    uint16_t nextId = 1;
+  };
+
+  std::string _host;
+  uint16_t _port = 0;
+  std::vector<std::unique_ptr<Session>> _sessions;
+  std::map<std::string, std::string> _retained;
+  std::vector<uint8_t> _tx;     // Reused for every outgoing packet
+  std::mt19937 _rng;
+  MQTTBrokerSimStats _stats;
+
+  void handle(Session& session, uint8_t header, const uint8_t* body, size_t length);
+  void handleConnect(Session& session, const uint8_t* body, size_t length);
+  void handlePublish(Session& session, uint8_t header, const uint8_t* body, size_t length);
+  void handleSubscribe(Session& session, const uint8_t* body, size_t length);
+
+  void route(const char* clientId, const std::string& topic, const uint8_t* payload, size_t length,
+             uint8_t qos, bool retain, bool dup, bool will);
+  void deliver(Session& session, const std::string& topic, const uint8_t* payload, size_t length,
+               uint8_t qos, bool retain);
+  void send(Session& session, uint8_t header, const uint8_t* body, size_t length);
+  void drop(Session& session);
+
+  static bool readString(const uint8_t*& p, const uint8_t* end, std::string* out);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+inline void MQTTBrokerSim::accept(hal::Link& link) {
+  std::unique_ptr<Session> session(new Session());
+  session->link = &link;
+  link.context = session.get();
+  _sessions.push_back(std::move(session));
+}
+
+inline void MQTTBrokerSim::receive(hal::Link& link, const uint8_t* data, size_t length) {
+  Session* session = (Session*)link.context;
+  if (!session) return;
+  _stats.bytesIn += length;
+  session->rx.insert(session->rx.end(), data, data + length);
+
+  // Whole packets only: fixed header, remaining length (1-4 bytes), body
+  size_t at = 0;
+  while (session->rx.size() - at >= 2) {
+    size_t remaining = 0;
+    size_t used = 1;
+    uint32_t multiplier = 1;
+    bool complete = false;
+    while (at + used < session->rx.size() && used <= 4) {
+      uint8_t b = session->rx[at + used++];
+      remaining += (b & 0x7F) * multiplier;
+      multiplier *= 128;
+      if (!(b & 0x80)) { complete = true; break; }
+    }
+    if (!complete) {
+      if (used > 4) {
+        _stats.protocolErrors++;
+        drop(*session);
+        return;
+      }
+      break;
+    }
+    if (session->rx.size() - at - used < remaining) break;
+
+    uint8_t header = session->rx[at];
+    const uint8_t* body = session->rx.data() + at + used;
+    at += used + remaining;
+    handle(*session, header, body, remaining);
+    if (!link.context) return; // Session is gone
+  }
+  session->rx.erase(session->rx.begin(), session->rx.begin() + at);
+}
+
+inline void MQTTBrokerSim::closed(hal::Link& link) {
+  Session* session = (Session*)link.context;
+  if (!session) return;
+  link.context = nullptr;
+
+  if (session->connected) {
+    session->connected = false;
+    _stats.drops++;
+    if (session->hasWill) {
+      _stats.wills++;
+      route(session->clientId.c_str(), session->willTopic, (const uint8_t*)session->willPayload.data(),
+            session->willPayload.size(), session->willQos, session->willRetain, false, true);
+    }
+  }
+  for (size_t i = 0; i < _sessions.size(); i++) {
+    if (_sessions[i].get() == session) {
+      _sessions.erase(_sessions.begin() + i);
+      break;
+    }
+  }
+}
+
+inline void MQTTBrokerSim::handle(Session& session, uint8_t header, const uint8_t* body, size_t length) {
+  uint8_t type = header >> 4;
+  if (!session.connected && type != 1) {
+    _stats.protocolErrors++;
+    drop(session);
+    return;
+  }
+
+  switch (type) {
+    case 1:   // CONNECT
+      handleConnect(session, body, length);
+      return;
+    case 3:   // PUBLISH
+      handlePublish(session, header, body, length);
+      return;
+    case 4:   // PUBACK (for QoS 1 we forwarded) - nothing is retried, nothing to do
+      return;
+    case 8:   // SUBSCRIBE
+      handleSubscribe(session, body, length);
+      return;
+    case 10: {  // UNSUBSCRIBE
+      if (length < 2) break;
+      const uint8_t* p = body + 2;
+      const uint8_t* end = body + length;
+      std::string filter;
+      while (p < end && readString(p, end, &filter)) {
+        for (size_t i = 0; i < session.subscriptions.size(); i++) {
+          if (session.subscriptions[i].first == filter) {
+            session.subscriptions.erase(session.subscriptions.begin() + i);
+            break;
+          }
+        }
+      }
+      send(session, 0xB0, body, 2);
+      return;
+    }
+    case 12:  // PINGREQ
+      _stats.pings++;
+      send(session, 0xD0, nullptr, 0);
+      return;
+    case 14:  // DISCONNECT: no will
+      _stats.disconnects++;
+      session.hasWill = false;
+      session.connected = false;
+      session.link->close();
+      return;
+    default:
+      break;
+  }
+  _stats.protocolErrors++;
+  drop(session);
+}
+
+inline void MQTTBrokerSim::handleConnect(Session& session, const uint8_t* body, size_t length) {
+  const uint8_t* p = body;
+  const uint8_t* end = body + length;
+  std::string protocol;
+  if (session.connected || !readString(p, end, &protocol) || end - p < 4) {
+    _stats.protocolErrors++;
+    drop(session);
+    return;
+  }
+  uint8_t flags = p[1];
+  p += 4; // Level, flags, keep-alive (no keep-alive timeout: a dead link closes here explicitly)
+
+  std::string clientId;
+  bool ok = readString(p, end, &clientId);
+  if (ok && (flags & 0x04)) {
+    session.hasWill = readString(p, end, &session.willTopic) && readString(p, end, &session.willPayload);
+    session.willQos = (flags >> 3) & 0x03;
+    session.willRetain = (flags & 0x20) != 0;
+    ok = session.hasWill;
+  }
+  if (!ok) {
+    _stats.protocolErrors++;
+    drop(session);
+    return;
+  }
+
+  if (faults.refuse) {
+    _stats.refused++;
+    const uint8_t connack[] = {0x00, 0x03};
+    send(session, 0x20, connack, sizeof(connack));
+    session.hasWill = false;
+    session.link->close();
+    return;
+  }
+
+  // Take over an existing session with this client ID (its will fires)
+  for (size_t i = 0; i < _sessions.size(); i++) {
+    Session& other = *_sessions[i];
+    if (&other != &session && other.connected && other.clientId == clientId) {
+      _stats.takeovers++;
+      drop(other);
+      break;
+    }
+  }
+
+  session.clientId = clientId;
+  session.connected = true;
+  _stats.connects++;
+  const uint8_t connack[] = {0x00, 0x00};
+  send(session, 0x20, connack, sizeof(connack));
+}
+
+inline void MQTTBrokerSim::handlePublish(Session& session, uint8_t header, const uint8_t* body, size_t length) {
+  const uint8_t* p = body;
+  const uint8_t* end = body + length;
+  uint8_t qos = (header >> 1) & 0x03;
+  std::string topic;
+  if (!readString(p, end, &topic) || (qos && end - p < 2)) {
+    _stats.protocolErrors++;
+    drop(session);
+    return;
+  }
+  const uint8_t* id = p;
+  if (qos) p += 2;
+
+  _stats.publishes++;
+  bool dup = (header & 0x08) != 0;
+  if (dup) _stats.duplicates++;
+
+  if (qos) {
+    if (faults.pubackLossRate > 0 &&
+        std::uniform_real_distribution<float>(0.0f, 1.0f)(_rng) < faults.pubackLossRate) {
+      _stats.pubacksLost++;
+    } else {
+      _stats.pubacks++;
+      send(session, 0x40, id, 2);
+    }
+  }
+  route(session.clientId.c_str(), topic, p, (size_t)(end - p), qos > 1 ? 1 : qos, (header & 0x01) != 0, dup, false);
+}
+
+inline void MQTTBrokerSim::handleSubscribe(Session& session, const uint8_t* body, size_t length) {
+  if (length < 2) {
+    _stats.protocolErrors++;
+    drop(session);
+    return;
+  }
+  const uint8_t* p = body + 2;
+  const uint8_t* end = body + length;
+
+  std::vector<uint8_t> suback(body, body + 2);
+  std::vector<std::string> added;
+  std::string filter;
+  while (p < end && readString(p, end, &filter) && p < end) {
+    uint8_t qos = *p++ & 0x03;
+    qos = qos > 1 ? 1 : qos;
+    bool replaced = false;
+    for (auto& subscription : session.subscriptions) {
+      if (subscription.first == filter) {
+        subscription.second = qos;
+        replaced = true;
+      }
+    }
+    if (!replaced) session.subscriptions.push_back({filter, qos});
+    added.push_back(filter);
+    suback.push_back(qos);
+  }
+  _stats.subscribes++;
+  send(session, 0x90, suback.data(), suback.size());
+
+  // Retained messages matching the new filters
+  for (const auto& entry : _retained) {
+    for (const std::string& f : added) {
+      if (topicMatches(f.c_str(), entry.first.c_str())) {
+        deliver(session, entry.first, (const uint8_t*)entry.second.data(), entry.second.size(), 0, true);
+        break;
+      }
+    }
+  }
+}
+
+inline void MQTTBrokerSim::publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain) {
+  route("", topic, payload, length, qos > 1 ? 1 : qos, retain, false, false);
+}
+
+inline void MQTTBrokerSim::route(const char* clientId, const std::string& topic, const uint8_t* payload,
+                                 size_t length, uint8_t qos, bool retain, bool dup, bool will) {
+  if (onPublish) {
+    MQTTSimMessage message = {clientId, topic.c_str(), payload, length, qos, retain, dup, will, hal::Clock::nowUs()};
+    onPublish(message);
+  }
+  if (retain) {
+    if (length) {
+      _retained[topic].assign((const char*)payload, length);
+    } else {
+      _retained.erase(topic);
+    }
+  }
+
+  // Delivery may drop a session (closed link), so walk by index
+  for (size_t i = 0; i < _sessions.size(); i++) {
+    Session& session = *_sessions[i];
+    if (!session.connected || !session.link->isOpen()) continue;
+    int granted = -1;
+    for (const auto& subscription : session.subscriptions) {
+      if (topicMatches(subscription.first.c_str(), topic.c_str()) && subscription.second > granted) {
+        granted = subscription.second;
+      }
+    }
+    if (granted >= 0) deliver(session, topic, payload, length, qos < granted ? qos : (uint8_t)granted, false);
+  }
+}
+
+inline void MQTTBrokerSim::deliver(Session& session, const std::string& topic, const uint8_t* payload,
+                                   size_t length, uint8_t qos, bool retain) {
+  std::vector<uint8_t> body;
+  body.reserve(2 + topic.size() + 2 + length);
+  body.push_back((uint8_t)(topic.size() >> 8));
+  body.push_back((uint8_t)topic.size());
+  body.insert(body.end(), topic.begin(), topic.end());
+  if (qos) {
+    uint16_t id = session.nextId++;
+    if (session.nextId == 0) session.nextId = 1;
+    body.push_back((uint8_t)(id >> 8));
+    body.push_back((uint8_t)id);
+  }
+  body.insert(body.end(), payload, payload + length);
+  _stats.forwarded++;
+  send(session, (uint8_t)(0x30 | (qos << 1) | (retain ? 1 : 0)), body.data(), body.size());
+}
+
+inline void MQTTBrokerSim::send(Session& session, uint8_t header, const uint8_t* body, size_t length) {
+  _tx.clear();
+  _tx.push_back(header);
+  size_t remaining = length;
+  do {
+    uint8_t b = remaining % 128;
+    remaining /= 128;
+    _tx.push_back(remaining ? b | 0x80 : b);
+  } while (remaining);
+  if (length) _tx.insert(_tx.end(), body, body + length);
+  _stats.bytesOut += _tx.size();
+  session.link->send(_tx.data(), _tx.size());
+}
+
+// Close the link as a broker does on a protocol error; the will (if any) fires
+inline void MQTTBrokerSim::drop(Session& session) {
+  hal::Link& link = *session.link;
+  link.close();
+  closed(link);
+}
+
+inline bool MQTTBrokerSim::isConnected(const char* clientId) const {
+  for (const auto& session : _sessions) {
+    if (session->connected && session->clientId == clientId) return true;
+  }
+  return false;
+}
+
+inline bool MQTTBrokerSim::topicMatches(const char* filter, const char* topic) {
+  while (*filter) {
+    if (*filter == '#') return true;
+    if (*filter == '+') {
+      while (*topic && *topic != '/') topic++;
+      filter++;
+      continue;
+    }
+    if (*filter != *topic) return false;
+    filter++;
+    topic++;
+  }
+  return *topic == '\0';
+}
+
+inline bool MQTTBrokerSim::readString(const uint8_t*& p, const uint8_t* end, std::string* out) {
+  if (end - p < 2) return false;
+  size_t length = ((size_t)p[0] << 8) | p[1];
+  if ((size_t)(end - p - 2) < length) return false;
+  out->assign((const char*)p + 2, length);
+  p += 2 + length;
+  return true;
+}
+
+#endif // MQTT_BROKER_SIM_H
@@ -0,0 +1,60 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🖥️ xBio native runner
+ * Host entry point for [env:native]: setup() once, then loop() forever on
+ * the virtual clock, as the Arduino core's loopTask does on the device.
+ *
+ *   .pio/build/native/program [--run-ms N] [--seed N] [--quiet] [--no-ap]
+ *
+ * A loop() that never waits would freeze virtual time, so an iteration that
+ * did not move the clock is charged NATIVE_IDLE_TICK_US (the idle task's
+ * share of a real tick). --run-ms stops after N ms of virtual time.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <Arduino.h>
+
+#ifndef NATIVE_IDLE_TICK_US
+  #define NATIVE_IDLE_TICK_US 1000
+#endif
+
+void setup();
+void loop();
+
+static void usage(const char* program) {
+  fprintf(stderr, "usage: %s [--run-ms N] [--seed N] [--quiet] [--no-ap]\n", program);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  uint64_t runUs = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--run-ms") && i + 1 < argc) {
+      runUs = strtoull(argv[++i], nullptr, 10) * 1000;
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      hal::System::seed((uint32_t)strtoul(argv[++i], nullptr, 0));
+    } else if (!strcmp(argv[i], "--quiet")) {
+      hal::Console::echo = false;
+    } else if (!strcmp(argv[i], "--no-ap")) {
+      hal::Network::apAvailable = false;
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  hal::Clock::claimOwnership();
+  setup();
+
+  uint64_t loops = 0;
+  while (runUs == 0 || hal::Clock::nowUs() < runUs) {
+    uint64_t before = hal::Clock::nowUs();
+    loop();
+    if (hal::Clock::nowUs() == before) hal::Clock::advanceUs(NATIVE_IDLE_TICK_US);
+    loops++;
+  }
+
+  fflush(stdout);
+  fprintf(stderr, "[native] %.3f s virtual, %llu loops, %zu bytes serial out\n",
+          hal::Clock::nowUs() / 1e6, (unsigned long long)loops, hal::Console::written);
+  return 0;
+}
@@ -0,0 +1,640 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧪 xBio whole-firmware simulator
+ * Host entry point for [env:native-sim]: the real setup() / loop() from
+ * main.cpp on the virtual clock, with the BME688 simulator on I2C, the MQTT
+ * broker stand-in behind WiFiClient and a WiFi link that drops on a script.
+ * Days of uptime run in minutes, and what comes out is meant to be kept as
+ * a regression budget for every change to the loop.
+ *
+ *   .pio/build/native-sim/program [--days N] [--speed X] [--drop AT:LEN]
+ *                                 [--drop-every PERIOD:LEN] [--rtt-ms N]
+ *                                 [--trace CSV] [--budget FILE] [--seed N]
+ *                                 [--tick-us N] [--verbose]
+ *
+ * --speed paces virtual time to X times real time (default 1000, 0 = as
+ * fast as the host goes). Drops are in seconds of virtual time: the AP goes
+ * away, every link dies with it and the firmware's reconnect paths run.
+ *
+ * Reported per run:
+ *   loop       loop() latency, virtual (blocking waits) and host (CPU)
+ *   samples    sensor reads missed against SENSOR_READ_INTERVAL, data and
+ *              stream samples that never reached the broker (timestamp gaps)
+ *   publish    xbio/<id>/data latency, sample timestamp to broker arrival
+ *   heap       live heap high-water mark during setup() and loop(), and
+ *              growth since setup() (leaks). Every malloc in the process is
+ *              counted, including the link buffers that stand in for lwIP's
+ *   radio      time powered and associated, and an airtime estimate
+ *              (frames + DTIM beacon wake-ups under modem sleep)
+ *
+ * The last block is "metric value" lines. A --budget file holds the same
+ * lines as limits ("#" comments allowed); any metric over its limit fails
+ * the run with exit status 1. A reset (ESP.restart(), deep sleep) ends the
+ * run early and is reported. native/sim_budget.txt is the committed
+ * baseline; its header has the command line it was produced with.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <errno.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <bme688_sim.h>
+#include <mqtt_broker_sim.h>
+
+#ifndef NATIVE_IDLE_TICK_US
+  #define NATIVE_IDLE_TICK_US 1000
+#endif
+
+// Same defaults as main.cpp
+#ifndef SENSOR_READ_INTERVAL
+  #define SENSOR_READ_INTERVAL 1000
+#endif
+
+#ifndef MQTT_PUBLISH_INTERVAL
+  #define MQTT_PUBLISH_INTERVAL 5000
+#endif
+
+#ifndef STREAM_UPDATE_INTERVAL
+  #define STREAM_UPDATE_INTERVAL 1000
+#endif
+
+#ifndef BME688_I2C_ADDR
+  #define BME688_I2C_ADDR 0x77
+#endif
+
+#define SIM_BROKER_HOST "broker.sim"
+#define SIM_BROKER_PORT 1883
+#define SIM_WIFI_SSID "xbio-sim"
+#define SIM_WIFI_PASSWORD "xbio-sim-pass"
+#define SIM_MAX_DROPS 64
+#define SIM_PHY_MBPS 24.0             // Effective 802.11n rate at the default RSSI
+#define SIM_FRAME_AIRTIME_US 300      // Per segment: contention, preamble, ACK
+#define SIM_BEACON_DUTY 0.02          // Modem sleep: ~2 ms awake per 102.4 ms DTIM
+#define SIM_REPORT_INTERVAL_S 21600   // Progress line on stderr every 6 h virtual
+
+void setup();
+void loop();
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Heap Accounting (glibc malloc interposed)
+// ═══════════════════════════════════════════════════════════════════════════════
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace heap {
+static std::atomic<int64_t> live{0};
+static std::atomic<int64_t> peak{0};
+
+static inline void add(void* ptr) {
+  if (!ptr) return;
+  int64_t size = (int64_t)malloc_usable_size(ptr);
+  int64_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+  int64_t high = peak.load(std::memory_order_relaxed);
+  while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {}
+}
+static inline void remove(void* ptr) {
+  if (ptr) live.fetch_sub((int64_t)malloc_usable_size(ptr), std::memory_order_relaxed);
+}
+static inline void resetPeak() { peak.store(live.load()); }
+} // namespace heap
+
+extern "C" {
+void* malloc(size_t size) noexcept {
+  void* ptr = __libc_malloc(size);
+  heap::add(ptr);
+  return ptr;
+}
+void* calloc(size_t count, size_t size) noexcept {
+  void* ptr = __libc_calloc(count, size);
+  heap::add(ptr);
+  return ptr;
+}
+void* realloc(void* ptr, size_t size) noexcept {
+  heap::remove(ptr);
+  void* moved = __libc_realloc(ptr, size);
+  heap::add(moved ? moved : (size ? ptr : nullptr)); // Failed realloc keeps the old block
+  return moved;
+}
+void free(void* ptr) noexcept {
+  heap::remove(ptr);
+  __libc_free(ptr);
+}
+void* memalign(size_t alignment, size_t size) noexcept {
+  void* ptr = __libc_memalign(alignment, size);
+  heap::add(ptr);
+  return ptr;
+}
+void* aligned_alloc(size_t alignment, size_t size) noexcept { return memalign(alignment, size); }
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+  void* ptr = memalign(alignment, size);
+  if (!ptr) return ENOMEM;
+  *out = ptr;
+  return 0;
+}
+void* valloc(size_t size) noexcept { return memalign(4096, size); }
+void* pvalloc(size_t size) noexcept { return memalign(4096, (size + 4095) & ~(size_t)4095); }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Latency Histogram
+// ═══════════════════════════════════════════════════════════════════════════════
+// Log-linear buckets: exact below 16, then 8 per power of two (<= 12.5 % error)
+class Histogram {
+public:
+  void add(uint64_t value) {
+    _buckets[bucket(value)]++;
+    _count++;
+    _sum += (double)value;
+    if (value > _max) _max = value;
+  }
+
+  uint64_t count() const { return _count; }
+  uint64_t max() const { return _max; }
+  double mean() const { return _count ? _sum / _count : 0; }
+
+  // Upper bound of the bucket holding the q-quantile
+  uint64_t percentile(double q) const {
+    if (!_count) return 0;
+    uint64_t rank = (uint64_t)ceil(q * _count);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+      seen += _buckets[i];
+      if (seen >= (rank ? rank : 1)) return std::min(upper(i), _max);
+    }
+    return _max;
+  }
+
+private:
+  static constexpr int BUCKETS = 16 + 60 * 8;
+  uint64_t _buckets[BUCKETS] = {};
+  uint64_t _count = 0;
+  uint64_t _max = 0;
+  double _sum = 0;
+
+  static int bucket(uint64_t v) {
+    if (v < 16) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return 16 + (e - 4) * 8 + (int)((v >> (e - 3)) & 7);
+  }
+  static uint64_t upper(int i) {
+    if (i < 16) return (uint64_t)i;
+    int e = (i - 16) / 8 + 4;
+    uint64_t sub = (uint64_t)((i - 16) % 8);
+    return ((8 + sub + 1) << (e - 3)) - 1;
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Sample Stream (timestamps seen at the broker)
+// ═══════════════════════════════════════════════════════════════════════════════
+// Gaps in the firmware's sample timestamps are samples that never arrived
+class SampleStream {
+public:
+  explicit SampleStream(uint32_t intervalMs) : _intervalMs(intervalMs) {}
+
+  void add(uint32_t timestamp) {
+    for (uint32_t seen : _recent) {
+      if (seen == timestamp && _received) {
+        duplicates++;
+        return;
+      }
+    }
+    _recent[_next++ % RECENT] = timestamp;
+    _received++;
+
+    if (_received == 1) {
+      _last = timestamp;
+      return;
+    }
+    if ((int32_t)(timestamp - _last) < 0) {
+      if (lost) lost--;          // Late arrival fills a gap already counted
+      late++;
+      return;
+    }
+    uint32_t gap = timestamp - _last;
+    uint32_t missing = (gap + _intervalMs / 2) / _intervalMs;
+    if (missing > 1) lost += missing - 1;
+    _last = timestamp;
+  }
+
+  // Samples due after the last one that arrived (still queued at the end)
+  uint32_t outstanding(uint32_t nowMs) const {
+    if (!_received) return 0;
+    uint32_t gap = nowMs - _last;
+    return gap > _intervalMs ? gap / _intervalMs - 1 : 0;
+  }
+
+  uint32_t received() const { return _received; }
+
+  uint32_t lost = 0;
+  uint32_t late = 0;
+  uint32_t duplicates = 0;
+
+private:
+  static constexpr int RECENT = 64;
+  uint32_t _intervalMs;
+  uint32_t _recent[RECENT] = {};
+  uint32_t _next = 0;
+  uint32_t _received = 0;
+  uint32_t _last = 0;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Simulation State
+// ═══════════════════════════════════════════════════════════════════════════════
+struct Drop {
+  uint64_t fromUs;
+  uint64_t untilUs;
+};
+
+struct SimReset {};
+
+static struct {
+  // Script
+  uint64_t runUs = 86400ULL * 1000000;
+  double speed = 1000;
+  uint32_t tickUs = NATIVE_IDLE_TICK_US;
+  Drop drops[SIM_MAX_DROPS];
+  int dropCount = 0;
+  uint64_t dropPeriodUs = 0;
+  uint64_t dropLengthUs = 0;
+  const char* budgetPath = nullptr;
+
+  // Clock listener
+  uint64_t lastUs = 0;
+  uint64_t hostStartNs = 0;
+  uint64_t virtualStartUs = 0;
+  uint64_t radioOnUs = 0;
+  uint64_t associatedUs = 0;
+  uint32_t linkDrops = 0;
+
+  // Broker
+  SampleStream data{MQTT_PUBLISH_INTERVAL};
+  SampleStream stream{STREAM_UPDATE_INTERVAL};
+  Histogram publishMs;
+  uint32_t online = 0;
+  uint32_t offline = 0;
+  uint32_t alerts = 0;
+  uint32_t otherTopics = 0;
+
+  // Loop
+  Histogram loopUs;
+  Histogram loopHostNs;
+  uint64_t loops = 0;
+
+  const char* resetReason = nullptr;
+  uint64_t resetAtUs = 0;
+} sim;
+
+static bool dropActive(uint64_t now) {
+  for (int i = 0; i < sim.dropCount; i++) {
+    if (now >= sim.drops[i].fromUs && now < sim.drops[i].untilUs) return true;
+  }
+  return sim.dropPeriodUs && now >= sim.dropPeriodUs && now % sim.dropPeriodUs < sim.dropLengthUs;
+}
+
+// Runs on every clock step: link script, radio time, network delivery, pacing
+static void onClock(uint64_t now, void*) {
+  uint64_t dt = now - sim.lastUs;
+  if (hal::Network::radioOn) sim.radioOnUs += dt;
+  if (hal::Network::associated) sim.associatedUs += dt;
+  sim.lastUs = now;
+
+  bool down = dropActive(now);
+  if (down == hal::Network::apAvailable) {
+    hal::Network::setApAvailable(!down);
+    if (down) sim.linkDrops++;
+  }
+  hal::Network::pump();
+
+  if (sim.speed > 0) {
+    uint64_t targetNs = (uint64_t)((now - sim.virtualStartUs) * 1000.0 / sim.speed);
+    uint64_t hostNs = hal::hostNs() - sim.hostStartNs;
+    if (targetNs > hostNs + 1000000) std::this_thread::sleep_for(std::chrono::nanoseconds(targetNs - hostNs));
+  }
+}
+
+static bool topicEndsWith(const char* topic, const char* suffix) {
+  size_t a = strlen(topic);
+  size_t b = strlen(suffix);
+  return a > b && !strcmp(topic + a - b, suffix) && !strncmp(topic, "xbio/", 5);
+}
+
+// Unsigned integer after "key": in a JSON payload (no parser needed for one field)
+static bool jsonUint(const MQTTSimMessage& m, const char* key, uint32_t* out) {
+  size_t keyLength = strlen(key);
+  const char* p = (const char*)m.payload;
+  const char* end = p + m.length;
+  for (; p + keyLength + 3 <= end; p++) {
+    if (*p != '"' || memcmp(p + 1, key, keyLength) || p[keyLength + 1] != '"' || p[keyLength + 2] != ':') continue;
+    p += keyLength + 3;
+    uint64_t value = 0;
+    bool digits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits = true) value = value * 10 + (uint64_t)(*p - '0');
+    *out = (uint32_t)value;
+    return digits;
+  }
+  return false;
+}
+
+static void onPublish(const MQTTSimMessage& m) {
+  uint32_t timestamp;
+  if (topicEndsWith(m.topic, "/data")) {
+    if (!jsonUint(m, "timestamp", &timestamp)) return;
+    uint32_t before = sim.data.duplicates;
+    sim.data.add(timestamp);
+    if (sim.data.duplicates == before) sim.publishMs.add((uint32_t)(m.atUs / 1000) - timestamp);
+  } else if (topicEndsWith(m.topic, "/ws")) {
+    if (jsonUint(m, "ts", &timestamp)) sim.stream.add(timestamp);
+  } else if (topicEndsWith(m.topic, "/status")) {
+    if (memmem(m.payload, m.length, "offline", 7)) {
+      sim.offline++;
+    } else {
+      sim.online++;
+    }
+  } else if (topicEndsWith(m.topic, "/alerts")) {
+    sim.alerts++;
+  } else {
+    sim.otherTopics++;
+  }
+}
+
+// Called instead of exiting the process: unwinds loop() (or ends a task)
+static void onReset(const char* reason, uint64_t sleepUs) {
+  (void)sleepUs;
+  if (!sim.resetReason) {
+    sim.resetReason = reason;
+    sim.resetAtUs = hal::Clock::nowUs();
+  }
+  if (hal::Clock::isOwner()) throw SimReset();
+  throw hal::TaskExit();
+}
+
+static BME688Environment drift(uint64_t nowUs) {
+  // Daily temperature / humidity cycle, slow pressure front, gas with occupancy swings
+  double s = nowUs / 1e6;
+  double day = 2 * PI * s / 86400.0;
+  return BME688Environment{(float)(21.5 + 2.5 * sin(day)), (float)(45.0 - 8.0 * sin(day)),
+                           (float)(1008.0 + 6.0 * sin(2 * PI * s / (3 * 86400.0))),
+                           (float)(120000.0 + 60000.0 * sin(2 * PI * s / 5400.0))};
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Report / Budget
+// ═══════════════════════════════════════════════════════════════════════════════
+struct Metric {
+  const char* key;
+  double value;
+};
+
+static bool parseSpan(const char* text, uint64_t* a, uint64_t* b) {
+  double x, y;
+  if (sscanf(text, "%lf:%lf", &x, &y) != 2 || x < 0 || y <= 0) return false;
+  *a = (uint64_t)(x * 1e6);
+  *b = (uint64_t)(y * 1e6);
+  return true;
+}
+
+static int checkBudget(const char* path, const Metric* metrics, size_t count) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "budget: cannot open %s\n", path);
+    return 1;
+  }
+  char line[256];
+  int failed = 0;
+  int checked = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char key[64];
+    double limit;
+    if (line[0] == '#' || sscanf(line, "%63s %lf", key, &limit) != 2) continue;
+    const Metric* metric = nullptr;
+    for (size_t i = 0; i < count; i++) {
+      if (!strcmp(metrics[i].key, key)) metric = &metrics[i];
+    }
+    if (!metric) {
+      printf("budget: unknown metric %s\n", key);
+      failed++;
+      continue;
+    }
+    checked++;
+    if (metric->value > limit) {
+      printf("budget: FAIL %s %.6g > %.6g\n", key, metric->value, limit);
+      failed++;
+    }
+  }
+  fclose(f);
+  printf("budget: %d checked, %d failed\n", checked, failed);
+  return failed ? 1 : 0;
+}
+
+static void usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [--days N] [--hours N] [--speed X] [--tick-us N] [--rtt-ms N]\n"
+          "          [--drop AT_S:LEN_S]... [--drop-every PERIOD_S:LEN_S] [--trace CSV]\n"
+          "          [--budget FILE] [--seed N] [--verbose]\n", program);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  const char* trace = nullptr;
+  bool verbose = false;
+  uint32_t seed = 1;
+  hal::Network::latencyUs = 20000;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--verbose")) {
+      verbose = true;
+      continue;
+    }
+    if (!value) usage(argv[0]);
+    i++;
+    if (!strcmp(arg, "--days")) {
+      sim.runUs = (uint64_t)(atof(value) * 86400e6);
+    } else if (!strcmp(arg, "--hours")) {
+      sim.runUs = (uint64_t)(atof(value) * 3600e6);
+    } else if (!strcmp(arg, "--speed")) {
+      sim.speed = atof(value);
+    } else if (!strcmp(arg, "--tick-us")) {
+      sim.tickUs = (uint32_t)strtoul(value, nullptr, 10);
+    } else if (!strcmp(arg, "--rtt-ms")) {
+      hal::Network::latencyUs = (uint64_t)(atof(value) * 500);
+    } else if (!strcmp(arg, "--drop")) {
+      uint64_t at, length;
+      if (sim.dropCount >= SIM_MAX_DROPS || !parseSpan(value, &at, &length)) usage(argv[0]);
+      sim.drops[sim.dropCount++] = {at, at + length};
+    } else if (!strcmp(arg, "--drop-every")) {
+      if (!parseSpan(value, &sim.dropPeriodUs, &sim.dropLengthUs) || sim.dropLengthUs >= sim.dropPeriodUs) usage(argv[0]);
+    } else if (!strcmp(arg, "--trace")) {
+      trace = value;
+    } else if (!strcmp(arg, "--budget")) {
+      sim.budgetPath = value;
+    } else if (!strcmp(arg, "--seed")) {
+      seed = (uint32_t)strtoul(value, nullptr, 0);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (sim.runUs == 0 || sim.tickUs == 0) usage(argv[0]);
+
+  hal::Clock::claimOwnership();
+  hal::System::seed(seed);
+  hal::System::onReset(onReset);
+  hal::Console::echo = verbose;
+
+  // Provisioned device: WiFi credentials and the broker, as NVS would hold them
+  Preferences prefs;
+  prefs.begin("wifi", false);
+  prefs.putString("ssid", SIM_WIFI_SSID);
+  prefs.putString("password", SIM_WIFI_PASSWORD);
+  prefs.end();
+  prefs.begin("xbio", false);
+  prefs.putString("mqtt_srv", SIM_BROKER_HOST);
+  prefs.putInt("mqtt_port", SIM_BROKER_PORT);
+  prefs.end();
+
+  static BME688Sim sensor(seed);
+  sensor.attach(BME688_I2C_ADDR);
+  if (trace) {
+    if (!sensor.loadTrace(trace, true)) {
+      fprintf(stderr, "cannot load trace %s\n", trace);
+      return 1;
+    }
+  } else {
+    sensor.setSource(drift);
+  }
+
+  static MQTTBrokerSim broker(seed);
+  broker.listen(SIM_BROKER_HOST, SIM_BROKER_PORT);
+  broker.onPublish = onPublish;
+
+  hal::Clock::addListener(onClock);
+  sim.hostStartNs = hal::hostNs();
+
+  // ─────────────────────────────────────────────────────────────────────────────
+  // Boot
+  // ─────────────────────────────────────────────────────────────────────────────
+  heap::resetPeak();
+  int64_t heapBefore = heap::live.load();
+  try {
+    setup();
+  } catch (const SimReset&) {
+  }
+  int64_t heapSetupPeak = heap::peak.load() - heapBefore;
+  int64_t heapAfterSetup = heap::live.load() - heapBefore;
+  uint64_t setupUs = hal::Clock::nowUs();
+  uint32_t triggersAtSetup = sensor.getStats().triggers;
+
+  // ─────────────────────────────────────────────────────────────────────────────
+  // Run
+  // ─────────────────────────────────────────────────────────────────────────────
+  heap::resetPeak();
+  uint64_t nextReportUs = (uint64_t)SIM_REPORT_INTERVAL_S * 1000000;
+  while (!sim.resetReason && hal::Clock::nowUs() < sim.runUs) {
+    uint64_t before = hal::Clock::nowUs();
+    uint64_t hostBefore = hal::hostNs();
+    try {
+      loop();
+    } catch (const SimReset&) {
+      break;
+    }
+    sim.loopHostNs.add(hal::hostNs() - hostBefore);
+    sim.loopUs.add(hal::Clock::nowUs() - before);
+    sim.loops++;
+    if (hal::Clock::nowUs() == before) hal::Clock::advanceUs(sim.tickUs);
+
+    if (hal::Clock::nowUs() >= nextReportUs) {
+      fprintf(stderr, "[sim] %6.2f h: %llu loops, %u data samples, %u link drops\n", hal::Clock::nowUs() / 3600e6,
+              (unsigned long long)sim.loops, sim.data.received(), sim.linkDrops);
+      nextReportUs += (uint64_t)SIM_REPORT_INTERVAL_S * 1000000;
+    }
+  }
+
+  uint64_t endUs = hal::Clock::nowUs();
+  double hostS = (hal::hostNs() - sim.hostStartNs) / 1e9;
+  int64_t heapRunPeak = heap::peak.load() - heapBefore;
+  int64_t heapEnd = heap::live.load() - heapBefore;
+
+  uint64_t expectedReads = (endUs - setupUs) / ((uint64_t)SENSOR_READ_INTERVAL * 1000);
+  uint32_t reads = sensor.getStats().triggers - triggersAtSetup;
+  uint64_t missedReads = expectedReads > reads ? expectedReads - reads : 0;
+
+  double airtimeUs = hal::Network::txSegments * (double)SIM_FRAME_AIRTIME_US +
+                     (hal::Network::txBytes + hal::Network::rxBytes) * 8.0 / SIM_PHY_MBPS +
+                     sim.associatedUs * SIM_BEACON_DUTY;
+  double totalUs = endUs ? (double)endUs : 1.0;
+  MQTTBrokerSimStats b = broker.getStats();
+  uint32_t endMs = (uint32_t)(endUs / 1000);
+
+  // ─────────────────────────────────────────────────────────────────────────────
+  // Report
+  // ─────────────────────────────────────────────────────────────────────────────
+  fflush(stdout);
+  printf("\nxBio firmware simulation: %.2f days virtual in %.1f s host (%.0fx), setup %.2f s, tick %u us\n",
+         endUs / 86400e6, hostS, hostS > 0 ? endUs / 1e6 / hostS : 0.0, setupUs / 1e6, sim.tickUs);
+  printf("  link:     RTT %.0f ms, %u drops", hal::Network::latencyUs * 2 / 1000.0, sim.linkDrops);
+  if (sim.resetReason) printf(", RESET (%s) at %.3f s", sim.resetReason, sim.resetAtUs / 1e6);
+  printf("\n");
+  printf("  loop:     %llu iterations; virtual p50 %llu us, p99 %llu us, p99.9 %llu us, max %llu us\n",
+         (unsigned long long)sim.loops, (unsigned long long)sim.loopUs.percentile(0.5),
+         (unsigned long long)sim.loopUs.percentile(0.99), (unsigned long long)sim.loopUs.percentile(0.999),
+         (unsigned long long)sim.loopUs.max());
+  printf("            host p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns, mean %.0f ns\n",
+         (unsigned long long)sim.loopHostNs.percentile(0.5), (unsigned long long)sim.loopHostNs.percentile(0.99),
+         (unsigned long long)sim.loopHostNs.percentile(0.999), (unsigned long long)sim.loopHostNs.max(),
+         sim.loopHostNs.mean());
+  printf("  samples:  %u sensor reads of %llu due (%llu missed)\n", reads, (unsigned long long)expectedReads,
+         (unsigned long long)missedReads);
+  printf("            data %u received, %u lost, %u late, %u duplicate, %u outstanding at end\n",
+         sim.data.received(), sim.data.lost, sim.data.late, sim.data.duplicates, sim.data.outstanding(endMs));
+  printf("            stream %u received, %u lost\n", sim.stream.received(), sim.stream.lost);
+  printf("  publish:  data latency p50 %llu ms, p99 %llu ms, max %llu ms\n",
+         (unsigned long long)sim.publishMs.percentile(0.5), (unsigned long long)sim.publishMs.percentile(0.99),
+         (unsigned long long)sim.publishMs.max());
+  printf("  broker:   %u connects, %u drops, %u wills, %u publishes (%u dup), %u status online / %u offline, "
+         "%u alerts\n", b.connects, b.drops, b.wills, b.publishes, b.duplicates, sim.online, sim.offline, sim.alerts);
+  printf("  heap:     setup peak %lld B, loop peak %lld B, after setup %lld B, end %lld B\n", (long long)heapSetupPeak,
+         (long long)heapRunPeak, (long long)heapAfterSetup, (long long)heapEnd);
+  printf("  radio:    on %.1f %%, associated %.1f %%, airtime est. %.2f %% (%llu B tx, %llu B rx, %u segments)\n",
+         100.0 * sim.radioOnUs / totalUs, 100.0 * sim.associatedUs / totalUs, 100.0 * airtimeUs / totalUs,
+         (unsigned long long)hal::Network::txBytes, (unsigned long long)hal::Network::rxBytes,
+         hal::Network::txSegments);
+
+  const Metric metrics[] = {
+    {"loop_p50_us", (double)sim.loopUs.percentile(0.5)},
+    {"loop_p99_us", (double)sim.loopUs.percentile(0.99)},
+    {"loop_p999_us", (double)sim.loopUs.percentile(0.999)},
+    {"loop_max_us", (double)sim.loopUs.max()},
+    {"loop_host_p99_ns", (double)sim.loopHostNs.percentile(0.99)},
+    {"loop_host_mean_ns", sim.loopHostNs.mean()},
+    {"sensor_missed", (double)missedReads},
+    {"data_lost", (double)sim.data.lost},
+    {"data_outstanding", (double)sim.data.outstanding(endMs)},
+    {"stream_lost", (double)sim.stream.lost},
+    {"publish_p50_ms", (double)sim.publishMs.percentile(0.5)},
+    {"publish_p99_ms", (double)sim.publishMs.percentile(0.99)},
+    {"publish_max_ms", (double)sim.publishMs.max()},
+    {"heap_setup_peak_bytes", (double)heapSetupPeak},
+    {"heap_peak_bytes", (double)heapRunPeak},
+    {"heap_growth_bytes", (double)(heapEnd - heapAfterSetup)},
+    {"radio_on_pct", 100.0 * sim.radioOnUs / totalUs},
+    {"airtime_pct", 100.0 * airtimeUs / totalUs},
+    {"resets", sim.resetReason ? 1.0 : 0.0},
+  };
+  printf("\n");
+  for (const Metric& metric : metrics) printf("%s %.6g\n", metric.key, metric.value);
+
+  int status = sim.budgetPath ? checkBudget(sim.budgetPath, metrics, sizeof(metrics) / sizeof(metrics[0])) : 0;
+  fflush(stdout);
+  _exit(status); // Firmware globals and task threads are not torn down
+}
@@ -1,73 +1,328 @@
 /**
  * ═══════════════════════════════════════════════════════════════════════════════
  * 🚨 Alert Manager - Threshold Monitoring & Notifications
+ * Fixed rule table, hysteresis + minimum duration, ring of recent events
  * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Each AlertType has exactly one state slot, so memory is fixed and lookup
+ * is an array index. A rule raises once its condition has held for
+ * minDurationMs, and clears only after the value is back past the threshold
+ * by the hysteresis band - a reading hovering at the limit neither floods
+ * nor flaps. Thresholds are read from ConfigManager on every evaluation, so
+ * a config patch takes effect on the next sample.
+ *
+ * The ANOMALY_* rules read the AnomalyDetector channel scores instead of the
+ * raw values, against the anomaly_z config threshold. Their hysteresis is in
+ * z units, they raise without a hold (the score is already a deviation from
+ * a learned baseline) and a NaN score - warm-up, missing channel - leaves
+ * the state as it is.
+ *
+ * Every raise / clear / acknowledge is appended to a small ring (oldest
+ * overwritten) and handed to the event callback, which publishes it straight
+ * away instead of waiting for the telemetry interval.
+ *
+ * Loop task only.
  */
 
 #ifndef ALERT_MANAGER_H
 #define ALERT_MANAGER_H
 
 #include <Arduino.h>
+#include "bme688_driver.h"
 #include "config_manager.h"
+#include "anomaly_detector.h"
 
-struct Alert {
-  String type;
+#ifndef ALERT_EVENT_CAPACITY
+  #define ALERT_EVENT_CAPACITY 16       // Recent events kept for status / late subscribers
+#endif
+
+#ifndef ALERT_MIN_DURATION
+  #define ALERT_MIN_DURATION 5000       // Condition must hold this long before raising
+#endif
+
+#ifndef ALERT_IAQ_MIN_DURATION
+  #define ALERT_IAQ_MIN_DURATION 30000  // IAQ spikes briefly (cooking, door opening)
+#endif
+
+#ifndef ALERT_ANOMALY_MIN_DURATION
+  #define ALERT_ANOMALY_MIN_DURATION 0
+#endif
+
+#ifndef ALERT_ANOMALY_HYSTERESIS
+  #define ALERT_ANOMALY_HYSTERESIS 2.0f // Score must fall this far below anomaly_z to clear
+#endif
+
+// Order matches ALERT_RULES
+enum class AlertType : uint8_t {
+  HIGH_TEMPERATURE = 0,
+  LOW_TEMPERATURE,
+  HIGH_HUMIDITY,
+  LOW_HUMIDITY,
+  POOR_AIR_QUALITY,
+  ANOMALY_TEMPERATURE,
+  ANOMALY_HUMIDITY,
+  ANOMALY_PRESSURE,
+  ANOMALY_IAQ,
+  ANOMALY_GAS,
+  COUNT
+};
+
+enum class AlertMetric : uint8_t {
+  TEMPERATURE,
+  HUMIDITY,
+  IAQ,
+  ANOMALY                       // AnomalyDetector score of AlertRule::channel
+};
+
+enum class AlertEventKind : uint8_t {
+  RAISED,
+  CLEARED,
+  ACKNOWLEDGED
+};
+
+struct AlertRule {
+  const char* name;             // Wire name (server formats messages by it)
+  AlertMetric metric;
+  ConfigKey threshold;
+  bool above;                   // true: alert when value > threshold
+  float hysteresis;             // Distance back past the threshold needed to clear
+  uint32_t minDurationMs;
+  AnomalyChannel channel = AnomalyChannel::COUNT; // ANOMALY metric only (COUNT: none)
+};
+
+static constexpr AlertRule ALERT_RULES[] = {
+  {"HIGH_TEMPERATURE", AlertMetric::TEMPERATURE, ConfigKey::MAX_TEMPERATURE, true,  0.5f,  ALERT_MIN_DURATION},
+  {"LOW_TEMPERATURE",  AlertMetric::TEMPERATURE, ConfigKey::MIN_TEMPERATURE, false, 0.5f,  ALERT_MIN_DURATION},
+  {"HIGH_HUMIDITY",    AlertMetric::HUMIDITY,    ConfigKey::MAX_HUMIDITY,    true,  2.0f,  ALERT_MIN_DURATION},
+  {"LOW_HUMIDITY",     AlertMetric::HUMIDITY,    ConfigKey::MIN_HUMIDITY,    false, 2.0f,  ALERT_MIN_DURATION},
+  {"POOR_AIR_QUALITY", AlertMetric::IAQ,         ConfigKey::MAX_IAQ,         true,  10.0f, ALERT_IAQ_MIN_DURATION},
+  {"ANOMALY_TEMPERATURE", AlertMetric::ANOMALY, ConfigKey::ANOMALY_Z, true, ALERT_ANOMALY_HYSTERESIS,
+   ALERT_ANOMALY_MIN_DURATION, AnomalyChannel::TEMPERATURE},
+  {"ANOMALY_HUMIDITY",    AlertMetric::ANOMALY, ConfigKey::ANOMALY_Z, true, ALERT_ANOMALY_HYSTERESIS,
+   ALERT_ANOMALY_MIN_DURATION, AnomalyChannel::HUMIDITY},
+  {"ANOMALY_PRESSURE",    AlertMetric::ANOMALY, ConfigKey::ANOMALY_Z, true, ALERT_ANOMALY_HYSTERESIS,
+   ALERT_ANOMALY_MIN_DURATION, AnomalyChannel::PRESSURE},
+  {"ANOMALY_IAQ",         AlertMetric::ANOMALY, ConfigKey::ANOMALY_Z, true, ALERT_ANOMALY_HYSTERESIS,
+   ALERT_ANOMALY_MIN_DURATION, AnomalyChannel::IAQ},
+  {"ANOMALY_GAS",         AlertMetric::ANOMALY, ConfigKey::ANOMALY_Z, true, ALERT_ANOMALY_HYSTERESIS,
+   ALERT_ANOMALY_MIN_DURATION, AnomalyChannel::GAS},
+};
+
+static_assert(sizeof(ALERT_RULES) / sizeof(ALERT_RULES[0]) == (size_t)AlertType::COUNT,
+              "ALERT_RULES must list every AlertType in order");
+
+struct AlertEvent {
+  uint32_t seq;                 // Monotonic, lets the server spot gaps
+  uint32_t timestamp;           // millis()
+  AlertType type;
+  AlertEventKind kind;
   float value;
-  uint32_t timestamp;
+  float threshold;
+};
+
+struct AlertState {
+  bool active;
   bool acknowledged;
+  uint32_t pendingSince;        // millis() the condition started holding, 0 = not holding
+  uint32_t raisedAt;
+  float peak;                   // Worst value while active
 };
 
+typedef void (*AlertEventCallback)(const AlertEvent& event);
+
 class AlertManager {
 public:
-  AlertManager() : _config(nullptr), _alertCount(0), _cooldownTime(60000) {}
-  
-  void begin(ConfigManager* config) { _config = config; }
-  
-  void trigger(const char* type, float value) {
-    uint32_t now = millis();
-    
-    // Check cooldown
-    for (int i = 0; i < _alertCount; i++) {
-      if (_alerts[i].type == type && now - _alerts[i].timestamp < _cooldownTime) {
-        return; // Still in cooldown
+  AlertManager() : _config(nullptr), _anomaly(nullptr), _callback(nullptr), _seq(0), _head(0), _count(0) {
+    memset(_state, 0, sizeof(_state));
+  }
+
+  /**
+   * @param anomaly Scores for the ANOMALY_* rules (optional - they never raise without it)
+   */
+  void begin(ConfigManager* config, const AnomalyDetector* anomaly = nullptr) {
+    _config = config;
+    _anomaly = anomaly;
+  }
+  void setEventCallback(AlertEventCallback callback) { _callback = callback; }
+
+  /**
+   * Run every rule against one sample
+   */
+  void evaluate(const SensorData& data);
+
+  /**
+   * Acknowledge an active alert (silences it until it clears and re-raises)
+   * @return Number of alerts acknowledged
+   */
+  uint8_t acknowledge(AlertType type);
+  uint8_t acknowledgeAll();
+
+  bool isActive(AlertType type) const { return _state[(uint8_t)type].active; }
+  const AlertState& state(AlertType type) const { return _state[(uint8_t)type]; }
+  uint8_t getActiveCount() const;       // Active and not acknowledged
+
+  /**
+   * Recent events, oldest first
+   * @param index 0 .. eventCount() - 1
+   */
+  const AlertEvent& event(uint8_t index) const {
+    return _events[(_head + ALERT_EVENT_CAPACITY - _count + index) % ALERT_EVENT_CAPACITY];
+  }
+  uint8_t eventCount() const { return _count; }
+  uint32_t lastSeq() const { return _seq; }
+
+  static const char* typeName(AlertType type);
+  static bool parseType(const char* name, AlertType* type);
+  static const char* kindName(AlertEventKind kind);
+
+private:
+  ConfigManager* _config;
+  const AnomalyDetector* _anomaly;
+  AlertEventCallback _callback;
+  AlertState _state[(uint8_t)AlertType::COUNT];
+
+  AlertEvent _events[ALERT_EVENT_CAPACITY];
+  uint32_t _seq;
+  uint8_t _head;                // Next write slot
+  uint8_t _count;
+
+  float value(const AlertRule& rule, const SensorData& data) const;
+  float threshold(const AlertRule& rule) const;
+  void record(AlertType type, AlertEventKind kind, float value, float threshold);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void AlertManager::evaluate(const SensorData& data) {
+  if (!_config || !data.valid) return;
+
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < (uint8_t)AlertType::COUNT; i++) {
+    const AlertRule& rule = ALERT_RULES[i];
+    AlertState& s = _state[i];
+
+    float value = this->value(rule, data);
+    if (value != value) continue; // No score yet
+    float limit = threshold(rule);
+
+    if (!s.active) {
+      bool breach = rule.above ? value > limit : value < limit;
+      if (!breach) {
+        s.pendingSince = 0;
+        continue;
       }
+      if (s.pendingSince == 0) s.pendingSince = now ? now : 1;
+      if (now - s.pendingSince < rule.minDurationMs) continue;
+
+      s.active = true;
+      s.acknowledged = false;
+      s.raisedAt = now;
+      s.peak = value;
+      Serial.printf("⚠️ ALERT: %s = %.2f (threshold %.2f)\n", rule.name, value, limit);
+      record((AlertType)i, AlertEventKind::RAISED, value, limit);
+      continue;
     }
-    
-    // Add new alert
-    if (_alertCount < 10) {
-      _alerts[_alertCount].type = type;
-      _alerts[_alertCount].value = value;
-      _alerts[_alertCount].timestamp = now;
-      _alerts[_alertCount].acknowledged = false;
-      _alertCount++;
-      
-      Serial.printf("⚠️ ALERT: %s = %.2f\n", type, value);
+
+    if (rule.above ? value > s.peak : value < s.peak) s.peak = value;
+
+    bool clear = rule.above ? value < limit - rule.hysteresis : value > limit + rule.hysteresis;
+    if (clear) {
+      s.active = false;
+      s.acknowledged = false;
+      s.pendingSince = 0;
+      Serial.printf("✅ ALERT cleared: %s = %.2f (peak %.2f, %lus)\n", rule.name, value, s.peak,
+                    (unsigned long)((now - s.raisedAt) / 1000));
+      record((AlertType)i, AlertEventKind::CLEARED, value, limit);
     }
   }
-  
-  void acknowledge(const char* type) {
-    for (int i = 0; i < _alertCount; i++) {
-      if (_alerts[i].type == type) {
-        _alerts[i].acknowledged = true;
-      }
-    }
+}
+
+uint8_t AlertManager::acknowledge(AlertType type) {
+  if (type >= AlertType::COUNT) return 0;
+  AlertState& s = _state[(uint8_t)type];
+  if (!s.active || s.acknowledged) return 0;
+
+  s.acknowledged = true;
+  Serial.printf("ALERT: %s acknowledged\n", typeName(type));
+  record(type, AlertEventKind::ACKNOWLEDGED, s.peak, threshold(ALERT_RULES[(uint8_t)type]));
+  return 1;
+}
+
+uint8_t AlertManager::acknowledgeAll() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < (uint8_t)AlertType::COUNT; i++) count += acknowledge((AlertType)i);
+  return count;
+}
+
+uint8_t AlertManager::getActiveCount() const {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < (uint8_t)AlertType::COUNT; i++) {
+    if (_state[i].active && !_state[i].acknowledged) count++;
+  }
+  return count;
+}
+
+float AlertManager::value(const AlertRule& rule, const SensorData& data) const {
+  switch (rule.metric) {
+    case AlertMetric::TEMPERATURE: return data.temperature;
+    case AlertMetric::HUMIDITY: return data.humidity;
+    case AlertMetric::IAQ: return (float)data.iaq;
+    case AlertMetric::ANOMALY: return _anomaly ? _anomaly->score(rule.channel).score : NAN;
   }
-  
-  int getActiveCount() {
-    int count = 0;
-    for (int i = 0; i < _alertCount; i++) {
-      if (!_alerts[i].acknowledged) count++;
+  return NAN;
+}
+
+float AlertManager::threshold(const AlertRule& rule) const {
+  if (!_config) return 0;
+  switch (rule.threshold) {
+    case ConfigKey::MAX_TEMPERATURE: return _config->getMaxTemperature();
+    case ConfigKey::MIN_TEMPERATURE: return _config->getMinTemperature();
+    case ConfigKey::MAX_HUMIDITY: return _config->getMaxHumidity();
+    case ConfigKey::MIN_HUMIDITY: return _config->getMinHumidity();
+    case ConfigKey::MAX_IAQ: return (float)_config->getMaxIAQ();
+    case ConfigKey::ANOMALY_Z: return _config->getAnomalyZ();
+    default: return 0;
+  }
+}
+
+void AlertManager::record(AlertType type, AlertEventKind kind, float value, float threshold) {
+  AlertEvent& e = _events[_head];
+  e.seq = ++_seq;
+  e.timestamp = millis();
+  e.type = type;
+  e.kind = kind;
+  e.value = value;
+  e.threshold = threshold;
+
+  _head = (_head + 1) % ALERT_EVENT_CAPACITY;
+  if (_count < ALERT_EVENT_CAPACITY) _count++;
+
+  if (_callback) _callback(e);
+}
+
+const char* AlertManager::typeName(AlertType type) {
+  return type < AlertType::COUNT ? ALERT_RULES[(uint8_t)type].name : "?";
+}
+
+bool AlertManager::parseType(const char* name, AlertType* type) {
+  for (uint8_t i = 0; i < (uint8_t)AlertType::COUNT; i++) {
+    if (strcmp(name, ALERT_RULES[i].name) == 0) {
+      *type = (AlertType)i;
+      return true;
     }
-    return count;
   }
-  
-  void setCooldown(uint32_t ms) { _cooldownTime = ms; }
-  
-private:
-  ConfigManager* _config;
-  Alert _alerts[10];
-  int _alertCount;
-  uint32_t _cooldownTime;
-};
+  return false;
+}
+
+const char* AlertManager::kindName(AlertEventKind kind) {
+  switch (kind) {
+    case AlertEventKind::RAISED: return "raised";
+    case AlertEventKind::CLEARED: return "cleared";
+    case AlertEventKind::ACKNOWLEDGED: return "acknowledged";
+  }
+  return "?";
+}
 
 #endif
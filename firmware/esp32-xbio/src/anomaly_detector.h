@@ -0,0 +1,287 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 📈 Anomaly Detector - Streaming Per-Channel Scores for Sensor Samples
+ * EWMA mean/variance z-score, rate-of-change z-score, daily seasonal baseline
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Static thresholds assume every room has the same normal range. Here each
+ * channel learns its own: an exponentially weighted mean and variance
+ * (half-life ANOMALY_HALF_LIFE_S) give a level z-score, and the same over
+ * the per-minute rate of change catches sudden steps and spikes that stay
+ * inside the level band. State is a handful of floats per channel.
+ *
+ * Optional seasonal baseline: ANOMALY_SEASON_SLOTS time-of-day buckets per
+ * channel (PSRAM), each a slow EWMA over several days. Once a bucket has
+ * learned, the level is judged against it instead of the EWMA, so a swing
+ * that happens every day at the same time stops scoring while a slow drift
+ * the EWMA would follow (cooling failing over an evening) still does. It
+ * needs wall-clock time; update() takes the second of the day, or -1.
+ *
+ * Scores are |z| in noise-floor-limited standard deviations; a channel's
+ * score is the larger of level and rate. Quantized channels (IAQ counts)
+ * also floor the rate noise at their rounding noise, so a one-count tick
+ * between 1 s samples is not scored as a 60/min rate. Each statistic learns an outlier
+ * at a reduced rate so a fault does not teach itself as normal, and the
+ * first ANOMALY_WARMUP samples use a running average so the baselines start
+ * unbiased instead of creeping up from zero.
+ *
+ * Pure C++ (no Arduino dependencies) so tools/anomaly_replay.cpp replays
+ * traces through the same code. The defaults (half-lives, anomaly_z = 6,
+ * clear band) were tuned on the labelled synthetic trace from
+ * `anomaly_replay synth` only; no recorded field trace has been replayed.
+ */
+
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BOARD_HAS_PSRAM
+  #include <esp32-hal-psram.h>
+#endif
+
+#ifndef ANOMALY_HALF_LIFE_S
+  #define ANOMALY_HALF_LIFE_S 1800      // Level / rate baseline half-life
+#endif
+
+#ifndef ANOMALY_WARMUP
+  #define ANOMALY_WARMUP 300            // Samples before scores are reported
+#endif
+
+#ifndef ANOMALY_ROBUST_Z
+  #define ANOMALY_ROBUST_Z 4.0f         // Above this, learn at ANOMALY_ROBUST_SCALE of the rate
+#endif
+
+#ifndef ANOMALY_ROBUST_SCALE
+  #define ANOMALY_ROBUST_SCALE 0.05f
+#endif
+
+#ifndef ANOMALY_SEASON_SLOTS
+  #define ANOMALY_SEASON_SLOTS 96       // 15-minute time-of-day buckets
+#endif
+
+#ifndef ANOMALY_SEASON_DAYS
+  #define ANOMALY_SEASON_DAYS 3.0f      // Seasonal memory, in days of bucket visits
+#endif
+
+#ifndef ANOMALY_SEASON_MIN
+  #define ANOMALY_SEASON_MIN 600        // Samples a bucket needs before it scores
+#endif
+
+#define ANOMALY_DAY_S 86400
+
+enum class AnomalyChannel : uint8_t {
+  TEMPERATURE = 0,
+  HUMIDITY,
+  PRESSURE,
+  IAQ,
+  GAS,
+  COUNT
+};
+
+struct AnomalyChannelSpec {
+  const char* name;
+  const char* key;              // Short JSON key
+  float noise;                  // Sensor noise floor (SD) for the level
+  float rateNoise;              // ... and for the rate, per minute
+  float step;                   // Reading resolution (0 = continuous)
+  bool logScale;                // Score ln(value) (gas resistance spans decades)
+};
+
+static constexpr AnomalyChannelSpec ANOMALY_CHANNELS[] = {
+  {"temperature", "t", 0.1f, 0.2f, 0.0f, false},
+  {"humidity", "h", 0.5f, 1.0f, 0.0f, false},
+  {"pressure", "p", 0.1f, 0.2f, 0.0f, false},
+  {"iaq", "q", 5.0f, 10.0f, 1.0f, false},       // SensorData::iaq is whole counts
+  {"gas", "g", 0.05f, 0.1f, 0.0f, true},
+};
+
+static_assert(sizeof(ANOMALY_CHANNELS) / sizeof(ANOMALY_CHANNELS[0]) == (size_t)AnomalyChannel::COUNT,
+              "ANOMALY_CHANNELS must list every AnomalyChannel in order");
+
+struct AnomalyScore {
+  float level;                  // |z| against the EWMA baseline
+  float rate;                   // |z| of the rate of change
+  float season;                 // |z| against this time of day, NAN if not learned
+  float score;                  // Larger of level (or season) and rate, NAN during warm-up
+};
+
+class AnomalyDetector {
+public:
+  AnomalyDetector() : _season(nullptr), _samples(0) { reset(); }
+  ~AnomalyDetector() { free(_season); }
+
+  /**
+   * Allocate the seasonal baseline (PSRAM when available)
+   * @return false if it could not be allocated - level / rate scores still work
+   */
+  bool enableSeasonal();
+  bool seasonalEnabled() const { return _season != nullptr; }
+
+  void reset();
+
+  /**
+   * Score one sample and fold it into the baselines
+   * @param values     One value per AnomalyChannel (NAN = missing)
+   * @param timeMs     Sample time, for rates and adaptation (millis())
+   * @param secondOfDay Wall-clock second of the day, or -1 if unknown
+   * @return Largest channel score, NAN during warm-up
+   */
+  float update(const float* values, uint32_t timeMs, int32_t secondOfDay);
+
+  const AnomalyScore& score(AnomalyChannel channel) const { return _scores[(uint8_t)channel]; }
+  float maxScore() const { return _max; }
+  uint32_t samples() const { return _samples; }
+  bool warm() const { return _samples >= ANOMALY_WARMUP; }
+
+private:
+  struct Stat {
+    float mean;
+    float var;
+  };
+
+  struct Channel {
+    Stat level;
+    Stat rate;
+    float last;
+    uint32_t lastMs;
+    bool primed;
+  };
+
+  struct SeasonSlot {
+    Stat stat;
+    uint32_t count;
+  };
+
+  Channel _channels[(uint8_t)AnomalyChannel::COUNT];
+  AnomalyScore _scores[(uint8_t)AnomalyChannel::COUNT];
+  SeasonSlot* _season;          // [slot][channel]
+  uint32_t _samples;
+  float _max;
+
+  static float zScore(const Stat& stat, float x, float noise) {
+    float var = stat.var > noise * noise ? stat.var : noise * noise;
+    return fabsf(x - stat.mean) / sqrtf(var);
+  }
+
+  // Learning-rate scale: an outlier (once the statistic can judge one) barely moves it
+  static float robust(float z, bool judged) {
+    return judged && z > ANOMALY_ROBUST_Z ? ANOMALY_ROBUST_SCALE : 1.0f;
+  }
+
+  // West's incremental EWMA mean / variance
+  static void learn(Stat& stat, float x, float alpha) {
+    float diff = x - stat.mean;
+    float incr = alpha * diff;
+    stat.mean += incr;
+    stat.var = (1.0f - alpha) * (stat.var + diff * incr);
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+inline bool AnomalyDetector::enableSeasonal() {
+  if (_season) return true;
+
+  size_t bytes = sizeof(SeasonSlot) * ANOMALY_SEASON_SLOTS * (uint8_t)AnomalyChannel::COUNT;
+  #ifdef BOARD_HAS_PSRAM
+    _season = (SeasonSlot*)ps_malloc(bytes);
+  #endif
+  if (!_season) _season = (SeasonSlot*)malloc(bytes);
+  if (!_season) return false;
+
+  memset(_season, 0, bytes);
+  return true;
+}
+
+inline void AnomalyDetector::reset() {
+  memset(_channels, 0, sizeof(_channels));
+  for (uint8_t c = 0; c < (uint8_t)AnomalyChannel::COUNT; c++) {
+    _scores[c] = {NAN, NAN, NAN, NAN};
+  }
+  if (_season) memset(_season, 0, sizeof(SeasonSlot) * ANOMALY_SEASON_SLOTS * (uint8_t)AnomalyChannel::COUNT);
+  _samples = 0;
+  _max = NAN;
+}
+
+inline float AnomalyDetector::update(const float* values, uint32_t timeMs, int32_t secondOfDay) {
+  static const float TAU_MS = ANOMALY_HALF_LIFE_S * 1000.0f / 0.693147f;
+
+  bool warm = _samples + 1 >= ANOMALY_WARMUP;
+  int32_t slot = (_season && secondOfDay >= 0)
+    ? (int32_t)((uint64_t)(secondOfDay % ANOMALY_DAY_S) * ANOMALY_SEASON_SLOTS / ANOMALY_DAY_S) : -1;
+  _max = NAN;
+
+  for (uint8_t c = 0; c < (uint8_t)AnomalyChannel::COUNT; c++) {
+    const AnomalyChannelSpec& spec = ANOMALY_CHANNELS[c];
+    Channel& ch = _channels[c];
+    AnomalyScore& out = _scores[c];
+
+    float x = values[c];
+    if (spec.logScale) x = x > 0 ? logf(x) : NAN;
+    if (!(x == x)) {
+      out = {NAN, NAN, NAN, NAN};
+      continue;
+    }
+
+    if (!ch.primed) {
+      // First sample seeds the baseline
+      ch.level.mean = x;
+      ch.last = x;
+      ch.lastMs = timeMs;
+      ch.primed = true;
+      out = {NAN, NAN, NAN, NAN};
+      continue;
+    }
+
+    uint32_t dtMs = timeMs - ch.lastMs;
+    if (dtMs == 0) dtMs = 1;
+    float alpha = 1.0f - expf(-(float)dtMs / TAU_MS);
+    if (!warm) alpha = fmaxf(alpha, 1.0f / (_samples + 1));
+    float rate = (x - ch.last) * 60000.0f / dtMs;
+
+    // A one-step change between close samples is quantization, not a fast rate:
+    // floor the rate noise at the SD of the difference of two rounded readings
+    float rateNoise = fmaxf(spec.rateNoise, spec.step * 0.408f * 60000.0f / dtMs);
+
+    out.level = zScore(ch.level, x, spec.noise);
+    out.rate = zScore(ch.rate, rate, rateNoise);
+    out.season = NAN;
+
+    SeasonSlot* season = slot >= 0 ? &_season[slot * (uint8_t)AnomalyChannel::COUNT + c] : nullptr;
+    bool seasonLearned = season && season->count >= ANOMALY_SEASON_MIN;
+    if (seasonLearned) out.season = zScore(season->stat, x, spec.noise);
+
+    float score = fmaxf(seasonLearned ? out.season : out.level, out.rate);
+    out.score = warm ? score : NAN;
+    if (warm && !(score <= _max)) _max = score;
+
+    learn(ch.level, x, alpha * robust(out.level, warm));
+    learn(ch.rate, rate, alpha * robust(out.rate, warm));
+
+    if (season) {
+      // Plain average until the bucket has ANOMALY_SEASON_MIN samples, then a multi-day EWMA
+      float seasonAlpha = (float)dtMs / (ANOMALY_SEASON_DAYS * (ANOMALY_DAY_S * 1000.0f / ANOMALY_SEASON_SLOTS));
+      if (!seasonLearned) {
+        if (season->count == 0) season->stat.mean = x;
+        seasonAlpha = 1.0f / (season->count + 1);
+      }
+      learn(season->stat, x, seasonAlpha * robust(out.season, seasonLearned));
+      season->count++;
+    }
+
+    ch.last = x;
+    ch.lastMs = timeMs;
+  }
+
+  _samples++;
+  return _max;
+}
+
+#endif
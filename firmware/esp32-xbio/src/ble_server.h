@@ -11,6 +11,7 @@
 #include <Arduino.h>
 #include <NimBLEDevice.h>
 #include "bme688_driver.h"
+#include "sink_bus.h"
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // BLE UUIDs
@@ -30,7 +31,7 @@ class XBioBLEServer;
 // Callback types
 typedef void (*BLEDataCallback)(SensorData data);
 typedef void (*BLEConfigCallback)(String config);
-typedef void (*BLECommandCallback)(String command);
+typedef void (*BLECommandCallback)(const char* payload, size_t length);
 typedef void (*BLEWiFiCallback)(String ssid, String password);
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -109,6 +110,7 @@ public:
    * Update sensor data characteristic
    */
   void updateSensorData(SensorData data);
+  void updateSensorJson(const char* json, size_t length);
   
   /**
    * Update status characteristic
@@ -155,7 +157,6 @@ private:
   
   void createService();
   void startAdvertising();
-  String sensorDataToJson(SensorData data);
 };
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -188,7 +189,8 @@ CommandCharCallbacks::CommandCharCallbacks(BLECommandCallback callback) : _callb
 
 void CommandCharCallbacks::onWrite(NimBLECharacteristic* pChar) {
   if (_callback) {
-    _callback(pChar->getValue().c_str());
+    NimBLEAttValue value = pChar->getValue();
+    _callback((const char*)value.data(), value.length());
   }
 }
 
@@ -335,10 +337,16 @@ uint8_t XBioBLEServer::getConnectedCount() {
 }
 
 void XBioBLEServer::updateSensorData(SensorData data) {
+  char buffer[256];
+  size_t length = XBioSinkBus::encodeCompact(data, millis(), buffer, sizeof(buffer));
+  if (length < sizeof(buffer)) updateSensorJson(buffer, length);
+}
+
+void XBioBLEServer::updateSensorJson(const char* json, size_t length) {
   if (!_sensorChar) return;
   
-  String json = sensorDataToJson(data);
-  _sensorChar->setValue(json);
+  // Same compact encoding the sink bus shares with WebSocket - no re-serialization here
+  _sensorChar->setValue((const uint8_t*)json, length);
   
   if (_connectedClients > 0) {
     _sensorChar->notify();
@@ -355,23 +363,6 @@ void XBioBLEServer::updateStatus(String status) {
   }
 }
 
-String XBioBLEServer::sensorDataToJson(SensorData data) {
-  // Compact JSON for BLE
-  char buffer[256];
-  snprintf(buffer, sizeof(buffer),
-    "{\"t\":%.1f,\"h\":%.1f,\"p\":%.1f,\"g\":%.0f,\"q\":%d,\"a\":%d,\"c\":%.0f,\"v\":%.2f}",
-    data.temperature,
-    data.humidity,
-    data.pressure,
-    data.gasResistance,
-    data.iaq,
-    data.iaqAccuracy,
-    data.co2Equivalent,
-    data.vocEquivalent
-  );
-  return String(buffer);
-}
-
 void XBioBLEServer::setDataCallback(BLEDataCallback callback) {
   _dataCallback = callback;
 }
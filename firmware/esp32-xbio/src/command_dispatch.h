@@ -0,0 +1,556 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🎛️ Command Dispatch - Compile-time Command Table for MQTT / BLE / WebSocket
+ * Perfect-hash name lookup, typed parameters parsed in place from the payload
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Payloads are flat JSON objects ({"command":"sleep","duration_ms":60000}) or,
+ * for BLE, a bare command name. The payload is scanned once into key/value
+ * spans that point back into the caller's buffer - no DOM, no String, no heap.
+ * Handlers declare their parameters and read them by index.
+ *
+ * Pure C++ (no Arduino dependencies) so host tools can use the same table.
+ */
+
+#ifndef COMMAND_DISPATCH_H
+#define COMMAND_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef COMMAND_MAX_FIELDS
+  #define COMMAND_MAX_FIELDS 24       // Top-level keys scanned per payload
+#endif
+
+#ifndef COMMAND_MAX_PARAMS
+  #define COMMAND_MAX_PARAMS 20       // Declared parameters per command (config_patch takes every field)
+#endif
+
+#ifndef COMMAND_SEED_SEARCH
+  #define COMMAND_SEED_SEARCH 4096    // Compile-time seed attempts for a collision-free table
+#endif
+
+#define COMMAND_NAME_KEY "command"
+#define COMMAND_PARAMS(list) list, (uint8_t)(sizeof(list) / sizeof(list[0]))
+#define COMMAND_NO_PARAMS nullptr, 0
+
+enum class CommandSource : uint8_t {
+  MQTT = 0,
+  BLE = 1,
+  WEBSOCKET = 2
+};
+
+enum class ParamType : uint8_t {
+  INT,
+  FLOAT,
+  BOOL,
+  STRING
+};
+
+enum class CommandResult : uint8_t {
+  OK,
+  UNKNOWN,          // Name not in the table
+  MALFORMED,        // Payload is not a flat JSON object / has no command
+  MISSING_PARAM,    // Required parameter absent
+  BAD_PARAM         // Parameter present with the wrong type
+};
+
+struct CommandParam {
+  const char* key;
+  ParamType type;
+  bool required;
+};
+
+// View into the caller's payload buffer
+struct CommandSpan {
+  const char* ptr;
+  uint16_t length;
+};
+
+struct CommandValue {
+  bool present;
+  union {
+    int32_t i;
+    float f;
+    bool b;
+    CommandSpan s;    // Raw (still escaped) string contents
+  };
+};
+
+class CommandArgs {
+public:
+  CommandSource source;
+  CommandSpan name;
+  CommandValue values[COMMAND_MAX_PARAMS];
+  uint8_t count;
+
+  bool has(uint8_t index) const { return index < count && values[index].present; }
+  int32_t getInt(uint8_t index, int32_t fallback = 0) const { return has(index) ? values[index].i : fallback; }
+  float getFloat(uint8_t index, float fallback = 0.0f) const { return has(index) ? values[index].f : fallback; }
+  bool getBool(uint8_t index, bool fallback = false) const { return has(index) ? values[index].b : fallback; }
+
+  /**
+   * Copy a string parameter out, unescaping it
+   * @return Length written (excluding NUL), 0 if absent
+   */
+  size_t getString(uint8_t index, char* out, size_t size) const;
+};
+
+typedef void (*CommandHandler)(const CommandArgs& args);
+
+struct CommandSpec {
+  const char* name;
+  CommandHandler handler;
+  const CommandParam* params;
+  uint8_t paramCount;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Payload Scanner
+// ═══════════════════════════════════════════════════════════════════════════════
+
+struct CommandField {
+  CommandSpan key;
+  CommandSpan value;
+  char kind;        // 's' string, 'n' number, 't' true, 'f' false, 'z' null, 'o' object/array
+};
+
+class CommandParser {
+public:
+  /**
+   * Split a flat JSON object into top-level fields
+   * @return Field count, or -1 if the payload is not a well-formed object
+   */
+  static int scan(const char* payload, size_t length, CommandField* fields, uint8_t maxFields);
+
+  static bool parseNumber(CommandSpan span, bool integer, int32_t* asInt, float* asFloat);
+  static bool keyEquals(CommandSpan key, const char* name, size_t nameLength);
+
+private:
+  static size_t skipSpace(const char* p, size_t i, size_t n);
+  static bool scanString(const char* p, size_t& i, size_t n, CommandSpan& out);
+  static bool skipNested(const char* p, size_t& i, size_t n);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Perfect Hash Table
+// ═══════════════════════════════════════════════════════════════════════════════
+
+constexpr uint32_t commandHash(const char* s, size_t n, uint32_t seed) {
+  uint32_t h = 2166136261u ^ (seed * 0x9E3779B1u);
+  for (size_t i = 0; i < n; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+constexpr size_t commandNameLength(const char* s) {
+  size_t n = 0;
+  while (s[n]) n++;
+  return n;
+}
+
+constexpr size_t commandSlotsFor(size_t n) {
+  size_t slots = 4;
+  while (slots < n * 2) slots <<= 1;
+  return slots;
+}
+
+/**
+ * Command table built at compile time. The constructor searches for a hash
+ * seed that gives every name its own slot; check valid() in a static_assert.
+ */
+template <size_t N>
+class CommandTable {
+public:
+  static constexpr size_t SLOTS = commandSlotsFor(N);
+  static constexpr uint32_t NO_SEED = 0xFFFFFFFFu;
+
+  constexpr CommandTable(const CommandSpec (&specs)[N])
+    : _specs(specs), _seed(NO_SEED), _slots{}, _lengths{} {
+    for (size_t i = 0; i < N; i++) _lengths[i] = (uint8_t)commandNameLength(specs[i].name);
+    for (uint32_t seed = 0; seed < COMMAND_SEED_SEARCH; seed++) {
+      if (build(seed)) {
+        _seed = seed;
+        return;
+      }
+    }
+  }
+
+  constexpr bool valid() const { return _seed != NO_SEED; }
+  constexpr uint32_t seed() const { return _seed; }
+  constexpr size_t size() const { return N; }
+
+  // Parameters past COMMAND_MAX_PARAMS would never be bound - check in a static_assert
+  constexpr bool paramsFit() const {
+    for (size_t i = 0; i < N; i++) {
+      if (_specs[i].paramCount > COMMAND_MAX_PARAMS) return false;
+    }
+    return true;
+  }
+
+  const CommandSpec* find(const char* name, size_t length) const {
+    uint8_t index = _slots[commandHash(name, length, _seed) & (SLOTS - 1)];
+    if (index == 0) return nullptr;
+    const CommandSpec* spec = &_specs[index - 1];
+    if (_lengths[index - 1] != length || memcmp(spec->name, name, length) != 0) return nullptr;
+    return spec;
+  }
+
+  /**
+   * Parse and run one command
+   * @param matched Set to the command that was found (nullptr if none)
+   */
+  CommandResult dispatch(CommandSource source, const char* payload, size_t length,
+                         const CommandSpec** matched = nullptr) const;
+
+private:
+  const CommandSpec* _specs;
+  uint32_t _seed;
+  uint8_t _slots[SLOTS];      // 1-based index into _specs, 0 = empty
+  uint8_t _lengths[N];
+
+  constexpr bool build(uint32_t seed) {
+    for (size_t s = 0; s < SLOTS; s++) _slots[s] = 0;
+    for (size_t i = 0; i < N; i++) {
+      size_t slot = commandHash(_specs[i].name, _lengths[i], seed) & (SLOTS - 1);
+      if (_slots[slot] != 0) return false;
+      _slots[slot] = (uint8_t)(i + 1);
+    }
+    return true;
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+template <size_t N>
+CommandResult CommandTable<N>::dispatch(CommandSource source, const char* payload, size_t length,
+                                        const CommandSpec** matched) const {
+  if (matched) *matched = nullptr;
+
+  CommandArgs args;
+  args.source = source;
+  args.count = 0;
+
+  CommandField fields[COMMAND_MAX_FIELDS];
+  int fieldCount = 0;
+
+  size_t start = 0;
+  while (start < length && (payload[start] == ' ' || payload[start] == '\t' ||
+                            payload[start] == '\r' || payload[start] == '\n')) start++;
+
+  if (start < length && payload[start] == '{') {
+    fieldCount = CommandParser::scan(payload, length, fields, COMMAND_MAX_FIELDS);
+    if (fieldCount < 0) return CommandResult::MALFORMED;
+
+    const CommandField* nameField = nullptr;
+    for (int f = 0; f < fieldCount; f++) {
+      if (fields[f].kind == 's' && CommandParser::keyEquals(fields[f].key, COMMAND_NAME_KEY,
+                                                            sizeof(COMMAND_NAME_KEY) - 1)) {
+        nameField = &fields[f];
+        break;
+      }
+    }
+    if (!nameField) return CommandResult::MALFORMED;
+    args.name = nameField->value;
+  } else {
+    // Bare command name (BLE terminal apps)
+    size_t end = length;
+    while (end > start && (payload[end - 1] == ' ' || payload[end - 1] == '\r' ||
+                           payload[end - 1] == '\n' || payload[end - 1] == '\0')) end--;
+    if (end == start) return CommandResult::MALFORMED;
+    args.name.ptr = payload + start;
+    args.name.length = (uint16_t)(end - start);
+  }
+
+  const CommandSpec* spec = find(args.name.ptr, args.name.length);
+  if (!spec) return CommandResult::UNKNOWN;
+  if (matched) *matched = spec;
+
+  // Bind declared parameters
+  args.count = spec->paramCount < COMMAND_MAX_PARAMS ? spec->paramCount : COMMAND_MAX_PARAMS;
+  for (uint8_t p = 0; p < args.count; p++) {
+    const CommandParam& param = spec->params[p];
+    CommandValue& value = args.values[p];
+    value.present = false;
+
+    const CommandField* field = nullptr;
+    size_t keyLength = strlen(param.key);
+    for (int f = 0; f < fieldCount; f++) {
+      if (CommandParser::keyEquals(fields[f].key, param.key, keyLength)) {
+        field = &fields[f];
+        break;
+      }
+    }
+
+    if (!field || field->kind == 'z') {
+      if (param.required) return CommandResult::MISSING_PARAM;
+      continue;
+    }
+
+    switch (param.type) {
+      case ParamType::INT:
+        if (field->kind != 'n' || !CommandParser::parseNumber(field->value, true, &value.i, nullptr)) {
+          return CommandResult::BAD_PARAM;
+        }
+        break;
+      case ParamType::FLOAT:
+        if (field->kind != 'n' || !CommandParser::parseNumber(field->value, false, nullptr, &value.f)) {
+          return CommandResult::BAD_PARAM;
+        }
+        break;
+      case ParamType::BOOL:
+        if (field->kind == 't' || field->kind == 'f') {
+          value.b = field->kind == 't';
+        } else if (field->kind == 'n' && CommandParser::parseNumber(field->value, true, &value.i, nullptr)) {
+          value.b = value.i != 0;
+        } else {
+          return CommandResult::BAD_PARAM;
+        }
+        break;
+      case ParamType::STRING:
+        if (field->kind != 's') return CommandResult::BAD_PARAM;
+        value.s = field->value;
+        break;
+    }
+    value.present = true;
+  }
+
+  spec->handler(args);
+  return CommandResult::OK;
+}
+
+inline size_t CommandArgs::getString(uint8_t index, char* out, size_t size) const {
+  if (size == 0) return 0;
+  out[0] = '\0';
+  if (!has(index)) return 0;
+
+  const CommandSpan& s = values[index].s;
+  size_t written = 0;
+  for (size_t i = 0; i < s.length && written < size - 1; i++) {
+    char c = s.ptr[i];
+    if (c == '\\' && i + 1 < s.length) {
+      char e = s.ptr[++i];
+      switch (e) {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'u': {
+          // ASCII code points only; anything wider becomes '?'
+          uint32_t cp = 0;
+          size_t digits = 0;
+          while (digits < 4 && i + 1 < s.length) {
+            char h = s.ptr[i + 1];
+            uint8_t v = (h >= '0' && h <= '9') ? h - '0' :
+                        (h >= 'a' && h <= 'f') ? h - 'a' + 10 :
+                        (h >= 'A' && h <= 'F') ? h - 'A' + 10 : 0xFF;
+            if (v == 0xFF) break;
+            cp = (cp << 4) | v;
+            i++;
+            digits++;
+          }
+          c = (digits == 4 && cp > 0 && cp < 0x80) ? (char)cp : '?';
+          break;
+        }
+        default: c = e; break;   // \" \\ \/
+      }
+    }
+    out[written++] = c;
+  }
+  out[written] = '\0';
+  return written;
+}
+
+inline size_t CommandParser::skipSpace(const char* p, size_t i, size_t n) {
+  while (i < n && (p[i] == ' ' || p[i] == '\t' || p[i] == '\r' || p[i] == '\n')) i++;
+  return i;
+}
+
+inline bool CommandParser::scanString(const char* p, size_t& i, size_t n, CommandSpan& out) {
+  // p[i] is the opening quote
+  size_t begin = ++i;
+  while (i < n && p[i] != '"') {
+    if (p[i] == '\\') i++;
+    i++;
+  }
+  if (i >= n || i - begin > 0xFFFF) return false;
+  out.ptr = p + begin;
+  out.length = (uint16_t)(i - begin);
+  i++; // Closing quote
+  return true;
+}
+
+inline bool CommandParser::skipNested(const char* p, size_t& i, size_t n) {
+  int depth = 0;
+  while (i < n) {
+    char c = p[i];
+    if (c == '"') {
+      CommandSpan ignored;
+      if (!scanString(p, i, n, ignored)) return false;
+      continue;
+    }
+    if (c == '{' || c == '[') depth++;
+    if (c == '}' || c == ']') {
+      if (--depth == 0) {
+        i++;
+        return true;
+      }
+    }
+    i++;
+  }
+  return false;
+}
+
+inline int CommandParser::scan(const char* payload, size_t length, CommandField* fields, uint8_t maxFields) {
+  const char* p = payload;
+  size_t n = length;
+  size_t i = skipSpace(p, 0, n);
+  if (i >= n || p[i] != '{') return -1;
+  i = skipSpace(p, i + 1, n);
+
+  int count = 0;
+  if (i < n && p[i] == '}') return 0;
+
+  while (i < n) {
+    CommandField field;
+    if (p[i] != '"' || !scanString(p, i, n, field.key)) return -1;
+
+    i = skipSpace(p, i, n);
+    if (i >= n || p[i] != ':') return -1;
+    i = skipSpace(p, i + 1, n);
+    if (i >= n) return -1;
+
+    char c = p[i];
+    size_t begin = i;
+    if (c == '"') {
+      if (!scanString(p, i, n, field.value)) return -1;
+      field.kind = 's';
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+      while (i < n && ((p[i] >= '0' && p[i] <= '9') || p[i] == '-' || p[i] == '+' ||
+                       p[i] == '.' || p[i] == 'e' || p[i] == 'E')) i++;
+      field.kind = 'n';
+    } else if (c == 't' && n - i >= 4 && memcmp(p + i, "true", 4) == 0) {
+      i += 4;
+      field.kind = 't';
+    } else if (c == 'f' && n - i >= 5 && memcmp(p + i, "false", 5) == 0) {
+      i += 5;
+      field.kind = 'f';
+    } else if (c == 'n' && n - i >= 4 && memcmp(p + i, "null", 4) == 0) {
+      i += 4;
+      field.kind = 'z';
+    } else if (c == '{' || c == '[') {
+      if (!skipNested(p, i, n)) return -1;
+      field.kind = 'o';
+    } else {
+      return -1;
+    }
+    if (field.kind != 's') {
+      field.value.ptr = p + begin;
+      field.value.length = (uint16_t)(i - begin);
+    }
+
+    if (count < maxFields) fields[count++] = field;
+
+    i = skipSpace(p, i, n);
+    if (i >= n) return -1;
+    if (p[i] == '}') return count;
+    if (p[i] != ',') return -1;
+    i = skipSpace(p, i + 1, n);
+  }
+  return -1;
+}
+
+inline bool CommandParser::parseNumber(CommandSpan span, bool integer, int32_t* asInt, float* asFloat) {
+  const char* p = span.ptr;
+  size_t n = span.length;
+  size_t i = 0;
+
+  bool negative = false;
+  if (i < n && p[i] == '-') {
+    negative = true;
+    i++;
+  }
+
+  int64_t mantissa = 0;
+  int exponent = 0;
+  size_t digits = 0;
+  while (i < n && p[i] >= '0' && p[i] <= '9') {
+    if (mantissa < 100000000000000000LL) mantissa = mantissa * 10 + (p[i] - '0');
+    else exponent++;
+    i++;
+    digits++;
+  }
+  if (i < n && p[i] == '.') {
+    i++;
+    while (i < n && p[i] >= '0' && p[i] <= '9') {
+      if (mantissa < 100000000000000000LL) {
+        mantissa = mantissa * 10 + (p[i] - '0');
+        exponent--;
+      }
+      i++;
+      digits++;
+    }
+  }
+  if (digits == 0) return false;
+  if (i < n && (p[i] == 'e' || p[i] == 'E')) {
+    i++;
+    bool expNegative = false;
+    if (i < n && (p[i] == '+' || p[i] == '-')) expNegative = p[i++] == '-';
+    int e = 0;
+    size_t expDigits = 0;
+    while (i < n && p[i] >= '0' && p[i] <= '9') {
+      if (e < 1000) e = e * 10 + (p[i] - '0');
+      i++;
+      expDigits++;
+    }
+    if (expDigits == 0) return false;
+    exponent += expNegative ? -e : e;
+  }
+  if (i != n) return false;
+
+  if (integer) {
+    // Integers must be exact - 1.5 is rejected, 1e3 is fine
+    int64_t v = mantissa;
+    for (; exponent > 0; exponent--) {
+      if (v > 0x7FFFFFFFLL) return false;
+      v *= 10;
+    }
+    for (; exponent < 0; exponent++) {
+      if (v % 10 != 0) return false;
+      v /= 10;
+    }
+    if (negative) v = -v;
+    if (v > 0x7FFFFFFFLL || v < -0x80000000LL) return false;
+    *asInt = (int32_t)v;
+    return true;
+  }
+
+  float v = (float)mantissa;
+  for (; exponent > 0; exponent--) v *= 10.0f;
+  for (; exponent < 0; exponent++) v /= 10.0f;
+  *asFloat = negative ? -v : v;
+  return true;
+}
+
+inline bool CommandParser::keyEquals(CommandSpan key, const char* name, size_t nameLength) {
+  return key.length == nameLength && memcmp(key.ptr, name, nameLength) == 0;
+}
+
+inline const char* commandResultName(CommandResult result) {
+  switch (result) {
+    case CommandResult::OK: return "ok";
+    case CommandResult::UNKNOWN: return "unknown command";
+    case CommandResult::MALFORMED: return "malformed payload";
+    case CommandResult::MISSING_PARAM: return "missing parameter";
+    case CommandResult::BAD_PARAM: return "bad parameter";
+  }
+  return "?";
+}
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 📬 Command Queue - Lock-free MPSC Hand-off from Transport Callbacks
+ * MQTT / BLE / WS callbacks copy the payload in and return; loop() executes
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Bounded ring with a sequence number per slot (Vyukov). Producers claim a
+ * slot with one CAS on the enqueue position and publish it with a release
+ * store, so the NimBLE host task and the Arduino loop task can push
+ * concurrently without locks. The single consumer reads the payload in place
+ * and releases the slot with pop().
+ *
+ * Pure C++ (no Arduino dependencies) so host tools can use the same queue.
+ */
+
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "command_dispatch.h"
+
+#ifndef COMMAND_QUEUE_DEPTH
+  #define COMMAND_QUEUE_DEPTH 8           // Must be a power of two
+#endif
+
+#ifndef COMMAND_QUEUE_SLOT_SIZE
+  #define COMMAND_QUEUE_SLOT_SIZE 768     // Largest command payload accepted (ota_update: two URLs + signature)
+#endif
+
+static_assert((COMMAND_QUEUE_DEPTH & (COMMAND_QUEUE_DEPTH - 1)) == 0, "COMMAND_QUEUE_DEPTH must be a power of two");
+
+struct CommandQueueStats {
+  uint32_t enqueued;
+  uint32_t executed;
+  uint32_t dropped;       // Queue full
+  uint32_t oversize;      // Payload larger than a slot
+  uint32_t pending;
+};
+
+class CommandQueue {
+public:
+  struct Entry {
+    std::atomic<uint32_t> sequence;
+    CommandSource source;
+    uint16_t length;
+    char data[COMMAND_QUEUE_SLOT_SIZE];
+  };
+
+  CommandQueue() : _enqueuePos(0), _dequeuePos(0), _enqueued(0), _dropped(0), _oversize(0), _executed(0) {
+    for (uint32_t i = 0; i < COMMAND_QUEUE_DEPTH; i++) {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Copy a payload in - safe from any task, never blocks
+   * @return false if the queue is full or the payload does not fit
+   */
+  bool push(CommandSource source, const char* payload, size_t length);
+
+  /**
+   * Consumer side (one task only) - oldest entry, or nullptr when empty
+   */
+  const Entry* front();
+  void pop();
+
+  bool isEmpty() { return front() == nullptr; }
+  CommandQueueStats getStats();
+
+private:
+  Entry _slots[COMMAND_QUEUE_DEPTH];
+  std::atomic<uint32_t> _enqueuePos;
+  uint32_t _dequeuePos;           // Consumer-owned
+
+  std::atomic<uint32_t> _enqueued;
+  std::atomic<uint32_t> _dropped;
+  std::atomic<uint32_t> _oversize;
+  uint32_t _executed;             // Consumer-owned
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+inline bool CommandQueue::push(CommandSource source, const char* payload, size_t length) {
+  if (length > COMMAND_QUEUE_SLOT_SIZE) {
+    _oversize.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+  Entry* slot;
+  for (;;) {
+    slot = &_slots[pos & (COMMAND_QUEUE_DEPTH - 1)];
+    uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(sequence - pos);
+
+    if (diff == 0) {
+      // Slot free at this position - claim it
+      if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      // Consumer has not released this slot yet - full
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = _enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->source = source;
+  slot->length = (uint16_t)length;
+  memcpy(slot->data, payload, length);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  _enqueued.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+inline const CommandQueue::Entry* CommandQueue::front() {
+  Entry* slot = &_slots[_dequeuePos & (COMMAND_QUEUE_DEPTH - 1)];
+  uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+  return sequence == _dequeuePos + 1 ? slot : nullptr;
+}
+
+inline void CommandQueue::pop() {
+  Entry* slot = &_slots[_dequeuePos & (COMMAND_QUEUE_DEPTH - 1)];
+  if (slot->sequence.load(std::memory_order_relaxed) != _dequeuePos + 1) return;
+
+  // Hand the slot back to producers one lap later
+  slot->sequence.store(_dequeuePos + COMMAND_QUEUE_DEPTH, std::memory_order_release);
+  _dequeuePos++;
+  _executed++;
+}
+
+inline CommandQueueStats CommandQueue::getStats() {
+  CommandQueueStats stats;
+  stats.enqueued = _enqueued.load(std::memory_order_relaxed);
+  stats.executed = _executed;
+  stats.dropped = _dropped.load(std::memory_order_relaxed);
+  stats.oversize = _oversize.load(std::memory_order_relaxed);
+  stats.pending = stats.enqueued - stats.executed;
+  return stats;
+}
+
+#endif
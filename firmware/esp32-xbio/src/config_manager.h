@@ -1,7 +1,30 @@
 /**
  * ═══════════════════════════════════════════════════════════════════════════════
  * ⚙️ Config Manager - Persistent Configuration Storage
+ * In-RAM snapshot loaded once at begin(), write-back to NVS
  * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Getters are plain field loads (the alert path reads thresholds every
+ * sample). Every change goes through apply(): the candidate record is
+ * validated as a whole and swapped in only if all of it is acceptable, then
+ * the changed keys are marked dirty and listeners notified. loop() flushes
+ * once writes have settled for CONFIG_COMMIT_DELAY, and at most once per
+ * CONFIG_COMMIT_INTERVAL. saveState() flushes immediately (before sleep /
+ * restart).
+ *
+ * Storage: the schema fields live in ONE versioned, CRC-protected NVS blob
+ * ("cfg"), so any number of changed fields costs a single flash write and a
+ * power cut leaves either the old or the new record, never a mix. The CA and
+ * OTA key PEMs are large and rarely change, so they keep their own keys.
+ * Devices upgrading from per-key storage migrate on first boot, and the
+ * per-key entries are erased once the blob is written. A blob from a newer
+ * schema (after an OTA rollback) loads the fields this build knows and keeps
+ * the rest, so rolling forward again finds its settings intact.
+ *
+ * hash() (CRC-32 of the record) goes out in status so the server can skip
+ * pushing a config the device already has.
+ *
+ * Loop task only - commands are already executed there.
  */
 
 #ifndef CONFIG_MANAGER_H
@@ -9,46 +32,629 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <stddef.h>
+
+#ifndef CONFIG_COMMIT_DELAY
+  #define CONFIG_COMMIT_DELAY 2000        // Quiet time after the last change before flushing
+#endif
+
+#ifndef CONFIG_COMMIT_INTERVAL
+  #define CONFIG_COMMIT_INTERVAL 10000    // Minimum gap between NVS flushes
+#endif
+
+#ifndef CONFIG_MAX_LISTENERS
+  #define CONFIG_MAX_LISTENERS 4
+#endif
+
+#ifndef CONFIG_BLOB_MAX_SIZE
+  #define CONFIG_BLOB_MAX_SIZE 4096       // Largest stored blob accepted (newer schemas included)
+#endif
+
+#define CONFIG_SCHEMA_VERSION 2
+#define CONFIG_BLOB_KEY "cfg"
+#define CONFIG_BLOB_MAGIC 0x47464358UL    // "XCFG"
+
+// Schema fields first (ConfigRecord order), then the PEM keys stored on their own
+enum class ConfigKey : uint8_t {
+  DEVICE_ID = 0,
+  DEVICE_NAME,
+  TEMP_OFFSET,
+  HUMIDITY_OFFSET,
+  MAX_TEMPERATURE,
+  MIN_TEMPERATURE,
+  MAX_HUMIDITY,
+  MIN_HUMIDITY,
+  MAX_IAQ,
+  MQTT_SERVER,
+  MQTT_PORT,
+  MQTT_TLS,
+  TLS_FINGERPRINT,
+  WS_SERVER,
+  WS_PORT,
+  UPLINK_MODE,
+  OTA_RATE,
+  ANOMALY_Z,
+  TLS_CA,
+  OTA_PUBKEY,
+  COUNT
+};
+
+#define CONFIG_RECORD_FIELDS ((uint8_t)ConfigKey::TLS_CA)
+
+static_assert((uint8_t)ConfigKey::COUNT <= 32, "Dirty set is a 32-bit mask");
+
+/**
+ * Schema v2 - persisted byte for byte. Append new fields at the end and bump
+ * CONFIG_SCHEMA_VERSION; older blobs load as a prefix over the defaults.
+ */
+struct ConfigRecord {
+  char deviceId[24];
+  char deviceName[32];
+  float tempOffset;
+  float humidityOffset;
+  float maxTemperature;
+  float minTemperature;
+  float maxHumidity;
+  float minHumidity;
+  int32_t maxIAQ;
+  char mqttServer[64];
+  int32_t mqttPort;
+  int32_t mqttTls;              // -1 = follow the port (8883 = TLS), else 0 / 1
+  char tlsFingerprint[100];     // SHA-256 hex, colons allowed
+  char wsServer[64];
+  int32_t wsPort;
+  int32_t uplinkMode;           // 0 = dual, 1 = auto (WS only as MQTT failover), 2 = MQTT only
+  int32_t otaRateLimit;         // KB/s, 0 = unlimited
+  float anomalyZ;               // v2: anomaly score that raises an ANOMALY_* alert
+};
+
+static_assert(sizeof(ConfigRecord) % 4 == 0, "ConfigRecord must have no tail padding");
+
+enum class ConfigType : uint8_t {
+  STRING,
+  FLOAT,
+  INT,
+  BOOL
+};
+
+struct ConfigField {
+  const char* name;             // Patch / status key
+  const char* nvsKey;           // Pre-blob per-key name (migration only)
+  ConfigType type;
+  uint16_t offset;
+  uint16_t size;
+  float min;                    // Accepted range for numbers
+  float max;
+  bool patchable;
+};
+
+#define CONFIG_FIELD(name, nvs, type, member, lo, hi, patch) \
+  {name, nvs, ConfigType::type, (uint16_t)offsetof(ConfigRecord, member), \
+   (uint16_t)sizeof(ConfigRecord::member), lo, hi, patch}
+
+static constexpr ConfigField CONFIG_FIELDS[] = {
+  CONFIG_FIELD("device_id",       "device_id",   STRING, deviceId,       0, 0, false),
+  CONFIG_FIELD("device_name",     "device_name", STRING, deviceName,     0, 0, true),
+  CONFIG_FIELD("temp_offset",     "temp_off",    FLOAT,  tempOffset,     -20, 20, true),
+  CONFIG_FIELD("humidity_offset", "hum_off",     FLOAT,  humidityOffset, -50, 50, true),
+  CONFIG_FIELD("max_temp",        "max_temp",    FLOAT,  maxTemperature, -40, 85, true),
+  CONFIG_FIELD("min_temp",        "min_temp",    FLOAT,  minTemperature, -40, 85, true),
+  CONFIG_FIELD("max_hum",         "max_hum",     FLOAT,  maxHumidity,    0, 100, true),
+  CONFIG_FIELD("min_hum",         "min_hum",     FLOAT,  minHumidity,    0, 100, true),
+  CONFIG_FIELD("max_iaq",         "max_iaq",     INT,    maxIAQ,         0, 500, true),
+  CONFIG_FIELD("mqtt_server",     "mqtt_srv",    STRING, mqttServer,     0, 0, true),
+  CONFIG_FIELD("mqtt_port",       "mqtt_port",   INT,    mqttPort,       1, 65535, true),
+  CONFIG_FIELD("mqtt_tls",        "mqtt_tls",    BOOL,   mqttTls,        -1, 1, true),
+  CONFIG_FIELD("tls_fp",          "tls_fp",      STRING, tlsFingerprint, 0, 0, true),
+  CONFIG_FIELD("ws_server",       "ws_srv",      STRING, wsServer,       0, 0, true),
+  CONFIG_FIELD("ws_port",         "ws_port",     INT,    wsPort,         1, 65535, true),
+  CONFIG_FIELD("uplink",          "uplink",      INT,    uplinkMode,     0, 2, true),
+  CONFIG_FIELD("ota_rate",        "ota_rate",    INT,    otaRateLimit,   0, 65535, true),
+  CONFIG_FIELD("anomaly_z",       "anomaly_z",   FLOAT,  anomalyZ,       2, 50, true),
+};
+
+static_assert(sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]) == CONFIG_RECORD_FIELDS,
+              "CONFIG_FIELDS must list every ConfigRecord field in ConfigKey order");
+
+struct ConfigBlobHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length;              // Record bytes that follow
+  uint32_t crc;                 // CRC-32 of the record bytes
+};
+
+struct ConfigStats {
+  uint32_t commits;             // NVS flushes
+  uint32_t keysWritten;         // Changed keys those flushes covered
+  uint32_t pending;             // Dirty keys not yet flushed
+  uint32_t rejected;            // apply() calls refused by validation
+};
+
+typedef void (*ConfigChangeCallback)(ConfigKey key);
 
 class ConfigManager {
 public:
-  void begin() { _prefs.begin("xbio", false); }
-  void end() { _prefs.end(); }
-  void saveState() { /* Save current state to NVS */ }
-  
+  ConfigManager() : _hash(0), _blobVersion(CONFIG_SCHEMA_VERSION), _extra(nullptr), _extraLength(0),
+                    _migrated(false), _dirty(0), _firstDirty(0), _lastChange(0), _lastCommit(0),
+                    _error(nullptr), _listenerCount(0) {
+    defaults(_r);
+    memset(&_stats, 0, sizeof(_stats));
+  }
+  ~ConfigManager() { free(_extra); }
+
+  void begin();
+  void end() { commit(); _prefs.end(); }
+
+  /**
+   * Flush dirty keys when writes have settled - call from loop()
+   */
+  void loop();
+
+  /**
+   * Flush dirty keys now
+   * @return Number of keys written
+   */
+  uint8_t commit();
+  void saveState() { commit(); }
+
+  /**
+   * Replace the whole record atomically - all fields validated first
+   * @return false (nothing changed, see lastError()) if any field is invalid
+   */
+  bool apply(const ConfigRecord& next);
+  const char* lastError() const { return _error; }
+
+  const ConfigRecord& record() const { return _r; }
+  uint32_t hash() const { return _hash; }
+
+  bool isDirty() const { return _dirty != 0; }
+  ConfigStats getStats() const;
+
+  /**
+   * Called after a change is applied (before it reaches NVS)
+   */
+  bool addListener(ConfigChangeCallback callback);
+
+  /**
+   * Generic field access for patch commands - range checks happen in apply()
+   * @return false if the value does not fit the field
+   */
+  static bool setString(ConfigRecord& record, ConfigKey key, const char* value);
+  static bool setNumber(ConfigRecord& record, ConfigKey key, float value);
+
+  static const char* keyName(ConfigKey key);
+  static void defaults(ConfigRecord& record);
+  static uint32_t crc32(const void* data, size_t length);
+
   // Device Identity
-  String getDeviceId() { return _prefs.getString("device_id", ""); }
-  void setDeviceId(String id) { _prefs.putString("device_id", id); }
-  String getDeviceName() { return _prefs.getString("device_name", ""); }
-  void setDeviceName(String name) { _prefs.putString("device_name", name); }
-  
+  const char* getDeviceId() const { return _r.deviceId; }
+  void setDeviceId(String id) { setOne(ConfigKey::DEVICE_ID, id.c_str()); }
+  const char* getDeviceName() const { return _r.deviceName; }
+  void setDeviceName(String name) { setOne(ConfigKey::DEVICE_NAME, name.c_str()); }
+
   // Sensor Offsets
-  float getTempOffset() { return _prefs.getFloat("temp_off", 0.0); }
-  void setTempOffset(float offset) { _prefs.putFloat("temp_off", offset); }
-  float getHumidityOffset() { return _prefs.getFloat("hum_off", 0.0); }
-  void setHumidityOffset(float offset) { _prefs.putFloat("hum_off", offset); }
-  
+  float getTempOffset() const { return _r.tempOffset; }
+  void setTempOffset(float offset) { setOne(ConfigKey::TEMP_OFFSET, offset); }
+  float getHumidityOffset() const { return _r.humidityOffset; }
+  void setHumidityOffset(float offset) { setOne(ConfigKey::HUMIDITY_OFFSET, offset); }
+
   // Thresholds
-  float getMaxTemperature() { return _prefs.getFloat("max_temp", 35.0); }
-  float getMinTemperature() { return _prefs.getFloat("min_temp", 10.0); }
-  float getMaxHumidity() { return _prefs.getFloat("max_hum", 80.0); }
-  float getMinHumidity() { return _prefs.getFloat("min_hum", 20.0); }
-  int getMaxIAQ() { return _prefs.getInt("max_iaq", 150); }
-  
+  float getMaxTemperature() const { return _r.maxTemperature; }
+  void setMaxTemperature(float value) { setOne(ConfigKey::MAX_TEMPERATURE, value); }
+  float getMinTemperature() const { return _r.minTemperature; }
+  void setMinTemperature(float value) { setOne(ConfigKey::MIN_TEMPERATURE, value); }
+  float getMaxHumidity() const { return _r.maxHumidity; }
+  void setMaxHumidity(float value) { setOne(ConfigKey::MAX_HUMIDITY, value); }
+  float getMinHumidity() const { return _r.minHumidity; }
+  void setMinHumidity(float value) { setOne(ConfigKey::MIN_HUMIDITY, value); }
+  int getMaxIAQ() const { return _r.maxIAQ; }
+  void setMaxIAQ(int value) { setOne(ConfigKey::MAX_IAQ, (float)value); }
+
   // MQTT Configuration
-  String getMqttServer() { return _prefs.getString("mqtt_srv", ""); }
-  int getMqttPort() { return _prefs.getInt("mqtt_port", 1883); }
+  const char* getMqttServer() const { return _r.mqttServer; }
+  int getMqttPort() const { return _r.mqttPort; }
   void setMqttServer(String server, int port) {
-    _prefs.putString("mqtt_srv", server);
-    _prefs.putInt("mqtt_port", port);
+    ConfigRecord next = _r;
+    if (setString(next, ConfigKey::MQTT_SERVER, server.c_str())) {
+      next.mqttPort = port;
+      apply(next);
+    }
   }
-  
+
+  bool getMqttTls() const { return _r.mqttTls < 0 ? _r.mqttPort == 8883 : _r.mqttTls != 0; }
+
+  // TLS Trust (CA chain PEM and/or SHA-256 server fingerprint)
+  const String& getTlsCaCert() const { return _tlsCaCert; }
+  const char* getTlsFingerprint() const { return _r.tlsFingerprint; }
+  void setTlsTrust(String caCert, String fingerprint) {
+    setOne(ConfigKey::TLS_FINGERPRINT, fingerprint.c_str());
+    setPem(ConfigKey::TLS_CA, _tlsCaCert, caCert);
+  }
+
   // WebSocket Configuration
-  String getWsServer() { return _prefs.getString("ws_srv", ""); }
-  int getWsPort() { return _prefs.getInt("ws_port", 443); }
-  
+  const char* getWsServer() const { return _r.wsServer; }
+  int getWsPort() const { return _r.wsPort; }
+
+  // Uplink policy: 0 = dual, 1 = auto (WS only as MQTT failover), 2 = MQTT only
+  uint8_t getUplinkMode() const { return (uint8_t)_r.uplinkMode; }
+  void setUplinkMode(uint8_t mode) { setOne(ConfigKey::UPLINK_MODE, (float)mode); }
+
+  // OTA: image signing key (PEM, optional) and download rate limit in KB/s (0 = unlimited)
+  const String& getOtaPublicKey() const { return _otaPublicKey; }
+  void setOtaPublicKey(String pem) { setPem(ConfigKey::OTA_PUBKEY, _otaPublicKey, pem); }
+  uint16_t getOtaRateLimit() const { return (uint16_t)_r.otaRateLimit; }
+  void setOtaRateLimit(uint16_t kbps) { setOne(ConfigKey::OTA_RATE, (float)kbps); }
+
+  // Anomaly score (z) that raises an ANOMALY_* alert
+  float getAnomalyZ() const { return _r.anomalyZ; }
+  void setAnomalyZ(float z) { setOne(ConfigKey::ANOMALY_Z, z); }
+
 private:
   Preferences _prefs;
+  ConfigRecord _r;
+  String _tlsCaCert;
+  String _otaPublicKey;
+  uint32_t _hash;
+
+  uint16_t _blobVersion;        // Schema written back (a newer one is kept as found)
+  uint8_t* _extra;              // Newer-schema fields past ConfigRecord, written back untouched
+  uint16_t _extraLength;
+  bool _migrated;               // Per-key entries to erase after the first blob write
+
+  uint32_t _dirty;              // Bit per ConfigKey
+  uint32_t _firstDirty;         // millis() of the oldest unflushed change
+  uint32_t _lastChange;
+  uint32_t _lastCommit;
+  const char* _error;
+  ConfigStats _stats;
+
+  ConfigChangeCallback _listeners[CONFIG_MAX_LISTENERS];
+  uint8_t _listenerCount;
+
+  bool loadBlob();
+  bool parseBlob(const uint8_t* buffer, size_t length);
+  void loadLegacy();
+  void eraseLegacy();
+  const char* validate(const ConfigRecord& record) const;
+  void markDirty(ConfigKey key);
+  void notify(ConfigKey key);
+
+  void setOne(ConfigKey key, const char* value) {
+    ConfigRecord next = _r;
+    if (setString(next, key, value)) apply(next);
+  }
+  void setOne(ConfigKey key, float value) {
+    ConfigRecord next = _r;
+    if (setNumber(next, key, value)) apply(next);
+  }
+  void setPem(ConfigKey key, String& field, const String& value) {
+    if (field == value) return;
+    field = value;
+    markDirty(key);
+    notify(key);
+  }
 };
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ConfigManager::begin() {
+  _prefs.begin("xbio", false);
+
+  if (!loadBlob()) {
+    // First boot on the blob schema: carry the per-key settings over in one write
+    loadLegacy();
+    const char* error = validate(_r);
+    if (error) {
+      Serial.printf("CONFIG: Stored value invalid (%s) - using defaults\n", error);
+      defaults(_r);
+    }
+    _dirty |= (1UL << CONFIG_RECORD_FIELDS) - 1;
+    _migrated = true;
+    Serial.println("CONFIG: Migrating settings to the config blob");
+  }
+  _hash = crc32(&_r, sizeof(_r));
+
+  _tlsCaCert = _prefs.getString("tls_ca", "");
+  _otaPublicKey = _prefs.getString("ota_pubkey", "");
+
+  _lastCommit = millis();
+  if (_dirty) commit();
+}
+
+bool ConfigManager::loadBlob() {
+  size_t length = _prefs.getBytesLength(CONFIG_BLOB_KEY);
+  if (length < sizeof(ConfigBlobHeader)) return false;
+  if (length > CONFIG_BLOB_MAX_SIZE) {
+    Serial.printf("CONFIG: Blob of %u bytes exceeds CONFIG_BLOB_MAX_SIZE - ignoring\n", (unsigned)length);
+    return false;
+  }
+
+  // Sized to what is stored: a newer schema's blob is longer than ConfigRecord
+  uint8_t* buffer = (uint8_t*)malloc(length);
+  if (!buffer) return false;
+  bool ok = _prefs.getBytes(CONFIG_BLOB_KEY, buffer, length) == length && parseBlob(buffer, length);
+  free(buffer);
+  return ok;
+}
+
+bool ConfigManager::parseBlob(const uint8_t* buffer, size_t length) {
+  ConfigBlobHeader header;
+  memcpy(&header, buffer, sizeof(header));
+  if (header.magic != CONFIG_BLOB_MAGIC || header.length != length - sizeof(header)) {
+    Serial.println("CONFIG: Blob header invalid - ignoring");
+    return false;
+  }
+  if (crc32(buffer + sizeof(header), header.length) != header.crc) {
+    Serial.println("CONFIG: Blob CRC mismatch - ignoring");
+    return false;
+  }
+
+  // Older schema: a shorter prefix over the defaults; newer: the fields we know
+  ConfigRecord record;
+  defaults(record);
+  memcpy(&record, buffer + sizeof(header), min((size_t)header.length, sizeof(record)));
+  const char* error = validate(record);
+  if (error) {
+    Serial.printf("CONFIG: Blob rejected (%s)\n", error);
+    return false;
+  }
+
+  _r = record;
+  if (header.version > CONFIG_SCHEMA_VERSION && header.length > sizeof(record)) {
+    // Newer firmware wrote this: keep its fields and version for the roll-forward
+    _extraLength = (uint16_t)(header.length - sizeof(record));
+    _extra = (uint8_t*)malloc(_extraLength);
+    if (_extra) {
+      memcpy(_extra, buffer + sizeof(header) + sizeof(record), _extraLength);
+      _blobVersion = header.version;
+    } else {
+      _extraLength = 0;
+    }
+  } else if (header.version != CONFIG_SCHEMA_VERSION || header.length != sizeof(record)) {
+    _dirty |= (1UL << CONFIG_RECORD_FIELDS) - 1; // Rewrite in the current schema
+  }
+  Serial.printf("CONFIG: Loaded schema v%u (%u bytes)\n", header.version, header.length);
+  return true;
+}
+
+void ConfigManager::loadLegacy() {
+  defaults(_r);
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    const ConfigField& field = CONFIG_FIELDS[k];
+    if (!_prefs.isKey(field.nvsKey)) continue;
+    uint8_t* p = (uint8_t*)&_r + field.offset;
+    switch (field.type) {
+      case ConfigType::STRING:
+        setString(_r, (ConfigKey)k, _prefs.getString(field.nvsKey, "").c_str());
+        break;
+      case ConfigType::FLOAT: {
+        float value = _prefs.getFloat(field.nvsKey, 0);
+        memcpy(p, &value, sizeof(value));
+        break;
+      }
+      case ConfigType::INT: {
+        // uplink / ota_rate were stored narrower than int32
+        int32_t value = (ConfigKey)k == ConfigKey::UPLINK_MODE ? _prefs.getUChar(field.nvsKey, 1)
+                      : (ConfigKey)k == ConfigKey::OTA_RATE ? _prefs.getUShort(field.nvsKey, 64)
+                      : _prefs.getInt(field.nvsKey, 0);
+        memcpy(p, &value, sizeof(value));
+        break;
+      }
+      case ConfigType::BOOL: {
+        int32_t value = _prefs.getBool(field.nvsKey, false) ? 1 : 0;
+        memcpy(p, &value, sizeof(value));
+        break;
+      }
+    }
+  }
+}
+
+void ConfigManager::eraseLegacy() {
+  uint8_t erased = 0;
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    const char* key = CONFIG_FIELDS[k].nvsKey;
+    if (_prefs.isKey(key) && _prefs.remove(key)) erased++;
+  }
+  _migrated = false;
+  if (erased) Serial.printf("CONFIG: Erased %u migrated per-key setting(s)\n", erased);
+}
+
+void ConfigManager::defaults(ConfigRecord& record) {
+  memset(&record, 0, sizeof(record));
+  record.tempOffset = 0.0;
+  record.humidityOffset = 0.0;
+  record.maxTemperature = 35.0;
+  record.minTemperature = 10.0;
+  record.maxHumidity = 80.0;
+  record.minHumidity = 20.0;
+  record.maxIAQ = 150;
+  record.mqttPort = 1883;
+  record.mqttTls = -1;
+  record.wsPort = 443;
+  record.uplinkMode = 1;
+  record.otaRateLimit = 64;
+  record.anomalyZ = 6.0f;
+}
+
+const char* ConfigManager::validate(const ConfigRecord& record) const {
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    const ConfigField& field = CONFIG_FIELDS[k];
+    const uint8_t* p = (const uint8_t*)&record + field.offset;
+    float value;
+    if (field.type == ConfigType::STRING) {
+      if (!memchr(p, '\0', field.size)) return field.name;
+      continue;
+    } else if (field.type == ConfigType::FLOAT) {
+      memcpy(&value, p, sizeof(value));
+    } else {
+      int32_t i;
+      memcpy(&i, p, sizeof(i));
+      value = (float)i;
+    }
+    if (!(value >= field.min && value <= field.max)) return field.name; // Also rejects NaN
+  }
+
+  if (record.minTemperature >= record.maxTemperature) return "min_temp >= max_temp";
+  if (record.minHumidity >= record.maxHumidity) return "min_hum >= max_hum";
+  return nullptr;
+}
+
+bool ConfigManager::apply(const ConfigRecord& next) {
+  _error = validate(next);
+  if (_error) {
+    _stats.rejected++;
+    Serial.printf("CONFIG: Rejected - invalid %s\n", _error);
+    return false;
+  }
+
+  uint32_t changed = 0;
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    const ConfigField& field = CONFIG_FIELDS[k];
+    if (memcmp((const uint8_t*)&_r + field.offset, (const uint8_t*)&next + field.offset, field.size) != 0) {
+      changed |= 1UL << k;
+    }
+  }
+  if (!changed) return true;
+
+  // Swap first so every listener sees the complete new record
+  _r = next;
+  _hash = crc32(&_r, sizeof(_r));
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    if (changed & (1UL << k)) markDirty((ConfigKey)k);
+  }
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    if (changed & (1UL << k)) notify((ConfigKey)k);
+  }
+  return true;
+}
+
+void ConfigManager::loop() {
+  if (!_dirty) return;
+
+  uint32_t now = millis();
+  if (now - _lastCommit < CONFIG_COMMIT_INTERVAL) return;
+
+  // Wait for a quiet period, but never hold a change longer than one interval
+  if (now - _lastChange < CONFIG_COMMIT_DELAY && now - _firstDirty < CONFIG_COMMIT_INTERVAL) return;
+
+  commit();
+}
+
+uint8_t ConfigManager::commit() {
+  if (!_dirty) return 0;
+
+  uint8_t written = __builtin_popcount(_dirty);
+
+  if (_dirty & ((1UL << CONFIG_RECORD_FIELDS) - 1)) {
+    uint8_t local[sizeof(ConfigBlobHeader) + sizeof(ConfigRecord)];
+    size_t size = sizeof(local) + _extraLength;
+    uint8_t* blob = _extraLength ? (uint8_t*)malloc(size) : local;
+    if (!blob) {
+      _lastCommit = millis();
+      return 0;
+    }
+
+    ConfigBlobHeader header = {CONFIG_BLOB_MAGIC, _blobVersion, (uint16_t)(sizeof(ConfigRecord) + _extraLength), _hash};
+    memcpy(blob + sizeof(header), &_r, sizeof(_r));
+    if (_extraLength) {
+      memcpy(blob + sizeof(local), _extra, _extraLength);
+      header.crc = crc32(blob + sizeof(header), header.length);
+    }
+    memcpy(blob, &header, sizeof(header));
+
+    bool stored = _prefs.putBytes(CONFIG_BLOB_KEY, blob, size) == size;
+    if (blob != local) free(blob);
+    if (!stored) {
+      Serial.println("CONFIG: ❌ Blob write failed - will retry");
+      _lastCommit = millis();
+      return 0;
+    }
+    if (_migrated) eraseLegacy(); // The blob is authoritative from here on
+  }
+  if (_dirty & (1UL << (uint8_t)ConfigKey::TLS_CA)) _prefs.putString("tls_ca", _tlsCaCert);
+  if (_dirty & (1UL << (uint8_t)ConfigKey::OTA_PUBKEY)) _prefs.putString("ota_pubkey", _otaPublicKey);
+
+  _dirty = 0;
+  _lastCommit = millis();
+  _stats.commits++;
+  _stats.keysWritten += written;
+  Serial.printf("CONFIG: Committed %u key(s) to NVS (hash %08x)\n", written, _hash);
+  return written;
+}
+
+void ConfigManager::markDirty(ConfigKey key) {
+  uint32_t now = millis();
+  if (!_dirty) _firstDirty = now;
+  _dirty |= 1UL << (uint8_t)key;
+  _lastChange = now;
+}
+
+void ConfigManager::notify(ConfigKey key) {
+  for (uint8_t i = 0; i < _listenerCount; i++) _listeners[i](key);
+}
+
+ConfigStats ConfigManager::getStats() const {
+  ConfigStats stats = _stats;
+  stats.pending = __builtin_popcount(_dirty);
+  return stats;
+}
+
+bool ConfigManager::addListener(ConfigChangeCallback callback) {
+  if (!callback || _listenerCount >= CONFIG_MAX_LISTENERS) return false;
+  _listeners[_listenerCount++] = callback;
+  return true;
+}
+
+bool ConfigManager::setString(ConfigRecord& record, ConfigKey key, const char* value) {
+  if ((uint8_t)key >= CONFIG_RECORD_FIELDS) return false;
+  const ConfigField& field = CONFIG_FIELDS[(uint8_t)key];
+  if (field.type != ConfigType::STRING) return false;
+
+  size_t length = value ? strlen(value) : 0;
+  if (length >= field.size) return false;
+
+  // Zero the tail too: the record is hashed and stored byte for byte
+  char* p = (char*)&record + field.offset;
+  memset(p, 0, field.size);
+  if (length) memcpy(p, value, length);
+  return true;
+}
+
+bool ConfigManager::setNumber(ConfigRecord& record, ConfigKey key, float value) {
+  if ((uint8_t)key >= CONFIG_RECORD_FIELDS) return false;
+  const ConfigField& field = CONFIG_FIELDS[(uint8_t)key];
+  uint8_t* p = (uint8_t*)&record + field.offset;
+
+  if (field.type == ConfigType::FLOAT) {
+    memcpy(p, &value, sizeof(value));
+    return true;
+  }
+  if (field.type == ConfigType::INT || field.type == ConfigType::BOOL) {
+    if (!(value >= -2147483648.0f && value < 2147483648.0f)) return false;
+    int32_t i = (int32_t)value;
+    memcpy(p, &i, sizeof(i));
+    return true;
+  }
+  return false;
+}
+
+const char* ConfigManager::keyName(ConfigKey key) {
+  if ((uint8_t)key < CONFIG_RECORD_FIELDS) return CONFIG_FIELDS[(uint8_t)key].name;
+  if (key == ConfigKey::TLS_CA) return "tls_ca";
+  if (key == ConfigKey::OTA_PUBKEY) return "ota_pubkey";
+  return "?";
+}
+
+uint32_t ConfigManager::crc32(const void* data, size_t length) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *p++;
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
 #endif
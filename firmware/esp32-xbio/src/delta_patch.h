@@ -0,0 +1,370 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧩 Delta Patch - Streaming bsdiff-style Patch Applier
+ * Rebuilds a new firmware image from the running one + a small patch
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Patch format (XBD1, produced by tools/xbio_delta.cpp):
+ *
+ *   Header  "XBD1" | u32 oldSize | u32 newSize | sha256(old) | sha256(new) | u32 flags
+ *   Records until newSize bytes are produced:
+ *     varint diffLen | varint extraLen | zigzag varint seek
+ *     diff   tokens: varint t, t&1 ? (t>>1) literal bytes : (t>>1) zero bytes
+ *            output = old[oldPos++] + token byte
+ *     extra  extraLen raw bytes copied to the output
+ *     oldPos += seek
+ *
+ * The diff stream is mostly zeros (code that only moved), so zero runs are
+ * stored as a single token instead of relying on a second compressor. Patch
+ * bytes can be fed in any chunking; old-image reads and output writes go
+ * through small fixed buffers, never the whole image.
+ *
+ * Pure C++ (no Arduino dependencies) so the host tool uses the same applier.
+ */
+
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef DELTA_BUFFER_SIZE
+  #define DELTA_BUFFER_SIZE 1024      // Old-image read window and output buffer, each
+#endif
+
+#define DELTA_MAGIC "XBD1"
+#define DELTA_HEADER_SIZE 80
+
+struct DeltaHeader {
+  uint32_t oldSize;
+  uint32_t newSize;
+  uint8_t oldHash[32];
+  uint8_t newHash[32];
+  uint32_t flags;
+};
+
+enum class DeltaError : uint8_t {
+  NONE,
+  BAD_HEADER,
+  REJECTED,       // Writer refused the header (e.g. base image mismatch)
+  CORRUPT,
+  READ_FAILED,
+  WRITE_FAILED
+};
+
+// Random-access reader for the image the patch was built against
+class DeltaSource {
+public:
+  virtual ~DeltaSource() {}
+  virtual bool read(uint32_t offset, uint8_t* out, size_t length) = 0;
+};
+
+// Receives the header once, then the rebuilt image in order
+class DeltaSink {
+public:
+  virtual ~DeltaSink() {}
+  virtual bool begin(const DeltaHeader& header) = 0;
+  virtual bool write(const uint8_t* data, size_t length) = 0;
+};
+
+class DeltaPatcher {
+public:
+  DeltaPatcher() { begin(nullptr, nullptr); }
+
+  void begin(DeltaSource* source, DeltaSink* sink);
+
+  /**
+   * Consume the next patch bytes
+   * @return false once the patch is found invalid or I/O fails (see error())
+   */
+  bool feed(const uint8_t* data, size_t length);
+
+  bool finished() const { return _state == DONE; }
+  DeltaError error() const { return _error; }
+  const DeltaHeader& header() const { return _header; }
+  uint32_t produced() const { return _newPos; }
+
+  static const char* errorName(DeltaError error);
+
+private:
+  enum State : uint8_t {
+    HEADER,
+    CTRL_DIFF,
+    CTRL_EXTRA,
+    CTRL_SEEK,
+    DIFF_TOKEN,
+    DIFF_LITERAL,
+    EXTRA,
+    DONE,
+    FAILED
+  };
+
+  DeltaSource* _source;
+  DeltaSink* _sink;
+  State _state;
+  DeltaError _error;
+  DeltaHeader _header;
+
+  uint8_t _headerBuf[DELTA_HEADER_SIZE];
+  size_t _headerLength;
+
+  uint32_t _varint;
+  uint8_t _varintShift;
+
+  uint32_t _diffRemaining;
+  uint32_t _extraRemaining;
+  uint32_t _literalRemaining;
+  int32_t _seek;
+
+  uint32_t _oldPos;
+  uint32_t _newPos;               // Bytes produced (buffered or written)
+
+  uint8_t _old[DELTA_BUFFER_SIZE];
+  uint32_t _oldStart;
+  size_t _oldLength;
+
+  uint8_t _out[DELTA_BUFFER_SIZE];
+  size_t _outLength;
+
+  bool fail(DeltaError error);
+  bool parseHeader();
+  bool varintByte(uint8_t byte, bool* complete);
+  bool oldByte(uint32_t pos, uint8_t* value);
+  bool emit(uint8_t byte);
+  bool flush();
+  bool copyOld(uint32_t count);
+  bool afterDiffToken();
+  bool endRecord();
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+inline void DeltaPatcher::begin(DeltaSource* source, DeltaSink* sink) {
+  _source = source;
+  _sink = sink;
+  _state = HEADER;
+  _error = DeltaError::NONE;
+  memset(&_header, 0, sizeof(_header));
+  _headerLength = 0;
+  _varint = 0;
+  _varintShift = 0;
+  _diffRemaining = _extraRemaining = _literalRemaining = 0;
+  _seek = 0;
+  _oldPos = _newPos = 0;
+  _oldStart = 0;
+  _oldLength = 0;
+  _outLength = 0;
+}
+
+inline bool DeltaPatcher::feed(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    switch (_state) {
+      case HEADER: {
+        size_t n = DELTA_HEADER_SIZE - _headerLength;
+        if (n > length - i) n = length - i;
+        memcpy(_headerBuf + _headerLength, data + i, n);
+        _headerLength += n;
+        i += n;
+        if (_headerLength == DELTA_HEADER_SIZE && !parseHeader()) return false;
+        break;
+      }
+
+      case CTRL_DIFF:
+      case CTRL_EXTRA:
+      case CTRL_SEEK: {
+        bool complete = false;
+        if (!varintByte(data[i++], &complete)) return false;
+        if (!complete) break;
+
+        if (_state == CTRL_DIFF) {
+          _diffRemaining = _varint;
+          _state = CTRL_EXTRA;
+        } else if (_state == CTRL_EXTRA) {
+          _extraRemaining = _varint;
+          if ((uint64_t)_newPos + _diffRemaining + _extraRemaining > _header.newSize) return fail(DeltaError::CORRUPT);
+          _state = CTRL_SEEK;
+        } else {
+          _seek = (int32_t)((_varint >> 1) ^ (~(_varint & 1) + 1)); // Zigzag
+          if (_diffRemaining) {
+            _state = DIFF_TOKEN;
+          } else if (_extraRemaining) {
+            _state = EXTRA;
+          } else if (!endRecord()) {
+            return false;
+          }
+        }
+        _varint = 0;
+        _varintShift = 0;
+        break;
+      }
+
+      case DIFF_TOKEN: {
+        bool complete = false;
+        if (!varintByte(data[i++], &complete)) return false;
+        if (!complete) break;
+
+        uint32_t count = _varint >> 1;
+        bool literal = _varint & 1;
+        _varint = 0;
+        _varintShift = 0;
+        if (count == 0 || count > _diffRemaining) return fail(DeltaError::CORRUPT);
+
+        if (literal) {
+          _literalRemaining = count;
+          _state = DIFF_LITERAL;
+        } else {
+          if (!copyOld(count)) return false;
+          _diffRemaining -= count;
+          if (!afterDiffToken()) return false;
+        }
+        break;
+      }
+
+      case DIFF_LITERAL: {
+        size_t n = _literalRemaining;
+        if (n > length - i) n = length - i;
+        for (size_t k = 0; k < n; k++) {
+          uint8_t base;
+          if (!oldByte(_oldPos++, &base)) return false;
+          if (!emit((uint8_t)(base + data[i + k]))) return false;
+        }
+        i += n;
+        _literalRemaining -= n;
+        _diffRemaining -= n;
+        if (_literalRemaining == 0 && !afterDiffToken()) return false;
+        break;
+      }
+
+      case EXTRA: {
+        size_t n = _extraRemaining;
+        if (n > length - i) n = length - i;
+        for (size_t k = 0; k < n; k++) {
+          if (!emit(data[i + k])) return false;
+        }
+        i += n;
+        _extraRemaining -= n;
+        if (_extraRemaining == 0 && !endRecord()) return false;
+        break;
+      }
+
+      case DONE:
+        return true; // Trailing bytes ignored
+
+      case FAILED:
+        return false;
+    }
+  }
+  return true;
+}
+
+inline bool DeltaPatcher::fail(DeltaError error) {
+  _error = error;
+  _state = FAILED;
+  return false;
+}
+
+inline bool DeltaPatcher::parseHeader() {
+  if (memcmp(_headerBuf, DELTA_MAGIC, 4) != 0) return fail(DeltaError::BAD_HEADER);
+
+  const uint8_t* p = _headerBuf + 4;
+  _header.oldSize = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  _header.newSize = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+  memcpy(_header.oldHash, p + 8, 32);
+  memcpy(_header.newHash, p + 40, 32);
+  p += 72;
+  _header.flags = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  if (_header.newSize == 0) return fail(DeltaError::BAD_HEADER);
+
+  if (_sink && !_sink->begin(_header)) return fail(DeltaError::REJECTED);
+  _state = CTRL_DIFF;
+  return true;
+}
+
+inline bool DeltaPatcher::varintByte(uint8_t byte, bool* complete) {
+  if (_varintShift > 28) return fail(DeltaError::CORRUPT);
+  _varint |= (uint32_t)(byte & 0x7F) << _varintShift;
+  _varintShift += 7;
+  *complete = !(byte & 0x80);
+  return true;
+}
+
+inline bool DeltaPatcher::oldByte(uint32_t pos, uint8_t* value) {
+  if (pos >= _header.oldSize) return fail(DeltaError::CORRUPT);
+
+  if (pos < _oldStart || pos >= _oldStart + _oldLength) {
+    size_t n = _header.oldSize - pos;
+    if (n > DELTA_BUFFER_SIZE) n = DELTA_BUFFER_SIZE;
+    if (!_source || !_source->read(pos, _old, n)) return fail(DeltaError::READ_FAILED);
+    _oldStart = pos;
+    _oldLength = n;
+  }
+  *value = _old[pos - _oldStart];
+  return true;
+}
+
+inline bool DeltaPatcher::emit(uint8_t byte) {
+  _out[_outLength++] = byte;
+  _newPos++;
+  if (_outLength == DELTA_BUFFER_SIZE) return flush();
+  return true;
+}
+
+inline bool DeltaPatcher::flush() {
+  if (_outLength == 0) return true;
+  if (_sink && !_sink->write(_out, _outLength)) return fail(DeltaError::WRITE_FAILED);
+  _outLength = 0;
+  return true;
+}
+
+inline bool DeltaPatcher::copyOld(uint32_t count) {
+  for (uint32_t k = 0; k < count; k++) {
+    uint8_t base;
+    if (!oldByte(_oldPos++, &base)) return false;
+    if (!emit(base)) return false;
+  }
+  return true;
+}
+
+inline bool DeltaPatcher::afterDiffToken() {
+  if (_diffRemaining) {
+    _state = DIFF_TOKEN;
+    return true;
+  }
+  if (_extraRemaining) {
+    _state = EXTRA;
+    return true;
+  }
+  return endRecord();
+}
+
+inline bool DeltaPatcher::endRecord() {
+  int64_t pos = (int64_t)_oldPos + _seek;
+  if (pos < 0 || pos > (int64_t)_header.oldSize) return fail(DeltaError::CORRUPT);
+  _oldPos = (uint32_t)pos;
+
+  if (_newPos == _header.newSize) {
+    if (!flush()) return false;
+    _state = DONE;
+  } else {
+    _state = CTRL_DIFF;
+  }
+  return true;
+}
+
+inline const char* DeltaPatcher::errorName(DeltaError error) {
+  switch (error) {
+    case DeltaError::NONE: return "none";
+    case DeltaError::BAD_HEADER: return "bad header";
+    case DeltaError::REJECTED: return "base image mismatch";
+    case DeltaError::CORRUPT: return "corrupt patch";
+    case DeltaError::READ_FAILED: return "base read failed";
+    case DeltaError::WRITE_FAILED: return "write failed";
+  }
+  return "?";
+}
+
+#endif
@@ -45,6 +45,8 @@ public:
     updateLEDs();
   }
   
+  LEDStatus getStatus() const { return _status; }
+  
 private:
   LEDStatus _status;
   uint32_t _lastBlink;
@@ -0,0 +1,273 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🗜️ LZSS Stream - Streaming Decoder for Compressed Firmware Images
+ * heatshrink-style LZSS with a small fixed window, decoded straight to flash
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Image format (XBZ1, produced by tools/xbio_compress.cpp):
+ *
+ *   Header  "XBZ1" | u8 windowBits | u8 flags | u16 reserved | u32 imageSize | sha256(image)
+ *   Body    groups of one flag byte + 8 items (LSB first):
+ *             1 = literal byte
+ *             0 = match, 2 bytes big-endian:
+ *                 (distance - 1) << lengthBits | (length - LZSS_MIN_MATCH)
+ *                 lengthBits = 16 - windowBits
+ *
+ * The window is the only state: a 2^windowBits ring that doubles as the output
+ * buffer, flushed to the sink each time it wraps. 4 KB for the default
+ * 12-bit window, whatever the image size.
+ *
+ * Pure C++ (no Arduino dependencies) so the host tool uses the same decoder.
+ */
+
+#ifndef LZSS_STREAM_H
+#define LZSS_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef LZSS_MAX_WINDOW_BITS
+  #define LZSS_MAX_WINDOW_BITS 14     // Largest window a device accepts (16 KB)
+#endif
+
+#define LZSS_MAGIC "XBZ1"
+#define LZSS_HEADER_SIZE 44
+#define LZSS_MIN_WINDOW_BITS 8
+#define LZSS_MIN_MATCH 3
+
+struct LzssHeader {
+  uint8_t windowBits;
+  uint8_t flags;
+  uint32_t imageSize;
+  uint8_t imageHash[32];
+};
+
+enum class LzssError : uint8_t {
+  NONE,
+  BAD_HEADER,
+  REJECTED,       // Sink refused the header (e.g. image too large)
+  NO_MEMORY,
+  CORRUPT,
+  WRITE_FAILED
+};
+
+// Receives the header once, then the decoded image in order
+class LzssSink {
+public:
+  virtual ~LzssSink() {}
+  virtual bool begin(const LzssHeader& header) = 0;
+  virtual bool write(const uint8_t* data, size_t length) = 0;
+};
+
+class LzssDecoder {
+public:
+  LzssDecoder() : _window(nullptr) { begin(nullptr); }
+  ~LzssDecoder() { free(_window); }
+
+  void begin(LzssSink* sink);
+
+  /**
+   * Consume the next compressed bytes
+   * @return false once the stream is found invalid or the sink fails (see error())
+   */
+  bool feed(const uint8_t* data, size_t length);
+
+  bool finished() const { return _state == DONE; }
+  LzssError error() const { return _error; }
+  const LzssHeader& header() const { return _header; }
+  uint32_t produced() const { return _produced; }
+
+  static const char* errorName(LzssError error);
+
+private:
+  enum State : uint8_t {
+    HEADER,
+    FLAGS,
+    ITEM,
+    MATCH_LOW,
+    DONE,
+    FAILED
+  };
+
+  LzssSink* _sink;
+  State _state;
+  LzssError _error;
+  LzssHeader _header;
+
+  uint8_t _headerBuf[LZSS_HEADER_SIZE];
+  size_t _headerLength;
+
+  uint8_t _flags;
+  uint8_t _flagCount;           // Items left in the current group
+  uint8_t _matchHigh;
+
+  uint8_t* _window;
+  uint32_t _windowMask;
+  uint32_t _pos;                // Next write position in the ring
+  uint32_t _produced;
+
+  bool fail(LzssError error);
+  bool parseHeader();
+  bool emit(uint8_t byte);
+  bool match(uint16_t token);
+  bool checkEnd();
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+inline void LzssDecoder::begin(LzssSink* sink) {
+  _sink = sink;
+  _state = HEADER;
+  _error = LzssError::NONE;
+  memset(&_header, 0, sizeof(_header));
+  _headerLength = 0;
+  _flags = 0;
+  _flagCount = 0;
+  _matchHigh = 0;
+  free(_window);
+  _window = nullptr;
+  _windowMask = 0;
+  _pos = 0;
+  _produced = 0;
+}
+
+inline bool LzssDecoder::feed(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    switch (_state) {
+      case HEADER: {
+        size_t n = LZSS_HEADER_SIZE - _headerLength;
+        if (n > length - i) n = length - i;
+        memcpy(_headerBuf + _headerLength, data + i, n);
+        _headerLength += n;
+        i += n;
+        if (_headerLength == LZSS_HEADER_SIZE && !parseHeader()) return false;
+        break;
+      }
+
+      case FLAGS:
+        _flags = data[i++];
+        _flagCount = 8;
+        _state = ITEM;
+        break;
+
+      case ITEM: {
+        // Literal runs are the hot path: stay in this loop while the flags allow
+        while (i < length && _flagCount && (_flags & 1)) {
+          if (!emit(data[i++])) return false;
+          _flags >>= 1;
+          _flagCount--;
+          if (!checkEnd()) return false;
+          if (_state == DONE) return true;
+        }
+        if (i == length) break;
+        if (_flagCount == 0) {
+          _state = FLAGS;
+          break;
+        }
+        _matchHigh = data[i++];
+        _state = MATCH_LOW;
+        break;
+      }
+
+      case MATCH_LOW: {
+        uint16_t token = ((uint16_t)_matchHigh << 8) | data[i++];
+        if (!match(token)) return false;
+        _flags >>= 1;
+        _flagCount--;
+        if (!checkEnd()) return false;
+        if (_state == DONE) return true;
+        _state = _flagCount ? ITEM : FLAGS;
+        break;
+      }
+
+      case DONE:
+        return true; // Trailing bytes ignored
+
+      case FAILED:
+        return false;
+    }
+  }
+  return true;
+}
+
+inline bool LzssDecoder::fail(LzssError error) {
+  _error = error;
+  _state = FAILED;
+  return false;
+}
+
+inline bool LzssDecoder::parseHeader() {
+  if (memcmp(_headerBuf, LZSS_MAGIC, 4) != 0) return fail(LzssError::BAD_HEADER);
+
+  const uint8_t* p = _headerBuf + 4;
+  _header.windowBits = p[0];
+  _header.flags = p[1];
+  _header.imageSize = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+  memcpy(_header.imageHash, p + 8, 32);
+  if (_header.windowBits < LZSS_MIN_WINDOW_BITS || _header.windowBits > LZSS_MAX_WINDOW_BITS ||
+      _header.imageSize == 0) {
+    return fail(LzssError::BAD_HEADER);
+  }
+
+  _window = (uint8_t*)malloc((size_t)1 << _header.windowBits);
+  if (!_window) return fail(LzssError::NO_MEMORY);
+  _windowMask = ((uint32_t)1 << _header.windowBits) - 1;
+
+  if (_sink && !_sink->begin(_header)) return fail(LzssError::REJECTED);
+  _state = FLAGS;
+  return true;
+}
+
+inline bool LzssDecoder::emit(uint8_t byte) {
+  if (_produced == _header.imageSize) return fail(LzssError::CORRUPT);
+  _window[_pos++] = byte;
+  _produced++;
+  if (_pos > _windowMask) {
+    if (_sink && !_sink->write(_window, _pos)) return fail(LzssError::WRITE_FAILED);
+    _pos = 0;
+  }
+  return true;
+}
+
+inline bool LzssDecoder::match(uint16_t token) {
+  uint8_t lengthBits = 16 - _header.windowBits;
+  uint32_t distance = (token >> lengthBits) + 1;
+  uint32_t count = (token & ((1u << lengthBits) - 1)) + LZSS_MIN_MATCH;
+  if (distance > _produced || count > _header.imageSize - _produced) return fail(LzssError::CORRUPT);
+
+  // Byte by byte: overlapping copies (distance < count) repeat the pattern
+  uint32_t from = (_pos - distance) & _windowMask;
+  for (uint32_t k = 0; k < count; k++) {
+    uint8_t byte = _window[from];
+    from = (from + 1) & _windowMask;
+    if (!emit(byte)) return false;
+  }
+  return true;
+}
+
+inline bool LzssDecoder::checkEnd() {
+  if (_produced < _header.imageSize) return true;
+  if (_pos && _sink && !_sink->write(_window, _pos)) return fail(LzssError::WRITE_FAILED);
+  _pos = 0;
+  _state = DONE;
+  return true;
+}
+
+inline const char* LzssDecoder::errorName(LzssError error) {
+  switch (error) {
+    case LzssError::NONE: return "none";
+    case LzssError::BAD_HEADER: return "bad header";
+    case LzssError::REJECTED: return "image rejected";
+    case LzssError::NO_MEMORY: return "no memory";
+    case LzssError::CORRUPT: return "corrupt image";
+    case LzssError::WRITE_FAILED: return "write failed";
+  }
+  return "?";
+}
+
+#endif
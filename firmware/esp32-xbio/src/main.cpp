@@ -11,11 +11,13 @@
 #include <Wire.h>
 #include <ArduinoJson.h>
 #include <PubSubClient.h>
-#include <WebSocketsClient.h>
 #include <Preferences.h>
 #include <esp_system.h>
 #include <esp_sleep.h>
 #include <esp_wifi.h>
+#include <array>
+#include <utility>
+#include <time.h>
 
 // xBio Modules
 #include "bme688_driver.h"
@@ -23,10 +25,17 @@
 #include "ble_server.h"
 #include "mqtt_client.h"
 #include "websocket_handler.h"
+#include "uplink_manager.h"
+#include "sink_bus.h"
+#include "sample_store.h"
+#include "command_dispatch.h"
+#include "command_queue.h"
 #include "ota_updater.h"
 #include "config_manager.h"
 #include "led_controller.h"
 #include "alert_manager.h"
+#include "rule_engine.h"
+#include "anomaly_detector.h"
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // Configuration Defaults
@@ -43,6 +52,22 @@
   #define MQTT_PUBLISH_INTERVAL 5000
 #endif
 
+#ifndef STREAM_UPDATE_INTERVAL
+  #define STREAM_UPDATE_INTERVAL 1000
+#endif
+
+#ifndef OTA_PROGRESS_INTERVAL
+  #define OTA_PROGRESS_INTERVAL 2000      // Status topic update rate during a download
+#endif
+
+#ifndef COMMAND_EXEC_BUDGET_MS
+  #define COMMAND_EXEC_BUDGET_MS 20       // Stop draining commands once a tick has used this much
+#endif
+
+#ifndef COMMAND_EXEC_MAX_PER_TICK
+  #define COMMAND_EXEC_MAX_PER_TICK 4
+#endif
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Global Objects
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -51,25 +76,34 @@ XBioWiFiManager wifiManager;
 XBioBLEServer bleServer;
 XBioMQTTClient mqttClient;
 XBioWebSocket wsHandler;
+XBioUplink uplink;
+XBioSinkBus sinkBus;
+XBioSampleStore sampleStore;
 XBioOTAUpdater otaUpdater;
 ConfigManager configManager;
 LEDController ledController;
 AlertManager alertManager;
+RuleEngine ruleEngine;
+AnomalyDetector anomalyDetector;
+CommandQueue commandQueue;
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // Global Variables
 // ═══════════════════════════════════════════════════════════════════════════════
 static unsigned long lastSensorRead = 0;
-static unsigned long lastMqttPublish = 0;
-static unsigned long lastWsUpdate = 0;
+static int8_t mqttSink = -1;
+static uint32_t reportedCommandDrops = 0;
 static bool systemReady = false;
 static bool sensorCalibrated = false;
+static uint32_t anomalyLastNs = 0;
+static uint32_t anomalyMaxNs = 0;
+static char ruleError[48] = "";         // Last rule_set / rule_clear failure, reported in status
 
 // Device Identity
 String deviceId;
 String deviceName;
 
-// Current Sensor Data
+// Current Sensor Data (loop task only - other tasks read sampleStore)
 SensorData currentData;
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -81,12 +115,96 @@ void initializeSensor();
 void initializeConnectivity();
 void readSensorData();
 void publishData();
+void initializeSinks();
+void updateAnomalyScores();
 void handleAlerts();
-void handleCommands(String command, JsonDocument& params);
+void publishAlert(const AlertEvent& event);
+void publishRuleEvent(const RuleEvent& event);
+void onConfigChanged(ConfigKey key);
+void dispatchCommand(CommandSource source, const char* payload, size_t length);
+void executeCommands();
+void reportOTAProgress();
 void enterDeepSleep(uint32_t sleepTimeMs);
 void printStartupBanner();
 String generateDeviceId();
 
+// Command handlers
+void cmdRestart(const CommandArgs& args);
+void cmdSetConfig(const CommandArgs& args);
+void cmdConfigPatch(const CommandArgs& args);
+void cmdGetStatus(const CommandArgs& args);
+void cmdCalibrate(const CommandArgs& args);
+void cmdSleep(const CommandArgs& args);
+void cmdOtaUpdate(const CommandArgs& args);
+void cmdAlertAck(const CommandArgs& args);
+void cmdRuleSet(const CommandArgs& args);
+void cmdRuleClear(const CommandArgs& args);
+void reportRuleResult(int slot, const char* error);
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Command Table (shared by MQTT, BLE and WebSocket)
+// ═══════════════════════════════════════════════════════════════════════════════
+static constexpr CommandParam setConfigParams[] = {
+  {"temp_offset", ParamType::FLOAT, false},
+  {"humidity_offset", ParamType::FLOAT, false},
+  {"device_name", ParamType::STRING, false},
+};
+
+// config_patch takes every schema field by its config name; param index == ConfigKey
+constexpr ParamType configParamType(ConfigType type) {
+  return type == ConfigType::STRING ? ParamType::STRING :
+         type == ConfigType::FLOAT ? ParamType::FLOAT :
+         type == ConfigType::BOOL ? ParamType::BOOL : ParamType::INT;
+}
+
+template <size_t... I>
+constexpr std::array<CommandParam, sizeof...(I)> configPatchParamsFor(std::index_sequence<I...>) {
+  return {{{CONFIG_FIELDS[I].name, configParamType(CONFIG_FIELDS[I].type), false}...}};
+}
+
+static constexpr auto configPatchParams = configPatchParamsFor(std::make_index_sequence<CONFIG_RECORD_FIELDS>());
+
+static constexpr CommandParam sleepParams[] = {
+  {"duration_ms", ParamType::INT, false},
+};
+
+static constexpr CommandParam otaParams[] = {
+  {"url", ParamType::STRING, true},
+  {"sha256", ParamType::STRING, false},
+  {"sig", ParamType::STRING, false},
+  {"patch", ParamType::STRING, false},
+};
+
+static constexpr CommandParam alertAckParams[] = {
+  {"type", ParamType::STRING, false},   // Omitted: acknowledge every active alert
+};
+
+static constexpr CommandParam ruleSetParams[] = {
+  {"slot", ParamType::INT, true},
+  {"rule", ParamType::STRING, true},    // Hex blob from tools/xbio_rulec
+};
+
+static constexpr CommandParam ruleClearParams[] = {
+  {"slot", ParamType::INT, true},
+};
+
+static constexpr CommandSpec commandSpecs[] = {
+  {"restart", cmdRestart, COMMAND_NO_PARAMS},
+  {"set_config", cmdSetConfig, COMMAND_PARAMS(setConfigParams)},
+  {"config_patch", cmdConfigPatch, configPatchParams.data(), (uint8_t)configPatchParams.size()},
+  {"get_status", cmdGetStatus, COMMAND_NO_PARAMS},
+  {"calibrate", cmdCalibrate, COMMAND_NO_PARAMS},
+  {"sleep", cmdSleep, COMMAND_PARAMS(sleepParams)},
+  {"ota_update", cmdOtaUpdate, COMMAND_PARAMS(otaParams)},
+  {"alert_ack", cmdAlertAck, COMMAND_PARAMS(alertAckParams)},
+  {"rule_set", cmdRuleSet, COMMAND_PARAMS(ruleSetParams)},
+  {"rule_clear", cmdRuleClear, COMMAND_PARAMS(ruleClearParams)},
+};
+
+static constexpr CommandTable<sizeof(commandSpecs) / sizeof(commandSpecs[0])> commandTable(commandSpecs);
+static_assert(commandTable.valid(), "Command names collide - raise COMMAND_SEED_SEARCH");
+static_assert(commandTable.paramsFit(), "A command declares more than COMMAND_MAX_PARAMS parameters");
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Setup
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -113,6 +231,9 @@ void setup() {
   // Initialize Connectivity
   initializeConnectivity();
   
+  // Register data sinks
+  initializeSinks();
+  
   // System Ready
   systemReady = true;
   ledController.setStatus(LEDStatus::READY);
@@ -145,33 +266,27 @@ void loop() {
     mqttClient.reconnect();
   }
   
-  // Handle WebSocket
-  if (wsHandler.isConnected()) {
-    wsHandler.loop();
-  }
+  // Handle WebSocket (opened/closed by the uplink policy)
+  uplink.loop();
+  
+  // Run commands queued by MQTT / BLE / WS callbacks
+  executeCommands();
+  
+  // Write settled config changes back to NVS
+  configManager.loop();
   
   // Handle OTA Updates
   #ifdef ENABLE_OTA_UPDATES
     otaUpdater.loop();
+    reportOTAProgress();
   #endif
   
-  // Read Sensor Data
+  // Read Sensor Data and fan out to MQTT / WebSocket / BLE at their own rates
   if (currentMillis - lastSensorRead >= SENSOR_READ_INTERVAL) {
     lastSensorRead = currentMillis;
     readSensorData();
     handleAlerts();
-  }
-  
-  // Publish to MQTT
-  if (currentMillis - lastMqttPublish >= MQTT_PUBLISH_INTERVAL) {
-    lastMqttPublish = currentMillis;
-    publishData();
-  }
-  
-  // Update WebSocket Clients
-  if (currentMillis - lastWsUpdate >= 1000) {
-    lastWsUpdate = currentMillis;
-    wsHandler.broadcastSensorData(currentData);
+    sinkBus.publish(currentData);
   }
   
   // Update LED Status
@@ -219,6 +334,7 @@ void initializeSystem() {
     deviceName = "xBio-" + deviceId.substring(0, 6);
     configManager.setDeviceName(deviceName);
   }
+  configManager.commit(); // First boot: persist the generated identity now
   
   Serial.printf("   Device ID: %s\n", deviceId.c_str());
   Serial.printf("   Device Name: %s\n", deviceName.c_str());
@@ -233,9 +349,19 @@ void initializePeripherals() {
   
   Serial.printf("   I2C: SDA=%d, SCL=%d @ 400kHz\n", BME688_SDA, BME688_SCL);
   
+  // Anomaly scores (time-of-day baseline in PSRAM, scored once NTP has set the clock)
+  bool seasonal = anomalyDetector.enableSeasonal();
+  Serial.printf("   Anomaly Detector: %u channels, seasonal %s\n", (unsigned)AnomalyChannel::COUNT,
+                seasonal ? "on" : "off (no memory)");
+  
   // Initialize Alert Manager
-  alertManager.begin(&configManager);
+  alertManager.begin(&configManager, &anomalyDetector);
+  alertManager.setEventCallback(publishAlert);
   Serial.println("   Alert Manager: Initialized");
+  
+  // Pushed rules (persisted in their own NVS namespace)
+  ruleEngine.begin();
+  ruleEngine.setEventCallback(publishRuleEvent);
 }
 
 void initializeSensor() {
@@ -264,6 +390,9 @@ void initializeSensor() {
   Serial.printf("   Temperature Offset: %.2f°C\n", configManager.getTempOffset());
   Serial.printf("   Humidity Offset: %.2f%%\n", configManager.getHumidityOffset());
   
+  // Offsets changed at runtime reach the driver through the config listener
+  configManager.addListener(onConfigChanged);
+  
   // Start calibration
   Serial.println("   Starting sensor calibration (5 minutes for optimal IAQ)...");
   ledController.setStatus(LEDStatus::CALIBRATING);
@@ -279,14 +408,65 @@ void initializeConnectivity() {
   if (wifiManager.waitForConnection(30000)) {
     Serial.printf("✅ WiFi Connected: %s\n", WiFi.localIP().toString().c_str());
     
+    // Wall clock for the anomaly detector's time-of-day baseline (SNTP keeps it synced)
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+    
     // Initialize MQTT
     String mqttServer = configManager.getMqttServer();
     int mqttPort = configManager.getMqttPort();
+    bool mqttTls = configManager.getMqttTls();
+    
+    // One trust store / TLS config shared by the MQTT and WebSocket links
+    XBioTLSContext::shared().setTrust(configManager.getTlsCaCert().c_str(),
+                                      configManager.getTlsFingerprint());
     
     if (!mqttServer.isEmpty()) {
-      mqttClient.begin(mqttServer.c_str(), mqttPort, deviceId.c_str());
-      mqttClient.setCallback([](String topic, JsonDocument& payload) {
-        handleCommands(topic, payload);
+      mqttClient.begin(mqttServer.c_str(), mqttPort, deviceId.c_str(), mqttTls);
+      mqttClient.setCallback([](const char* topic, const uint8_t* payload, size_t length) {
+        commandQueue.push(CommandSource::MQTT, (const char*)payload, length);
+      });
+      mqttClient.setStatusCallback([](JsonDocument& doc) {
+        // Lets the server skip pushing a config the device already runs
+        char hash[9];
+        snprintf(hash, sizeof(hash), "%08x", configManager.hash());
+        doc["config_hash"] = hash;
+        doc["alerts_active"] = alertManager.getActiveCount();
+        doc["alert_seq"] = alertManager.lastSeq();
+        
+        JsonObject a = doc["anomaly"].to<JsonObject>();
+        a["samples"] = anomalyDetector.samples();
+        a["seasonal"] = anomalyDetector.seasonalEnabled();
+        a["last_ns"] = anomalyLastNs;
+        a["max_ns"] = anomalyMaxNs;
+        
+        RuleStats rules = ruleEngine.getStats();
+        if (rules.loaded || ruleError[0]) {
+          JsonObject r = doc["rules"].to<JsonObject>();
+          r["loaded"] = rules.loaded;
+          r["active"] = rules.active;
+          r["avg_ns"] = rules.avgNs;
+          r["max_ns"] = rules.maxNs;
+          r["last_ns"] = rules.lastNs;
+          r["seq"] = ruleEngine.lastSeq();
+          if (ruleError[0]) r["error"] = ruleError;
+        }
+        
+        OTAProgress ota = otaUpdater.getProgress();
+        if (ota.state == OTAState::IDLE) return;
+        JsonObject o = doc["ota"].to<JsonObject>();
+        o["state"] = XBioOTAUpdater::stateName(ota.state);
+        o["received"] = ota.received;
+        o["total"] = ota.total;
+        if (ota.total) o["progress"] = (uint8_t)((uint64_t)ota.received * 100 / ota.total);
+        o["rate_bps"] = ota.bytesPerSec;
+        o["verified"] = ota.verified;
+        o["format"] = XBioOTAUpdater::formatName(ota.format);
+        o["written"] = ota.written;
+        if (ota.format != OTAFormat::IMAGE && ota.written) {
+          o["ratio"] = (uint8_t)((uint64_t)ota.received * 100 / ota.written);
+          o["decode_bps"] = ota.decodeBytesPerSec;
+        }
+        if (ota.error[0]) o["error"] = ota.error;
       });
       Serial.printf("   MQTT: %s:%d\n", mqttServer.c_str(), mqttPort);
     }
@@ -295,12 +475,19 @@ void initializeConnectivity() {
     String wsServer = configManager.getWsServer();
     if (!wsServer.isEmpty()) {
       wsHandler.begin(wsServer.c_str(), configManager.getWsPort());
+      wsHandler.setMessageCallback([](const char* payload, size_t length) {
+        commandQueue.push(CommandSource::WEBSOCKET, payload, length);
+      });
       Serial.printf("   WebSocket: %s\n", wsServer.c_str());
     }
     
+    uplink.begin(&mqttClient, &wsHandler, (UplinkMode)configManager.getUplinkMode(), deviceId.c_str());
+    
     // Initialize OTA
     #ifdef ENABLE_OTA_UPDATES
       otaUpdater.begin(deviceName.c_str());
+      otaUpdater.setTrust(configManager.getTlsCaCert(), configManager.getOtaPublicKey(),
+                          configManager.getOtaRateLimit());
       Serial.println("   OTA Updates: Enabled");
     #endif
     
@@ -314,6 +501,10 @@ void initializeConnectivity() {
     bleServer.setDataCallback([](SensorData data) {
       // Handle BLE data requests
     });
+    bleServer.setCommandCallback([](const char* payload, size_t length) {
+      // NimBLE host task - only enqueue, loop() executes
+      commandQueue.push(CommandSource::BLE, payload, length);
+    });
     Serial.println("   BLE Server: Active");
   #endif
 }
@@ -326,6 +517,7 @@ void readSensorData() {
   if (!sensorDriver.isReady()) return;
   
   currentData = sensorDriver.read();
+  sampleStore.publish(currentData);
   
   // Check calibration status
   if (!sensorCalibrated && sensorDriver.isCalibrated()) {
@@ -345,101 +537,403 @@ void readSensorData() {
   #endif
 }
 
+void initializeSinks() {
+  Serial.println("🚌 Initializing Data Sinks...");
+  
+  static String dataTopic = "xbio/" + deviceId + "/data";
+  
+  // Identity + status for the full xbio/<id>/data record
+  sinkBus.setEnvelope([](JsonDocument& doc) {
+    doc["device_id"] = deviceId;
+    doc["device_name"] = deviceName;
+    doc["calibrated"] = sensorCalibrated;
+    
+    JsonObject status = doc["status"].to<JsonObject>();
+    status["wifi_rssi"] = WiFi.RSSI();
+    status["uptime"] = millis() / 1000;
+    status["free_heap"] = ESP.getFreeHeap();
+    status["battery"] = 100; // Future: Add battery monitoring
+    status["mqtt_pending"] = mqttClient.getQueueStats().pending;
+    
+    UplinkStats link = uplink.getStats();
+    status["uplink_links"] = link.activeLinks;
+    status["tls_heap_saved"] = link.heapSaved;
+    
+    // Last closed aggregate window: [min, avg, max]
+    SensorAggregates agg = sampleStore.aggregates();
+    if (agg.count > 0) {
+      JsonObject window = doc["aggregates"].to<JsonObject>();
+      window["window_s"] = agg.windowMs / 1000;
+      window["samples"] = agg.count;
+      const char* keys[] = {"temperature", "humidity", "pressure", "iaq"};
+      const SensorStat* stats[] = {&agg.temperature, &agg.humidity, &agg.pressure, &agg.iaq};
+      for (uint8_t i = 0; i < 4; i++) {
+        JsonArray range = window[keys[i]].to<JsonArray>();
+        range.add(XBioSinkBus::rounded(stats[i]->min));
+        range.add(XBioSinkBus::rounded(stats[i]->avg));
+        range.add(XBioSinkBus::rounded(stats[i]->max));
+      }
+    }
+    
+    // Anomaly scores (|z|) per channel, once the detector has warmed up
+    if (anomalyDetector.warm()) {
+      JsonObject anomaly = doc["anomaly"].to<JsonObject>();
+      anomaly["max"] = XBioSinkBus::rounded(anomalyDetector.maxScore());
+      for (uint8_t c = 0; c < (uint8_t)AnomalyChannel::COUNT; c++) {
+        float score = anomalyDetector.score((AnomalyChannel)c).score;
+        if (score == score) anomaly[ANOMALY_CHANNELS[c].key] = XBioSinkBus::rounded(score);
+      }
+    }
+  });
+  
+  // MQTT (QoS 1 - queued while offline and delivered after reconnect)
+  mqttSink = sinkBus.addSink("mqtt", SinkFormat::FULL_JSON, MQTT_PUBLISH_INTERVAL,
+    [](const char* payload, size_t length) {
+      if (!mqttClient.isInitialized()) return false;
+      return mqttClient.publish(dataTopic.c_str(), payload, false, 1);
+    });
+  
+  // Live stream (WS link or MQTT tunnel)
+  sinkBus.addSink("stream", SinkFormat::COMPACT_JSON, STREAM_UPDATE_INTERVAL,
+    [](const char* payload, size_t length) {
+      return uplink.sendFrame(payload, length);
+    });
+  
+  #ifdef ENABLE_BLE_PROVISIONING
+    sinkBus.addSink("ble", SinkFormat::COMPACT_JSON, STREAM_UPDATE_INTERVAL,
+      [](const char* payload, size_t length) {
+        bleServer.updateSensorJson(payload, length);
+        return true;
+      });
+  #endif
+}
+
 void publishData() {
-  if (!mqttClient.isConnected()) return;
+  // Deliver the latest sample to MQTT now, outside its normal rate
+  sinkBus.flush(mqttSink);
+}
+
+void updateAnomalyScores() {
+  if (!currentData.valid) return;
+  
+  float values[(uint8_t)AnomalyChannel::COUNT];
+  values[(uint8_t)AnomalyChannel::TEMPERATURE] = currentData.temperature;
+  values[(uint8_t)AnomalyChannel::HUMIDITY] = currentData.humidity;
+  values[(uint8_t)AnomalyChannel::PRESSURE] = currentData.pressure;
+  values[(uint8_t)AnomalyChannel::IAQ] = currentData.iaq;
+  values[(uint8_t)AnomalyChannel::GAS] = currentData.gasResistance;
+  
+  // UTC is fine for the time-of-day baseline - only the daily period matters
+  time_t now = time(nullptr);
+  int32_t secondOfDay = now > 1700000000 ? (int32_t)(now % 86400) : -1;
+  
+  uint32_t start = ESP.getCycleCount();
+  anomalyDetector.update(values, currentData.timestamp, secondOfDay);
+  anomalyLastNs = (uint32_t)((uint64_t)(ESP.getCycleCount() - start) * 1000 / ESP.getCpuFreqMHz());
+  if (anomalyLastNs > anomalyMaxNs) anomalyMaxNs = anomalyLastNs;
+}
+
+void handleAlerts() {
+  updateAnomalyScores();
+  alertManager.evaluate(currentData);
+  ruleEngine.evaluate(currentData, sampleStore.aggregates());
+  
+  // Unacknowledged alerts hold the warning blink; back to ready once they clear or are acked
+  bool warning = alertManager.getActiveCount() > 0 || ruleEngine.getStats().active > 0;
+  LEDStatus led = ledController.getStatus();
+  if (warning && led == LEDStatus::READY) {
+    ledController.setStatus(LEDStatus::WARNING);
+  } else if (!warning && led == LEDStatus::WARNING) {
+    ledController.setStatus(LEDStatus::READY);
+  }
+}
+
+void publishAlert(const AlertEvent& event) {
+  // Straight to xbio/<id>/alerts at QoS 1 - not held back for the telemetry interval
+  static String alertTopic = "xbio/" + deviceId + "/alerts";
+  if (!mqttClient.isInitialized()) return;
   
-  // Create JSON payload
   JsonDocument doc;
+  doc["type"] = AlertManager::typeName(event.type);
+  doc["event"] = AlertManager::kindName(event.kind);
+  doc["value"] = event.value;
+  doc["threshold"] = event.threshold;
+  doc["seq"] = event.seq;
+  doc["timestamp"] = event.timestamp;
   doc["device_id"] = deviceId;
-  doc["device_name"] = deviceName;
-  doc["timestamp"] = millis();
-  doc["calibrated"] = sensorCalibrated;
-  
-  JsonObject sensors = doc["sensors"].to<JsonObject>();
-  sensors["temperature"] = currentData.temperature;
-  sensors["humidity"] = currentData.humidity;
-  sensors["pressure"] = currentData.pressure;
-  sensors["iaq"] = currentData.iaq;
-  sensors["iaq_accuracy"] = currentData.iaqAccuracy;
-  sensors["gas_resistance"] = currentData.gasResistance;
-  sensors["co2_equivalent"] = currentData.co2Equivalent;
-  sensors["voc_equivalent"] = currentData.vocEquivalent;
-  
-  JsonObject status = doc["status"].to<JsonObject>();
-  status["wifi_rssi"] = WiFi.RSSI();
-  status["uptime"] = millis() / 1000;
-  status["free_heap"] = ESP.getFreeHeap();
-  status["battery"] = 100; // Future: Add battery monitoring
-  
-  // Publish to MQTT
-  String topic = "xbio/" + deviceId + "/data";
-  mqttClient.publish(topic.c_str(), doc);
+  mqttClient.publish(alertTopic.c_str(), doc, false, 1);
 }
 
-void handleAlerts() {
-  // Check temperature thresholds
-  if (currentData.temperature > configManager.getMaxTemperature()) {
-    alertManager.trigger("HIGH_TEMPERATURE", currentData.temperature);
-  }
-  if (currentData.temperature < configManager.getMinTemperature()) {
-    alertManager.trigger("LOW_TEMPERATURE", currentData.temperature);
-  }
+void publishRuleEvent(const RuleEvent& event) {
+  // Same topic and fields as built-in alerts; type is the rule's name, and
+  // seq counts rule events on their own (the "rule" field tells them apart)
+  static String alertTopic = "xbio/" + deviceId + "/alerts";
+  if (!mqttClient.isInitialized()) return;
   
-  // Check humidity thresholds
-  if (currentData.humidity > configManager.getMaxHumidity()) {
-    alertManager.trigger("HIGH_HUMIDITY", currentData.humidity);
-  }
-  if (currentData.humidity < configManager.getMinHumidity()) {
-    alertManager.trigger("LOW_HUMIDITY", currentData.humidity);
+  JsonDocument doc;
+  doc["type"] = event.name;
+  doc["event"] = event.kind == RuleEventKind::RAISED ? "raised" : "cleared";
+  doc["value"] = event.value;
+  doc["threshold"] = event.threshold;
+  doc["rule"] = event.slot;
+  doc["seq"] = event.seq;
+  doc["timestamp"] = event.timestamp;
+  doc["device_id"] = deviceId;
+  mqttClient.publish(alertTopic.c_str(), doc, false, 1);
+}
+
+void executeCommands() {
+  uint32_t start = millis();
+  uint8_t executed = 0;
+  
+  // Budget is checked between commands; one slow command (OTA) still runs to completion
+  const CommandQueue::Entry* entry;
+  while (executed < COMMAND_EXEC_MAX_PER_TICK && millis() - start < COMMAND_EXEC_BUDGET_MS &&
+         (entry = commandQueue.front()) != nullptr) {
+    dispatchCommand(entry->source, entry->data, entry->length);
+    commandQueue.pop();
+    executed++;
   }
   
-  // Check IAQ thresholds
-  if (currentData.iaq > configManager.getMaxIAQ()) {
-    alertManager.trigger("POOR_AIR_QUALITY", currentData.iaq);
-    ledController.setStatus(LEDStatus::WARNING);
+  CommandQueueStats stats = commandQueue.getStats();
+  uint32_t drops = stats.dropped + stats.oversize;
+  if (drops != reportedCommandDrops) {
+    Serial.printf("⚠️ Commands dropped: %u (queue full: %u, oversize: %u)\n",
+                  drops - reportedCommandDrops, stats.dropped, stats.oversize);
+    reportedCommandDrops = drops;
   }
 }
 
-void handleCommands(String topic, JsonDocument& params) {
-  Serial.printf("📥 Command received: %s\n", topic.c_str());
+void dispatchCommand(CommandSource source, const char* payload, size_t length) {
+  static const char* sourceNames[] = {"MQTT", "BLE", "WS"};
   
-  String command = params["command"].as<String>();
+  const CommandSpec* command = nullptr;
+  CommandResult result = commandTable.dispatch(source, payload, length, &command);
   
-  if (command == "restart") {
-    Serial.println("🔄 Restarting device...");
-    delay(1000);
-    ESP.restart();
+  if (result == CommandResult::OK) {
+    Serial.printf("📥 Command received: %s (%s)\n", command->name, sourceNames[(uint8_t)source]);
+  } else if (source != CommandSource::WEBSOCKET || result != CommandResult::MALFORMED) {
+    // WS also carries non-command frames, so only report real command errors there
+    Serial.printf("⚠️ Command rejected (%s): %s\n", sourceNames[(uint8_t)source], commandResultName(result));
   }
-  else if (command == "set_config") {
-    if (params.containsKey("temp_offset")) {
-      configManager.setTempOffset(params["temp_offset"].as<float>());
-      sensorDriver.setTemperatureOffset(params["temp_offset"].as<float>());
-    }
-    if (params.containsKey("humidity_offset")) {
-      configManager.setHumidityOffset(params["humidity_offset"].as<float>());
-      sensorDriver.setHumidityOffset(params["humidity_offset"].as<float>());
+}
+
+void cmdRestart(const CommandArgs& args) {
+  Serial.println("🔄 Restarting device...");
+  configManager.saveState();
+  mqttClient.persistQueue();
+  delay(1000);
+  ESP.restart();
+}
+
+void cmdSetConfig(const CommandArgs& args) {
+  // One apply() so the offsets and name land (and persist) together
+  ConfigRecord next = configManager.record();
+  if (args.has(0)) ConfigManager::setNumber(next, ConfigKey::TEMP_OFFSET, args.getFloat(0));
+  if (args.has(1)) ConfigManager::setNumber(next, ConfigKey::HUMIDITY_OFFSET, args.getFloat(1));
+  if (args.has(2)) {
+    char name[sizeof(next.deviceName)];
+    args.getString(2, name, sizeof(name));
+    ConfigManager::setString(next, ConfigKey::DEVICE_NAME, name);
+  }
+  configManager.apply(next);
+}
+
+void cmdConfigPatch(const CommandArgs& args) {
+  // All-or-nothing: any bad field rejects the whole patch
+  ConfigRecord next = configManager.record();
+  uint8_t fields = 0;
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    if (!args.has(k)) continue;
+    const ConfigField& field = CONFIG_FIELDS[k];
+    bool ok = field.patchable;
+    
+    if (ok) {
+      switch (field.type) {
+        case ConfigType::STRING: {
+          char value[128];
+          // One spare byte so an over-long value is caught instead of truncated
+          size_t length = args.getString(k, value, min((size_t)field.size + 1, sizeof(value)));
+          ok = length < field.size && ConfigManager::setString(next, (ConfigKey)k, value);
+          break;
+        }
+        case ConfigType::FLOAT:
+          ok = ConfigManager::setNumber(next, (ConfigKey)k, args.getFloat(k));
+          break;
+        case ConfigType::INT:
+          ok = ConfigManager::setNumber(next, (ConfigKey)k, (float)args.getInt(k));
+          break;
+        case ConfigType::BOOL:
+          ok = ConfigManager::setNumber(next, (ConfigKey)k, args.getBool(k) ? 1.0f : 0.0f);
+          break;
+      }
     }
-    if (params.containsKey("device_name")) {
-      configManager.setDeviceName(params["device_name"].as<String>());
-      deviceName = params["device_name"].as<String>();
+    if (!ok) {
+      Serial.printf("⚠️ Config patch rejected: %s\n", field.name);
+      return;
     }
+    fields++;
   }
-  else if (command == "get_status") {
-    // Force publish current status
-    publishData();
+  
+  uint32_t before = configManager.hash();
+  if (!configManager.apply(next)) {
+    Serial.printf("⚠️ Config patch rejected: %s\n", configManager.lastError());
+    return;
   }
-  else if (command == "calibrate") {
-    sensorDriver.forceCalibration();
-    sensorCalibrated = false;
-    ledController.setStatus(LEDStatus::CALIBRATING);
+  Serial.printf("⚙️ Config patch: %u field(s), hash %08x -> %08x\n", fields, before, configManager.hash());
+  
+  // Report the new hash right away so the server sees the patch landed
+  if (configManager.hash() != before) mqttClient.publishStatus("online");
+}
+
+void onConfigChanged(ConfigKey key) {
+  switch (key) {
+    case ConfigKey::TEMP_OFFSET:
+      sensorDriver.setTemperatureOffset(configManager.getTempOffset());
+      break;
+    case ConfigKey::HUMIDITY_OFFSET:
+      sensorDriver.setHumidityOffset(configManager.getHumidityOffset());
+      break;
+    case ConfigKey::DEVICE_NAME:
+      deviceName = configManager.getDeviceName();
+      break;
+    default:
+      break;
+  }
+  Serial.printf("⚙️ Config changed: %s\n", ConfigManager::keyName(key));
+}
+
+void cmdGetStatus(const CommandArgs& args) {
+  // Force publish current status
+  publishData();
+}
+
+void cmdCalibrate(const CommandArgs& args) {
+  sensorDriver.forceCalibration();
+  sensorCalibrated = false;
+  ledController.setStatus(LEDStatus::CALIBRATING);
+}
+
+void cmdSleep(const CommandArgs& args) {
+  uint32_t sleepTime = args.getInt(0, 60000);
+  enterDeepSleep(sleepTime);
+}
+
+void cmdOtaUpdate(const CommandArgs& args) {
+  char url[256];
+  char sha256[72];
+  char signature[264];
+  char patch[256];
+  args.getString(0, url, sizeof(url));
+  args.getString(1, sha256, sizeof(sha256));
+  args.getString(2, signature, sizeof(signature));
+  args.getString(3, patch, sizeof(patch));
+  
+  // Returns at once - the download runs in its own task while sampling continues
+  otaUpdater.startUpdate(url, sha256, signature, patch);
+}
+
+void cmdAlertAck(const CommandArgs& args) {
+  if (!args.has(0)) {
+    alertManager.acknowledgeAll();
+    return;
+  }
+  
+  char name[24];
+  args.getString(0, name, sizeof(name));
+  AlertType type;
+  if (!AlertManager::parseType(name, &type)) {
+    Serial.printf("⚠️ Unknown alert type: %s\n", name);
+    return;
   }
-  else if (command == "sleep") {
-    uint32_t sleepTime = params["duration_ms"] | 60000;
-    enterDeepSleep(sleepTime);
+  alertManager.acknowledge(type);
+}
+
+static int hexDigit(char c) {
+  return (c >= '0' && c <= '9') ? c - '0' :
+         (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+         (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+// Range-checked before any narrowing: slot 264 must not become slot 8 or 0
+static bool validRuleSlot(int32_t slot) {
+  return slot >= 0 && slot < RULE_MAX_RULES;
+}
+
+void cmdRuleSet(const CommandArgs& args) {
+  int32_t slot = args.getInt(0);
+  char hex[RULE_BLOB_MAX * 2 + 2];
+  size_t length = args.getString(1, hex, sizeof(hex));
+  
+  uint8_t blob[RULE_BLOB_MAX];
+  size_t size = 0;
+  bool ok = length % 2 == 0 && length / 2 <= sizeof(blob);
+  for (size_t i = 0; ok && i < length; i += 2) {
+    int hi = hexDigit(hex[i]);
+    int lo = hexDigit(hex[i + 1]);
+    ok = hi >= 0 && lo >= 0;
+    blob[size++] = (uint8_t)((hi << 4) | lo);
   }
-  else if (command == "ota_update") {
-    String url = params["url"].as<String>();
-    otaUpdater.startUpdate(url);
+  
+  const char* error = !validRuleSlot(slot) ? "bad slot" :
+                      !ok ? "bad hex" : ruleEngine.set((uint8_t)slot, blob, size);
+  if (error) Serial.printf("⚠️ Rule rejected (slot %d): %s\n", (int)slot, error);
+  reportRuleResult(slot, error);
+}
+
+void cmdRuleClear(const CommandArgs& args) {
+  int32_t slot = args.getInt(0);
+  const char* error = !validRuleSlot(slot) ? "bad slot" :
+                      ruleEngine.clear((uint8_t)slot) ? nullptr : "no rule";
+  if (error) Serial.printf("⚠️ Rule not cleared (slot %d): %s\n", (int)slot, error);
+  reportRuleResult(slot, error);
+}
+
+void reportRuleResult(int slot, const char* error) {
+  // Commands have no reply channel; the status topic carries the outcome
+  if (error) {
+    snprintf(ruleError, sizeof(ruleError), "slot %d: %s", slot, error);
+  } else {
+    ruleError[0] = '\0';
+  }
+  mqttClient.publishStatus("online");
+}
+
+void reportOTAProgress() {
+  static uint32_t lastVersion = 0;
+  static uint32_t lastReport = 0;
+  static OTAState lastState = OTAState::IDLE;
+  
+  uint32_t version = otaUpdater.progressVersion();
+  if (version == lastVersion) return;
+  
+  OTAProgress ota = otaUpdater.getProgress();
+  bool stateChanged = ota.state != lastState;
+  if (!stateChanged && millis() - lastReport < OTA_PROGRESS_INTERVAL) return;
+  
+  lastVersion = version;
+  lastReport = millis();
+  lastState = ota.state;
+  
+  switch (ota.state) {
+    case OTAState::DOWNLOADING:
+    case OTAState::VERIFYING:
+      mqttClient.publishStatus("updating");
+      break;
+    case OTAState::FAILED:
+      Serial.printf("❌ OTA failed: %s\n", ota.error);
+      mqttClient.publishStatus("online");
+      break;
+    case OTAState::SUCCESS:
+      Serial.println("✅ OTA complete - rebooting...");
+      mqttClient.publishStatus("rebooting");
+      configManager.saveState();
+      mqttClient.persistQueue();
+      delay(500);
+      ESP.restart();
+      break;
+    default:
+      break;
   }
 }
 
@@ -448,6 +942,7 @@ void enterDeepSleep(uint32_t sleepTimeMs) {
   
   // Save state
   configManager.saveState();
+  mqttClient.persistQueue();
   
   // Disconnect
   mqttClient.disconnect();
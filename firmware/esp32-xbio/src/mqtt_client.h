@@ -1,7 +1,7 @@
 /**
  * ═══════════════════════════════════════════════════════════════════════════════
  * 📤 MQTT Client - Cloud Communication Handler
- * Supports auto-reconnect, QoS, and secure connections
+ * Supports auto-reconnect, QoS 1 outbound session, and secure connections
  * ═══════════════════════════════════════════════════════════════════════════════
  */
 
@@ -10,9 +10,11 @@
 
 #include <Arduino.h>
 #include <WiFiClient.h>
-#include <WiFiClientSecure.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
+#include "mqtt_session.h"
+#include "tls_transport.h"
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // Configuration
@@ -32,7 +34,11 @@
 // ═══════════════════════════════════════════════════════════════════════════════
 // Callback Type
 // ═══════════════════════════════════════════════════════════════════════════════
-typedef void (*MQTTMessageCallback)(String topic, JsonDocument& payload);
+// Raw payload from the PubSubClient buffer - valid only during the call
+typedef void (*MQTTMessageCallback)(const char* topic, const uint8_t* payload, size_t length);
+
+// Adds extra fields (e.g. OTA progress) to every status message
+typedef void (*MQTTStatusCallback)(JsonDocument& doc);
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // XBio MQTT Client Class
@@ -70,21 +76,35 @@ public:
   
   /**
    * Publish messages
+   * QoS 0 goes straight to the socket; QoS 1 is queued (also while offline)
+   * and retransmitted until the broker acknowledges it
    */
-  bool publish(const char* topic, const char* payload, bool retained = false);
-  bool publish(const char* topic, JsonDocument& doc, bool retained = false);
+  bool publish(const char* topic, const char* payload, bool retained = false, uint8_t qos = 0);
+  bool publish(const char* topic, JsonDocument& doc, bool retained = false, uint8_t qos = 0);
   bool publishSensor(float temp, float humidity, float pressure, int iaq, float gasRes);
   
+  /**
+   * Retained status message (also sent as "online" on every connect)
+   */
+  void publishStatus(const char* status);
+  
   /**
    * Subscribe to topics
    */
   bool subscribe(const char* topic, uint8_t qos = 0);
   bool unsubscribe(const char* topic);
   
+  /**
+   * QoS 1 session state
+   */
+  MQTTQueueStats getQueueStats();
+  size_t persistQueue();
+  
   /**
    * Set callbacks
    */
   void setCallback(MQTTMessageCallback callback);
+  void setStatusCallback(MQTTStatusCallback callback) { _statusCallback = callback; }
   
   /**
    * Get connection info
@@ -92,10 +112,15 @@ public:
   String getServer();
   int getPort();
   bool isSecure();
+  bool isInitialized();
+  TLSHandshakeStats getTLSStats();
 
 private:
   WiFiClient _wifiClient;
-  WiFiClientSecure _wifiClientSecure;
+  XBioTLSClient _tlsClient;
+  MQTTSessionTap _tap;
+  MQTTOutboundQueue _outbound;
+  Preferences _queuePrefs;
   PubSubClient _mqtt;
   
   char _server[64];
@@ -105,9 +130,11 @@ private:
   char _password[64];
   bool _useTLS;
   bool _initialized;
+  bool _linkUp;
   uint32_t _lastReconnectAttempt;
   
   MQTTMessageCallback _messageCallback;
+  MQTTStatusCallback _statusCallback;
   
   String _baseTopic;
   String _cmdTopic;
@@ -118,7 +145,7 @@ private:
   static XBioMQTTClient* _instance;
   
   void setupTopics();
-  void publishStatus(const char* status);
+  bool checkLink();
 };
 
 // Static instance pointer for callback
@@ -128,16 +155,20 @@ XBioMQTTClient* XBioMQTTClient::_instance = nullptr;
 // Implementation
 // ═══════════════════════════════════════════════════════════════════════════════
 
-XBioMQTTClient::XBioMQTTClient() : _mqtt(_wifiClient) {
+XBioMQTTClient::XBioMQTTClient() : _mqtt(_tap) {
   _port = 1883;
   _useTLS = false;
   _initialized = false;
+  _linkUp = false;
   _lastReconnectAttempt = 0;
   _messageCallback = nullptr;
+  _statusCallback = nullptr;
   memset(_server, 0, sizeof(_server));
   memset(_deviceId, 0, sizeof(_deviceId));
   memset(_username, 0, sizeof(_username));
   memset(_password, 0, sizeof(_password));
+  _tap.setTransport(&_wifiClient);
+  _tap.setQueue(&_outbound);
   _instance = this;
 }
 
@@ -149,11 +180,11 @@ void XBioMQTTClient::begin(const char* server, int port, const char* deviceId, b
   
   // Setup client based on TLS
   if (_useTLS) {
-    _wifiClientSecure.setInsecure(); // Skip certificate validation (for testing)
-    _mqtt.setClient(_wifiClientSecure);
+    _tap.setTransport(&_tlsClient);
   } else {
-    _mqtt.setClient(_wifiClient);
+    _tap.setTransport(&_wifiClient);
   }
+  _mqtt.setClient(_tap);
   
   _mqtt.setServer(_server, _port);
   _mqtt.setBufferSize(MQTT_BUFFER_SIZE);
@@ -162,8 +193,15 @@ void XBioMQTTClient::begin(const char* server, int port, const char* deviceId, b
   
   setupTopics();
   
+  // QoS 1 backlog survives deep sleep / restarts in its own NVS namespace
+  if (_outbound.begin()) {
+    _queuePrefs.begin("mqttq", false);
+    _outbound.restore(_queuePrefs);
+  }
+  
   _initialized = true;
-  Serial.printf("MQTT: Initialized - %s:%d (TLS: %s)\n", _server, _port, _useTLS ? "yes" : "no");
+  Serial.printf("MQTT: Initialized - %s:%d (TLS: %s)\n", _server, _port,
+                _useTLS ? (_tlsClient.isVerified() ? "verified" : "unverified") : "no");
 }
 
 void XBioMQTTClient::setAuth(const char* username, const char* password) {
@@ -181,7 +219,7 @@ void XBioMQTTClient::setupTopics() {
 void XBioMQTTClient::loop() {
   if (!_initialized) return;
   
-  if (!_mqtt.connected()) {
+  if (!checkLink()) {
     uint32_t now = millis();
     if (now - _lastReconnectAttempt >= MQTT_RECONNECT_INTERVAL) {
       _lastReconnectAttempt = now;
@@ -189,6 +227,7 @@ void XBioMQTTClient::loop() {
     }
   } else {
     _mqtt.loop();
+    _outbound.pump(_tap);
   }
 }
 
@@ -219,6 +258,11 @@ bool XBioMQTTClient::connect() {
     // Publish online status
     publishStatus("online");
     
+    // Resend everything the broker has not acknowledged yet
+    _outbound.rewind();
+    _outbound.pump(_tap);
+    _linkUp = true;
+    
     return true;
   } else {
     Serial.printf("MQTT: Connection failed, rc=%d\n", _mqtt.state());
@@ -231,6 +275,7 @@ void XBioMQTTClient::disconnect() {
     publishStatus("offline");
     _mqtt.disconnect();
   }
+  checkLink();
 }
 
 bool XBioMQTTClient::isConnected() {
@@ -241,18 +286,39 @@ void XBioMQTTClient::reconnect() {
   connect();
 }
 
-bool XBioMQTTClient::publish(const char* topic, const char* payload, bool retained) {
+bool XBioMQTTClient::checkLink() {
+  if (_mqtt.connected()) return true;
+  
+  if (_linkUp) {
+    // Packets on the wire will never be acknowledged on this connection.
+    // Return them to the queue so the offline backlog can evict its oldest
+    // instead of rejecting every new sample until the next reconnect.
+    _linkUp = false;
+    _outbound.rewind();
+    Serial.printf("MQTT: Link lost, %d message(s) pending\n", _outbound.getStats().pending);
+  }
+  return false;
+}
+
+bool XBioMQTTClient::publish(const char* topic, const char* payload, bool retained, uint8_t qos) {
+  if (qos > 0) {
+    bool linked = checkLink();
+    if (!_outbound.enqueue(topic, (const uint8_t*)payload, strlen(payload), retained)) return false;
+    if (linked) _outbound.pump(_tap);
+    return true;
+  }
+  
   if (!_mqtt.connected()) return false;
   return _mqtt.publish(topic, payload, retained);
 }
 
-bool XBioMQTTClient::publish(const char* topic, JsonDocument& doc, bool retained) {
-  if (!_mqtt.connected()) return false;
+bool XBioMQTTClient::publish(const char* topic, JsonDocument& doc, bool retained, uint8_t qos) {
+  if (qos == 0 && !_mqtt.connected()) return false;
   
   char buffer[MQTT_BUFFER_SIZE];
-  size_t len = serializeJson(doc, buffer, sizeof(buffer));
+  serializeJson(doc, buffer, sizeof(buffer));
   
-  return _mqtt.publish(topic, buffer, retained);
+  return publish(topic, buffer, retained, qos);
 }
 
 bool XBioMQTTClient::publishSensor(float temp, float humidity, float pressure, int iaq, float gasRes) {
@@ -280,6 +346,18 @@ void XBioMQTTClient::publishStatus(const char* status) {
   doc["uptime"] = millis() / 1000;
   doc["free_heap"] = ESP.getFreeHeap();
   
+  if (_useTLS) {
+    TLSHandshakeStats tls = _tlsClient.getStats();
+    JsonObject t = doc["tls"].to<JsonObject>();
+    t["verified"] = _tlsClient.isVerified();
+    t["resumed"] = tls.lastResumed;
+    t["handshake_ms"] = tls.lastHandshakeMs;
+    t["handshake_bytes"] = tls.lastBytesOut + tls.lastBytesIn;
+    t["resumption_rate"] = tls.handshakes ? (float)tls.resumed / tls.handshakes : 0.0f;
+  }
+  
+  if (_statusCallback) _statusCallback(doc);
+  
   publish(_statusTopic.c_str(), doc, true);
 }
 
@@ -293,6 +371,15 @@ bool XBioMQTTClient::unsubscribe(const char* topic) {
   return _mqtt.unsubscribe(topic);
 }
 
+MQTTQueueStats XBioMQTTClient::getQueueStats() {
+  return _outbound.getStats();
+}
+
+size_t XBioMQTTClient::persistQueue() {
+  if (!_initialized) return 0;
+  return _outbound.persist(_queuePrefs);
+}
+
 void XBioMQTTClient::setCallback(MQTTMessageCallback callback) {
   _messageCallback = callback;
 }
@@ -300,16 +387,8 @@ void XBioMQTTClient::setCallback(MQTTMessageCallback callback) {
 void XBioMQTTClient::mqttCallback(char* topic, byte* payload, unsigned int length) {
   if (!_instance || !_instance->_messageCallback) return;
   
-  // Parse payload as JSON
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload, length);
-  
-  if (error) {
-    Serial.printf("MQTT: JSON parse error - %s\n", error.c_str());
-    return;
-  }
-  
-  _instance->_messageCallback(String(topic), doc);
+  // No copy, no DOM - the command table scans the payload in place
+  _instance->_messageCallback(topic, payload, length);
 }
 
 String XBioMQTTClient::getServer() {
@@ -324,4 +403,12 @@ bool XBioMQTTClient::isSecure() {
   return _useTLS;
 }
 
+bool XBioMQTTClient::isInitialized() {
+  return _initialized;
+}
+
+TLSHandshakeStats XBioMQTTClient::getTLSStats() {
+  return _tlsClient.getStats();
+}
+
 #endif // MQTT_CLIENT_H
@@ -0,0 +1,508 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 📬 MQTT Session - QoS 1 Outbound Queue & PUBACK Tracking
+ * Bounded in-flight window, retransmit on reconnect, persistent backlog
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * PubSubClient only writes QoS 0 PUBLISH packets and silently drops PUBACKs.
+ * This layer builds QoS 1 packets itself and writes them straight to the
+ * transport, while MQTTSessionTap sits between PubSubClient and the socket and
+ * frames the inbound byte stream so PUBACKs reach the queue.
+ */
+
+#ifndef MQTT_SESSION_H
+#define MQTT_SESSION_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <Preferences.h>
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Configuration
+// ═══════════════════════════════════════════════════════════════════════════════
+#ifndef MQTT_QUEUE_DEPTH
+  #define MQTT_QUEUE_DEPTH 32          // Messages held until PUBACK
+#endif
+
+#ifndef MQTT_INFLIGHT_WINDOW
+  #define MQTT_INFLIGHT_WINDOW 8       // Unacknowledged PUBLISH packets on the wire
+#endif
+
+#ifndef MQTT_QUEUE_SLOT_SIZE
+  #define MQTT_QUEUE_SLOT_SIZE 768     // Encoded PUBLISH packet (header + topic + payload)
+#endif
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Queue Statistics
+// ═══════════════════════════════════════════════════════════════════════════════
+struct MQTTQueueStats {
+  uint32_t enqueued;          // Messages accepted
+  uint32_t acked;             // PUBACKs matched
+  uint32_t retransmitted;     // PUBLISH resent with DUP after reconnect
+  uint32_t dropped;           // Rejected (queue full / too large) or evicted
+  uint16_t pending;           // Queued + in flight
+  uint16_t inFlight;          // Sent, awaiting PUBACK
+  uint16_t peakInFlight;      // High-water mark of inFlight
+  uint32_t lastAckLatencyMs;  // Send → PUBACK of the latest ack
+  uint32_t avgAckLatencyMs;   // EWMA (1/8) of ack latency
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Outbound Queue
+// ═══════════════════════════════════════════════════════════════════════════════
+class MQTTOutboundQueue {
+public:
+  MQTTOutboundQueue();
+
+  /**
+   * Allocate slot storage (PSRAM when available)
+   * @return true if storage is available
+   */
+  bool begin();
+
+  /**
+   * Encode and queue a QoS 1 PUBLISH packet
+   * @return false if the queue is full or the packet exceeds MQTT_QUEUE_SLOT_SIZE
+   */
+  bool enqueue(const char* topic, const uint8_t* payload, size_t length, bool retained = false);
+
+  /**
+   * Write queued packets to the transport while the in-flight window is open
+   */
+  void pump(Client& transport);
+
+  /**
+   * Match a PUBACK and release acknowledged slots
+   */
+  void onPubAck(uint16_t packetId);
+
+  /**
+   * Link lost or session (re)established - in-flight packets return to the
+   * queue (evictable while offline) and are resent with DUP set
+   */
+  void rewind();
+
+  /**
+   * Persist / restore unacknowledged packets across deep sleep and restarts
+   */
+  size_t persist(Preferences& prefs);
+  size_t restore(Preferences& prefs);
+
+  MQTTQueueStats getStats();
+  bool isEmpty() { return _head == _tail; }
+
+private:
+  enum SlotState : uint8_t { SLOT_FREE, SLOT_QUEUED, SLOT_INFLIGHT, SLOT_ACKED };
+
+  struct Slot {
+    uint16_t packetId;
+    uint8_t state;
+    bool sent;                  // Written at least once - retransmit with DUP
+    uint32_t sentAt;
+    uint16_t length;
+    uint8_t packet[MQTT_QUEUE_SLOT_SIZE];
+  };
+
+  Slot* _slots;
+  uint32_t _head;               // Next slot to fill
+  uint32_t _tail;               // Oldest unacknowledged slot
+  uint32_t _next;               // Next slot to write to the wire
+  uint16_t _nextPacketId;
+  MQTTQueueStats _stats;
+
+  Slot& slotAt(uint32_t seq) { return _slots[seq % MQTT_QUEUE_DEPTH]; }
+  uint16_t allocatePacketId();
+  void releaseAcked();
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Session Tap - Client wrapper that frames inbound packets for PUBACKs
+// ═══════════════════════════════════════════════════════════════════════════════
+class MQTTSessionTap : public Client {
+public:
+  MQTTSessionTap() : _transport(nullptr), _queue(nullptr) { resetFramer(); }
+
+  void setTransport(Client* transport) { _transport = transport; resetFramer(); }
+  void setQueue(MQTTOutboundQueue* queue) { _queue = queue; }
+
+  int connect(IPAddress ip, uint16_t port) override {
+    resetFramer();
+    return _transport ? _transport->connect(ip, port) : 0;
+  }
+  int connect(const char* host, uint16_t port) override {
+    resetFramer();
+    return _transport ? _transport->connect(host, port) : 0;
+  }
+  size_t write(uint8_t b) override { return _transport ? _transport->write(b) : 0; }
+  size_t write(const uint8_t* buf, size_t size) override {
+    return _transport ? _transport->write(buf, size) : 0;
+  }
+  int available() override { return _transport ? _transport->available() : 0; }
+  int read() override {
+    int b = _transport ? _transport->read() : -1;
+    if (b >= 0) feed((uint8_t)b);
+    return b;
+  }
+  int read(uint8_t* buf, size_t size) override {
+    int n = _transport ? _transport->read(buf, size) : -1;
+    for (int i = 0; i < n; i++) feed(buf[i]);
+    return n;
+  }
+  int peek() override { return _transport ? _transport->peek() : -1; }
+  void flush() override { if (_transport) _transport->flush(); }
+  void stop() override {
+    if (_transport) _transport->stop();
+    resetFramer();
+  }
+  uint8_t connected() override { return _transport ? _transport->connected() : 0; }
+  operator bool() override { return _transport && (bool)*_transport; }
+
+private:
+  enum FramerState : uint8_t { RX_HEADER, RX_LENGTH, RX_BODY };
+
+  Client* _transport;
+  MQTTOutboundQueue* _queue;
+
+  FramerState _rxState;
+  uint8_t _rxType;
+  uint8_t _rxShift;
+  uint32_t _rxLength;
+  uint32_t _rxPos;
+  uint16_t _rxPacketId;
+
+  void resetFramer() {
+    _rxState = RX_HEADER;
+    _rxType = 0;
+    _rxShift = 0;
+    _rxLength = 0;
+    _rxPos = 0;
+    _rxPacketId = 0;
+  }
+
+  void feed(uint8_t b);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation - Outbound Queue
+// ═══════════════════════════════════════════════════════════════════════════════
+
+MQTTOutboundQueue::MQTTOutboundQueue() {
+  _slots = nullptr;
+  _head = 0;
+  _tail = 0;
+  _next = 0;
+  _nextPacketId = 1;
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+bool MQTTOutboundQueue::begin() {
+  if (_slots) return true;
+
+  size_t bytes = sizeof(Slot) * MQTT_QUEUE_DEPTH;
+  #ifdef BOARD_HAS_PSRAM
+    _slots = (Slot*)ps_malloc(bytes);
+  #endif
+  if (!_slots) _slots = (Slot*)malloc(bytes);
+
+  if (!_slots) {
+    Serial.println("MQTT: Outbound queue allocation failed");
+    return false;
+  }
+
+  memset(_slots, 0, bytes);
+  Serial.printf("MQTT: QoS1 queue %d x %d B, window %d\n",
+                MQTT_QUEUE_DEPTH, MQTT_QUEUE_SLOT_SIZE, MQTT_INFLIGHT_WINDOW);
+  return true;
+}
+
+uint16_t MQTTOutboundQueue::allocatePacketId() {
+  uint16_t id = _nextPacketId++;
+  if (_nextPacketId == 0) _nextPacketId = 1; // 0 is not a valid packet identifier
+  return id;
+}
+
+bool MQTTOutboundQueue::enqueue(const char* topic, const uint8_t* payload, size_t length, bool retained) {
+  if (!_slots) return false;
+
+  size_t topicLength = strlen(topic);
+  size_t remaining = 2 + topicLength + 2 + length;
+  size_t lengthBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+  size_t total = 1 + lengthBytes + remaining;
+
+  if (total > MQTT_QUEUE_SLOT_SIZE) {
+    _stats.dropped++;
+    return false;
+  }
+
+  if (_head - _tail >= MQTT_QUEUE_DEPTH) {
+    // Evict the oldest message only if nothing is on the wire (offline backlog)
+    if (_next == _tail && slotAt(_tail).state == SLOT_QUEUED) {
+      slotAt(_tail).state = SLOT_FREE;
+      _tail++;
+      _next++;
+      _stats.dropped++;
+    } else {
+      _stats.dropped++;
+      return false;
+    }
+  }
+
+  Slot& s = slotAt(_head);
+  uint8_t* p = s.packet;
+
+  *p++ = 0x32 | (retained ? 0x01 : 0x00); // PUBLISH, QoS 1
+  do {
+    uint8_t digit = remaining & 0x7F;
+    remaining >>= 7;
+    if (remaining > 0) digit |= 0x80;
+    *p++ = digit;
+  } while (remaining > 0);
+
+  *p++ = (uint8_t)(topicLength >> 8);
+  *p++ = (uint8_t)(topicLength & 0xFF);
+  memcpy(p, topic, topicLength);
+  p += topicLength;
+
+  s.packetId = allocatePacketId();
+  *p++ = (uint8_t)(s.packetId >> 8);
+  *p++ = (uint8_t)(s.packetId & 0xFF);
+  memcpy(p, payload, length);
+  p += length;
+
+  s.length = (uint16_t)(p - s.packet);
+  s.state = SLOT_QUEUED;
+  s.sent = false;
+  s.sentAt = 0;
+
+  _head++;
+  _stats.enqueued++;
+  return true;
+}
+
+void MQTTOutboundQueue::pump(Client& transport) {
+  if (!_slots) return;
+
+  while (_stats.inFlight < MQTT_INFLIGHT_WINDOW && _next != _head) {
+    Slot& s = slotAt(_next);
+
+    if (s.state == SLOT_ACKED) {
+      _next++;
+      continue;
+    }
+
+    if (s.sent) {
+      s.packet[0] |= 0x08; // DUP
+      _stats.retransmitted++;
+    }
+
+    if (transport.write(s.packet, s.length) != s.length) {
+      // Connection is going down; the whole window is resent after reconnect
+      break;
+    }
+
+    s.state = SLOT_INFLIGHT;
+    s.sent = true;
+    s.sentAt = millis();
+    _next++;
+
+    _stats.inFlight++;
+    if (_stats.inFlight > _stats.peakInFlight) {
+      _stats.peakInFlight = _stats.inFlight;
+    }
+  }
+}
+
+void MQTTOutboundQueue::onPubAck(uint16_t packetId) {
+  if (!_slots) return;
+
+  for (uint32_t seq = _tail; seq != _next; seq++) {
+    Slot& s = slotAt(seq);
+    if (s.state == SLOT_INFLIGHT && s.packetId == packetId) {
+      s.state = SLOT_ACKED;
+      _stats.inFlight--;
+      _stats.acked++;
+
+      uint32_t latency = millis() - s.sentAt;
+      _stats.lastAckLatencyMs = latency;
+      _stats.avgAckLatencyMs = _stats.acked == 1
+        ? latency
+        : _stats.avgAckLatencyMs + ((int32_t)(latency - _stats.avgAckLatencyMs) >> 3);
+      break;
+    }
+  }
+
+  releaseAcked();
+}
+
+void MQTTOutboundQueue::releaseAcked() {
+  while (_tail != _next && slotAt(_tail).state == SLOT_ACKED) {
+    slotAt(_tail).state = SLOT_FREE;
+    _tail++;
+  }
+}
+
+void MQTTOutboundQueue::rewind() {
+  if (!_slots) return;
+
+  for (uint32_t seq = _tail; seq != _head; seq++) {
+    Slot& s = slotAt(seq);
+    if (s.state == SLOT_INFLIGHT) s.state = SLOT_QUEUED;
+  }
+  _next = _tail;
+  _stats.inFlight = 0;
+}
+
+size_t MQTTOutboundQueue::persist(Preferences& prefs) {
+  if (!_slots) return 0;
+
+  // Blob layout: [count:u16] then per message [flags:u8][length:u16][packet]
+  size_t bytes = 2;
+  uint16_t count = 0;
+  for (uint32_t seq = _tail; seq != _head; seq++) {
+    Slot& s = slotAt(seq);
+    if (s.state == SLOT_QUEUED || s.state == SLOT_INFLIGHT) {
+      bytes += 3 + s.length;
+      count++;
+    }
+  }
+
+  if (count == 0) {
+    prefs.remove("pending");
+    return 0;
+  }
+
+  uint8_t* blob = nullptr;
+  #ifdef BOARD_HAS_PSRAM
+    blob = (uint8_t*)ps_malloc(bytes);
+  #endif
+  if (!blob) blob = (uint8_t*)malloc(bytes);
+  if (!blob) return 0;
+
+  uint8_t* p = blob;
+  *p++ = (uint8_t)(count & 0xFF);
+  *p++ = (uint8_t)(count >> 8);
+  for (uint32_t seq = _tail; seq != _head; seq++) {
+    Slot& s = slotAt(seq);
+    if (s.state != SLOT_QUEUED && s.state != SLOT_INFLIGHT) continue;
+    *p++ = s.sent ? 0x01 : 0x00;
+    *p++ = (uint8_t)(s.length & 0xFF);
+    *p++ = (uint8_t)(s.length >> 8);
+    memcpy(p, s.packet, s.length);
+    p += s.length;
+  }
+
+  size_t written = prefs.putBytes("pending", blob, bytes);
+  free(blob);
+
+  Serial.printf("MQTT: Persisted %u unacknowledged messages (%u B)\n", count, (unsigned)written);
+  return count;
+}
+
+size_t MQTTOutboundQueue::restore(Preferences& prefs) {
+  if (!_slots) return 0;
+
+  size_t bytes = prefs.getBytesLength("pending");
+  if (bytes < 2) return 0;
+
+  uint8_t* blob = nullptr;
+  #ifdef BOARD_HAS_PSRAM
+    blob = (uint8_t*)ps_malloc(bytes);
+  #endif
+  if (!blob) blob = (uint8_t*)malloc(bytes);
+  if (!blob) return 0;
+
+  prefs.getBytes("pending", blob, bytes);
+  prefs.remove("pending"); // Never replay the same backlog twice
+
+  const uint8_t* p = blob;
+  const uint8_t* end = blob + bytes;
+  uint16_t count = p[0] | (p[1] << 8);
+  p += 2;
+
+  size_t restored = 0;
+  for (uint16_t i = 0; i < count && _head - _tail < MQTT_QUEUE_DEPTH; i++) {
+    if (end - p < 3) break;
+    bool sent = p[0] & 0x01;
+    uint16_t length = p[1] | (p[2] << 8);
+    p += 3;
+    if (length > MQTT_QUEUE_SLOT_SIZE || end - p < length) break;
+
+    Slot& s = slotAt(_head);
+    memcpy(s.packet, p, length);
+    p += length;
+    s.length = length;
+    s.state = SLOT_QUEUED;
+    s.sent = sent;
+    s.sentAt = 0;
+
+    // Packet identifier sits right after the topic
+    size_t lengthBytes = 1;
+    while (lengthBytes < 4 && (s.packet[lengthBytes] & 0x80)) lengthBytes++;
+    size_t topicAt = 1 + lengthBytes;
+    size_t topicLength = (s.packet[topicAt] << 8) | s.packet[topicAt + 1];
+    size_t idAt = topicAt + 2 + topicLength;
+    s.packetId = (s.packet[idAt] << 8) | s.packet[idAt + 1];
+    if (s.packetId >= _nextPacketId) {
+      _nextPacketId = s.packetId + 1;
+      if (_nextPacketId == 0) _nextPacketId = 1;
+    }
+
+    _head++;
+    restored++;
+  }
+  _next = _tail;
+
+  free(blob);
+
+  if (restored > 0) {
+    Serial.printf("MQTT: Restored %u unacknowledged messages\n", (unsigned)restored);
+  }
+  return restored;
+}
+
+MQTTQueueStats MQTTOutboundQueue::getStats() {
+  MQTTQueueStats stats = _stats;
+  stats.pending = (uint16_t)(_head - _tail);
+  return stats;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation - Session Tap
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void MQTTSessionTap::feed(uint8_t b) {
+  switch (_rxState) {
+    case RX_HEADER:
+      _rxType = b & 0xF0;
+      _rxLength = 0;
+      _rxShift = 0;
+      _rxState = RX_LENGTH;
+      break;
+
+    case RX_LENGTH:
+      _rxLength |= (uint32_t)(b & 0x7F) << _rxShift;
+      _rxShift += 7;
+      if (!(b & 0x80)) {
+        _rxPos = 0;
+        _rxPacketId = 0;
+        _rxState = _rxLength > 0 ? RX_BODY : RX_HEADER;
+      } else if (_rxShift > 21) {
+        resetFramer(); // Malformed length - resync on the next packet
+      }
+      break;
+
+    case RX_BODY:
+      if (_rxType == 0x40 && _rxPos < 2) {
+        _rxPacketId = (_rxPacketId << 8) | b;
+      }
+      if (++_rxPos >= _rxLength) {
+        if (_rxType == 0x40 && _rxLength == 2 && _queue) {
+          _queue->onPubAck(_rxPacketId);
+        }
+        _rxState = RX_HEADER;
+      }
+      break;
+  }
+}
+
+#endif // MQTT_SESSION_H
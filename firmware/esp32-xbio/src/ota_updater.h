@@ -1,7 +1,26 @@
 /**
  * ═══════════════════════════════════════════════════════════════════════════════
  * 📲 OTA Updater - Over-The-Air Firmware Updates
+ * HTTP(S) downloads run in a background task: bounded buffer, streaming
+ * SHA-256 / signature check, throttled so sampling and telemetry keep going
  * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Progress is published through a SeqLock so loop() can report it on the
+ * status topic without touching the download task. The task never reboots;
+ * loop() does that once it sees SUCCESS, after flushing the MQTT queue.
+ *
+ * Signing (when ota_pubkey is provisioned, the signature is mandatory):
+ *   openssl dgst -sha256 -sign ota_key.pem firmware.bin | xxd -p | tr -d '\n'
+ *
+ * Delta updates: with a patch URL (tools/xbio_delta.cpp) the new image is
+ * rebuilt from the running partition through DeltaPatcher and streamed into
+ * Update. Hash and signature checks cover the rebuilt image, so one signature
+ * serves both paths. If the running image is not the patch base, or the result
+ * does not match, the task falls back to the full image URL.
+ *
+ * Compressed images: a URL serving XBZ1 (tools/xbio_compress.cpp) is
+ * recognised by its first byte (plain images start with 0xE9) and decoded
+ * through a 4 KB LZSS window into Update. Works for any image, no base needed.
  */
 
 #ifndef OTA_UPDATER_H
@@ -9,23 +28,113 @@
 
 #include <Arduino.h>
 #include <ArduinoOTA.h>
-#include <HTTPUpdate.h>
+#include <HTTPClient.h>
+#include <Update.h>
+#include <WiFiClientSecure.h>
+#include <new>
+#include <mbedtls/sha256.h>
+#include <mbedtls/pk.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include "delta_patch.h"
+#include "lzss_stream.h"
+#include "seqlock.h"
+
+#ifndef OTA_CHUNK_SIZE
+  #define OTA_CHUNK_SIZE 4096         // Download buffer - one flash sector
+#endif
+
+#ifndef OTA_TASK_STACK
+  #define OTA_TASK_STACK 12288        // Room for a TLS handshake
+#endif
+
+#ifndef OTA_TASK_PRIORITY
+  #define OTA_TASK_PRIORITY 1         // Below the loop task, so sampling wins
+#endif
+
+#ifndef OTA_STALL_TIMEOUT
+  #define OTA_STALL_TIMEOUT 15000     // No data for this long -> abort
+#endif
+
+enum class OTAState : uint8_t {
+  IDLE = 0,
+  DOWNLOADING,
+  VERIFYING,
+  SUCCESS,
+  FAILED
+};
+
+enum class OTAFormat : uint8_t {
+  IMAGE = 0,                  // Plain .bin
+  DELTA,                      // XBD1 patch against the running image
+  COMPRESSED                  // XBZ1 LZSS image
+};
+
+struct OTAProgress {
+  OTAState state;
+  OTAFormat format;
+  bool verified;              // Hash and/or signature checked
+  uint32_t received;          // Downloaded bytes (patch / compressed / image)
+  uint32_t total;             // 0 if the server sent no Content-Length
+  uint32_t written;           // Image bytes written to flash
+  uint32_t bytesPerSec;       // Download rate
+  uint32_t decodeBytesPerSec; // Patch/LZSS output per CPU second, flash writes excluded
+  uint32_t elapsedMs;
+  char error[48];
+};
+
+// Running app partition as the patch base
+class OTAPartitionSource : public DeltaSource {
+public:
+  explicit OTAPartitionSource(const esp_partition_t* partition) : _partition(partition) {}
+  bool read(uint32_t offset, uint8_t* out, size_t length) override {
+    return _partition && esp_partition_read(_partition, offset, out, length) == ESP_OK;
+  }
+
+private:
+  const esp_partition_t* _partition;
+};
+
+// Checks the patch base, then hashes and writes the rebuilt / decoded image
+class OTAUpdateSink : public DeltaSink, public LzssSink {
+public:
+  OTAUpdateSink(const esp_partition_t* base, mbedtls_sha256_context* sha)
+    : error(nullptr), writeUs(0), _base(base), _sha(sha) {}
+  bool begin(const DeltaHeader& header) override;
+  bool begin(const LzssHeader& header) override;
+  bool write(const uint8_t* data, size_t length) override;
+
+  const char* error;            // Set when begin()/write() refuse
+  uint32_t writeUs;             // Time spent in Update.write
+
+private:
+  const esp_partition_t* _base;
+  mbedtls_sha256_context* _sha;
+};
 
 class XBioOTAUpdater {
 public:
-  XBioOTAUpdater() : _initialized(false), _updating(false) {}
-  
+  XBioOTAUpdater() : _initialized(false), _updating(false), _downloading(false), _rateLimit(0),
+                     _hasHash(false), _signatureLength(0), _sha(nullptr), _sink(nullptr),
+                     _patcher(nullptr), _decoder(nullptr), _decodeUs(0) {
+    memset(_url, 0, sizeof(_url));
+    memset(_patchUrl, 0, sizeof(_patchUrl));
+    memset(_hash, 0, sizeof(_hash));
+    OTAProgress idle = {};
+    _progress.write(idle);
+  }
+
   void begin(const char* hostname) {
     ArduinoOTA.setHostname(hostname);
     ArduinoOTA.setPassword("xbio_ota_2024");
-    
-    ArduinoOTA.onStart([this]() { 
-      _updating = true; 
-      Serial.println("OTA: Update started"); 
+
+    ArduinoOTA.onStart([this]() {
+      _updating = true;
+      Serial.println("OTA: Update started");
     });
-    ArduinoOTA.onEnd([this]() { 
-      _updating = false; 
-      Serial.println("OTA: Update complete"); 
+    ArduinoOTA.onEnd([this]() {
+      _updating = false;
+      Serial.println("OTA: Update complete");
     });
     ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
       Serial.printf("OTA: %u%%\r", (progress / (total / 100)));
@@ -34,40 +143,516 @@ public:
       _updating = false;
       Serial.printf("OTA: Error[%u]\n", error);
     });
-    
+
     ArduinoOTA.begin();
     _initialized = true;
   }
-  
-  void loop() { if (_initialized && !_updating) ArduinoOTA.handle(); }
-  
-  void startUpdate(String url) {
-    if (url.isEmpty()) return;
-    Serial.printf("OTA: Starting HTTP update from %s\n", url.c_str());
-    
-    WiFiClient client;
-    t_httpUpdate_return ret = httpUpdate.update(client, url);
-    
-    switch (ret) {
-      case HTTP_UPDATE_FAILED:
-        Serial.printf("OTA: HTTP Update failed (%d): %s\n", 
-          httpUpdate.getLastError(), httpUpdate.getLastErrorString().c_str());
-        break;
-      case HTTP_UPDATE_NO_UPDATES:
-        Serial.println("OTA: No updates available");
-        break;
-      case HTTP_UPDATE_OK:
-        Serial.println("OTA: Update successful, rebooting...");
-        ESP.restart();
-        break;
+
+  /**
+   * Trust material for HTTP updates
+   * @param caCert CA for https:// URLs (empty = no server verification, image checks still apply)
+   * @param publicKey PEM key images must be signed with (empty = hash only)
+   * @param rateKBps Download throttle, 0 = unlimited
+   */
+  void setTrust(const String& caCert, const String& publicKey, uint16_t rateKBps) {
+    _caCert = caCert;
+    _publicKey = publicKey;
+    _rateLimit = (uint32_t)rateKBps * 1024;
+  }
+
+  // ArduinoOTA shares the Update writer, so it pauses while a download runs
+  void loop() { if (_initialized && !_updating && !isDownloading()) ArduinoOTA.handle(); }
+
+  /**
+   * Start a background HTTP(S) update - returns immediately
+   * @param sha256Hex Expected image SHA-256 (optional)
+   * @param signatureHex DER ECDSA signature over the SHA-256 (required if a public key is set)
+   * @param patchUrl Delta patch against the running image, tried before url (optional)
+   */
+  bool startUpdate(const char* url, const char* sha256Hex = "", const char* signatureHex = "",
+                   const char* patchUrl = "");
+
+  bool isUpdating() { return _updating || isDownloading(); }
+  bool isDownloading() { return _downloading; }
+
+  /**
+   * Lock-free progress snapshot - any task
+   */
+  OTAProgress getProgress() { return _progress.read(); }
+  uint32_t progressVersion() { return _progress.version(); }
+
+  static const char* formatName(OTAFormat format) {
+    switch (format) {
+      case OTAFormat::DELTA: return "delta";
+      case OTAFormat::COMPRESSED: return "xbz";
+      default: return "image";
+    }
+  }
+
+  static const char* stateName(OTAState state) {
+    switch (state) {
+      case OTAState::DOWNLOADING: return "downloading";
+      case OTAState::VERIFYING: return "verifying";
+      case OTAState::SUCCESS: return "success";
+      case OTAState::FAILED: return "failed";
+      default: return "idle";
     }
   }
-  
-  bool isUpdating() { return _updating; }
-  
+
 private:
   bool _initialized;
-  bool _updating;
+  bool _updating;               // ArduinoOTA in progress
+  volatile bool _downloading;   // HTTP download task alive
+
+  String _caCert;
+  String _publicKey;
+  uint32_t _rateLimit;          // Bytes/s, 0 = unlimited
+
+  char _url[256];
+  char _patchUrl[256];
+  bool _hasHash;
+  uint8_t _hash[32];
+  uint8_t _signature[128];      // DER ECDSA up to P-384
+  size_t _signatureLength;
+
+  SeqLock<OTAProgress> _progress;
+  OTAProgress _state;           // Task-owned working copy
+
+  // Task-owned while a transfer runs
+  mbedtls_sha256_context* _sha;
+  OTAUpdateSink* _sink;
+  DeltaPatcher* _patcher;
+  LzssDecoder* _decoder;
+  uint32_t _decodeUs;
+
+  static void taskEntry(void* arg);
+  void runDownload();
+  bool runTransfer(const char* url, bool delta);
+  bool download(HTTPClient& http);
+  bool consume(uint8_t* data, size_t length);
+  int peekFirstByte(WiFiClient* stream);
+  bool verify(const uint8_t* digest);
+  void setState(OTAState state, const char* error = nullptr);
+  static size_t parseHex(const char* hex, uint8_t* out, size_t size);
 };
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool OTAUpdateSink::begin(const DeltaHeader& header) {
+  if (!_base || header.oldSize > _base->size) {
+    error = "base image mismatch";
+    return false;
+  }
+
+  // The patch only applies to the exact image it was built from
+  uint8_t buffer[512];
+  uint8_t digest[32];
+  mbedtls_sha256_context base;
+  mbedtls_sha256_init(&base);
+  #if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_starts(&base, 0);
+  #else
+    mbedtls_sha256_starts_ret(&base, 0);
+  #endif
+  bool readOk = true;
+  for (uint32_t offset = 0; offset < header.oldSize && readOk; offset += sizeof(buffer)) {
+    size_t n = min((uint32_t)sizeof(buffer), header.oldSize - offset);
+    readOk = esp_partition_read(_base, offset, buffer, n) == ESP_OK;
+    #if MBEDTLS_VERSION_MAJOR >= 3
+      mbedtls_sha256_update(&base, buffer, n);
+    #else
+      mbedtls_sha256_update_ret(&base, buffer, n);
+    #endif
+  }
+  #if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_finish(&base, digest);
+  #else
+    mbedtls_sha256_finish_ret(&base, digest);
+  #endif
+  mbedtls_sha256_free(&base);
+
+  if (!readOk || memcmp(digest, header.oldHash, sizeof(digest)) != 0) {
+    error = "base image mismatch";
+    return false;
+  }
+
+  if (!Update.begin(header.newSize)) {
+    error = Update.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool OTAUpdateSink::begin(const LzssHeader& header) {
+  if (!Update.begin(header.imageSize)) {
+    error = Update.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool OTAUpdateSink::write(const uint8_t* data, size_t length) {
+  #if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_update(_sha, data, length);
+  #else
+    mbedtls_sha256_update_ret(_sha, data, length);
+  #endif
+  uint32_t start = micros();
+  size_t written = Update.write((uint8_t*)data, length);
+  writeUs += micros() - start;
+  if (written != length) {
+    error = Update.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool XBioOTAUpdater::startUpdate(const char* url, const char* sha256Hex, const char* signatureHex,
+                                 const char* patchUrl) {
+  if (!url || !url[0]) return false;
+  if (isUpdating()) {
+    Serial.println("OTA: Update already in progress");
+    return false;
+  }
+
+  _hasHash = sha256Hex && sha256Hex[0];
+  if (_hasHash && parseHex(sha256Hex, _hash, sizeof(_hash)) != sizeof(_hash)) {
+    Serial.println("OTA: Invalid sha256");
+    return false;
+  }
+  _signatureLength = signatureHex && signatureHex[0] ? parseHex(signatureHex, _signature, sizeof(_signature)) : 0;
+  if (!_publicKey.isEmpty() && _signatureLength == 0) {
+    Serial.println("OTA: Signature required");
+    return false;
+  }
+  if (_publicKey.isEmpty() && _signatureLength > 0) {
+    // Nothing to check it against - never report it as verified
+    Serial.println("OTA: ⚠️ Signature ignored - no public key provisioned");
+    _signatureLength = 0;
+  }
+
+  strncpy(_url, url, sizeof(_url) - 1);
+  _url[sizeof(_url) - 1] = '\0';
+  strncpy(_patchUrl, patchUrl ? patchUrl : "", sizeof(_patchUrl) - 1);
+  _patchUrl[sizeof(_patchUrl) - 1] = '\0';
+
+  memset(&_state, 0, sizeof(_state));
+  setState(OTAState::DOWNLOADING);
+
+  _downloading = true;
+  if (xTaskCreatePinnedToCore(taskEntry, "xbio-ota", OTA_TASK_STACK, this,
+                              OTA_TASK_PRIORITY, nullptr, 0) != pdPASS) {
+    _downloading = false;
+    setState(OTAState::FAILED, "task create failed");
+    return false;
+  }
+
+  Serial.printf("OTA: Background update from %s (%s%s)\n", _patchUrl[0] ? _patchUrl : _url,
+                _signatureLength ? "signed" : _hasHash ? "sha256" : "unverified", _patchUrl[0] ? ", delta" : "");
+  return true;
+}
+
+void XBioOTAUpdater::taskEntry(void* arg) {
+  XBioOTAUpdater* self = (XBioOTAUpdater*)arg;
+  self->runDownload();
+  self->_downloading = false;
+  vTaskDelete(nullptr);
+}
+
+void XBioOTAUpdater::runDownload() {
+  if (_patchUrl[0]) {
+    if (runTransfer(_patchUrl, true)) return;
+    Serial.printf("OTA: Delta update failed (%s) - falling back to full image\n", _state.error);
+    memset(&_state, 0, sizeof(_state));
+    setState(OTAState::DOWNLOADING);
+  }
+  runTransfer(_url, false);
+}
+
+bool XBioOTAUpdater::runTransfer(const char* url, bool delta) {
+  _state.format = delta ? OTAFormat::DELTA : OTAFormat::IMAGE;
+
+  bool https = strncmp(url, "https://", 8) == 0;
+  WiFiClient plain;
+  WiFiClientSecure secure;
+  if (https) {
+    if (_caCert.isEmpty()) {
+      secure.setInsecure(); // Transport unauthenticated; the image hash/signature still gate the install
+    } else {
+      secure.setCACert(_caCert.c_str());
+    }
+  }
+
+  HTTPClient http;
+  http.setTimeout(OTA_STALL_TIMEOUT);
+  http.useHTTP10(true); // download() reads the raw stream - a chunked body would be written as image data
+  if (!http.begin(https ? (WiFiClient&)secure : plain, url)) {
+    setState(OTAState::FAILED, "bad url");
+    return false;
+  }
+
+  int code = http.GET();
+  if (code != HTTP_CODE_OK) {
+    char error[32];
+    snprintf(error, sizeof(error), "http %d", code);
+    setState(OTAState::FAILED, error);
+    http.end();
+    return false;
+  }
+
+  int size = http.getSize();
+  _state.total = size > 0 ? size : 0;
+
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  #if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_starts(&sha, 0);
+  #else
+    mbedtls_sha256_starts_ret(&sha, 0);
+  #endif
+
+  // Delta/XBZ: the sink hashes and writes what the decoder produces; plain: consume() does
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  OTAPartitionSource source(running);
+  OTAUpdateSink sink(running, &sha);
+  _sha = &sha;
+  _sink = &sink;
+  _patcher = nullptr;
+  _decoder = nullptr;
+  _decodeUs = 0;
+
+  bool ok = true;
+  if (delta) {
+    _patcher = new (std::nothrow) DeltaPatcher();
+    if (_patcher) _patcher->begin(&source, &sink);
+  } else {
+    // XBZ1 starts with 'X', ESP images with 0xE9
+    int first = peekFirstByte(http.getStreamPtr());
+    if (first < 0) {
+      setState(OTAState::FAILED, "download stalled");
+      ok = false;
+    } else if (first == LZSS_MAGIC[0]) {
+      _state.format = OTAFormat::COMPRESSED;
+      _decoder = new (std::nothrow) LzssDecoder();
+      if (_decoder) _decoder->begin(&sink);
+    } else if (!Update.begin(size > 0 ? size : UPDATE_SIZE_UNKNOWN)) {
+      setState(OTAState::FAILED, Update.errorString());
+      ok = false;
+    }
+  }
+  if (ok && _state.format != OTAFormat::IMAGE && !_patcher && !_decoder) {
+    setState(OTAState::FAILED, "no memory");
+    ok = false;
+  }
+
+  if (ok) ok = download(http);
+  http.end();
+  if (!ok && sink.error) setState(OTAState::FAILED, sink.error);
+
+  bool complete = _patcher ? _patcher->finished() : _decoder ? _decoder->finished() : true;
+  if (ok && !complete) {
+    setState(OTAState::FAILED, _patcher ? "truncated patch" : "truncated image");
+    ok = false;
+  }
+
+  uint8_t digest[32];
+  #if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_finish(&sha, digest);
+  #else
+    mbedtls_sha256_finish_ret(&sha, digest);
+  #endif
+  mbedtls_sha256_free(&sha);
+
+  // Embedded hashes catch a wrong base or a damaged stream before the command's checks
+  const uint8_t* expected = _patcher ? _patcher->header().newHash : _decoder ? _decoder->header().imageHash : nullptr;
+  if (ok && expected && memcmp(digest, expected, sizeof(digest)) != 0) {
+    setState(OTAState::FAILED, _patcher ? "patched image mismatch" : "decoded image mismatch");
+    ok = false;
+  }
+  delete _patcher;
+  delete _decoder;
+  _patcher = nullptr;
+  _decoder = nullptr;
+  _sink = nullptr;
+  _sha = nullptr;
+
+  if (ok) {
+    setState(OTAState::VERIFYING);
+    ok = verify(digest);
+  }
+
+  if (!ok) {
+    Update.abort();
+    Serial.printf("OTA: Failed - %s\n", _state.error);
+    return false;
+  }
+
+  if (!Update.end(true)) {
+    setState(OTAState::FAILED, Update.errorString());
+    return false;
+  }
+
+  _state.verified = _hasHash || (_signatureLength > 0 && !_publicKey.isEmpty());
+  setState(OTAState::SUCCESS);
+  Serial.printf("OTA: Image written (%s, %u bytes from %u downloaded = %u%%, %u B/s download",
+                formatName(_state.format), _state.written, _state.received,
+                _state.written ? (unsigned)((uint64_t)_state.received * 100 / _state.written) : 0,
+                _state.bytesPerSec);
+  if (_state.format != OTAFormat::IMAGE) Serial.printf(", %u B/s decode", _state.decodeBytesPerSec);
+  Serial.println(")");
+  return true;
+}
+
+bool XBioOTAUpdater::download(HTTPClient& http) {
+  uint8_t* buffer = (uint8_t*)malloc(OTA_CHUNK_SIZE);
+  if (!buffer) {
+    setState(OTAState::FAILED, "no memory");
+    return false;
+  }
+
+  WiFiClient* stream = http.getStreamPtr();
+  uint32_t start = millis();
+  uint32_t lastData = start;
+  bool ok = true;
+
+  while (_state.total == 0 || _state.received < _state.total) {
+    size_t available = stream->available();
+    if (available == 0) {
+      if (!stream->connected() && _state.total == 0) break; // Close-delimited body finished
+      if (!stream->connected() || millis() - lastData > OTA_STALL_TIMEOUT) {
+        setState(OTAState::FAILED, "download stalled");
+        ok = false;
+        break;
+      }
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+
+    size_t want = available < OTA_CHUNK_SIZE ? available : OTA_CHUNK_SIZE;
+    if (_state.total) want = min(want, (size_t)(_state.total - _state.received));
+    int n = stream->readBytes(buffer, want);
+    if (n <= 0) continue;
+    lastData = millis();
+
+    if (!consume(buffer, n)) {
+      ok = false;
+      break;
+    }
+
+    _state.received += n;
+    _state.elapsedMs = millis() - start;
+    _state.bytesPerSec = _state.elapsedMs ? (uint64_t)_state.received * 1000 / _state.elapsedMs : 0;
+    _progress.write(_state);
+
+    // Throttle: stay on the rate line so MQTT/WS traffic keeps getting airtime
+    if (_rateLimit) {
+      uint32_t due = (uint64_t)_state.received * 1000 / _rateLimit;
+      if (due > _state.elapsedMs) vTaskDelay(pdMS_TO_TICKS(due - _state.elapsedMs));
+    } else {
+      taskYIELD();
+    }
+  }
+
+  free(buffer);
+  return ok;
+}
+
+bool XBioOTAUpdater::consume(uint8_t* data, size_t length) {
+  if (!_patcher && !_decoder) {
+    #if MBEDTLS_VERSION_MAJOR >= 3
+      mbedtls_sha256_update(_sha, data, length);
+    #else
+      mbedtls_sha256_update_ret(_sha, data, length);
+    #endif
+    if (Update.write(data, length) != length) {
+      setState(OTAState::FAILED, Update.errorString());
+      return false;
+    }
+    _state.written += length;
+    return true;
+  }
+
+  uint32_t writeUs = _sink->writeUs;
+  uint32_t start = micros();
+  bool ok = _patcher ? _patcher->feed(data, length) : _decoder->feed(data, length);
+  _decodeUs += (micros() - start) - (_sink->writeUs - writeUs);
+
+  if (!ok) {
+    setState(OTAState::FAILED, _patcher ? DeltaPatcher::errorName(_patcher->error())
+                                        : LzssDecoder::errorName(_decoder->error()));
+    return false;
+  }
+  _state.written = _patcher ? _patcher->produced() : _decoder->produced();
+  _state.decodeBytesPerSec = _decodeUs ? (uint64_t)_state.written * 1000000 / _decodeUs : 0;
+  return true;
+}
+
+int XBioOTAUpdater::peekFirstByte(WiFiClient* stream) {
+  uint32_t start = millis();
+  while (stream->available() == 0) {
+    if (!stream->connected() || millis() - start > OTA_STALL_TIMEOUT) return -1;
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  return stream->peek();
+}
+
+bool XBioOTAUpdater::verify(const uint8_t* digest) {
+  if (_hasHash && memcmp(digest, _hash, sizeof(_hash)) != 0) {
+    setState(OTAState::FAILED, "sha256 mismatch");
+    return false;
+  }
+
+  if (_publicKey.isEmpty()) return true;
+
+  mbedtls_pk_context pk;
+  mbedtls_pk_init(&pk);
+  int ret = mbedtls_pk_parse_public_key(&pk, (const unsigned char*)_publicKey.c_str(), _publicKey.length() + 1);
+  if (ret == 0) {
+    ret = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, 32, _signature, _signatureLength);
+  }
+  mbedtls_pk_free(&pk);
+
+  if (ret != 0) {
+    setState(OTAState::FAILED, "bad signature");
+    return false;
+  }
+  return true;
+}
+
+void XBioOTAUpdater::setState(OTAState state, const char* error) {
+  _state.state = state;
+  if (error) {
+    strncpy(_state.error, error, sizeof(_state.error) - 1);
+    _state.error[sizeof(_state.error) - 1] = '\0';
+  }
+  // A failed patch is not terminal (the full image follows), so loop() never sees it
+  if (state == OTAState::FAILED && _state.format == OTAFormat::DELTA) return;
+  _progress.write(_state);
+}
+
+size_t XBioOTAUpdater::parseHex(const char* hex, uint8_t* out, size_t size) {
+  size_t count = 0;
+  int high = -1;
+  for (const char* p = hex; *p; p++) {
+    char c = *p;
+    int v = (c >= '0' && c <= '9') ? c - '0' :
+            (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+            (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+    if (v < 0) {
+      if (c == ':' || c == ' ') continue;
+      return 0;
+    }
+    if (high < 0) {
+      if (count == size) return 0; // Longer than the buffer
+      high = v;
+    } else {
+      out[count++] = (uint8_t)((high << 4) | v);
+      high = -1;
+    }
+  }
+  return high < 0 ? count : 0;
+}
+
 #endif
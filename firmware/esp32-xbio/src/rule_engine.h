@@ -0,0 +1,293 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 📜 Rule Engine - Pushed Alert Rules, Evaluated Every Sample
+ * RuleVM programs in fixed slots, persisted in NVS, hold / clear timing
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * The server pushes compiled rules with rule_set (see rule_vm.h for the
+ * format); each goes into one of RULE_MAX_RULES fixed slots and its own NVS
+ * key, so rules survive reboots and no slot ever allocates. A rule raises
+ * once its program has been true for holdSeconds and clears after it has
+ * been false for clearSeconds; raise / clear go to the event callback.
+ *
+ * rate(x) is the change per hour between the oldest and newest aggregate
+ * window averages kept in a short history (pressure trends, slow leaks).
+ *
+ * Evaluation cost is measured per rule with the CPU cycle counter (a rule
+ * is well under a microsecond) and reported in status.
+ *
+ * Loop task only.
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "bme688_driver.h"
+#include "sample_store.h"
+#include "rule_vm.h"
+
+#ifndef RULE_MAX_RULES
+  #define RULE_MAX_RULES 8
+#endif
+
+#ifndef RULE_RATE_WINDOWS
+  #define RULE_RATE_WINDOWS 30          // Aggregate windows kept for rate() (30 min at 60 s)
+#endif
+
+enum class RuleEventKind : uint8_t {
+  RAISED,
+  CLEARED
+};
+
+struct RuleEvent {
+  uint8_t slot;
+  const char* name;
+  RuleEventKind kind;
+  float value;
+  float threshold;
+  uint32_t seq;                 // Monotonic across rule events, lets the server spot gaps
+  uint32_t timestamp;           // millis() when the rule fired or cleared
+};
+
+struct RuleStats {
+  uint8_t loaded;
+  uint8_t active;
+  uint32_t evaluations;         // Per rule, summed
+  uint32_t lastNs;              // All rules, last sample
+  uint32_t maxNs;               // Slowest single rule so far
+  uint32_t avgNs;               // Mean cost of one rule evaluation
+};
+
+typedef void (*RuleEventCallback)(const RuleEvent& event);
+
+class RuleEngine {
+public:
+  RuleEngine() : _callback(nullptr), _seq(0), _lastWindow(0), _rateHead(0), _rateCount(0), _totalCycles(0) {
+    memset(_slots, 0, sizeof(_slots));
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+  void begin();
+  void setEventCallback(RuleEventCallback callback) { _callback = callback; }
+
+  /**
+   * Install a rule blob in a slot (replaces what was there) and persist it
+   * @return nullptr on success, otherwise why it was rejected
+   */
+  const char* set(uint8_t slot, const uint8_t* blob, size_t length);
+  bool clear(uint8_t slot);
+
+  /**
+   * Evaluate every loaded rule against one sample
+   */
+  void evaluate(const SensorData& data, const SensorAggregates& aggregates);
+
+  bool isLoaded(uint8_t slot) const { return slot < RULE_MAX_RULES && _slots[slot].loaded; }
+  const RuleProgram& program(uint8_t slot) const { return _slots[slot].program; }
+  RuleStats getStats() const;
+  uint32_t lastSeq() const { return _seq; }
+
+private:
+  struct Slot {
+    bool loaded;
+    bool active;
+    uint32_t since;             // millis() the current condition state began, 0 = unset
+    RuleResult last;
+    RuleProgram program;
+  };
+
+  Preferences _prefs;
+  RuleEventCallback _callback;
+  uint32_t _seq;
+  Slot _slots[RULE_MAX_RULES];
+
+  // Window averages for rate(): [window][T, H, P, IAQ]
+  float _rateAvg[RULE_RATE_WINDOWS][4];
+  uint32_t _rateAt[RULE_RATE_WINDOWS];
+  uint32_t _lastWindow;
+  uint8_t _rateHead;
+  uint8_t _rateCount;
+
+  RuleStats _stats;
+  uint64_t _totalCycles;
+
+  void trackRates(const SensorAggregates& aggregates);
+  void buildContext(const SensorData& data, const SensorAggregates& aggregates, RuleContext& context) const;
+  void emit(uint8_t slot, RuleEventKind kind, uint32_t timestamp);
+
+  static void key(uint8_t slot, char* out) { snprintf(out, 4, "r%u", slot); }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void RuleEngine::begin() {
+  _prefs.begin("xbio_rules", false);
+
+  for (uint8_t s = 0; s < RULE_MAX_RULES; s++) {
+    char name[4];
+    key(s, name);
+    size_t length = _prefs.getBytesLength(name);
+    if (length == 0) continue;
+
+    uint8_t blob[RULE_BLOB_MAX];
+    if (length > sizeof(blob) || _prefs.getBytes(name, blob, length) != length) continue;
+    const char* error = RuleVM::load(blob, length, &_slots[s].program);
+    if (error) {
+      Serial.printf("RULES: Slot %u invalid (%s) - ignored\n", s, error);
+      continue;
+    }
+    _slots[s].loaded = true;
+    Serial.printf("RULES: Slot %u \"%s\" (%u ops)\n", s, _slots[s].program.name, _slots[s].program.ops);
+  }
+}
+
+const char* RuleEngine::set(uint8_t slot, const uint8_t* blob, size_t length) {
+  if (slot >= RULE_MAX_RULES) return "bad slot";
+
+  RuleProgram program;
+  const char* error = RuleVM::load(blob, length, &program);
+  if (error) return error;
+
+  char name[4];
+  key(slot, name);
+  if (_prefs.putBytes(name, blob, length) != length) return "NVS write failed";
+
+  // A replaced rule starts from scratch; clear its old alert first
+  if (_slots[slot].loaded && _slots[slot].active) emit(slot, RuleEventKind::CLEARED, millis());
+  Slot& s = _slots[slot];
+  memset(&s, 0, sizeof(s));
+  s.program = program;
+  s.loaded = true;
+  Serial.printf("RULES: Slot %u = \"%s\" (%u ops, hold %us)\n", slot, program.name, program.ops, program.holdSeconds);
+  return nullptr;
+}
+
+bool RuleEngine::clear(uint8_t slot) {
+  if (slot >= RULE_MAX_RULES || !_slots[slot].loaded) return false;
+  if (_slots[slot].active) emit(slot, RuleEventKind::CLEARED, millis());
+
+  char name[4];
+  key(slot, name);
+  _prefs.remove(name);
+  memset(&_slots[slot], 0, sizeof(_slots[slot]));
+  Serial.printf("RULES: Slot %u cleared\n", slot);
+  return true;
+}
+
+void RuleEngine::evaluate(const SensorData& data, const SensorAggregates& aggregates) {
+  if (!data.valid) return;
+  trackRates(aggregates);
+
+  RuleContext context;
+  buildContext(data, aggregates, context);
+
+  uint32_t now = millis();
+  if (now == 0) now = 1;
+  uint32_t sampleCycles = 0;
+  uint32_t mhz = ESP.getCpuFreqMHz();
+
+  for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+    Slot& s = _slots[i];
+    if (!s.loaded) continue;
+
+    uint32_t start = ESP.getCycleCount();
+    RuleResult result = RuleVM::run(s.program, context);
+    uint32_t cycles = ESP.getCycleCount() - start;
+    sampleCycles += cycles;
+    _totalCycles += cycles;
+    _stats.evaluations++;
+    uint32_t ns = (uint32_t)((uint64_t)cycles * 1000 / mhz);
+    if (ns > _stats.maxNs) _stats.maxNs = ns;
+
+    // since tracks how long the result has differed from the current state
+    if (result.fired == s.active) {
+      s.since = 0;
+      if (result.fired) s.last = result;
+      continue;
+    }
+    if (s.since == 0) s.since = now;
+    uint32_t needMs = (uint32_t)(s.active ? s.program.clearSeconds : s.program.holdSeconds) * 1000;
+    if (now - s.since < needMs) continue;
+
+    s.active = result.fired;
+    s.since = 0;
+    if (result.fired) s.last = result;
+    emit(i, s.active ? RuleEventKind::RAISED : RuleEventKind::CLEARED, now);
+  }
+  _stats.lastNs = (uint32_t)((uint64_t)sampleCycles * 1000 / mhz);
+}
+
+void RuleEngine::trackRates(const SensorAggregates& aggregates) {
+  if (aggregates.count == 0 || aggregates.windowStart == _lastWindow) return;
+  _lastWindow = aggregates.windowStart;
+
+  float* avg = _rateAvg[_rateHead];
+  avg[0] = aggregates.temperature.avg;
+  avg[1] = aggregates.humidity.avg;
+  avg[2] = aggregates.pressure.avg;
+  avg[3] = aggregates.iaq.avg;
+  _rateAt[_rateHead] = aggregates.windowStart + aggregates.windowMs / 2;
+  _rateHead = (_rateHead + 1) % RULE_RATE_WINDOWS;
+  if (_rateCount < RULE_RATE_WINDOWS) _rateCount++;
+}
+
+void RuleEngine::buildContext(const SensorData& data, const SensorAggregates& aggregates, RuleContext& context) const {
+  context.clear();
+  context.set(RuleSource::VALUE, RuleVar::TEMPERATURE, data.temperature);
+  context.set(RuleSource::VALUE, RuleVar::HUMIDITY, data.humidity);
+  context.set(RuleSource::VALUE, RuleVar::PRESSURE, data.pressure);
+  context.set(RuleSource::VALUE, RuleVar::GAS, data.gasResistance);
+  context.set(RuleSource::VALUE, RuleVar::IAQ, data.iaq);
+  context.set(RuleSource::VALUE, RuleVar::CO2, data.co2Equivalent);
+  context.set(RuleSource::VALUE, RuleVar::VOC, data.vocEquivalent);
+
+  static const RuleVar windowed[] = {RuleVar::TEMPERATURE, RuleVar::HUMIDITY, RuleVar::PRESSURE, RuleVar::IAQ};
+  const SensorStat* stats[] = {&aggregates.temperature, &aggregates.humidity, &aggregates.pressure, &aggregates.iaq};
+  if (aggregates.count > 0) {
+    for (uint8_t v = 0; v < 4; v++) {
+      context.set(RuleSource::WIN_MIN, windowed[v], stats[v]->min);
+      context.set(RuleSource::WIN_AVG, windowed[v], stats[v]->avg);
+      context.set(RuleSource::WIN_MAX, windowed[v], stats[v]->max);
+    }
+  }
+
+  if (_rateCount >= 2) {
+    uint8_t newest = (_rateHead + RULE_RATE_WINDOWS - 1) % RULE_RATE_WINDOWS;
+    uint8_t oldest = (_rateHead + RULE_RATE_WINDOWS - _rateCount) % RULE_RATE_WINDOWS;
+    float hours = (_rateAt[newest] - _rateAt[oldest]) / 3600000.0f;
+    if (hours > 0) {
+      for (uint8_t v = 0; v < 4; v++) {
+        context.set(RuleSource::RATE, windowed[v], (_rateAvg[newest][v] - _rateAvg[oldest][v]) / hours);
+      }
+    }
+  }
+}
+
+void RuleEngine::emit(uint8_t slot, RuleEventKind kind, uint32_t timestamp) {
+  const Slot& s = _slots[slot];
+  _seq++;
+  Serial.printf("%s RULE %s: %s (%.2f vs %.2f)\n", kind == RuleEventKind::RAISED ? "⚠️" : "✅",
+                kind == RuleEventKind::RAISED ? "raised" : "cleared", s.program.name, s.last.value, s.last.threshold);
+  if (!_callback) return;
+
+  RuleEvent event = {slot, s.program.name, kind, s.last.value, s.last.threshold, _seq, timestamp};
+  _callback(event);
+}
+
+RuleStats RuleEngine::getStats() const {
+  RuleStats stats = _stats;
+  stats.loaded = 0;
+  stats.active = 0;
+  for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+    if (_slots[i].loaded) stats.loaded++;
+    if (_slots[i].active) stats.active++;
+  }
+  stats.avgNs = stats.evaluations ? (uint32_t)(_totalCycles * 1000 / ESP.getCpuFreqMHz() / stats.evaluations) : 0;
+  return stats;
+}
+
+#endif
@@ -0,0 +1,343 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧮 Rule VM - Bytecode Condition Evaluator for Pushed Alert Rules
+ * Stack machine over the current sample + windowed aggregates
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Rules are compiled on the host (tools/xbio_rulec.cpp), e.g.
+ *
+ *   iaq > 150 && humidity > 60 for 5m
+ *   rate(pressure) < -3 for 10m
+ *
+ * and pushed over MQTT as a small blob:
+ *
+ *   u8 version | u8 flags | u16 holdSeconds | u16 clearSeconds
+ *   u8 nameLength | name | u8 codeLength | code
+ *
+ * The code has no jumps (&& and || evaluate both sides), so run time is
+ * linear in its length. load() walks it once to check operands and stack
+ * depth; run() then needs no bounds checks and touches no heap - a program
+ * that loaded always fits the fixed stack and leaves exactly one value.
+ *
+ * Pure C++ (no Arduino dependencies) so the host compiler uses the same
+ * loader and interpreter.
+ */
+
+#ifndef RULE_VM_H
+#define RULE_VM_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef RULE_MAX_CODE
+  #define RULE_MAX_CODE 96            // Bytecode bytes per rule
+#endif
+
+#ifndef RULE_STACK_DEPTH
+  #define RULE_STACK_DEPTH 16
+#endif
+
+#define RULE_FORMAT_VERSION 1
+#define RULE_NAME_MAX 23
+#define RULE_BLOB_MAX (8 + RULE_NAME_MAX + RULE_MAX_CODE)
+
+// Sample fields a rule can read
+enum class RuleVar : uint8_t {
+  TEMPERATURE = 0,
+  HUMIDITY,
+  PRESSURE,
+  GAS,
+  IAQ,
+  CO2,
+  VOC,
+  COUNT
+};
+
+// Where a LOAD reads the variable from
+enum class RuleSource : uint8_t {
+  VALUE = 0,        // Current sample
+  WIN_MIN,          // Last closed aggregate window
+  WIN_AVG,
+  WIN_MAX,
+  RATE,             // Change per hour over recent windows
+  COUNT
+};
+
+#define RULE_SLOTS ((uint8_t)RuleSource::COUNT * 8)
+#define RULE_SLOT(source, var) ((uint8_t)(((uint8_t)(source) << 3) | (uint8_t)(var)))
+
+enum class RuleOp : uint8_t {
+  CONST = 0x01,     // + f32 LE
+  LOAD = 0x02,      // + u8 RULE_SLOT(source, var)
+
+  ADD = 0x10,
+  SUB,
+  MUL,
+  DIV,
+  MIN,
+  MAX,
+
+  NEG = 0x18,
+  ABS,
+  NOT,
+
+  GT = 0x20,        // Comparisons push 1 / 0
+  GE,
+  LT,
+  LE,
+  EQ,
+  NE,
+
+  AND = 0x28,
+  OR
+};
+
+/**
+ * Values a rule can read. Unavailable entries are NaN, which makes any
+ * comparison against them false.
+ */
+struct RuleContext {
+  float slots[RULE_SLOTS];
+
+  void clear() {
+    for (uint8_t i = 0; i < RULE_SLOTS; i++) slots[i] = NAN;
+  }
+  void set(RuleSource source, RuleVar var, float value) { slots[RULE_SLOT(source, var)] = value; }
+};
+
+struct RuleProgram {
+  char name[RULE_NAME_MAX + 1];
+  uint16_t holdSeconds;       // Condition must hold this long to raise
+  uint16_t clearSeconds;      // ... and be false this long to clear
+  uint8_t flags;
+  uint8_t codeLength;
+  uint8_t ops;                // Instruction count (cost)
+  uint8_t stackDepth;         // Peak depth found by load()
+  uint8_t code[RULE_MAX_CODE];
+};
+
+struct RuleResult {
+  bool fired;
+  float value;                // Left / right side of the first comparison,
+  float threshold;            // reported with the alert
+};
+
+class RuleVM {
+public:
+  /**
+   * Decode and verify a rule blob
+   * @return nullptr on success, otherwise why it was rejected
+   */
+  static const char* load(const uint8_t* blob, size_t length, RuleProgram* out);
+
+  /**
+   * Encode a program as a blob
+   * @return Blob length, 0 if it does not fit
+   */
+  static size_t store(const RuleProgram& program, uint8_t* out, size_t size);
+
+  /**
+   * Evaluate a program that load() accepted
+   */
+  static RuleResult run(const RuleProgram& program, const RuleContext& context);
+
+  static const char* varName(RuleVar var);
+  static const char* sourceName(RuleSource source);
+  static const char* opName(RuleOp op);
+
+private:
+  static float readF32(const uint8_t* p) {
+    uint32_t bits = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+inline const char* RuleVM::load(const uint8_t* blob, size_t length, RuleProgram* out) {
+  memset(out, 0, sizeof(*out));
+  if (length < 8) return "truncated";
+  if (blob[0] != RULE_FORMAT_VERSION) return "unsupported version";
+  out->flags = blob[1];
+  out->holdSeconds = blob[2] | (blob[3] << 8);
+  out->clearSeconds = blob[4] | (blob[5] << 8);
+
+  size_t pos = 6;
+  uint8_t nameLength = blob[pos++];
+  if (nameLength == 0 || nameLength > RULE_NAME_MAX) return "bad name";
+  if (pos + nameLength + 1 > length) return "truncated";
+  memcpy(out->name, blob + pos, nameLength);
+  out->name[nameLength] = '\0';
+  if (strlen(out->name) != nameLength) return "bad name";
+  pos += nameLength;
+
+  uint8_t codeLength = blob[pos++];
+  if (codeLength == 0 || codeLength > RULE_MAX_CODE) return "bad code length";
+  if (pos + codeLength != length) return "length mismatch";
+  memcpy(out->code, blob + pos, codeLength);
+  out->codeLength = codeLength;
+
+  // One pass: operands in range, stack never under/overflows, one result left
+  uint8_t depth = 0;
+  const uint8_t* code = out->code;
+  size_t pc = 0;
+  while (pc < codeLength) {
+    RuleOp op = (RuleOp)code[pc++];
+    int8_t pops = 0;
+    switch (op) {
+      case RuleOp::CONST:
+        if (pc + 4 > codeLength) return "truncated constant";
+        pc += 4;
+        pops = -1;
+        break;
+      case RuleOp::LOAD: {
+        if (pc + 1 > codeLength) return "truncated load";
+        uint8_t slot = code[pc++];
+        if ((slot >> 3) >= (uint8_t)RuleSource::COUNT || (slot & 7) >= (uint8_t)RuleVar::COUNT) {
+          return "bad variable";
+        }
+        pops = -1;
+        break;
+      }
+      case RuleOp::NEG: case RuleOp::ABS: case RuleOp::NOT:
+        pops = 0;
+        if (depth < 1) return "stack underflow";
+        break;
+      case RuleOp::ADD: case RuleOp::SUB: case RuleOp::MUL: case RuleOp::DIV:
+      case RuleOp::MIN: case RuleOp::MAX:
+      case RuleOp::GT: case RuleOp::GE: case RuleOp::LT: case RuleOp::LE:
+      case RuleOp::EQ: case RuleOp::NE:
+      case RuleOp::AND: case RuleOp::OR:
+        if (depth < 2) return "stack underflow";
+        pops = 1;
+        break;
+      default:
+        return "bad opcode";
+    }
+    depth -= pops;
+    if (depth > RULE_STACK_DEPTH) return "stack overflow";
+    if (depth > out->stackDepth) out->stackDepth = depth;
+    out->ops++;
+  }
+  if (depth != 1) return "must leave one value";
+  return nullptr;
+}
+
+inline size_t RuleVM::store(const RuleProgram& program, uint8_t* out, size_t size) {
+  size_t nameLength = strlen(program.name);
+  size_t length = 8 + nameLength + program.codeLength;
+  if (nameLength == 0 || nameLength > RULE_NAME_MAX || length > size) return 0;
+
+  out[0] = RULE_FORMAT_VERSION;
+  out[1] = program.flags;
+  out[2] = (uint8_t)program.holdSeconds;
+  out[3] = (uint8_t)(program.holdSeconds >> 8);
+  out[4] = (uint8_t)program.clearSeconds;
+  out[5] = (uint8_t)(program.clearSeconds >> 8);
+  out[6] = (uint8_t)nameLength;
+  memcpy(out + 7, program.name, nameLength);
+  out[7 + nameLength] = program.codeLength;
+  memcpy(out + 8 + nameLength, program.code, program.codeLength);
+  return length;
+}
+
+inline RuleResult RuleVM::run(const RuleProgram& program, const RuleContext& context) {
+  float stack[RULE_STACK_DEPTH];
+  uint8_t sp = 0;
+  RuleResult result = {false, NAN, NAN};
+  bool compared = false;
+
+  const uint8_t* code = program.code;
+  const uint8_t* end = code + program.codeLength;
+  while (code < end) {
+    RuleOp op = (RuleOp)*code++;
+    switch (op) {
+      case RuleOp::CONST:
+        stack[sp++] = readF32(code);
+        code += 4;
+        continue;
+      case RuleOp::LOAD:
+        stack[sp++] = context.slots[*code++];
+        continue;
+      case RuleOp::NEG: stack[sp - 1] = -stack[sp - 1]; continue;
+      case RuleOp::ABS: stack[sp - 1] = fabsf(stack[sp - 1]); continue;
+      case RuleOp::NOT: stack[sp - 1] = stack[sp - 1] == 0.0f ? 1.0f : 0.0f; continue;
+      default: break;
+    }
+
+    // Binary: b on top, a below
+    float b = stack[--sp];
+    float& a = stack[sp - 1];
+    switch (op) {
+      case RuleOp::ADD: a = a + b; break;
+      case RuleOp::SUB: a = a - b; break;
+      case RuleOp::MUL: a = a * b; break;
+      case RuleOp::DIV: a = b != 0.0f ? a / b : NAN; break;
+      case RuleOp::MIN: a = b < a ? b : a; break;
+      case RuleOp::MAX: a = b > a ? b : a; break;
+      case RuleOp::AND: a = (a != 0.0f && b != 0.0f && a == a && b == b) ? 1.0f : 0.0f; break;
+      case RuleOp::OR: a = ((a != 0.0f && a == a) || (b != 0.0f && b == b)) ? 1.0f : 0.0f; break;
+      default: {
+        if (!compared) {
+          result.value = a;
+          result.threshold = b;
+          compared = true;
+        }
+        bool r = op == RuleOp::GT ? a > b :
+                 op == RuleOp::GE ? a >= b :
+                 op == RuleOp::LT ? a < b :
+                 op == RuleOp::LE ? a <= b :
+                 op == RuleOp::EQ ? a == b : a != b;
+        a = r ? 1.0f : 0.0f;
+        break;
+      }
+    }
+  }
+
+  float top = stack[0];
+  result.fired = top != 0.0f && top == top; // NaN never fires
+  return result;
+}
+
+inline const char* RuleVM::varName(RuleVar var) {
+  static const char* names[] = {"temperature", "humidity", "pressure", "gas", "iaq", "co2", "voc"};
+  return var < RuleVar::COUNT ? names[(uint8_t)var] : "?";
+}
+
+inline const char* RuleVM::sourceName(RuleSource source) {
+  static const char* names[] = {"", "win_min", "win_avg", "win_max", "rate"};
+  return source < RuleSource::COUNT ? names[(uint8_t)source] : "?";
+}
+
+inline const char* RuleVM::opName(RuleOp op) {
+  switch (op) {
+    case RuleOp::CONST: return "const";
+    case RuleOp::LOAD: return "load";
+    case RuleOp::ADD: return "add";
+    case RuleOp::SUB: return "sub";
+    case RuleOp::MUL: return "mul";
+    case RuleOp::DIV: return "div";
+    case RuleOp::MIN: return "min";
+    case RuleOp::MAX: return "max";
+    case RuleOp::NEG: return "neg";
+    case RuleOp::ABS: return "abs";
+    case RuleOp::NOT: return "not";
+    case RuleOp::GT: return "gt";
+    case RuleOp::GE: return "ge";
+    case RuleOp::LT: return "lt";
+    case RuleOp::LE: return "le";
+    case RuleOp::EQ: return "eq";
+    case RuleOp::NE: return "ne";
+    case RuleOp::AND: return "and";
+    case RuleOp::OR: return "or";
+  }
+  return "?";
+}
+
+#endif
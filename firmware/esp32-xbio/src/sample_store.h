@@ -0,0 +1,109 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 📌 Sample Store - Latest Sample + Aggregates for Any Task
+ * The sensor path writes, BLE / HTTP / publish paths read lock-free snapshots
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef SAMPLE_STORE_H
+#define SAMPLE_STORE_H
+
+#include <Arduino.h>
+#include "bme688_driver.h"
+#include "seqlock.h"
+
+#ifndef AGGREGATE_WINDOW_MS
+  #define AGGREGATE_WINDOW_MS 60000   // Tumbling window for min/avg/max
+#endif
+
+struct SensorStat {
+  float min;
+  float avg;
+  float max;
+};
+
+struct SensorAggregates {
+  uint32_t windowStart;       // millis() when the window opened
+  uint32_t windowMs;
+  uint16_t count;             // Samples in the window
+  SensorStat temperature;
+  SensorStat humidity;
+  SensorStat pressure;
+  SensorStat iaq;
+};
+
+class XBioSampleStore {
+public:
+  XBioSampleStore() : _windowStart(0), _count(0) {
+    resetWindow(0);
+  }
+
+  /**
+   * Publish a new sample - sensor task only
+   */
+  void publish(const SensorData& data);
+
+  /**
+   * Snapshots - safe from any task or core, never block the writer
+   */
+  SensorData latest() const { return _latest.read(); }
+  SensorAggregates aggregates() const { return _aggregates.read(); }
+  uint32_t version() const { return _latest.version(); }
+
+private:
+  SeqLock<SensorData> _latest;
+  SeqLock<SensorAggregates> _aggregates;
+
+  // Writer-side accumulators for the open window
+  uint32_t _windowStart;
+  uint16_t _count;
+  SensorStat _acc[4];
+  float _sum[4];
+
+  void resetWindow(uint32_t now);
+  static void accumulate(SensorStat& stat, float& sum, float value, bool first);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void XBioSampleStore::publish(const SensorData& data) {
+  _latest.write(data);
+  if (!data.valid) return;
+
+  uint32_t now = millis();
+  if (_count > 0 && now - _windowStart >= AGGREGATE_WINDOW_MS) {
+    SensorAggregates closed;
+    closed.windowStart = _windowStart;
+    closed.windowMs = now - _windowStart;
+    closed.count = _count;
+    SensorStat* out[4] = {&closed.temperature, &closed.humidity, &closed.pressure, &closed.iaq};
+    for (uint8_t i = 0; i < 4; i++) {
+      *out[i] = _acc[i];
+      out[i]->avg = _sum[i] / _count;
+    }
+    _aggregates.write(closed);
+    resetWindow(now);
+  }
+  if (_count == 0) _windowStart = now;
+
+  float values[4] = {data.temperature, data.humidity, data.pressure, (float)data.iaq};
+  for (uint8_t i = 0; i < 4; i++) accumulate(_acc[i], _sum[i], values[i], _count == 0);
+  if (_count < 0xFFFF) _count++;
+}
+
+void XBioSampleStore::resetWindow(uint32_t now) {
+  _windowStart = now;
+  _count = 0;
+  memset(_acc, 0, sizeof(_acc));
+  memset(_sum, 0, sizeof(_sum));
+}
+
+void XBioSampleStore::accumulate(SensorStat& stat, float& sum, float value, bool first) {
+  if (first || value < stat.min) stat.min = value;
+  if (first || value > stat.max) stat.max = value;
+  sum += value;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🔁 SeqLock - Lock-free Latest-Value Publication (single writer, any readers)
+ * Two-copy sequence latch: readers never wait on a preempted writer
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * The writer bumps the sequence to odd, rewrites copy 0, bumps it to even and
+ * rewrites copy 1. Readers always copy the side the writer is NOT touching
+ * (sequence & 1) and retry only if the sequence moved meanwhile - i.e. the
+ * writer finished a whole update during the read. A reader that preempts the
+ * writer on the same core therefore succeeds first time instead of spinning.
+ *
+ * Storage is 32-bit atomic words so the copy is race-free under the C++
+ * memory model (a plain memcpy would be a data race, even if it "works").
+ * Pure C++ (no Arduino dependencies) so host tools can use it.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+public:
+  SeqLock() : _sequence(0) {
+    for (size_t c = 0; c < 2; c++) {
+      for (size_t w = 0; w < WORDS; w++) _copies[c][w].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Publish a new value - one writer task only
+   */
+  void write(const T& value) {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+
+    // Odd: readers move to copy 1 while copy 0 is rewritten
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    storeCopy(0, words);
+
+    // Even: readers move back to the fresh copy 0 while copy 1 catches up
+    std::atomic_thread_fence(std::memory_order_release);
+    _sequence.store(sequence + 2, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    storeCopy(1, words);
+  }
+
+  /**
+   * Consistent snapshot - safe from any task or core
+   * @return Number of retries it took (0 unless the writer lapped the read)
+   */
+  uint32_t read(T& out) const {
+    uint32_t words[WORDS];
+    uint32_t retries = 0;
+    for (;;) {
+      uint32_t before = _sequence.load(std::memory_order_acquire);
+      const std::atomic<uint32_t>* copy = _copies[before & 1];
+      for (size_t w = 0; w < WORDS; w++) words[w] = copy[w].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_sequence.load(std::memory_order_relaxed) == before) break;
+      retries++;
+    }
+    memcpy(&out, words, sizeof(T));
+    return retries;
+  }
+
+  T read() const {
+    T out;
+    read(out);
+    return out;
+  }
+
+  /**
+   * Number of completed writes
+   */
+  uint32_t version() const { return _sequence.load(std::memory_order_acquire) >> 1; }
+
+private:
+  static constexpr size_t WORDS = (sizeof(T) + 3) / 4;
+
+  std::atomic<uint32_t> _sequence;
+  std::atomic<uint32_t> _copies[2][WORDS];
+
+  void storeCopy(size_t index, const uint32_t* words) {
+    for (size_t w = 0; w < WORDS; w++) _copies[index][w].store(words[w], std::memory_order_relaxed);
+  }
+};
+
+#endif
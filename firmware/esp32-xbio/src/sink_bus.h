@@ -0,0 +1,251 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🚌 Sink Bus - Encode Once, Fan Out to MQTT / WebSocket / BLE
+ * Each sample is serialized at most once per format and shared by all sinks
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Sinks register with a wire format and a minimum delivery interval. On
+ * publish() the bus hands every due sink a pointer into the per-format
+ * encode buffer; a format nobody is due for is never encoded.
+ *
+ *   FULL_JSON     xbio/<id>/data schema (identity + sensors + status)
+ *   COMPACT_JSON  live-stream schema used by WebSocket, MQTT tunnel and BLE
+ */
+
+#ifndef SINK_BUS_H
+#define SINK_BUS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "bme688_driver.h"
+
+#ifndef SINK_BUS_MAX_SINKS
+  #define SINK_BUS_MAX_SINKS 6
+#endif
+
+#ifndef SINK_BUS_ENCODE_SIZE
+  #define SINK_BUS_ENCODE_SIZE 704     // Fits one MQTT_QUEUE_SLOT_SIZE packet with the data topic
+#endif
+
+#ifndef SINK_BUS_RATE_SLACK_MS
+  #define SINK_BUS_RATE_SLACK_MS 50   // Absorbs sample-loop jitter so 5 s sinks don't slip to 6 s
+#endif
+
+enum class SinkFormat : uint8_t {
+  FULL_JSON = 0,
+  COMPACT_JSON = 1,
+  COUNT
+};
+
+// Sink writer - payload is owned by the bus and valid only during the call
+typedef bool (*SinkWriter)(const char* payload, size_t length);
+
+// Adds device identity and status fields to FULL_JSON records
+typedef void (*SinkEnvelopeCallback)(JsonDocument& doc);
+
+struct SinkBusStats {
+  uint32_t samples;
+  uint32_t encodes[(uint8_t)SinkFormat::COUNT];
+  uint32_t deliveries;
+  uint32_t failures;
+  uint32_t oversize;          // Records that did not fit SINK_BUS_ENCODE_SIZE (counted in failures)
+  uint32_t lastFanoutUs;      // Encode + deliver time for the last sample
+};
+
+class XBioSinkBus {
+public:
+  XBioSinkBus() : _sinkCount(0), _sequence(0), _sampleTime(0), _envelope(nullptr) {
+    memset(&_sample, 0, sizeof(_sample));
+    memset(&_stats, 0, sizeof(_stats));
+    memset(_encodedSeq, 0, sizeof(_encodedSeq));
+    memset(_encodedLength, 0, sizeof(_encodedLength));
+  }
+
+  /**
+   * Register a sink
+   * @param intervalMs Minimum time between deliveries (0 = every sample)
+   * @return Sink handle, or -1 if the table is full
+   */
+  int8_t addSink(const char* name, SinkFormat format, uint32_t intervalMs, SinkWriter writer);
+
+  void setEnvelope(SinkEnvelopeCallback callback) { _envelope = callback; }
+
+  /**
+   * Publish a sample and deliver it to every sink that is due
+   */
+  void publish(const SensorData& data);
+
+  /**
+   * Deliver the latest sample to one sink now, ignoring its rate
+   */
+  bool flush(int8_t sink);
+
+  SinkBusStats getStats() { return _stats; }
+
+  /**
+   * Encoders - also usable directly by code that holds a single sample
+   */
+  static size_t encodeCompact(const SensorData& data, uint32_t timestamp, char* buffer, size_t size);
+  size_t encodeFull(const SensorData& data, uint32_t timestamp, char* buffer, size_t size);
+
+  /**
+   * Round a reading for FULL_JSON - keeps the record inside SINK_BUS_ENCODE_SIZE
+   * (a raw float serializes with 9 significant digits)
+   */
+  static double rounded(float value, uint8_t decimals = 2);
+
+private:
+  struct Sink {
+    const char* name;
+    SinkFormat format;
+    uint32_t intervalMs;
+    SinkWriter writer;
+    uint32_t lastDelivery;
+    bool delivered;
+  };
+
+  Sink _sinks[SINK_BUS_MAX_SINKS];
+  uint8_t _sinkCount;
+
+  SensorData _sample;
+  uint32_t _sequence;         // 0 = nothing published yet
+  uint32_t _sampleTime;
+  SinkEnvelopeCallback _envelope;
+
+  char _encoded[(uint8_t)SinkFormat::COUNT][SINK_BUS_ENCODE_SIZE];
+  size_t _encodedLength[(uint8_t)SinkFormat::COUNT];
+  uint32_t _encodedSeq[(uint8_t)SinkFormat::COUNT];
+
+  SinkBusStats _stats;
+
+  const char* encoding(SinkFormat format, size_t* length);
+  bool deliver(Sink& sink, uint32_t now);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+int8_t XBioSinkBus::addSink(const char* name, SinkFormat format, uint32_t intervalMs, SinkWriter writer) {
+  if (_sinkCount >= SINK_BUS_MAX_SINKS || !writer) return -1;
+
+  Sink& sink = _sinks[_sinkCount];
+  sink.name = name;
+  sink.format = format;
+  sink.intervalMs = intervalMs;
+  sink.writer = writer;
+  sink.lastDelivery = 0;
+  sink.delivered = false;
+
+  Serial.printf("SinkBus: %s (%s, %lu ms)\n", name,
+                format == SinkFormat::FULL_JSON ? "full" : "compact", (unsigned long)intervalMs);
+  return _sinkCount++;
+}
+
+void XBioSinkBus::publish(const SensorData& data) {
+  uint32_t start = micros();
+
+  _sample = data;
+  _sampleTime = millis();
+  _sequence++;
+  _stats.samples++;
+
+  for (uint8_t i = 0; i < _sinkCount; i++) {
+    Sink& sink = _sinks[i];
+    bool due = !sink.delivered ||
+               _sampleTime - sink.lastDelivery + SINK_BUS_RATE_SLACK_MS >= sink.intervalMs;
+    if (due) deliver(sink, _sampleTime);
+  }
+
+  _stats.lastFanoutUs = micros() - start;
+}
+
+bool XBioSinkBus::flush(int8_t sink) {
+  if (sink < 0 || sink >= _sinkCount || _sequence == 0) return false;
+  return deliver(_sinks[sink], millis());
+}
+
+bool XBioSinkBus::deliver(Sink& sink, uint32_t now) {
+  // The rate slot is consumed even on failure - a stale sample is not worth retrying
+  sink.lastDelivery = now;
+  sink.delivered = true;
+
+  size_t length = 0;
+  const char* payload = encoding(sink.format, &length);
+  if (payload && sink.writer(payload, length)) {
+    _stats.deliveries++;
+    return true;
+  }
+  _stats.failures++;
+  return false;
+}
+
+const char* XBioSinkBus::encoding(SinkFormat format, size_t* length) {
+  uint8_t index = (uint8_t)format;
+  if (index >= (uint8_t)SinkFormat::COUNT) return nullptr;
+
+  if (_encodedSeq[index] != _sequence) {
+    char* buffer = _encoded[index];
+    size_t written = format == SinkFormat::FULL_JSON
+      ? encodeFull(_sample, _sampleTime, buffer, SINK_BUS_ENCODE_SIZE)
+      : encodeCompact(_sample, _sampleTime, buffer, SINK_BUS_ENCODE_SIZE);
+    if (written == 0 || written >= SINK_BUS_ENCODE_SIZE) {
+      if (_stats.oversize++ == 0) {
+        Serial.printf("Sinks: %s record over %d B, not sent\n",
+                      format == SinkFormat::FULL_JSON ? "full" : "compact", SINK_BUS_ENCODE_SIZE);
+      }
+      return nullptr;
+    }
+
+    _encodedLength[index] = written;
+    _encodedSeq[index] = _sequence;
+    _stats.encodes[index]++;
+  }
+
+  *length = _encodedLength[index];
+  return _encoded[index];
+}
+
+size_t XBioSinkBus::encodeCompact(const SensorData& data, uint32_t timestamp, char* buffer, size_t size) {
+  int length = snprintf(buffer, size,
+    "{\"type\":\"sensor_data\",\"ts\":%lu,\"t\":%.1f,\"h\":%.1f,\"p\":%.1f,\"g\":%.0f,"
+    "\"q\":%u,\"a\":%u,\"c\":%.0f,\"v\":%.2f}",
+    (unsigned long)timestamp,
+    data.temperature,
+    data.humidity,
+    data.pressure,
+    data.gasResistance,
+    data.iaq,
+    data.iaqAccuracy,
+    data.co2Equivalent,
+    data.vocEquivalent
+  );
+  return length > 0 ? (size_t)length : 0;
+}
+
+size_t XBioSinkBus::encodeFull(const SensorData& data, uint32_t timestamp, char* buffer, size_t size) {
+  JsonDocument doc;
+  if (_envelope) _envelope(doc);
+  doc["timestamp"] = timestamp;
+
+  JsonObject sensors = doc["sensors"].to<JsonObject>();
+  sensors["temperature"] = rounded(data.temperature);
+  sensors["humidity"] = rounded(data.humidity);
+  sensors["pressure"] = rounded(data.pressure);
+  sensors["iaq"] = data.iaq;
+  sensors["iaq_accuracy"] = data.iaqAccuracy;
+  sensors["gas_resistance"] = rounded(data.gasResistance, 0);
+  sensors["co2_equivalent"] = rounded(data.co2Equivalent, 1);
+  sensors["voc_equivalent"] = rounded(data.vocEquivalent);
+
+  if (measureJson(doc) >= size) return 0;
+  return serializeJson(doc, buffer, size);
+}
+
+double XBioSinkBus::rounded(float value, uint8_t decimals) {
+  double scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+  return round((double)value * scale) / scale;
+}
+
+#endif
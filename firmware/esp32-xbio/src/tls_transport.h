@@ -0,0 +1,681 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🔐 TLS Transport - Verified TLS with Session Resumption
+ * CA / SHA-256 fingerprint pinning, session cache kept in RTC memory
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * WiFiClientSecure runs a full ECDHE handshake on every connect and has no
+ * hook to offer a cached session. This Client drives mbedTLS directly over a
+ * plain WiFiClient so the negotiated session (ID or ticket) is offered again
+ * on reconnect, and survives soft reboots / deep sleep through RTC memory.
+ *
+ * Trust anchors, RNG and the mbedTLS config live in one XBioTLSContext that
+ * every connection (MQTT, WebSocket) shares; only the per-connection SSL
+ * context and its record buffers are allocated per link.
+ */
+
+#ifndef TLS_TRANSPORT_H
+#define TLS_TRANSPORT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFiClient.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <mbedtls/version.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/sha256.h>
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Configuration
+// ═══════════════════════════════════════════════════════════════════════════════
+#ifndef XBIO_TLS_HANDSHAKE_TIMEOUT
+  #define XBIO_TLS_HANDSHAKE_TIMEOUT 10000
+#endif
+
+#ifndef XBIO_TLS_SESSION_SLOTS
+  #define XBIO_TLS_SESSION_SLOTS 1       // RTC-backed session records
+#endif
+
+#ifndef XBIO_TLS_SESSION_SIZE
+  #define XBIO_TLS_SESSION_SIZE 2048     // Serialized session incl. peer certificate
+#endif
+
+// Resumed sessions are pinned against the certificate they were negotiated with
+#if !defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+  #error "tls_transport.h needs MBEDTLS_SSL_KEEP_PEER_CERTIFICATE (CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE=y)"
+#endif
+
+#if MBEDTLS_VERSION_MAJOR >= 3
+  #define XBIO_TLS_STATE(ssl) ((ssl).MBEDTLS_PRIVATE(state))
+#else
+  #define XBIO_TLS_STATE(ssl) ((ssl).state)
+#endif
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Handshake Statistics
+// ═══════════════════════════════════════════════════════════════════════════════
+struct TLSHandshakeStats {
+  uint32_t handshakes;        // Successful handshakes
+  uint32_t resumed;           // ...of which abbreviated (session resumed)
+  uint32_t failures;          // Handshake or verification failures
+  uint32_t lastHandshakeMs;   // Duration of the latest handshake
+  uint32_t lastBytesOut;      // Handshake bytes sent
+  uint32_t lastBytesIn;       // Handshake bytes received
+  uint32_t heapBytes;         // Internal heap held by the connection after handshake
+  bool lastResumed;
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// RTC Session Record - survives soft reboot and deep sleep, not power loss
+// ═══════════════════════════════════════════════════════════════════════════════
+struct TLSSessionRecord {
+  uint32_t magic;
+  uint32_t crc;
+  uint16_t port;
+  uint16_t length;
+  char host[64];
+  uint8_t trust[32];            // XBioTLSContext::trustHash() the session was verified under
+  uint8_t data[XBIO_TLS_SESSION_SIZE];
+};
+
+#define XBIO_TLS_SESSION_MAGIC 0x58544C54 // "XTLT"
+
+RTC_NOINIT_ATTR static TLSSessionRecord _tlsSessionRecords[XBIO_TLS_SESSION_SLOTS];
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Shared TLS Context - one trust store and mbedTLS config for all links
+// ═══════════════════════════════════════════════════════════════════════════════
+class XBioTLSContext {
+public:
+  static XBioTLSContext& shared();
+
+  /**
+   * Trust configuration - at least one should be set for verified connections.
+   * Set at boot before any link connects; the config is shared by live links.
+   * @param caCert CA certificate chain (PEM), may be empty
+   * @param fingerprint SHA-256 of the server certificate, hex (colons optional), may be empty
+   */
+  void setTrust(const char* caCert, const char* fingerprint);
+  bool isVerified();
+
+  /**
+   * SHA-256 of the trust settings (CA PEM ‖ fingerprint); a cached session
+   * is only offered again under the settings it was verified with
+   */
+  const uint8_t* trustHash() { return _trustHash; }
+
+  /**
+   * Parse trust anchors and build the config (once, on first connect)
+   */
+  bool configure();
+  const mbedtls_ssl_config* config() { return &_conf; }
+
+  bool verifyPeer(const mbedtls_ssl_context* ssl);
+
+private:
+  XBioTLSContext();
+
+  mbedtls_ssl_config _conf;
+  mbedtls_entropy_context _entropy;
+  mbedtls_ctr_drbg_context _drbg;
+  mbedtls_x509_crt _caChain;
+
+  String _caCert;
+  uint8_t _fingerprint[32];
+  uint8_t _trustHash[32];
+  bool _pinned;
+  bool _seeded;
+  bool _configured;
+
+  void parseFingerprint(const char* fingerprint);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// XBio TLS Client Class
+// ═══════════════════════════════════════════════════════════════════════════════
+class XBioTLSClient : public Client {
+public:
+  /**
+   * @param sessionSlot RTC session record index (>= XBIO_TLS_SESSION_SLOTS keeps the cache in RAM only)
+   */
+  XBioTLSClient(uint8_t sessionSlot = 0);
+  ~XBioTLSClient();
+
+  bool isVerified() { return XBioTLSContext::shared().isVerified(); }
+
+  /**
+   * Drop the cached session (e.g. after a server key rollover)
+   */
+  void clearSession();
+
+  TLSHandshakeStats getStats() { return _stats; }
+
+  // Client interface
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override { _socket.flush(); }
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+private:
+  WiFiClient _socket;
+  uint8_t _sessionSlot;
+
+  mbedtls_ssl_context _ssl;
+  mbedtls_ssl_session _session;
+
+  bool _connected;
+  bool _sessionValid;
+  char _sessionHost[64];
+  uint16_t _sessionPort;
+  uint8_t _sessionTrust[32];
+  int _peeked;
+
+  uint32_t _bytesOut;
+  uint32_t _bytesIn;
+  TLSHandshakeStats _stats;
+
+  bool setup();
+  void release();
+  bool handshake(const char* host, uint16_t port);
+  void saveSession(const char* host, uint16_t port);
+  void loadSession();
+
+  static int bioSend(void* ctx, const unsigned char* buf, size_t len);
+  static int bioRecv(void* ctx, unsigned char* buf, size_t len);
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation - Shared Context
+// ═══════════════════════════════════════════════════════════════════════════════
+
+XBioTLSContext& XBioTLSContext::shared() {
+  static XBioTLSContext context;
+  return context;
+}
+
+XBioTLSContext::XBioTLSContext() {
+  _pinned = false;
+  _seeded = false;
+  _configured = false;
+  memset(_fingerprint, 0, sizeof(_fingerprint));
+  memset(_trustHash, 0, sizeof(_trustHash));
+
+  mbedtls_ssl_config_init(&_conf);
+  mbedtls_entropy_init(&_entropy);
+  mbedtls_ctr_drbg_init(&_drbg);
+  mbedtls_x509_crt_init(&_caChain);
+}
+
+void XBioTLSContext::setTrust(const char* caCert, const char* fingerprint) {
+  _caCert = caCert ? caCert : "";
+  _pinned = false;
+  _configured = false; // Re-parse on next connect
+  memset(_fingerprint, 0, sizeof(_fingerprint));
+
+  if (fingerprint && *fingerprint) {
+    parseFingerprint(fingerprint);
+  }
+
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  #if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, (const unsigned char*)_caCert.c_str(), _caCert.length());
+    mbedtls_sha256_update(&sha, (const unsigned char*)&_pinned, 1);
+    mbedtls_sha256_update(&sha, _fingerprint, sizeof(_fingerprint));
+    mbedtls_sha256_finish(&sha, _trustHash);
+  #else
+    mbedtls_sha256_starts_ret(&sha, 0);
+    mbedtls_sha256_update_ret(&sha, (const unsigned char*)_caCert.c_str(), _caCert.length());
+    mbedtls_sha256_update_ret(&sha, (const unsigned char*)&_pinned, 1);
+    mbedtls_sha256_update_ret(&sha, _fingerprint, sizeof(_fingerprint));
+    mbedtls_sha256_finish_ret(&sha, _trustHash);
+  #endif
+  mbedtls_sha256_free(&sha);
+
+  // Sessions verified under other settings must not be resumed. Setting the
+  // same trust again at boot keeps the RTC cache usable across soft reboots.
+  for (int i = 0; i < XBIO_TLS_SESSION_SLOTS; i++) {
+    if (memcmp(_tlsSessionRecords[i].trust, _trustHash, sizeof(_trustHash)) != 0) {
+      _tlsSessionRecords[i].magic = 0;
+    }
+  }
+}
+
+void XBioTLSContext::parseFingerprint(const char* fingerprint) {
+  size_t n = 0;
+  int high = -1;
+  for (const char* p = fingerprint; *p && n < sizeof(_fingerprint); p++) {
+    char c = *p;
+    int v;
+    if (c >= '0' && c <= '9') v = c - '0';
+    else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+    else continue; // Separators
+    if (high < 0) {
+      high = v;
+    } else {
+      _fingerprint[n++] = (uint8_t)((high << 4) | v);
+      high = -1;
+    }
+  }
+
+  if (n != sizeof(_fingerprint)) {
+    Serial.println("TLS: Invalid SHA-256 fingerprint");
+    memset(_fingerprint, 0, sizeof(_fingerprint));
+    return;
+  }
+  _pinned = true;
+}
+
+bool XBioTLSContext::isVerified() {
+  return _pinned || !_caCert.isEmpty();
+}
+
+bool XBioTLSContext::configure() {
+  if (_configured) return true;
+
+  if (!_seeded) {
+    if (mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                              (const unsigned char*)"xbio", 4) != 0) {
+      Serial.println("TLS: RNG seed failed");
+      return false;
+    }
+    _seeded = true;
+  }
+
+  mbedtls_ssl_config_free(&_conf);
+  mbedtls_ssl_config_init(&_conf);
+  if (mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+    Serial.println("TLS: Config defaults failed");
+    return false;
+  }
+
+  mbedtls_x509_crt_free(&_caChain);
+  mbedtls_x509_crt_init(&_caChain);
+
+  if (!_caCert.isEmpty()) {
+    int ret = mbedtls_x509_crt_parse(&_caChain, (const unsigned char*)_caCert.c_str(),
+                                     _caCert.length() + 1);
+    if (ret != 0) {
+      Serial.printf("TLS: CA parse failed (-0x%04X)\n", -ret);
+      return false;
+    }
+    mbedtls_ssl_conf_ca_chain(&_conf, &_caChain, nullptr);
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  } else if (_pinned) {
+    // Chain is not checked; the leaf certificate must match the pinned hash
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+  } else {
+    Serial.println("TLS: ⚠️ No CA or fingerprint configured - server NOT verified");
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_NONE);
+  }
+
+  mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+  #if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+  #endif
+
+  _configured = true;
+  return true;
+}
+
+bool XBioTLSContext::verifyPeer(const mbedtls_ssl_context* ssl) {
+  if (!_caCert.isEmpty()) {
+    uint32_t flags = mbedtls_ssl_get_verify_result(ssl);
+    if (flags != 0) {
+      Serial.printf("TLS: Certificate verification failed (0x%08X)\n", flags);
+      return false;
+    }
+  }
+
+  if (_pinned) {
+    const mbedtls_x509_crt* peer = mbedtls_ssl_get_peer_cert(ssl);
+    if (!peer) {
+      // Resumed sessions carry the certificate too (MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+      Serial.println("TLS: No peer certificate to pin");
+      return false;
+    }
+
+    uint8_t digest[32];
+    #if MBEDTLS_VERSION_MAJOR >= 3
+      mbedtls_sha256(peer->raw.p, peer->raw.len, digest, 0);
+    #else
+      mbedtls_sha256_ret(peer->raw.p, peer->raw.len, digest, 0);
+    #endif
+    if (memcmp(digest, _fingerprint, sizeof(digest)) != 0) {
+      Serial.println("TLS: Server fingerprint mismatch");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Implementation - TLS Client
+// ═══════════════════════════════════════════════════════════════════════════════
+
+XBioTLSClient::XBioTLSClient(uint8_t sessionSlot) {
+  _sessionSlot = sessionSlot;
+  _connected = false;
+  _sessionValid = false;
+  _sessionPort = 0;
+  _peeked = -1;
+  _bytesOut = 0;
+  _bytesIn = 0;
+  memset(_sessionHost, 0, sizeof(_sessionHost));
+  memset(_sessionTrust, 0, sizeof(_sessionTrust));
+  memset(&_stats, 0, sizeof(_stats));
+
+  mbedtls_ssl_init(&_ssl);
+  mbedtls_ssl_session_init(&_session);
+}
+
+XBioTLSClient::~XBioTLSClient() {
+  stop();
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_free(&_ssl);
+}
+
+void XBioTLSClient::clearSession() {
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_session_init(&_session);
+  _sessionValid = false;
+  if (_sessionSlot < XBIO_TLS_SESSION_SLOTS) {
+    _tlsSessionRecords[_sessionSlot].magic = 0;
+  }
+}
+
+bool XBioTLSClient::setup() {
+  XBioTLSContext& context = XBioTLSContext::shared();
+  if (!context.configure()) return false;
+
+  // Record buffers are allocated here and released in stop(), so an idle link holds no TLS heap
+  if (mbedtls_ssl_setup(&_ssl, context.config()) != 0) {
+    Serial.println("TLS: SSL setup failed");
+    release();
+    return false;
+  }
+
+  loadSession();
+  return true;
+}
+
+void XBioTLSClient::release() {
+  mbedtls_ssl_free(&_ssl);
+  mbedtls_ssl_init(&_ssl);
+}
+
+int XBioTLSClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip.toString().c_str(), port);
+}
+
+int XBioTLSClient::connect(const char* host, uint16_t port) {
+  stop();
+
+  size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  if (!setup()) return 0;
+
+  if (!_socket.connect(host, port)) {
+    release();
+    return 0;
+  }
+
+  if (!handshake(host, port)) {
+    _stats.failures++;
+    _socket.stop();
+    release();
+    return 0;
+  }
+
+  size_t heapAfter = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  _stats.heapBytes = heapBefore > heapAfter ? heapBefore - heapAfter : 0;
+
+  _connected = true;
+  return 1;
+}
+
+bool XBioTLSClient::handshake(const char* host, uint16_t port) {
+  mbedtls_ssl_set_hostname(&_ssl, host);
+  mbedtls_ssl_set_bio(&_ssl, this, bioSend, bioRecv, nullptr);
+
+  bool offered = false;
+  if (_sessionValid && _sessionPort == port && strcmp(_sessionHost, host) == 0 &&
+      memcmp(_sessionTrust, XBioTLSContext::shared().trustHash(), sizeof(_sessionTrust)) == 0) {
+    offered = mbedtls_ssl_set_session(&_ssl, &_session) == 0;
+  }
+
+  _bytesOut = 0;
+  _bytesIn = 0;
+  bool fullHandshake = false;
+  uint32_t start = millis();
+
+  // Step manually so an abbreviated handshake (no server Certificate) is observable
+  while (XBIO_TLS_STATE(_ssl) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    if (XBIO_TLS_STATE(_ssl) == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+      fullHandshake = true;
+    }
+
+    int ret = mbedtls_ssl_handshake_step(&_ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      if (millis() - start > XBIO_TLS_HANDSHAKE_TIMEOUT) {
+        Serial.println("TLS: Handshake timeout");
+        return false;
+      }
+      delay(1);
+      continue;
+    }
+    if (ret != 0) {
+      Serial.printf("TLS: Handshake failed (-0x%04X)\n", -ret);
+      if (offered) clearSession(); // Stale ticket/ID - next attempt does a full handshake
+      return false;
+    }
+  }
+
+  bool resumed = offered && !fullHandshake;
+  if (!XBioTLSContext::shared().verifyPeer(&_ssl)) {
+    if (offered) clearSession();
+    mbedtls_ssl_close_notify(&_ssl);
+    return false;
+  }
+
+  _stats.handshakes++;
+  _stats.lastHandshakeMs = millis() - start;
+  _stats.lastBytesOut = _bytesOut;
+  _stats.lastBytesIn = _bytesIn;
+  _stats.lastResumed = resumed;
+  if (resumed) _stats.resumed++;
+
+  Serial.printf("TLS: %s handshake with %s:%u in %u ms (%u B out / %u B in)\n",
+                resumed ? "Resumed" : "Full", host, port,
+                _stats.lastHandshakeMs, _stats.lastBytesOut, _stats.lastBytesIn);
+
+  if (!resumed) saveSession(host, port);
+  return true;
+}
+
+void XBioTLSClient::saveSession(const char* host, uint16_t port) {
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_session_init(&_session);
+  if (mbedtls_ssl_get_session(&_ssl, &_session) != 0) {
+    _sessionValid = false;
+    return;
+  }
+
+  _sessionValid = true;
+  strncpy(_sessionHost, host, sizeof(_sessionHost) - 1);
+  _sessionHost[sizeof(_sessionHost) - 1] = '\0';
+  _sessionPort = port;
+  memcpy(_sessionTrust, XBioTLSContext::shared().trustHash(), sizeof(_sessionTrust));
+
+  if (_sessionSlot >= XBIO_TLS_SESSION_SLOTS) return;
+
+  TLSSessionRecord& rec = _tlsSessionRecords[_sessionSlot];
+  size_t length = 0;
+  if (mbedtls_ssl_session_save(&_session, rec.data, sizeof(rec.data), &length) != 0) {
+    Serial.println("TLS: Session too large for RTC cache, keeping it in RAM only");
+    rec.magic = 0;
+    return;
+  }
+
+  memcpy(rec.host, _sessionHost, sizeof(rec.host));
+  memcpy(rec.trust, _sessionTrust, sizeof(rec.trust));
+  rec.port = port;
+  rec.length = (uint16_t)length;
+  rec.crc = esp_rom_crc32_le(0, rec.data, rec.length);
+  rec.magic = XBIO_TLS_SESSION_MAGIC;
+}
+
+void XBioTLSClient::loadSession() {
+  if (_sessionValid || _sessionSlot >= XBIO_TLS_SESSION_SLOTS) return;
+
+  TLSSessionRecord& rec = _tlsSessionRecords[_sessionSlot];
+  if (rec.magic != XBIO_TLS_SESSION_MAGIC || rec.length > sizeof(rec.data) ||
+      rec.crc != esp_rom_crc32_le(0, rec.data, rec.length)) {
+    return;
+  }
+
+  if (memcmp(rec.trust, XBioTLSContext::shared().trustHash(), sizeof(rec.trust)) != 0) {
+    Serial.println("TLS: Cached session was verified under other trust settings, dropping it");
+    rec.magic = 0;
+    return;
+  }
+
+  if (mbedtls_ssl_session_load(&_session, rec.data, rec.length) != 0) {
+    rec.magic = 0;
+    return;
+  }
+
+  memcpy(_sessionHost, rec.host, sizeof(_sessionHost));
+  _sessionHost[sizeof(_sessionHost) - 1] = '\0';
+  _sessionPort = rec.port;
+  memcpy(_sessionTrust, rec.trust, sizeof(_sessionTrust));
+  _sessionValid = true;
+  Serial.printf("TLS: Restored cached session for %s:%u\n", _sessionHost, _sessionPort);
+}
+
+size_t XBioTLSClient::write(const uint8_t* buf, size_t size) {
+  if (!_connected) return 0;
+
+  size_t written = 0;
+  uint32_t start = millis();
+  while (written < size) {
+    int ret = mbedtls_ssl_write(&_ssl, buf + written, size - written);
+    if (ret > 0) {
+      written += ret;
+    } else if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) {
+      if (millis() - start > XBIO_TLS_HANDSHAKE_TIMEOUT) break;
+      delay(1);
+    } else {
+      stop();
+      break;
+    }
+  }
+  return written;
+}
+
+int XBioTLSClient::available() {
+  if (!_connected) return 0;
+
+  int pending = (int)mbedtls_ssl_get_bytes_avail(&_ssl);
+  if (pending == 0 && _socket.available()) {
+    // Process the next record so decrypted bytes become visible
+    int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      stop();
+      return _peeked >= 0 ? 1 : 0;
+    }
+    pending = (int)mbedtls_ssl_get_bytes_avail(&_ssl);
+  }
+  return pending + (_peeked >= 0 ? 1 : 0);
+}
+
+int XBioTLSClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int XBioTLSClient::read(uint8_t* buf, size_t size) {
+  if (size == 0) return 0;
+
+  int count = 0;
+  if (_peeked >= 0) {
+    buf[count++] = (uint8_t)_peeked;
+    _peeked = -1;
+    if (size == 1) return 1;
+  }
+  if (!_connected) return count > 0 ? count : -1;
+
+  int ret = mbedtls_ssl_read(&_ssl, buf + count, size - count);
+  if (ret > 0) return count + ret;
+  if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    stop(); // Close notify or fatal alert
+  }
+  return count > 0 ? count : -1;
+}
+
+int XBioTLSClient::peek() {
+  if (_peeked < 0) {
+    uint8_t b;
+    if (read(&b, 1) == 1) _peeked = b;
+  }
+  return _peeked;
+}
+
+void XBioTLSClient::stop() {
+  if (_connected) {
+    mbedtls_ssl_close_notify(&_ssl);
+    _connected = false;
+  }
+  _peeked = -1;
+  _socket.stop();
+  release();
+}
+
+uint8_t XBioTLSClient::connected() {
+  if (!_connected) return 0;
+  if (!_socket.connected() && mbedtls_ssl_get_bytes_avail(&_ssl) == 0 && _peeked < 0) {
+    _connected = false;
+    return 0;
+  }
+  return 1;
+}
+
+int XBioTLSClient::bioSend(void* ctx, const unsigned char* buf, size_t len) {
+  XBioTLSClient* self = (XBioTLSClient*)ctx;
+  if (!self->_socket.connected()) return MBEDTLS_ERR_SSL_CONN_EOF;
+
+  size_t n = self->_socket.write(buf, len);
+  if (n == 0) return MBEDTLS_ERR_SSL_WANT_WRITE;
+  self->_bytesOut += n;
+  return (int)n;
+}
+
+int XBioTLSClient::bioRecv(void* ctx, unsigned char* buf, size_t len) {
+  XBioTLSClient* self = (XBioTLSClient*)ctx;
+  if (!self->_socket.available()) {
+    return self->_socket.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_SSL_CONN_EOF;
+  }
+
+  int n = self->_socket.read(buf, len);
+  if (n <= 0) return MBEDTLS_ERR_SSL_WANT_READ;
+  self->_bytesIn += n;
+  return n;
+}
+
+#endif // TLS_TRANSPORT_H
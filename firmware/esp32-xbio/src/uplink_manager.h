@@ -0,0 +1,137 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🛰️ Uplink Manager - Single TLS Uplink Policy for MQTT + WebSocket
+ * Keeps one TLS connection open when MQTT is healthy, WS only as failover
+ * ═══════════════════════════════════════════════════════════════════════════════
+ *
+ * Every TLS link costs its own record buffers (~40 KB internal RAM) and
+ * keepalive traffic. In AUTO mode the WebSocket link is closed while MQTT is
+ * healthy and its live frames are tunnelled on xbio/<id>/ws instead; the WS
+ * link only comes back when MQTT has been down for UPLINK_FAILOVER_MS.
+ */
+
+#ifndef UPLINK_MANAGER_H
+#define UPLINK_MANAGER_H
+
+#include <Arduino.h>
+#include "mqtt_client.h"
+#include "websocket_handler.h"
+
+#ifndef UPLINK_HEALTHY_MS
+  #define UPLINK_HEALTHY_MS 10000     // MQTT connected this long -> drop WS
+#endif
+
+#ifndef UPLINK_FAILOVER_MS
+  #define UPLINK_FAILOVER_MS 30000    // MQTT down this long -> bring WS up
+#endif
+
+enum class UplinkMode : uint8_t {
+  DUAL = 0,        // MQTT and WS both connected (legacy)
+  AUTO = 1,        // WS only while MQTT is unavailable
+  MQTT_ONLY = 2    // Never open WS; frames always tunnelled
+};
+
+struct UplinkStats {
+  UplinkMode mode;
+  uint8_t activeLinks;        // Open TLS connections
+  bool wsActive;
+  uint32_t failovers;         // WS brought up because MQTT was down
+  uint32_t tunnelledFrames;   // WS frames carried over MQTT
+  uint32_t tlsHeapPerLink;    // Measured internal heap cost of one TLS link
+  uint32_t heapSaved;         // tlsHeapPerLink while the WS link is suppressed
+};
+
+class XBioUplink {
+public:
+  XBioUplink() : _mqtt(nullptr), _ws(nullptr), _mode(UplinkMode::AUTO),
+                 _mqttUpSince(0), _mqttDownSince(0), _mqttWasUp(false) {
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+  void begin(XBioMQTTClient* mqtt, XBioWebSocket* ws, UplinkMode mode, const char* deviceId) {
+    _mqtt = mqtt;
+    _ws = ws;
+    _mode = mode;
+    _streamTopic = "xbio/" + String(deviceId) + "/ws";
+    _mqttDownSince = millis();
+
+    // AUTO starts with WS held back to give MQTT a chance to come up first
+    if (_ws->isInitialized()) {
+      _ws->setEnabled(_mode == UplinkMode::DUAL || (_mode == UplinkMode::AUTO && !_mqtt->isInitialized()));
+    }
+
+    Serial.printf("Uplink: Mode %s\n", modeName());
+  }
+
+  void loop() {
+    if (!_mqtt || !_ws) return;
+
+    uint32_t now = millis();
+    bool mqttUp = _mqtt->isConnected();
+    if (mqttUp && !_mqttWasUp) _mqttUpSince = now;
+    if (!mqttUp && _mqttWasUp) _mqttDownSince = now;
+    _mqttWasUp = mqttUp;
+
+    if (_mode == UplinkMode::AUTO && _ws->isInitialized() && _mqtt->isInitialized()) {
+      if (_ws->isEnabled() && mqttUp && now - _mqttUpSince >= UPLINK_HEALTHY_MS) {
+        Serial.println("Uplink: MQTT healthy - closing WS link");
+        _ws->setEnabled(false);
+      } else if (!_ws->isEnabled() && !mqttUp && now - _mqttDownSince >= UPLINK_FAILOVER_MS) {
+        Serial.println("Uplink: MQTT down - failing over to WS");
+        _ws->setEnabled(true);
+        _stats.failovers++;
+      }
+    }
+
+    _ws->loop();
+  }
+
+  /**
+   * Send a live-stream frame on whichever link is open
+   */
+  bool sendFrame(const char* json, size_t length) {
+    if (_ws && _ws->isConnected()) {
+      return _ws->sendText(json, length);
+    }
+    if (_mode != UplinkMode::DUAL && _mqtt && _mqtt->isConnected()) {
+      _stats.tunnelledFrames++;
+      return _mqtt->publish(_streamTopic.c_str(), json);
+    }
+    return false;
+  }
+
+  UplinkStats getStats() {
+    UplinkStats stats = _stats;
+    stats.mode = _mode;
+    stats.wsActive = _ws && _ws->isConnected();
+    stats.activeLinks = (_mqtt && _mqtt->isConnected() ? 1 : 0) + (stats.wsActive ? 1 : 0);
+
+    // Both links use the same server and shared TLS config, so either measurement stands in
+    uint32_t mqttHeap = _mqtt && _mqtt->isSecure() ? _mqtt->getTLSStats().heapBytes : 0;
+    uint32_t wsHeap = _ws ? _ws->getTLSStats().heapBytes : 0;
+    stats.tlsHeapPerLink = wsHeap ? wsHeap : mqttHeap;
+    stats.heapSaved = (_ws && _ws->isInitialized() && !_ws->isEnabled()) ? stats.tlsHeapPerLink : 0;
+    return stats;
+  }
+
+  const char* modeName() {
+    switch (_mode) {
+      case UplinkMode::DUAL: return "dual";
+      case UplinkMode::MQTT_ONLY: return "mqtt_only";
+      default: return "auto";
+    }
+  }
+
+private:
+  XBioMQTTClient* _mqtt;
+  XBioWebSocket* _ws;
+  UplinkMode _mode;
+  String _streamTopic;
+
+  uint32_t _mqttUpSince;
+  uint32_t _mqttDownSince;
+  bool _mqttWasUp;
+  UplinkStats _stats;
+};
+
+#endif
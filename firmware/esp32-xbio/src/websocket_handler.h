@@ -1,6 +1,7 @@
 /**
  * ═══════════════════════════════════════════════════════════════════════════════
  * 🔌 WebSocket Handler - Real-time Data Streaming
+ * Minimal RFC 6455 client over the shared TLS context
  * ═══════════════════════════════════════════════════════════════════════════════
  */
 
@@ -8,59 +9,283 @@
 #define WEBSOCKET_HANDLER_H
 
 #include <Arduino.h>
-#include <WebSocketsClient.h>
-#include <ArduinoJson.h>
-#include "bme688_driver.h"
+#include <esp_system.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha1.h>
+#include "tls_transport.h"
+
+#ifndef WS_RECONNECT_INTERVAL
+  #define WS_RECONNECT_INTERVAL 5000
+#endif
+
+#ifndef WS_RX_BUFFER_SIZE
+  #define WS_RX_BUFFER_SIZE 1024
+#endif
+
+#ifndef WS_TX_BUFFER_SIZE
+  #define WS_TX_BUFFER_SIZE 512
+#endif
+
+// Text frame payload - valid only during the call
+typedef void (*WSMessageCallback)(const char* payload, size_t length);
+
+#define WS_TLS_SESSION_SLOT 1 // RAM-only session cache unless XBIO_TLS_SESSION_SLOTS > 1
 
 class XBioWebSocket {
 public:
-  XBioWebSocket() : _connected(false), _initialized(false) {}
-  
+  XBioWebSocket()
+    : _tls(WS_TLS_SESSION_SLOT), _port(443), _initialized(false), _enabled(false),
+      _connected(false), _lastAttempt(0), _rxLength(0), _messageCallback(nullptr) {
+    memset(_host, 0, sizeof(_host));
+    memset(_path, 0, sizeof(_path));
+  }
+
   void begin(const char* host, int port = 443, const char* path = "/ws/xbio") {
-    _ws.beginSSL(host, port, path);
-    _ws.onEvent([this](WStype_t type, uint8_t* payload, size_t length) {
-      handleEvent(type, payload, length);
-    });
-    _ws.setReconnectInterval(5000);
+    strncpy(_host, host, sizeof(_host) - 1);
+    strncpy(_path, path, sizeof(_path) - 1);
+    _port = port;
     _initialized = true;
+    _enabled = true;
+    _lastAttempt = millis() - WS_RECONNECT_INTERVAL; // Connect on first loop()
   }
-  
-  void loop() { if (_initialized) _ws.loop(); }
+
+  void loop() {
+    if (!_initialized || !_enabled) return;
+
+    if (_connected && !_tls.connected()) {
+      _connected = false;
+      Serial.println("WS: Disconnected");
+    }
+
+    if (!_connected) {
+      uint32_t now = millis();
+      if (now - _lastAttempt >= WS_RECONNECT_INTERVAL) {
+        _lastAttempt = now;
+        connectNow();
+      }
+      return;
+    }
+
+    pollFrames();
+  }
+
+  /**
+   * Enable/disable the link - disabling closes the socket and frees its TLS buffers
+   */
+  void setEnabled(bool enabled) {
+    if (enabled == _enabled) return;
+    _enabled = enabled;
+    if (!enabled) {
+      end();
+    } else {
+      _lastAttempt = millis() - WS_RECONNECT_INTERVAL;
+    }
+  }
+
+  void end() {
+    if (_connected) {
+      sendFrame(0x8, nullptr, 0); // Close
+      Serial.println("WS: Closed");
+    }
+    _tls.stop();
+    _connected = false;
+    _rxLength = 0;
+  }
+
+  bool isInitialized() { return _initialized; }
+  bool isEnabled() { return _enabled; }
   bool isConnected() { return _connected; }
-  
-  void broadcastSensorData(SensorData data) {
-    if (!_connected) return;
-    JsonDocument doc;
-    doc["type"] = "sensor_data";
-    doc["t"] = data.temperature;
-    doc["h"] = data.humidity;
-    doc["p"] = data.pressure;
-    doc["g"] = data.gasResistance;
-    doc["q"] = data.iaq;
-    char buffer[256];
-    serializeJson(doc, buffer);
-    _ws.sendTXT(buffer);
+  TLSHandshakeStats getTLSStats() { return _tls.getStats(); }
+
+  void setMessageCallback(WSMessageCallback callback) { _messageCallback = callback; }
+
+  bool sendText(const char* text, size_t length) {
+    return sendFrame(0x1, (const uint8_t*)text, length);
   }
-  
+
 private:
-  WebSocketsClient _ws;
-  bool _connected;
+  XBioTLSClient _tls;
+  char _host[64];
+  char _path[64];
+  int _port;
   bool _initialized;
-  
-  void handleEvent(WStype_t type, uint8_t* payload, size_t length) {
-    switch (type) {
-      case WStype_CONNECTED: _connected = true; Serial.println("WS: Connected"); break;
-      case WStype_DISCONNECTED: _connected = false; Serial.println("WS: Disconnected"); break;
-      case WStype_TEXT: handleMessage((char*)payload); break;
-      default: break;
+  bool _enabled;
+  bool _connected;
+  uint32_t _lastAttempt;
+
+  uint8_t _rx[WS_RX_BUFFER_SIZE];
+  size_t _rxLength;
+  uint8_t _tx[WS_TX_BUFFER_SIZE + 14];
+  WSMessageCallback _messageCallback;
+
+  bool connectNow() {
+    if (!_tls.connect(_host, _port)) {
+      Serial.printf("WS: Connection to %s:%d failed\n", _host, _port);
+      return false;
     }
+
+    if (!upgrade()) {
+      _tls.stop();
+      return false;
+    }
+
+    _connected = true;
+    _rxLength = 0;
+    Serial.println("WS: Connected");
+    return true;
+  }
+
+  bool upgrade() {
+    // Sec-WebSocket-Key: base64 of 16 random bytes
+    uint8_t nonce[16];
+    esp_fill_random(nonce, sizeof(nonce));
+    char key[32];
+    size_t keyLength = 0;
+    mbedtls_base64_encode((unsigned char*)key, sizeof(key), &keyLength, nonce, sizeof(nonce));
+    key[keyLength] = '\0';
+
+    char request[256];
+    int length = snprintf(request, sizeof(request),
+      "GET %s HTTP/1.1\r\n"
+      "Host: %s\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key: %s\r\n"
+      "Sec-WebSocket-Version: 13\r\n\r\n",
+      _path, _host, key);
+    if (length < 0 || length >= (int)sizeof(request)) {
+      Serial.println("WS: Upgrade request too long");
+      return false;
+    }
+    if (_tls.write((const uint8_t*)request, length) != (size_t)length) return false;
+
+    // Expected Sec-WebSocket-Accept: base64(SHA1(key + GUID))
+    char concat[sizeof(key) + 36];
+    snprintf(concat, sizeof(concat), "%s258EAFA5-E914-47DA-95CA-C5AB0DC85B11", key);
+    uint8_t digest[20];
+    #if MBEDTLS_VERSION_MAJOR >= 3
+      mbedtls_sha1((const unsigned char*)concat, strlen(concat), digest);
+    #else
+      mbedtls_sha1_ret((const unsigned char*)concat, strlen(concat), digest);
+    #endif
+    char accept[32];
+    size_t acceptLength = 0;
+    mbedtls_base64_encode((unsigned char*)accept, sizeof(accept), &acceptLength, digest, sizeof(digest));
+    accept[acceptLength] = '\0';
+
+    // Read response headers
+    char response[512];
+    size_t received = 0;
+    uint32_t start = millis();
+    while (received < sizeof(response) - 1 && millis() - start < 5000) {
+      if (!_tls.available()) {
+        if (!_tls.connected()) break;
+        delay(1);
+        continue;
+      }
+      int c = _tls.read();
+      if (c < 0) continue;
+      response[received++] = (char)c;
+      if (received >= 4 && memcmp(response + received - 4, "\r\n\r\n", 4) == 0) break;
+    }
+    response[received] = '\0';
+
+    if (strncmp(response, "HTTP/1.1 101", 12) != 0 || !strstr(response, accept)) {
+      Serial.println("WS: Upgrade rejected");
+      return false;
+    }
+    return true;
+  }
+
+  bool sendFrame(uint8_t opcode, const uint8_t* payload, size_t length) {
+    if (!_connected || length > WS_TX_BUFFER_SIZE) return false;
+
+    // Client frames are always masked (RFC 6455 §5.3)
+    size_t header = 0;
+    _tx[header++] = 0x80 | opcode;
+    if (length < 126) {
+      _tx[header++] = 0x80 | length;
+    } else {
+      _tx[header++] = 0x80 | 126;
+      _tx[header++] = (uint8_t)(length >> 8);
+      _tx[header++] = (uint8_t)(length & 0xFF);
+    }
+    uint32_t mask = esp_random();
+    uint8_t* maskKey = _tx + header;
+    memcpy(maskKey, &mask, 4);
+    header += 4;
+
+    for (size_t i = 0; i < length; i++) {
+      _tx[header + i] = payload[i] ^ maskKey[i & 3];
+    }
+
+    // One write -> one TLS record
+    return _tls.write(_tx, header + length) == header + length;
   }
-  
-  void handleMessage(char* payload) {
-    JsonDocument doc;
-    if (deserializeJson(doc, payload) == DeserializationError::Ok) {
-      String type = doc["type"] | "";
-      Serial.printf("WS: Received %s\n", type.c_str());
+
+  void pollFrames() {
+    int avail;
+    while ((avail = _tls.available()) > 0 && _rxLength < WS_RX_BUFFER_SIZE) {
+      int n = _tls.read(_rx + _rxLength, min((size_t)avail, WS_RX_BUFFER_SIZE - _rxLength));
+      if (n <= 0) break;
+      _rxLength += n;
+    }
+
+    while (_rxLength >= 2) {
+      uint8_t opcode = _rx[0] & 0x0F;
+      bool fin = _rx[0] & 0x80;
+      bool masked = _rx[1] & 0x80;
+      size_t length = _rx[1] & 0x7F;
+      size_t header = 2;
+
+      if (length == 126) {
+        if (_rxLength < 4) return;
+        length = (_rx[2] << 8) | _rx[3];
+        header = 4;
+      } else if (length == 127) {
+        Serial.println("WS: Frame too large");
+        end();
+        return;
+      }
+      if (masked) header += 4;
+
+      if (header + length > WS_RX_BUFFER_SIZE) {
+        Serial.println("WS: Frame too large");
+        end();
+        return;
+      }
+      if (_rxLength < header + length) return; // Wait for the rest
+
+      uint8_t* payload = _rx + header;
+      if (masked) {
+        for (size_t i = 0; i < length; i++) payload[i] ^= _rx[header - 4 + (i & 3)];
+      }
+
+      switch (opcode) {
+        case 0x1: // Text
+          if (fin) handleMessage((const char*)payload, length);
+          break;
+        case 0x8: // Close
+          end();
+          return;
+        case 0x9: // Ping
+          sendFrame(0xA, payload, length);
+          break;
+        default:
+          break;
+      }
+
+      size_t consumed = header + length;
+      memmove(_rx, _rx + consumed, _rxLength - consumed);
+      _rxLength -= consumed;
+    }
+  }
+
+  void handleMessage(const char* payload, size_t length) {
+    if (_messageCallback) {
+      _messageCallback(payload, length);
+    } else {
+      Serial.printf("WS: Received %u bytes\n", (unsigned)length);
     }
   }
 };
@@ -0,0 +1,158 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧪 xBio BME688 driver bench (host)
+ * Runs the firmware BME688Driver against the register-level simulator
+ * (native/include/bme688_sim.h) in virtual time and reports, per scenario,
+ * the I2C cost of begin() and of each read(), how often read() returns a
+ * result it already returned or one still being converted, and the error
+ * against the environment the simulated sensor sat in.
+ *
+ *   g++ -std=gnu++17 -O2 -pthread -DARDUINO=10812 -I../native/include -I../src \
+ *       bme688_bench.cpp -o bme688_bench
+ *
+ *   ./bme688_bench [reads] [trace.csv]
+ *
+ * Without a trace the environment is a slow synthetic drift (temperature,
+ * humidity, pressure ramps, gas cycling), so stale results show up as error.
+ * Scenarios: clean bus, 1 % NACKs, a 2 s stuck bus, a missing part and a
+ * wrong chip ID. Bus time is given at the firmware's 400 kHz.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <bme688_sim.h>
+
+#include "bme688_driver.h"
+
+#ifndef BME688_SDA
+  #define BME688_SDA 8
+#endif
+
+#ifndef BME688_SCL
+  #define BME688_SCL 9
+#endif
+
+#define BENCH_I2C_HZ 400000           // main.cpp: Wire.setClock(400000)
+#define BENCH_READ_INTERVAL 1000      // SENSOR_READ_INTERVAL
+
+struct Scenario {
+  const char* name;
+  void (*apply)(BME688Sim& sim);
+};
+
+struct Result {
+  bool began;
+  BME688SimStats init;
+  BME688SimStats reads;
+  uint32_t valid;
+  double readUs;                // Virtual time inside read()
+  double hostNs;                // Host time inside read()
+  double errTemp, errHum, errPress, errGas;
+  double maxTemp;
+};
+
+static BME688Environment drift(uint64_t nowUs) {
+  double s = nowUs / 1e6;
+  return BME688Environment{(float)(21.0 + s / 600.0), (float)(40.0 + 10.0 * sin(s / 900.0)),
+                           (float)(1005.0 + s / 3600.0), (float)(150000.0 + 100000.0 * sin(s / 300.0))};
+}
+
+static Result run(const Scenario& scenario, int reads, const char* tracePath) {
+  Result r = {};
+  hal::Clock::reset(0);
+
+  BME688Sim sim;
+  sim.attach(BME688_I2C_ADDR);
+  if (tracePath) {
+    sim.loadTrace(tracePath);
+  } else {
+    sim.setSource(drift);
+  }
+  scenario.apply(sim);
+
+  Wire.begin(BME688_SDA, BME688_SCL);
+  Wire.setClock(BENCH_I2C_HZ);
+
+  BME688Driver driver;
+  bool quiet = hal::Console::echo;
+  hal::Console::echo = false;
+  r.began = driver.begin();
+  hal::Console::echo = quiet;
+  r.init = sim.getStats();
+  if (!r.began) return r;
+
+  sim.resetStats();
+  uint64_t next = hal::Clock::nowUs();
+  for (int i = 0; i < reads; i++) {
+    if (next > hal::Clock::nowUs()) hal::Clock::advanceUs(next - hal::Clock::nowUs());
+    next += (uint64_t)BENCH_READ_INTERVAL * 1000;
+
+    uint64_t t0 = hal::Clock::nowUs();
+    uint32_t c0 = ESP.getCycleCount();
+    SensorData data = driver.read();
+    r.hostNs += (double)(uint32_t)(ESP.getCycleCount() - c0) * 1000.0 / ESP.getCpuFreqMHz();
+    r.readUs += (double)(hal::Clock::nowUs() - t0);
+    if (!data.valid) continue;
+
+    BME688Environment env = sim.environmentAt(t0);
+    double dt = fabs(data.temperature - env.temperature);
+    r.errTemp += dt;
+    r.maxTemp = dt > r.maxTemp ? dt : r.maxTemp;
+    r.errHum += fabs(data.humidity - env.humidity);
+    r.errPress += fabs(data.pressure - env.pressure);
+    r.errGas += fabs(data.gasResistance - env.gasResistance) / env.gasResistance;
+    r.valid++;
+  }
+  r.reads = sim.getStats();
+  return r;
+}
+
+static void report(const Scenario& scenario, const Result& r, int reads) {
+  printf("\n%s\n", scenario.name);
+  printf("  begin():   %s, %u transactions, %u bytes, %u NACKs, %.0f us bus\n",
+         r.began ? "ok" : "FAILED", r.init.writes + r.init.reads, r.init.bytesWritten + r.init.bytesRead,
+         r.init.nacks, r.init.busTimeUs(BENCH_I2C_HZ));
+  if (!r.began) return;
+
+  const BME688SimStats& s = r.reads;
+  double n = reads;
+  printf("  read():    %.1f transactions, %.1f bytes, %.0f us bus, %.1f ms blocked, %.0f ns host (per call)\n",
+         (s.writes + s.reads) / n, (s.bytesWritten + s.bytesRead) / n, s.busTimeUs(BENCH_I2C_HZ) / n,
+         r.readUs / n / 1000.0, r.hostNs / n);
+  printf("  results:   %u conversions / %u triggers, %u stale of %d, %u NACKs\n", s.conversions, s.triggers,
+         s.staleReads, reads, s.nacks);
+  if (r.valid) {
+    printf("  error:     T %.3f C (max %.3f), RH %.2f %%, P %.3f hPa, gas %.1f %%\n", r.errTemp / r.valid,
+           r.maxTemp, r.errHum / r.valid, r.errPress / r.valid, 100.0 * r.errGas / r.valid);
+  }
+}
+
+int main(int argc, char** argv) {
+  int reads = argc > 1 ? atoi(argv[1]) : 600;
+  const char* trace = argc > 2 ? argv[2] : nullptr;
+  if (reads <= 0) {
+    fprintf(stderr, "Usage: %s [reads] [trace.csv]\n", argv[0]);
+    return 1;
+  }
+
+  static const Scenario scenarios[] = {
+    {"clean bus", [](BME688Sim&) {}},
+    {"1% NACK", [](BME688Sim& sim) { sim.faults.nackRate = 0.01f; }},
+    {"bus stuck 2 s at t=60 s", [](BME688Sim& sim) {
+      sim.faults.stuckFromUs = 60000000;
+      sim.faults.stuckUntilUs = 62000000;
+    }},
+    {"part missing", [](BME688Sim& sim) { sim.faults.absentUntilUs = UINT64_MAX; }},
+    {"wrong chip ID (BME280)", [](BME688Sim& sim) { sim.faults.chipId = 0x60; }},
+  };
+
+  printf("BME688Driver vs simulated BME688: %d reads every %d ms, %s, I2C %u kHz\n", reads, BENCH_READ_INTERVAL,
+         trace ? trace : "synthetic drift", BENCH_I2C_HZ / 1000);
+  for (const Scenario& scenario : scenarios) report(scenario, run(scenario, reads, trace), reads);
+  return 0;
+}
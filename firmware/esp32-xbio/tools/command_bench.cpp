@@ -0,0 +1,140 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * ⏱️ xBio command dispatch benchmark (host)
+ * Measures name lookup and full dispatch latency for the firmware command
+ * table and counts heap allocations made while dispatching.
+ *
+ *   g++ -std=c++17 -O2 -I../src command_bench.cpp -o command_bench && ./command_bench
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "command_dispatch.h"
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Allocation counter
+// ═══════════════════════════════════════════════════════════════════════════════
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = malloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Same names and parameters as the firmware table in main.cpp
+// ═══════════════════════════════════════════════════════════════════════════════
+static volatile int32_t sink;
+
+static void onCommand(const CommandArgs& args) {
+  sink = sink + args.count + args.getInt(0);
+}
+
+static constexpr CommandParam setConfigParams[] = {
+  {"temp_offset", ParamType::FLOAT, false},
+  {"humidity_offset", ParamType::FLOAT, false},
+  {"device_name", ParamType::STRING, false},
+};
+static constexpr CommandParam sleepParams[] = {
+  {"duration_ms", ParamType::INT, false},
+};
+static constexpr CommandParam otaParams[] = {
+  {"url", ParamType::STRING, true},
+};
+
+static constexpr CommandSpec specs[] = {
+  {"restart", onCommand, COMMAND_NO_PARAMS},
+  {"set_config", onCommand, COMMAND_PARAMS(setConfigParams)},
+  {"get_status", onCommand, COMMAND_NO_PARAMS},
+  {"calibrate", onCommand, COMMAND_NO_PARAMS},
+  {"sleep", onCommand, COMMAND_PARAMS(sleepParams)},
+  {"ota_update", onCommand, COMMAND_PARAMS(otaParams)},
+};
+static constexpr CommandTable<sizeof(specs) / sizeof(specs[0])> table(specs);
+static_assert(table.valid(), "no collision-free seed");
+
+// Baseline: the if/else chain the firmware used, as a linear compare
+static const CommandSpec* linearFind(const char* name, size_t length) {
+  for (const CommandSpec& spec : specs) {
+    if (strlen(spec.name) == length && memcmp(spec.name, name, length) == 0) return &spec;
+  }
+  return nullptr;
+}
+
+template <typename F>
+static double nsPerOp(size_t iterations, F&& body) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) body(i);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main() {
+  const size_t iterations = 2000000;
+  const char* names[] = {"restart", "set_config", "get_status", "calibrate", "sleep", "ota_update", "bogus"};
+  const size_t nameCount = sizeof(names) / sizeof(names[0]);
+  size_t lengths[nameCount];
+  for (size_t i = 0; i < nameCount; i++) lengths[i] = strlen(names[i]);
+
+  printf("Command table: %zu commands, %zu slots, seed %u\n", table.size(), table.SLOTS, table.seed());
+
+  volatile uintptr_t found = 0;
+  double hashNs = nsPerOp(iterations, [&](size_t i) {
+    found = found + (uintptr_t)table.find(names[i % nameCount], lengths[i % nameCount]);
+  });
+  double linearNs = nsPerOp(iterations, [&](size_t i) {
+    found = found + (uintptr_t)linearFind(names[i % nameCount], lengths[i % nameCount]);
+  });
+  printf("Lookup   perfect hash %6.1f ns   linear compare %6.1f ns\n", hashNs, linearNs);
+
+  struct Case { const char* label; const char* payload; CommandResult expected; };
+  const Case cases[] = {
+    {"restart", "{\"command\":\"restart\"}", CommandResult::OK},
+    {"sleep", "{\"command\":\"sleep\",\"duration_ms\":60000}", CommandResult::OK},
+    {"set_config", "{\"command\":\"set_config\",\"temp_offset\":-1.25,\"humidity_offset\":2.5,"
+                   "\"device_name\":\"Lab \\\"north\\\"\",\"max_temp\":35}", CommandResult::OK},
+    {"ota (missing url)", "{\"command\":\"ota_update\"}", CommandResult::MISSING_PARAM},
+    {"BLE bare name", "calibrate\r\n", CommandResult::OK},
+    {"unknown", "{\"command\":\"bogus\",\"x\":[1,{\"y\":2}]}", CommandResult::UNKNOWN},
+  };
+
+  bool ok = true;
+  for (const Case& c : cases) {
+    size_t length = strlen(c.payload);
+    CommandResult result = table.dispatch(CommandSource::MQTT, c.payload, length);
+    if (result != c.expected) {
+      printf("❌ %s: %s (expected %s)\n", c.label, commandResultName(result), commandResultName(c.expected));
+      ok = false;
+    }
+
+    size_t before = allocations;
+    double ns = nsPerOp(iterations / 4, [&](size_t) {
+      table.dispatch(CommandSource::MQTT, c.payload, length);
+    });
+    printf("Dispatch %-18s %6.1f ns  %zu allocations\n", c.label, ns, allocations - before);
+  }
+
+  // Typed parameter round-trip
+  struct Probe {
+    static void run(const CommandArgs& args) {
+      char name[32];
+      args.getString(2, name, sizeof(name));
+      printf("Parsed   temp_offset=%.2f humidity_offset=%.2f device_name=%s\n",
+             args.getFloat(0), args.getFloat(1), name);
+    }
+  };
+  const CommandSpec probeSpecs[] = {{"set_config", Probe::run, COMMAND_PARAMS(setConfigParams)}};
+  CommandTable<1> probe(probeSpecs);
+  probe.dispatch(CommandSource::BLE, cases[2].payload, strlen(cases[2].payload));
+
+  printf(ok ? "✅ All dispatch results as expected\n" : "❌ Dispatch mismatch\n");
+  return ok ? 0 : 1;
+}
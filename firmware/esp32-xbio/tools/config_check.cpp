@@ -0,0 +1,279 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🗄️ xBio config store check (host)
+ * Runs src/config_manager.h against the native shim's Preferences, with the
+ * NVS contents set up and inspected directly through hal::Nvs, and checks
+ * the storage paths a device only hits once in its life:
+ *
+ *   legacy     per-key settings from the pre-blob firmware migrate into the
+ *              blob on first boot, the old keys are erased, and the next
+ *              boot loads the blob without writing anything
+ *   newer      a blob from a newer schema (OTA rollback) keeps its extra
+ *              bytes and its version through a commit, with a valid CRC
+ *   rejected   a blob with a bad CRC, an out-of-range value or an
+ *              inconsistent pair is ignored and the defaults are used
+ *   patch      apply() with one bad field changes nothing: record, hash,
+ *              dirty set and listeners all stay as they were
+ *
+ *   g++ -std=gnu++17 -O2 -pthread -DARDUINO=10812 -I../native/include -I../src \
+ *       config_check.cpp -o config_check
+ *
+ *   ./config_check [--verbose]
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include "config_manager.h"
+
+#define CHECK_NAMESPACE "xbio"
+#define CHECK_EXTRA_BYTES 12            // Fields a future schema appended
+
+static bool failed = false;
+static uint32_t notifications = 0;
+
+static void expect(bool condition, const char* what) {
+  if (condition) return;
+  printf("   ❌ %s\n", what);
+  failed = true;
+}
+
+static void onChange(ConfigKey) {
+  notifications++;
+}
+
+static std::vector<uint8_t>& stored(const char* key) {
+  return hal::Nvs::space(CHECK_NAMESPACE)[key];
+}
+
+static bool storedHas(const char* key) {
+  return hal::Nvs::space(CHECK_NAMESPACE).count(key) > 0;
+}
+
+// Blob as a given firmware would have written it: header, record, then its extra fields
+static std::vector<uint8_t> makeBlob(const ConfigRecord& record, uint16_t version, const uint8_t* extra,
+                                     uint16_t extraLength) {
+  std::vector<uint8_t> body(sizeof(record) + extraLength);
+  memcpy(body.data(), &record, sizeof(record));
+  if (extraLength) memcpy(body.data() + sizeof(record), extra, extraLength);
+  ConfigBlobHeader header = {CONFIG_BLOB_MAGIC, version, (uint16_t)body.size(),
+                             ConfigManager::crc32(body.data(), body.size())};
+  std::vector<uint8_t> blob(sizeof(header));
+  memcpy(blob.data(), &header, sizeof(header));
+  blob.insert(blob.end(), body.begin(), body.end());
+  return blob;
+}
+
+static bool parseStored(ConfigBlobHeader& header, std::vector<uint8_t>& body) {
+  if (!storedHas(CONFIG_BLOB_KEY)) return false;
+  const std::vector<uint8_t>& blob = stored(CONFIG_BLOB_KEY);
+  if (blob.size() < sizeof(header)) return false;
+  memcpy(&header, blob.data(), sizeof(header));
+  body.assign(blob.begin() + sizeof(header), blob.end());
+  return header.magic == CONFIG_BLOB_MAGIC && header.length == body.size() &&
+         header.crc == ConfigManager::crc32(body.data(), body.size());
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Cases
+// ═══════════════════════════════════════════════════════════════════════════════
+
+static void checkLegacyMigration() {
+  printf("legacy: per-key settings migrate and are erased\n");
+  hal::Nvs::clear();
+  {
+    Preferences prefs;
+    prefs.begin(CHECK_NAMESPACE, false);
+    prefs.putString("device_id", "xbio-legacy-07");
+    prefs.putString("device_name", "Greenhouse 2");
+    prefs.putFloat("temp_off", -1.5f);
+    prefs.putFloat("max_temp", 41.0f);
+    prefs.putInt("max_iaq", 220);
+    prefs.putString("mqtt_srv", "broker.lan");
+    prefs.putInt("mqtt_port", 8883);
+    prefs.putBool("mqtt_tls", true);
+    prefs.putUChar("uplink", 2);          // Stored as uint8 before the blob
+    prefs.putUShort("ota_rate", 128);     // Stored as uint16 before the blob
+    prefs.putString("tls_ca", "-----BEGIN CERTIFICATE-----");
+    prefs.end();
+  }
+
+  ConfigManager config;
+  config.begin();
+  const ConfigRecord& r = config.record();
+  expect(strcmp(r.deviceId, "xbio-legacy-07") == 0, "device_id carried over");
+  expect(strcmp(r.deviceName, "Greenhouse 2") == 0, "device_name carried over");
+  expect(r.tempOffset == -1.5f && r.maxTemperature == 41.0f, "float settings carried over");
+  expect(r.maxIAQ == 220 && r.mqttPort == 8883 && r.mqttTls == 1, "int / bool settings carried over");
+  expect(r.uplinkMode == 2 && r.otaRateLimit == 128, "narrow legacy types widened");
+  expect(r.minTemperature == 10.0f && r.anomalyZ == 6.0f, "unset fields at their defaults");
+  expect(strcmp(config.getTlsCaCert().c_str(), "-----BEGIN CERTIFICATE-----") == 0, "tls_ca loaded");
+
+  ConfigBlobHeader header;
+  std::vector<uint8_t> body;
+  expect(parseStored(header, body), "blob written with a valid header and CRC");
+  expect(header.version == CONFIG_SCHEMA_VERSION && body.size() == sizeof(ConfigRecord) &&
+         memcmp(body.data(), &r, sizeof(r)) == 0, "blob holds the migrated record");
+  for (uint8_t k = 0; k < CONFIG_RECORD_FIELDS; k++) {
+    if (storedHas(CONFIG_FIELDS[k].nvsKey)) {
+      printf("   ❌ legacy key %s still stored\n", CONFIG_FIELDS[k].nvsKey);
+      failed = true;
+    }
+  }
+  expect(storedHas("tls_ca"), "tls_ca keeps its own key");
+
+  // Second boot: straight from the blob, nothing to write
+  ConfigManager again;
+  again.begin();
+  expect(memcmp(&again.record(), &r, sizeof(r)) == 0 && again.hash() == config.hash(), "reboot loads the same record");
+  expect(again.getStats().commits == 0, "reboot does not rewrite the blob");
+}
+
+static void checkNewerSchema() {
+  printf("newer: a newer schema's extra bytes and version survive a commit\n");
+  hal::Nvs::clear();
+  ConfigRecord record;
+  ConfigManager::defaults(record);
+  ConfigManager::setString(record, ConfigKey::DEVICE_ID, "xbio-rollback");
+  record.maxIAQ = 180;
+  uint8_t extra[CHECK_EXTRA_BYTES];
+  for (uint8_t i = 0; i < CHECK_EXTRA_BYTES; i++) extra[i] = (uint8_t)(0xA0 + i);
+  const uint16_t newer = CONFIG_SCHEMA_VERSION + 1;
+  stored(CONFIG_BLOB_KEY) = makeBlob(record, newer, extra, CHECK_EXTRA_BYTES);
+
+  ConfigManager config;
+  config.begin();
+  expect(config.record().maxIAQ == 180 && strcmp(config.getDeviceId(), "xbio-rollback") == 0,
+         "known fields loaded");
+  expect(config.getStats().commits == 0, "loading alone does not rewrite the blob");
+
+  config.setMaxIAQ(300);
+  expect(config.commit() > 0, "change committed");
+
+  ConfigBlobHeader header;
+  std::vector<uint8_t> body;
+  expect(parseStored(header, body), "rewritten blob has a valid header and CRC");
+  expect(header.version == newer, "newer schema version kept");
+  expect(body.size() == sizeof(ConfigRecord) + CHECK_EXTRA_BYTES &&
+         memcmp(body.data() + sizeof(ConfigRecord), extra, CHECK_EXTRA_BYTES) == 0, "extra bytes kept as found");
+  ConfigRecord written;
+  memcpy(&written, body.data(), sizeof(written));
+  expect(written.maxIAQ == 300 && strcmp(written.deviceId, "xbio-rollback") == 0, "record part updated");
+
+  ConfigManager again;
+  again.begin();
+  expect(again.record().maxIAQ == 300, "reboot loads the committed value");
+}
+
+static void checkRejected() {
+  printf("rejected: bad CRC, out-of-range and inconsistent blobs fall back to defaults\n");
+  ConfigRecord defaults;
+  ConfigManager::defaults(defaults);
+
+  struct Bad {
+    const char* label;
+    void (*editRecord)(ConfigRecord& record);   // Before the CRC is computed
+    void (*editBlob)(std::vector<uint8_t>& blob);  // After
+  };
+  static const Bad cases[] = {
+    {"bad CRC", nullptr, [](std::vector<uint8_t>& blob) { blob.back() ^= 0x01; }},
+    {"max_iaq out of range", [](ConfigRecord& record) { record.maxIAQ = 900; }, nullptr},
+    {"anomaly_z NaN", [](ConfigRecord& record) { record.anomalyZ = NAN; }, nullptr},
+    {"min_temp >= max_temp", [](ConfigRecord& record) { record.minTemperature = 50; }, nullptr},
+    {"unterminated device_id", [](ConfigRecord& record) { memset(record.deviceId, 'x', sizeof(record.deviceId)); },
+     nullptr},
+    {"length disagrees with header", nullptr, [](std::vector<uint8_t>& blob) { blob.push_back(0); }},
+  };
+
+  for (const Bad& bad : cases) {
+    hal::Nvs::clear();
+    ConfigRecord record = defaults;
+    record.maxTemperature = 30.0f;      // A valid change the rejection must also discard
+    if (bad.editRecord) bad.editRecord(record);
+    std::vector<uint8_t> blob = makeBlob(record, CONFIG_SCHEMA_VERSION, nullptr, 0);
+    if (bad.editBlob) bad.editBlob(blob);
+    stored(CONFIG_BLOB_KEY) = blob;
+
+    ConfigManager config;
+    config.begin();
+    if (memcmp(&config.record(), &defaults, sizeof(defaults)) != 0) {
+      printf("   ❌ %s: stored record loaded instead of the defaults\n", bad.label);
+      failed = true;
+    }
+  }
+}
+
+static void checkPartialPatch() {
+  printf("patch: a partly invalid apply() changes nothing\n");
+  hal::Nvs::clear();
+  ConfigManager config;
+  config.begin();
+  config.setDeviceName("Lab bench");
+  config.commit();
+  config.addListener(onChange);
+  notifications = 0;
+
+  ConfigRecord before = config.record();
+  uint32_t hash = config.hash();
+  std::vector<uint8_t> blob = stored(CONFIG_BLOB_KEY);
+  uint32_t rejected = config.getStats().rejected;
+
+  struct Patch {
+    const char* label;
+    const char* error;
+    void (*edit)(ConfigRecord& record);
+  };
+  static const Patch patches[] = {
+    {"good name + max_iaq 9999", "max_iaq", [](ConfigRecord& r) {
+       ConfigManager::setString(r, ConfigKey::DEVICE_NAME, "Renamed");
+       r.maxIAQ = 9999;
+     }},
+    {"good offsets + mqtt_port 0", "mqtt_port", [](ConfigRecord& r) {
+       r.tempOffset = 2.0f;
+       r.humidityOffset = -3.0f;
+       r.mqttPort = 0;
+     }},
+    {"each bound valid alone, min_hum >= max_hum", "min_hum >= max_hum", [](ConfigRecord& r) {
+       r.minHumidity = 70.0f;
+       r.maxHumidity = 60.0f;
+     }},
+  };
+
+  for (const Patch& patch : patches) {
+    ConfigRecord next = config.record();
+    patch.edit(next);
+    bool applied = config.apply(next);
+    bool unchanged = memcmp(&config.record(), &before, sizeof(before)) == 0 && config.hash() == hash &&
+                     !config.isDirty() && notifications == 0 && stored(CONFIG_BLOB_KEY) == blob;
+    if (applied || !unchanged || !config.lastError() || strcmp(config.lastError(), patch.error) != 0) {
+      printf("   ❌ %s: %s (error %s)\n", patch.label, applied ? "applied" : "state changed",
+             config.lastError() ? config.lastError() : "none");
+      failed = true;
+    }
+  }
+  expect(config.getStats().rejected == rejected + 3, "every rejection counted");
+
+  // The same edits, valid, go through
+  ConfigRecord next = config.record();
+  ConfigManager::setString(next, ConfigKey::DEVICE_NAME, "Renamed");
+  next.maxIAQ = 400;
+  expect(config.apply(next) && config.record().maxIAQ == 400 && notifications == 2 && config.isDirty(),
+         "valid patch applied and notified per field");
+}
+
+int main(int argc, char** argv) {
+  hal::Console::echo = argc > 1 && strcmp(argv[1], "--verbose") == 0;
+
+  checkLegacyMigration();
+  checkNewerSchema();
+  checkRejected();
+  checkPartialPatch();
+
+  printf(failed ? "❌ Config store check failed\n" : "✅ Config store: migration, rollback, rejection and patches as expected\n");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,340 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 📬 xBio MQTT session bench (host)
+ * Runs the firmware's QoS 1 outbound queue (src/mqtt_session.h) and its
+ * PUBACK tap over the WiFiClient shim and reports publish throughput with N
+ * messages in flight, plus what a WiFi drop with a full window does to the
+ * backlog.
+ *
+ *   g++ -std=gnu++17 -O2 -pthread -DARDUINO=10812 -I../native/include -I../src \
+ *       mqtt_session_bench.cpp -o mqtt_session_bench
+ *
+ *   ./mqtt_session_bench [messages] [--broker host:port] [--payload bytes]
+ *
+ * By default the broker is the in-process stand-in (native/include/
+ * mqtt_broker_sim.h) in virtual time, swept over 2 / 20 / 100 ms round
+ * trips; there every number is exact and repeatable. With --broker the same
+ * queue talks to a real broker (mosquitto -p 1883) over host TCP and time is
+ * host time. A closed-loop producer keeps N messages outstanding (queued or
+ * in flight); above MQTT_INFLIGHT_WINDOW the window is the limit.
+ *
+ * The outage scenario fills the window, drops the AP and keeps sampling at
+ * 1 Hz for 3 x MQTT_QUEUE_DEPTH seconds, once with the queue rewound on link
+ * loss (XBioMQTTClient::checkLink) and once without, then reconnects and
+ * checks that the newest samples were the ones delivered.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <poll.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <mqtt_broker_sim.h>
+
+#include "mqtt_session.h"
+
+#define BENCH_SIM_HOST "broker.sim"
+#define BENCH_SIM_PORT 1883
+#define BENCH_TOPIC "xbio/bench/data"
+
+struct Options {
+  uint32_t messages = 2000;
+  size_t payload = 256;         // About one sensor JSON document
+  const char* host = nullptr;   // Real broker (host time) instead of the stand-in
+  uint16_t port = 1883;
+};
+
+struct Result {
+  bool ok;
+  double seconds;               // Clock time from first enqueue to last PUBACK
+  double hostUsPerMessage;      // Host CPU time per message (encode, write, frame)
+  MQTTQueueStats queue;
+  MQTTBrokerSimStats broker;
+};
+
+static Options options;
+static uint64_t hostStartNs = 0;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Transport helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+// Nothing to do: move to the next delivery (virtual) or wait for bytes (host)
+static void idle(WiFiClient& wifi) {
+  if (!options.host) {
+    uint64_t next = hal::Network::nextDeliveryUs();
+    uint64_t now = hal::Clock::nowUs();
+    hal::Clock::advanceUs(next == UINT64_MAX ? 1000 : next > now ? next - now : 1);
+    return;
+  }
+  pollfd p = {wifi.fd(), POLLIN, 0};
+  poll(&p, 1, 1);
+  hal::Clock::reset((hal::hostNs() - hostStartNs) / 1000); // millis() follows host time
+}
+
+static bool openSession(WiFiClient& wifi, MQTTSessionTap& tap, const char* clientId) {
+  const char* host = options.host ? options.host : BENCH_SIM_HOST;
+  uint16_t port = options.host ? options.port : BENCH_SIM_PORT;
+  if (!tap.connect(host, port)) return false;
+
+  // CONNECT: MQTT 3.1.1, clean session, 60 s keepalive
+  size_t idLength = strlen(clientId);
+  uint8_t packet[64];
+  size_t n = 0;
+  packet[n++] = 0x10;
+  packet[n++] = (uint8_t)(10 + 2 + idLength);
+  const uint8_t header[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02, 0x00, 60};
+  memcpy(packet + n, header, sizeof(header));
+  n += sizeof(header);
+  packet[n++] = 0;
+  packet[n++] = (uint8_t)idLength;
+  memcpy(packet + n, clientId, idLength);
+  n += idLength;
+  if (wifi.write(packet, n) != n) return false;
+
+  // CONNACK is read past the tap, whose framer then starts on the next packet
+  uint8_t connack[4];
+  size_t got = 0;
+  uint64_t deadlineUs = hal::Clock::nowUs() + 5000000ULL;
+  while (got < sizeof(connack)) {
+    if (!wifi.connected() || hal::Clock::nowUs() > deadlineUs) return false;
+    int r = wifi.available() > 0 ? wifi.read(connack + got, sizeof(connack) - got) : -1;
+    if (r > 0) {
+      got += (size_t)r;
+    } else {
+      idle(wifi);
+    }
+  }
+  return connack[0] == 0x20 && connack[3] == 0x00;
+}
+
+// Drain inbound bytes through the tap so PUBACKs reach the queue
+static bool drain(MQTTSessionTap& tap) {
+  uint8_t buffer[512];
+  bool progress = false;
+  while (tap.available() > 0) {
+    if (tap.read(buffer, sizeof(buffer)) <= 0) break;
+    progress = true;
+  }
+  return progress;
+}
+
+static bool enqueueSample(MQTTOutboundQueue& queue, uint32_t seq) {
+  char payload[2048];
+  size_t size = options.payload < sizeof(payload) ? options.payload : sizeof(payload) - 1;
+  int n = snprintf(payload, sizeof(payload), "{\"seq\":%u,\"pad\":\"", (unsigned)seq);
+  while ((size_t)n < size - 2) payload[n++] = 'x';
+  payload[n++] = '"';
+  payload[n++] = '}';
+  return queue.enqueue(BENCH_TOPIC, (const uint8_t*)payload, (size_t)n);
+}
+
+static uint32_t payloadSeq(const MQTTSimMessage& m) {
+  char head[32] = {};
+  memcpy(head, m.payload, m.length < sizeof(head) - 1 ? m.length : sizeof(head) - 1);
+  unsigned seq = 0;
+  return sscanf(head, "{\"seq\":%u", &seq) == 1 ? seq : UINT32_MAX;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Throughput with N outstanding
+// ═══════════════════════════════════════════════════════════════════════════════
+static Result runThroughput(uint32_t outstanding, uint32_t rttMs) {
+  Result r = {};
+  hal::Clock::reset(0);
+  hal::Network::latencyUs = (uint64_t)rttMs * 500;
+  hostStartNs = hal::hostNs();
+
+  MQTTBrokerSim broker;
+  if (!options.host) broker.listen(BENCH_SIM_HOST, BENCH_SIM_PORT);
+
+  MQTTOutboundQueue queue;
+  WiFiClient wifi;
+  MQTTSessionTap tap;
+  tap.setTransport(&wifi);
+  tap.setQueue(&queue);
+  if (!queue.begin() || !openSession(wifi, tap, "xbio-bench")) return r;
+
+  uint64_t startUs = hal::Clock::nowUs();
+  uint64_t startNs = hal::hostNs();
+  uint32_t produced = 0;
+
+  while (queue.getStats().acked < options.messages) {
+    bool progress = false;
+    while (produced < options.messages && queue.getStats().pending < outstanding) {
+      if (!enqueueSample(queue, produced)) return r;
+      produced++;
+      progress = true;
+    }
+    queue.pump(tap);
+    if (drain(tap)) progress = true;
+    if (!wifi.connected()) return r;
+    if (!progress) idle(wifi);
+  }
+
+  r.seconds = (hal::Clock::nowUs() - startUs) / 1e6;
+  r.hostUsPerMessage = (hal::hostNs() - startNs) / 1e3 / options.messages;
+  r.queue = queue.getStats();
+  r.broker = broker.getStats();
+  r.ok = true;
+  tap.stop();
+  return r;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// WiFi drop with a full window
+// ═══════════════════════════════════════════════════════════════════════════════
+struct OutageResult {
+  bool ok;
+  uint32_t sampled;             // Samples taken during the outage
+  uint32_t rejected;            // enqueue() returned false
+  uint32_t dropped;             // Queue drops (rejected + evicted)
+  uint32_t newest;              // Seq of the last sample taken
+  uint32_t delivered;           // Distinct samples the broker received
+  bool newestDelivered;         // The last MQTT_QUEUE_DEPTH samples all arrived
+};
+
+static OutageResult runOutage(bool rewindOnLoss) {
+  OutageResult r = {};
+  hal::Clock::reset(0);
+  hal::Network::latencyUs = 20000;
+  hal::Network::setApAvailable(true);
+
+  std::set<uint32_t> received;
+  MQTTBrokerSim broker;
+  broker.listen(BENCH_SIM_HOST, BENCH_SIM_PORT);
+  broker.onPublish = [&received](const MQTTSimMessage& m) { received.insert(payloadSeq(m)); };
+
+  MQTTOutboundQueue queue;
+  WiFiClient wifi;
+  MQTTSessionTap tap;
+  tap.setTransport(&wifi);
+  tap.setQueue(&queue);
+  if (!queue.begin() || !openSession(wifi, tap, "xbio-bench")) return r;
+
+  // A full window on the wire when the AP goes away
+  uint32_t seq = 0;
+  for (; seq < MQTT_INFLIGHT_WINDOW; seq++) enqueueSample(queue, seq);
+  queue.pump(tap);
+  hal::Network::setApAvailable(false);
+
+  if (!wifi.connected() && rewindOnLoss) queue.rewind();
+
+  uint32_t droppedBefore = queue.getStats().dropped;
+  for (uint32_t i = 0; i < 3 * MQTT_QUEUE_DEPTH; i++, seq++) {
+    hal::Clock::advanceUs(1000000);
+    r.sampled++;
+    if (!enqueueSample(queue, seq)) r.rejected++;
+  }
+  r.dropped = queue.getStats().dropped - droppedBefore;
+  r.newest = seq - 1;
+
+  hal::Network::setApAvailable(true);
+  if (!openSession(wifi, tap, "xbio-bench")) return r;
+  queue.rewind();
+  while (!queue.isEmpty()) {
+    queue.pump(tap);
+    if (!drain(tap)) idle(wifi);
+    if (!wifi.connected()) return r;
+  }
+
+  r.delivered = (uint32_t)received.size();
+  r.newestDelivered = true;
+  for (uint32_t s = r.newest + 1 - MQTT_QUEUE_DEPTH; s <= r.newest; s++) {
+    if (!received.count(s)) r.newestDelivered = false;
+  }
+  r.ok = true;
+  tap.stop();
+  return r;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Main
+// ═══════════════════════════════════════════════════════════════════════════════
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--broker") && i + 1 < argc) {
+      static std::string host;
+      host = argv[++i];
+      size_t colon = host.rfind(':');
+      if (colon != std::string::npos) {
+        options.port = (uint16_t)atoi(host.c_str() + colon + 1);
+        host.resize(colon);
+      }
+      options.host = host.c_str();
+    } else if (!strcmp(argv[i], "--payload") && i + 1 < argc) {
+      options.payload = (size_t)atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      options.messages = (uint32_t)atoi(argv[i]);
+    } else {
+      fprintf(stderr, "usage: %s [messages] [--broker host:port] [--payload bytes]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (options.payload < 16) options.payload = 16;
+  if (options.messages == 0) options.messages = 1;
+
+  printf("QoS 1 queue: depth %d, window %d, %u messages of %zu B payload, broker %s\n\n",
+         MQTT_QUEUE_DEPTH, MQTT_INFLIGHT_WINDOW, (unsigned)options.messages, options.payload,
+         options.host ? options.host : "stand-in (virtual time)");
+
+  const uint32_t outstanding[] = {1, 2, 4, 8, 16, 32};
+  const uint32_t simRtts[] = {2, 20, 100};
+  const uint32_t hostRtts[] = {0};
+  const uint32_t* rtts = options.host ? hostRtts : simRtts;
+  size_t rttCount = options.host ? 1 : sizeof(simRtts) / sizeof(simRtts[0]);
+
+  printf("%-8s %4s %10s %10s %9s %9s %8s %9s\n",
+         "RTT", "N", "msgs/s", "x N=1", "peak fl", "ack ms", "DUP", "host us");
+  bool ok = true;
+  for (size_t i = 0; i < rttCount; i++) {
+    double base = 0;
+    for (uint32_t n : outstanding) {
+      Result r = runThroughput(n, rtts[i]);
+      if (!r.ok) {
+        printf("N=%u: session failed\n", (unsigned)n);
+        ok = false;
+        break;
+      }
+      double rate = options.messages / r.seconds;
+      if (base == 0) base = rate;
+      char rtt[16];
+      if (options.host) {
+        snprintf(rtt, sizeof(rtt), "host");
+      } else {
+        snprintf(rtt, sizeof(rtt), "%u ms", (unsigned)rtts[i]);
+      }
+      printf("%-8s %4u %10.0f %9.2fx %9u %9u %8u %9.2f\n", rtt, (unsigned)n, rate, rate / base,
+             (unsigned)r.queue.peakInFlight, (unsigned)r.queue.avgAckLatencyMs,
+             (unsigned)(options.host ? r.queue.retransmitted : r.broker.duplicates), r.hostUsPerMessage);
+      if (r.queue.acked != options.messages || r.queue.dropped ||
+          (!options.host && r.broker.pubacks != options.messages)) ok = false;
+    }
+  }
+
+  if (!options.host) {
+    printf("\nWiFi drop with %d in flight, %d x 1 Hz samples while offline:\n",
+           MQTT_INFLIGHT_WINDOW, 3 * MQTT_QUEUE_DEPTH);
+    printf("%-22s %8s %9s %8s %10s %s\n", "", "sampled", "rejected", "dropped", "delivered", "newest kept");
+    for (int rewind = 1; rewind >= 0; rewind--) {
+      OutageResult r = runOutage(rewind != 0);
+      if (!r.ok) {
+        printf("outage: session failed\n");
+        ok = false;
+        continue;
+      }
+      printf("%-22s %8u %9u %8u %10u %s\n", rewind ? "rewind on link loss" : "no rewind (before)",
+             (unsigned)r.sampled, (unsigned)r.rejected, (unsigned)r.dropped, (unsigned)r.delivered,
+             r.newestDelivered ? "yes" : "NO");
+      if (rewind && (!r.newestDelivered || r.rejected)) ok = false;
+    }
+  }
+
+  printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
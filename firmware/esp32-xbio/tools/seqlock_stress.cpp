@@ -0,0 +1,112 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🔁 xBio SeqLock stress test (host)
+ * One writer publishes at full rate while reader threads check every snapshot
+ * for torn reads (fields from two different writes) and version regressions.
+ *
+ *   g++ -std=c++17 -O2 -pthread -I../src seqlock_stress.cpp -o seqlock_stress && ./seqlock_stress [seconds] [readers]
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "seqlock.h"
+
+// Same size and shape class as SensorData / aggregates: every field derives from one counter
+struct Snapshot {
+  uint32_t version;
+  float temperature;
+  float humidity;
+  float pressure;
+  float gasResistance;
+  uint16_t iaq;
+  uint8_t iaqAccuracy;
+  uint8_t pad;
+  double co2Equivalent;
+  uint32_t words[8];
+  uint32_t check;
+};
+
+static Snapshot make(uint32_t v) {
+  Snapshot s = {};
+  s.version = v;
+  s.temperature = (float)(v % 4096);
+  s.humidity = (float)((v * 3) % 4096);
+  s.pressure = (float)((v * 5) % 4096);
+  s.gasResistance = (float)((v * 7) % 4096);
+  s.iaq = (uint16_t)(v % 500);
+  s.iaqAccuracy = (uint8_t)(v & 3);
+  s.co2Equivalent = (double)v * 0.5;
+  for (int i = 0; i < 8; i++) s.words[i] = v ^ (0x9E3779B9u * (i + 1));
+  s.check = ~v;
+  return s;
+}
+
+static bool consistent(const Snapshot& s) {
+  Snapshot expected = make(s.version);
+  return memcmp(&s, &expected, sizeof(Snapshot)) == 0;
+}
+
+int main(int argc, char** argv) {
+  int seconds = argc > 1 ? atoi(argv[1]) : 3;
+  int readers = argc > 2 ? atoi(argv[2]) : 3;
+
+  static SeqLock<Snapshot> latest;
+  latest.write(make(0));
+
+  std::atomic<bool> running(true);
+  std::atomic<uint64_t> writes(0);
+  std::vector<uint64_t> reads(readers, 0), retries(readers, 0), torn(readers, 0), regressions(readers, 0);
+
+  std::thread writer([&] {
+    uint32_t v = 1;
+    while (running.load(std::memory_order_relaxed)) {
+      latest.write(make(v++));
+    }
+    writes = v - 1;
+  });
+
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; r++) {
+    threads.emplace_back([&, r] {
+      uint32_t last = 0;
+      Snapshot s;
+      while (running.load(std::memory_order_relaxed)) {
+        retries[r] += latest.read(s);
+        reads[r]++;
+        if (!consistent(s)) torn[r]++;
+        if (s.version < last) regressions[r]++;
+        last = s.version;
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  running = false;
+  writer.join();
+  for (auto& t : threads) t.join();
+
+  uint64_t totalReads = 0, totalRetries = 0, totalTorn = 0, totalRegressions = 0;
+  for (int r = 0; r < readers; r++) {
+    totalReads += reads[r];
+    totalRetries += retries[r];
+    totalTorn += torn[r];
+    totalRegressions += regressions[r];
+  }
+
+  printf("Writes: %llu  Reads: %llu (%d readers, %d s, %zu-byte snapshot)\n",
+         (unsigned long long)writes.load(), (unsigned long long)totalReads, readers, seconds, sizeof(Snapshot));
+  printf("Retries: %llu (%.3f per read)\n", (unsigned long long)totalRetries,
+         totalReads ? (double)totalRetries / totalReads : 0.0);
+  printf("Torn reads: %llu  Version regressions: %llu\n",
+         (unsigned long long)totalTorn, (unsigned long long)totalRegressions);
+
+  bool ok = totalTorn == 0 && totalRegressions == 0 && totalReads > 0;
+  printf(ok ? "✅ No torn reads\n" : "❌ Inconsistent snapshots\n");
+  return ok ? 0 : 1;
+}
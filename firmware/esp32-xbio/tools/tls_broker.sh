@@ -0,0 +1,100 @@
+#!/bin/bash
+# ═══════════════════════════════════════════════════════════════════════════════
+# 🔐 xBio local TLS broker fixture
+# Generates a throwaway CA + broker certificate, runs mosquitto on :8883 and
+# checks that TLS session resumption works from Linux.
+#
+#   ./tls_broker.sh init     # create certs + mosquitto.conf in $XBIO_TLS_DIR
+#   ./tls_broker.sh run      # start mosquitto in the foreground
+#   ./tls_broker.sh verify   # full vs resumed handshake via openssl s_client
+#   ./tls_broker.sh provision # print values for the tls_ca / tls_fp NVS keys
+# ═══════════════════════════════════════════════════════════════════════════════
+
+set -e
+
+DIR="${XBIO_TLS_DIR:-${TMPDIR:-/tmp}/xbio-tls-broker}"
+PORT="${XBIO_TLS_PORT:-8883}"
+HOST="${XBIO_TLS_HOST:-localhost}"
+
+init() {
+  mkdir -p "$DIR"
+  cd "$DIR"
+
+  echo "🔧 Generating CA and broker certificate in $DIR"
+  openssl ecparam -name prime256v1 -genkey -noout -out ca.key
+  openssl req -x509 -new -key ca.key -sha256 -days 3650 -subj "/CN=xBio Test CA" -out ca.crt
+
+  # SAN covers loopback plus this machine's LAN addresses so a real device can connect
+  SAN="DNS:localhost,DNS:$(hostname),IP:127.0.0.1"
+  for ip in $(hostname -I 2>/dev/null); do
+    case "$ip" in *:*) ;; *) SAN="$SAN,IP:$ip" ;; esac
+  done
+
+  openssl ecparam -name prime256v1 -genkey -noout -out server.key
+  openssl req -new -key server.key -subj "/CN=$HOST" -out server.csr
+  printf "subjectAltName=%s\nextendedKeyUsage=serverAuth\n" "$SAN" > server.ext
+  openssl x509 -req -in server.csr -CA ca.crt -CAkey ca.key -CAcreateserial \
+    -days 825 -sha256 -extfile server.ext -out server.crt
+  rm -f server.csr server.ext
+
+  cat > mosquitto.conf <<EOF
+listener $PORT
+cafile $DIR/ca.crt
+certfile $DIR/server.crt
+keyfile $DIR/server.key
+tls_version tlsv1.2
+allow_anonymous true
+EOF
+
+  echo "✅ Fixture ready (SAN: $SAN)"
+}
+
+run() {
+  [ -f "$DIR/mosquitto.conf" ] || init
+  command -v mosquitto >/dev/null || { echo "❌ mosquitto not installed"; exit 1; }
+  echo "📡 mosquitto listening on :$PORT (TLS)"
+  exec mosquitto -c "$DIR/mosquitto.conf" -v
+}
+
+verify() {
+  [ -f "$DIR/ca.crt" ] || { echo "❌ Run '$0 init' first"; exit 1; }
+  SESSION="$DIR/session.pem"
+  rm -f "$SESSION"
+
+  handshake() {
+    echo | openssl s_client -connect "$HOST:$PORT" -servername "$HOST" -CAfile "$DIR/ca.crt" \
+      -tls1_2 "$@" 2>/dev/null
+  }
+
+  echo "1️⃣ Full handshake"
+  out=$(handshake -sess_out "$SESSION")
+  echo "$out" | grep -E "^(New|Reused),|Verify return code|SSL handshake has read"
+
+  echo "2️⃣ Resumed handshake"
+  out=$(handshake -sess_in "$SESSION")
+  echo "$out" | grep -E "^(New|Reused),|Verify return code|SSL handshake has read"
+
+  if echo "$out" | grep -q "^Reused,"; then
+    echo "✅ Session resumption supported by the broker"
+  else
+    echo "❌ Broker did not resume the session"
+    exit 1
+  fi
+}
+
+provision() {
+  [ -f "$DIR/ca.crt" ] || { echo "❌ Run '$0 init' first"; exit 1; }
+  echo "tls_ca (PEM):"
+  cat "$DIR/ca.crt"
+  echo "tls_fp (SHA-256):"
+  openssl x509 -in "$DIR/server.crt" -noout -fingerprint -sha256 | cut -d= -f2
+  echo "mqtt_port: $PORT (mqtt_tls defaults on for 8883)"
+}
+
+case "${1:-}" in
+  init) init ;;
+  run) run ;;
+  verify) verify ;;
+  provision) provision ;;
+  *) echo "Usage: $0 {init|run|verify|provision}"; exit 1 ;;
+esac
@@ -0,0 +1,315 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🗜️ xBio compressed image tool (host)
+ * Packs a firmware image as XBZ1 (LZSS, hash-chain match finder with one-step
+ * lazy matching) plus a JSON manifest, and decodes through the same streaming
+ * LzssDecoder the device runs.
+ *
+ *   g++ -std=c++17 -O2 -I../src xbio_compress.cpp -o xbio_compress
+ *
+ *   ./xbio_compress compress firmware.bin firmware.xbz [windowBits]   # + firmware.xbz.json
+ *   ./xbio_compress decompress firmware.xbz out.bin
+ *   ./xbio_compress roundtrip firmware.bin [windowBits]
+ *
+ * The device detects XBZ1 by its first byte (plain images start with 0xE9):
+ *   {"command":"ota_update","url":"<firmware.xbz>","sha256":"<manifest sha256>"}
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lzss_stream.h"
+#include "sha256.h"
+
+#define DEFAULT_WINDOW_BITS 12        // 4 KB decoder window on the device
+#define HASH_BITS 16
+#define MAX_CHAIN 256                 // Candidates examined per position
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Compression
+// ═══════════════════════════════════════════════════════════════════════════════
+
+class MatchFinder {
+public:
+  MatchFinder(const Bytes& data, uint32_t window, uint32_t maxLength)
+    : _data(data), _window(window), _maxLength(maxLength), _head(1 << HASH_BITS, -1), _prev(data.size(), -1), _next(0) {}
+
+  // Index every position before pos
+  void advance(size_t pos) {
+    for (; _next < pos; _next++) {
+      if (_next + LZSS_MIN_MATCH > _data.size()) continue;
+      uint32_t h = hash(_next);
+      _prev[_next] = _head[h];
+      _head[h] = (int32_t)_next;
+    }
+  }
+
+  uint32_t longest(size_t pos, uint32_t* distance) {
+    advance(pos);
+    if (pos + LZSS_MIN_MATCH > _data.size()) return 0;
+
+    uint32_t limit = (uint32_t)std::min<size_t>(_maxLength, _data.size() - pos);
+    uint32_t best = 0;
+    int32_t candidate = _head[hash(pos)];
+    for (int chain = 0; candidate >= 0 && chain < MAX_CHAIN; chain++, candidate = _prev[candidate]) {
+      uint32_t d = (uint32_t)(pos - candidate);
+      if (d > _window) break;
+      uint32_t n = 0;
+      while (n < limit && _data[candidate + n] == _data[pos + n]) n++;
+      if (n > best) {
+        best = n;
+        *distance = d;
+        if (n == limit) break;
+      }
+    }
+    return best >= LZSS_MIN_MATCH ? best : 0;
+  }
+
+private:
+  const Bytes& _data;
+  uint32_t _window;
+  uint32_t _maxLength;
+  std::vector<int32_t> _head;
+  std::vector<int32_t> _prev;
+  size_t _next;
+
+  uint32_t hash(size_t pos) const {
+    uint32_t v = _data[pos] | (_data[pos + 1] << 8) | (_data[pos + 2] << 16);
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+  }
+};
+
+class TokenWriter {
+public:
+  explicit TokenWriter(Bytes& out) : _out(out), _flagPos(0), _count(8) {}
+
+  void literal(uint8_t byte) {
+    slot(true);
+    _out.push_back(byte);
+  }
+
+  void match(uint16_t token) {
+    slot(false);
+    _out.push_back((uint8_t)(token >> 8));
+    _out.push_back((uint8_t)token);
+  }
+
+private:
+  Bytes& _out;
+  size_t _flagPos;
+  uint8_t _count;
+
+  void slot(bool literal) {
+    if (_count == 8) {
+      _flagPos = _out.size();
+      _out.push_back(0);
+      _count = 0;
+    }
+    if (literal) _out[_flagPos] |= (uint8_t)(1 << _count);
+    _count++;
+  }
+};
+
+static Bytes compress(const Bytes& image, uint8_t windowBits) {
+  Bytes out;
+  for (size_t i = 0; i < 4; i++) out.push_back((uint8_t)LZSS_MAGIC[i]);
+  out.push_back(windowBits);
+  out.push_back(0);
+  out.push_back(0);
+  out.push_back(0);
+  for (int i = 0; i < 4; i++) out.push_back((uint8_t)(image.size() >> (i * 8)));
+  uint8_t hash[32];
+  sha256(image, hash);
+  out.insert(out.end(), hash, hash + 32);
+
+  uint8_t lengthBits = 16 - windowBits;
+  uint32_t window = 1u << windowBits;
+  uint32_t maxLength = (1u << lengthBits) - 1 + LZSS_MIN_MATCH;
+  MatchFinder finder(image, window, maxLength);
+  TokenWriter writer(out);
+
+  size_t pos = 0;
+  while (pos < image.size()) {
+    uint32_t distance = 0;
+    uint32_t length = finder.longest(pos, &distance);
+
+    // Lazy: a literal now is worth it if the next position matches longer
+    if (length && length < maxLength && pos + 1 < image.size()) {
+      uint32_t nextDistance = 0;
+      if (finder.longest(pos + 1, &nextDistance) > length + 1) length = 0;
+    }
+
+    if (length) {
+      writer.match((uint16_t)(((distance - 1) << lengthBits) | (length - LZSS_MIN_MATCH)));
+      pos += length;
+    } else {
+      writer.literal(image[pos]);
+      pos++;
+    }
+  }
+  return out;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Decompression (device code path)
+// ═══════════════════════════════════════════════════════════════════════════════
+
+class MemorySink : public LzssSink {
+public:
+  bool begin(const LzssHeader& header) override {
+    image.reserve(header.imageSize);
+    return true;
+  }
+  bool write(const uint8_t* data, size_t length) override {
+    image.insert(image.end(), data, data + length);
+    return true;
+  }
+  Bytes image;
+};
+
+static bool decompress(const Bytes& packed, Bytes& out) {
+  MemorySink sink;
+  LzssDecoder decoder;
+  decoder.begin(&sink);
+
+  // Random chunking catches state carried across feed() calls
+  std::mt19937 rng(4321);
+  size_t offset = 0;
+  while (offset < packed.size()) {
+    size_t n = std::min<size_t>(1 + rng() % 1500, packed.size() - offset);
+    if (!decoder.feed(packed.data() + offset, n)) break;
+    offset += n;
+  }
+  if (!decoder.finished()) {
+    fprintf(stderr, "Decode failed: %s\n",
+            decoder.error() == LzssError::NONE ? "truncated image" : LzssDecoder::errorName(decoder.error()));
+    return false;
+  }
+
+  uint8_t hash[32];
+  sha256(sink.image, hash);
+  if (memcmp(hash, decoder.header().imageHash, 32) != 0) {
+    fprintf(stderr, "Image hash mismatch\n");
+    return false;
+  }
+  out.swap(sink.image);
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════════
+
+static bool load(const char* path, Bytes& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static bool save(const char* path, const void* data, size_t length) {
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s\n", path);
+    return false;
+  }
+  bool ok = fwrite(data, 1, length, f) == length;
+  return fclose(f) == 0 && ok;
+}
+
+static bool writeManifest(const char* artifact, const Bytes& image, const Bytes& packed, uint8_t windowBits) {
+  uint8_t hash[32];
+  sha256(image, hash);
+  const char* name = strrchr(artifact, '/');
+  name = name ? name + 1 : artifact;
+
+  char manifest[512];
+  int n = snprintf(manifest, sizeof(manifest),
+                   "{\n"
+                   "  \"format\": \"xbz1\",\n"
+                   "  \"file\": \"%s\",\n"
+                   "  \"size\": %zu,\n"
+                   "  \"image_size\": %zu,\n"
+                   "  \"sha256\": \"%s\",\n"
+                   "  \"window_bits\": %u,\n"
+                   "  \"ratio\": %.3f\n"
+                   "}\n",
+                   name, packed.size(), image.size(), hex(hash, 32).c_str(), windowBits,
+                   (double)packed.size() / image.size());
+  std::string path = std::string(artifact) + ".json";
+  return save(path.c_str(), manifest, n);
+}
+
+static uint8_t windowArg(int argc, char** argv, int index) {
+  int bits = argc > index ? atoi(argv[index]) : DEFAULT_WINDOW_BITS;
+  if (bits < LZSS_MIN_WINDOW_BITS || bits > LZSS_MAX_WINDOW_BITS) {
+    fprintf(stderr, "windowBits must be %d..%d\n", LZSS_MIN_WINDOW_BITS, LZSS_MAX_WINDOW_BITS);
+    exit(2);
+  }
+  return (uint8_t)bits;
+}
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  Bytes image, packed, out;
+
+  if (mode == "compress" && (argc == 4 || argc == 5)) {
+    uint8_t windowBits = windowArg(argc, argv, 4);
+    if (!load(argv[2], image) || image.empty()) return 1;
+    packed = compress(image, windowBits);
+    if (!save(argv[3], packed.data(), packed.size()) || !writeManifest(argv[3], image, packed, windowBits)) return 1;
+    printf("Compressed %zu -> %zu bytes (%.1f%%, %u-bit window)\n", image.size(), packed.size(),
+           100.0 * packed.size() / image.size(), windowBits);
+    printf("Manifest: %s.json\n", argv[3]);
+    return 0;
+  }
+
+  if (mode == "decompress" && argc == 4) {
+    if (!load(argv[2], packed)) return 1;
+    if (!decompress(packed, out)) return 1;
+    if (!save(argv[3], out.data(), out.size())) return 1;
+    printf("Decoded %zu bytes ✅\n", out.size());
+    return 0;
+  }
+
+  if (mode == "roundtrip" && (argc == 3 || argc == 4)) {
+    uint8_t windowBits = windowArg(argc, argv, 3);
+    if (!load(argv[2], image) || image.empty()) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    packed = compress(image, windowBits);
+    double compressMs = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    bool ok = decompress(packed, out) && out == image;
+    double decodeMs = msSince(start);
+
+    printf("Image %zu  Compressed %zu bytes (%.1f%%, %u-bit window)\n", image.size(), packed.size(),
+           100.0 * packed.size() / image.size(), windowBits);
+    printf("Compress %.0f ms  Decode+hash %.1f ms (%.0f MB/s)\n", compressMs, decodeMs,
+           decodeMs > 0 ? image.size() / decodeMs / 1000.0 : 0.0);
+    printf(ok ? "✅ Round trip matches\n" : "❌ Round trip mismatch\n");
+    return ok ? 0 : 1;
+  }
+
+  fprintf(stderr, "Usage: %s compress <image> <out.xbz> [windowBits] | decompress <in.xbz> <out> | roundtrip <image> [windowBits]\n",
+          argv[0]);
+  return 2;
+}
@@ -0,0 +1,364 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧩 xBio delta patch tool (host)
+ * Builds XBD1 patches between two firmware images (bsdiff matching over a
+ * suffix array) and applies them through the same streaming DeltaPatcher the
+ * device runs, fed in random-sized chunks like an HTTP download.
+ *
+ *   g++ -std=c++17 -O2 -I../src xbio_delta.cpp -o xbio_delta
+ *
+ *   ./xbio_delta diff old.bin new.bin patch.xbd
+ *   ./xbio_delta apply old.bin patch.xbd out.bin
+ *   ./xbio_delta roundtrip old.bin new.bin        # diff + apply + compare
+ *
+ * Publish the patch next to the full image and send both:
+ *   {"command":"ota_update","url":"<full.bin>","patch":"<patch.xbd>","sha256":"<new sha>"}
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "delta_patch.h"
+#include "sha256.h"
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Patch generation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+// Suffix array by prefix doubling; entry 0 is the empty suffix (as in bsdiff)
+static std::vector<int32_t> suffixArray(const Bytes& old) {
+  int32_t n = (int32_t)old.size();
+  std::vector<int32_t> sa(n + 1), rank(n + 1), tmp(n + 1);
+  for (int32_t i = 0; i <= n; i++) {
+    sa[i] = i;
+    rank[i] = i < n ? old[i] + 1 : 0;
+  }
+  for (int32_t k = 1;; k <<= 1) {
+    auto key = [&](int32_t i) { return i + k <= n ? rank[i + k] : -1; };
+    auto less = [&](int32_t a, int32_t b) {
+      if (rank[a] != rank[b]) return rank[a] < rank[b];
+      return key(a) < key(b);
+    };
+    std::sort(sa.begin(), sa.end(), less);
+    tmp[sa[0]] = 0;
+    for (int32_t i = 1; i <= n; i++) tmp[sa[i]] = tmp[sa[i - 1]] + (less(sa[i - 1], sa[i]) ? 1 : 0);
+    rank.swap(tmp);
+    if (rank[sa[n]] == n) break;
+  }
+  return sa;
+}
+
+static int32_t matchLength(const uint8_t* a, int32_t aLength, const uint8_t* b, int32_t bLength) {
+  int32_t i = 0;
+  while (i < aLength && i < bLength && a[i] == b[i]) i++;
+  return i;
+}
+
+static int32_t search(const std::vector<int32_t>& sa, const Bytes& old, const uint8_t* target, int32_t targetLength,
+                      int32_t start, int32_t end, int32_t* pos) {
+  int32_t oldSize = (int32_t)old.size();
+  while (end - start >= 2) {
+    int32_t mid = start + (end - start) / 2;
+    int32_t n = std::min(oldSize - sa[mid], targetLength);
+    if (memcmp(old.data() + sa[mid], target, n) < 0) start = mid;
+    else end = mid;
+  }
+  int32_t x = matchLength(old.data() + sa[start], oldSize - sa[start], target, targetLength);
+  int32_t y = matchLength(old.data() + sa[end], oldSize - sa[end], target, targetLength);
+  if (x > y) {
+    *pos = sa[start];
+    return x;
+  }
+  *pos = sa[end];
+  return y;
+}
+
+static void putVarint(Bytes& out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+static void putU32(Bytes& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (i * 8)));
+}
+
+// Zero runs shorter than this stay inside a literal token (a token costs 1-3 bytes)
+#define MIN_ZERO_RUN 4
+
+static void putDiff(Bytes& out, const Bytes& diff) {
+  size_t i = 0;
+  while (i < diff.size()) {
+    size_t run = 0;
+    while (i + run < diff.size() && diff[i + run] == 0) run++;
+    if (run >= MIN_ZERO_RUN || i + run == diff.size()) {
+      if (run) {
+        putVarint(out, (uint32_t)run << 1);
+        i += run;
+        continue;
+      }
+    }
+    // Literal: extend until the next long zero run
+    size_t end = i;
+    while (end < diff.size()) {
+      size_t zeros = 0;
+      while (end + zeros < diff.size() && diff[end + zeros] == 0) zeros++;
+      if (zeros >= MIN_ZERO_RUN || end + zeros == diff.size()) break;
+      end += zeros ? zeros : 1;
+    }
+    putVarint(out, ((uint32_t)(end - i) << 1) | 1);
+    out.insert(out.end(), diff.begin() + i, diff.begin() + end);
+    i = end;
+  }
+}
+
+static Bytes makePatch(const Bytes& old, const Bytes& next, size_t* records) {
+  Bytes patch;
+  for (size_t i = 0; i < 4; i++) patch.push_back((uint8_t)DELTA_MAGIC[i]);
+  putU32(patch, (uint32_t)old.size());
+  putU32(patch, (uint32_t)next.size());
+  uint8_t hash[32];
+  sha256(old, hash);
+  patch.insert(patch.end(), hash, hash + 32);
+  sha256(next, hash);
+  patch.insert(patch.end(), hash, hash + 32);
+  putU32(patch, 0);
+
+  std::vector<int32_t> sa = suffixArray(old);
+  int32_t oldSize = (int32_t)old.size();
+  int32_t newSize = (int32_t)next.size();
+  const uint8_t* nb = next.data();
+
+  int32_t scan = 0, len = 0, pos = 0;
+  int32_t lastScan = 0, lastPos = 0, lastOffset = 0;
+  *records = 0;
+
+  // bsdiff 4 matching: approximate matches become diff bytes, the rest extra bytes
+  while (scan < newSize) {
+    int32_t oldScore = 0;
+    int32_t scsc;
+    for (scsc = scan += len; scan < newSize; scan++) {
+      len = search(sa, old, nb + scan, newSize - scan, 0, oldSize, &pos);
+      for (; scsc < scan + len; scsc++) {
+        if (scsc + lastOffset < oldSize && old[scsc + lastOffset] == nb[scsc]) oldScore++;
+      }
+      if ((len == oldScore && len != 0) || len > oldScore + 8) break;
+      if (scan + lastOffset < oldSize && old[scan + lastOffset] == nb[scan]) oldScore--;
+    }
+
+    if (len != oldScore || scan == newSize) {
+      int32_t s = 0, sf = 0, lenf = 0;
+      for (int32_t i = 0; lastScan + i < scan && lastPos + i < oldSize;) {
+        if (old[lastPos + i] == nb[lastScan + i]) s++;
+        i++;
+        if (s * 2 - i > sf * 2 - lenf) {
+          sf = s;
+          lenf = i;
+        }
+      }
+
+      int32_t lenb = 0;
+      if (scan < newSize) {
+        int32_t sb = 0;
+        s = 0;
+        for (int32_t i = 1; scan >= lastScan + i && pos >= i; i++) {
+          if (old[pos - i] == nb[scan - i]) s++;
+          if (s * 2 - i > sb * 2 - lenb) {
+            sb = s;
+            lenb = i;
+          }
+        }
+      }
+
+      if (lastScan + lenf > scan - lenb) {
+        int32_t overlap = (lastScan + lenf) - (scan - lenb);
+        int32_t ss = 0, lens = 0;
+        s = 0;
+        for (int32_t i = 0; i < overlap; i++) {
+          if (nb[lastScan + lenf - overlap + i] == old[lastPos + lenf - overlap + i]) s++;
+          if (nb[scan - lenb + i] == old[pos - lenb + i]) s--;
+          if (s > ss) {
+            ss = s;
+            lens = i + 1;
+          }
+        }
+        lenf += lens - overlap;
+        lenb -= lens;
+      }
+
+      int32_t extraLength = (scan - lenb) - (lastScan + lenf);
+      int32_t seek = (pos - lenb) - (lastPos + lenf);
+
+      putVarint(patch, (uint32_t)lenf);
+      putVarint(patch, (uint32_t)extraLength);
+      putVarint(patch, ((uint32_t)seek << 1) ^ (uint32_t)(seek >> 31));
+
+      Bytes diff(lenf);
+      for (int32_t i = 0; i < lenf; i++) diff[i] = (uint8_t)(nb[lastScan + i] - old[lastPos + i]);
+      putDiff(patch, diff);
+      patch.insert(patch.end(), nb + lastScan + lenf, nb + lastScan + lenf + extraLength);
+      (*records)++;
+
+      lastScan = scan - lenb;
+      lastPos = pos - lenb;
+      lastOffset = pos - scan;
+    }
+  }
+  return patch;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Patch application (device code path)
+// ═══════════════════════════════════════════════════════════════════════════════
+
+class MemorySource : public DeltaSource {
+public:
+  explicit MemorySource(const Bytes& image) : _image(image), reads(0) {}
+  bool read(uint32_t offset, uint8_t* out, size_t length) override {
+    if (offset + length > _image.size()) return false;
+    memcpy(out, _image.data() + offset, length);
+    reads++;
+    return true;
+  }
+private:
+  const Bytes& _image;
+public:
+  size_t reads;
+};
+
+class MemorySink : public DeltaSink {
+public:
+  explicit MemorySink(const Bytes& base) : _base(base) {}
+  bool begin(const DeltaHeader& header) override {
+    uint8_t hash[32];
+    sha256(_base, hash);
+    if (header.oldSize != _base.size() || memcmp(hash, header.oldHash, 32) != 0) return false;
+    image.reserve(header.newSize);
+    return true;
+  }
+  bool write(const uint8_t* data, size_t length) override {
+    image.insert(image.end(), data, data + length);
+    return true;
+  }
+  Bytes image;
+private:
+  const Bytes& _base;
+};
+
+static bool applyPatch(const Bytes& old, const Bytes& patch, Bytes& out, size_t* reads) {
+  MemorySource source(old);
+  MemorySink sink(old);
+  DeltaPatcher patcher;
+  patcher.begin(&source, &sink);
+
+  // Random chunking catches state carried across feed() calls
+  std::mt19937 rng(1234);
+  size_t offset = 0;
+  while (offset < patch.size()) {
+    size_t n = std::min<size_t>(1 + rng() % 1500, patch.size() - offset);
+    if (!patcher.feed(patch.data() + offset, n)) break;
+    offset += n;
+  }
+  if (!patcher.finished()) {
+    fprintf(stderr, "Patch failed: %s\n",
+            patcher.error() == DeltaError::NONE ? "truncated patch" : DeltaPatcher::errorName(patcher.error()));
+    return false;
+  }
+
+  uint8_t hash[32];
+  sha256(sink.image, hash);
+  if (memcmp(hash, patcher.header().newHash, 32) != 0) {
+    fprintf(stderr, "Result hash mismatch\n");
+    return false;
+  }
+  out.swap(sink.image);
+  if (reads) *reads = source.reads;
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════════
+
+static bool load(const char* path, Bytes& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static bool save(const char* path, const Bytes& data) {
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s\n", path);
+    return false;
+  }
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  return fclose(f) == 0 && ok;
+}
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  Bytes old, next, patch, out;
+
+  if (mode == "diff" && argc == 5) {
+    if (!load(argv[2], old) || !load(argv[3], next)) return 1;
+    size_t records;
+    patch = makePatch(old, next, &records);
+    if (!save(argv[4], patch)) return 1;
+    uint8_t hash[32];
+    sha256(next, hash);
+    printf("Patch: %zu bytes (%.1f%% of %zu), %zu records\n", patch.size(),
+           100.0 * patch.size() / next.size(), next.size(), records);
+    printf("sha256: %s\n", hex(hash, 32).c_str());
+    return 0;
+  }
+
+  if (mode == "apply" && argc == 5) {
+    if (!load(argv[2], old) || !load(argv[3], patch)) return 1;
+    if (!applyPatch(old, patch, out, nullptr)) return 1;
+    if (!save(argv[4], out)) return 1;
+    printf("Rebuilt %zu bytes ✅\n", out.size());
+    return 0;
+  }
+
+  if (mode == "roundtrip" && argc == 4) {
+    if (!load(argv[2], old) || !load(argv[3], next)) return 1;
+    size_t records, reads = 0;
+    auto start = std::chrono::steady_clock::now();
+    patch = makePatch(old, next, &records);
+    double diffMs = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    bool ok = applyPatch(old, patch, out, &reads) && out == next;
+    double applyMs = msSince(start);
+
+    printf("Old %zu  New %zu  Patch %zu bytes (%.1f%%), %zu records\n", old.size(), next.size(), patch.size(),
+           100.0 * patch.size() / next.size(), records);
+    printf("Diff %.0f ms  Apply %.0f ms  Base reads %zu x %d bytes\n", diffMs, applyMs, reads, DELTA_BUFFER_SIZE);
+    printf(ok ? "✅ Round trip matches\n" : "❌ Round trip mismatch\n");
+    return ok ? 0 : 1;
+  }
+
+  fprintf(stderr, "Usage: %s diff <old> <new> <patch> | apply <old> <patch> <out> | roundtrip <old> <new>\n", argv[0]);
+  return 2;
+}
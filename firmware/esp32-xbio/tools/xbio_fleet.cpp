@@ -0,0 +1,1731 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🚦 xBio fleet load generator (host)
+ * Connects thousands of virtual xBio devices to a real MQTT broker and drives
+ * the traffic the ingestion service sees from a fleet: retained online status
+ * with an offline will, QoS 1 data on xbio/<id>/data, optional compact stream
+ * on xbio/<id>/ws and threshold alerts on xbio/<id>/alerts. Payloads come from
+ * the firmware's own encoders (XBioSinkBus, AlertManager names), the outbound
+ * QoS 1 queue follows mqtt_session.h, and reconnects follow mqtt_client.h.
+ *
+ *   g++ -std=gnu++17 -O2 -pthread -DARDUINO=10812 -I../native/include -I../src \
+ *       -I../.pio/libdeps/native/ArduinoJson/src xbio_fleet.cpp -o xbio_fleet
+ *
+ *   ./xbio_fleet [--devices 10000] [--duration 120] [--storm 60:0.5] [--cmd-rate 20]
+ *
+ * A second connection plays the server: it subscribes the same filters as
+ * iot_service.ts, sends get_status commands at --cmd-rate and measures
+ * sample-to-server latency. Samples are taken on each device's millisecond
+ * grid, so a data timestamp pins its intended send time and lag inside the
+ * generator counts against the broker, never in its favour. Server-side drops
+ * are data the broker PUBACKed that never reached the subscriber.
+ *
+ * Above ~25k devices on loopback, sockets are spread over 127.0.0.2+ source
+ * addresses to stay clear of the ephemeral port range; the broker needs a
+ * matching connection limit and file descriptor budget.
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "alert_manager.h"
+#include "anomaly_detector.h"
+#include "bme688_driver.h"
+#include "config_manager.h"
+#include "mqtt_session.h"
+#include "sink_bus.h"
+
+#define FLEET_PUBLISH_INTERVAL 5000     // MQTT_PUBLISH_INTERVAL (main.cpp)
+#define FLEET_STREAM_INTERVAL 1000      // STREAM_UPDATE_INTERVAL (main.cpp)
+#define FLEET_RECONNECT_INTERVAL 5000   // MQTT_RECONNECT_INTERVAL (mqtt_client.h)
+#define FLEET_KEEPALIVE 60              // MQTT_KEEPALIVE (mqtt_client.h)
+#define FLEET_BUFFER_SIZE 1024          // MQTT_BUFFER_SIZE (mqtt_client.h)
+#define FLEET_SOCKET_TIMEOUT 15         // PubSubClient MQTT_SOCKET_TIMEOUT
+
+#define FLEET_OUI 0x02F1EE              // Locally administered: never a real ESP32 MAC
+#define FLEET_MAX_STORMS 8
+#define FLEET_MAX_SOURCE_IPS 250
+#define FLEET_DEVICES_PER_SOURCE_IP 25000
+#define FLEET_SEND_BUFFER 16384         // Per-socket backlog before the queue stops pumping
+#define FLEET_COMMAND_TIMEOUT_S 30
+#define FLEET_DRAIN_S 10
+#define FLEET_SETTLE_MS 2000
+
+enum : uint8_t { SLOT_FREE, SLOT_QUEUED, SLOT_INFLIGHT, SLOT_ACKED };
+enum : uint8_t { MSG_DATA, MSG_ALERT_RAISED, MSG_ALERT_CLEARED };
+enum : int { PHASE_RUN, PHASE_DRAIN, PHASE_CLOSE };
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Options
+// ═══════════════════════════════════════════════════════════════════════════════
+struct FleetStorm {
+  double atS;
+  double fraction;
+};
+
+struct FleetOptions {
+  const char* host = "127.0.0.1";
+  uint16_t port = 1883;
+  const char* user = nullptr;
+  const char* pass = nullptr;
+  uint32_t devices = 10000;
+  uint32_t idBase = 0;
+  int threads = 0;
+  double durationS = 120;
+  uint32_t intervalMs = FLEET_PUBLISH_INTERVAL;
+  uint32_t streamMs = 0;                // Off: the stream normally rides the WS uplink
+  double jitter = 0.1;                  // ± fraction of the data interval
+  double rampS = 10;
+  double cmdRate = 0;                   // get_status commands per second, fleet-wide
+  double alertRate = 0;                 // Temperature excursions per device-hour
+  int sourceIps = -1;                   // -1: automatic on loopback
+  uint32_t seed = 1;
+  FleetStorm storms[FLEET_MAX_STORMS];
+  int stormCount = 0;
+};
+
+static FleetOptions opt;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Shared state
+// ═══════════════════════════════════════════════════════════════════════════════
+static uint64_t monoNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Log-linear buckets, ~12 % resolution (same layout as native/sim_main.cpp)
+class Histogram {
+public:
+  void add(uint64_t value) {
+    _buckets[bucket(value)]++;
+    _count++;
+    _sum += (double)value;
+    if (value > _max) _max = value;
+  }
+
+  void merge(const Histogram& other) {
+    for (int i = 0; i < BUCKETS; i++) _buckets[i] += other._buckets[i];
+    _count += other._count;
+    _sum += other._sum;
+    if (other._max > _max) _max = other._max;
+  }
+
+  uint64_t count() const { return _count; }
+  uint64_t max() const { return _max; }
+  double mean() const { return _count ? _sum / _count : 0; }
+
+  // Upper bound of the bucket holding the q-quantile
+  uint64_t percentile(double q) const {
+    if (!_count) return 0;
+    uint64_t rank = (uint64_t)ceil(q * _count);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+      seen += _buckets[i];
+      if (seen >= (rank ? rank : 1)) return std::min(upper(i), _max);
+    }
+    return _max;
+  }
+
+private:
+  static constexpr int BUCKETS = 16 + 60 * 8;
+  uint64_t _buckets[BUCKETS] = {};
+  uint64_t _count = 0;
+  uint64_t _max = 0;
+  double _sum = 0;
+
+  static int bucket(uint64_t v) {
+    if (v < 16) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return 16 + (e - 4) * 8 + (int)((v >> (e - 3)) & 7);
+  }
+  static uint64_t upper(int i) {
+    if (i < 16) return (uint64_t)i;
+    int e = (i - 16) / 8 + 4;
+    uint64_t sub = (uint64_t)((i - 16) % 8);
+    return ((8 + sub + 1) << (e - 3)) - 1;
+  }
+};
+
+// Per-device state the workers and the server connection both touch
+struct DeviceShared {
+  uint64_t bootNs;                      // Fixed before any thread starts
+  std::atomic<uint8_t> online{0};
+  std::atomic<uint64_t> commandNs{0};   // Server: get_status in flight since (0 = none)
+  std::atomic<uint32_t> answerTs{0};    // Device: timestamp of the data that answers it
+  uint32_t acked = 0;                   // Worker: data PUBACKed by the broker
+  uint32_t received = 0;                // Server: distinct data delivered
+  uint32_t lastData = 0;                // Server: newest data timestamp
+  uint32_t lastStream = 0;
+  uint32_t lastAlertSeq = 0;
+};
+
+struct alignas(64) FleetCounters {
+  std::atomic<uint64_t> connects{0};
+  std::atomic<uint64_t> refused{0};         // CONNACK return code != 0
+  std::atomic<uint64_t> failed{0};          // TCP connect failed / CONNACK timeout
+  std::atomic<uint64_t> lost{0};            // Broker closed or keepalive expired
+  std::atomic<uint64_t> stormDrops{0};
+  std::atomic<uint64_t> dataQueued{0};
+  std::atomic<uint64_t> alertsQueued{0};
+  std::atomic<uint64_t> sent{0};            // QoS 1 PUBLISH written, first transmission
+  std::atomic<uint64_t> resent{0};          // ... with DUP after reconnect
+  std::atomic<uint64_t> dataAcked{0};
+  std::atomic<uint64_t> alertsAcked{0};
+  std::atomic<uint64_t> queueDropped{0};    // MQTTQueueStats::dropped
+  std::atomic<uint64_t> streamSent{0};
+  std::atomic<uint64_t> commands{0};
+  std::atomic<uint64_t> pings{0};
+  std::atomic<uint64_t> bytesOut{0};
+  std::atomic<uint64_t> bytesIn{0};
+
+  static void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
+};
+
+// Snapshot summed over workers
+struct FleetTotals {
+  uint64_t connects = 0, refused = 0, failed = 0, lost = 0, stormDrops = 0;
+  uint64_t dataQueued = 0, alertsQueued = 0, sent = 0, resent = 0, dataAcked = 0, alertsAcked = 0;
+  uint64_t queueDropped = 0, streamSent = 0, commands = 0, pings = 0, bytesOut = 0, bytesIn = 0;
+
+  void add(const FleetCounters& c) {
+    auto get = [](const std::atomic<uint64_t>& v) { return v.load(std::memory_order_relaxed); };
+    connects += get(c.connects);
+    refused += get(c.refused);
+    failed += get(c.failed);
+    lost += get(c.lost);
+    stormDrops += get(c.stormDrops);
+    dataQueued += get(c.dataQueued);
+    alertsQueued += get(c.alertsQueued);
+    sent += get(c.sent);
+    resent += get(c.resent);
+    dataAcked += get(c.dataAcked);
+    alertsAcked += get(c.alertsAcked);
+    queueDropped += get(c.queueDropped);
+    streamSent += get(c.streamSent);
+    commands += get(c.commands);
+    pings += get(c.pings);
+    bytesOut += get(c.bytesOut);
+    bytesIn += get(c.bytesIn);
+  }
+};
+
+static DeviceShared* shared = nullptr;
+static uint64_t startNs = 0;
+static sockaddr_in brokerAddr;
+static std::atomic<int> phase{PHASE_RUN};
+static std::atomic<int32_t> onlineCount{0};
+static std::atomic<uint32_t> errorsShown{0};
+static ConfigRecord thresholds;
+
+static void reportError(const char* what, int err) {
+  if (errorsShown.fetch_add(1) < 10) fprintf(stderr, "xbio_fleet: %s: %s\n", what, strerror(err));
+}
+
+static void formatDeviceId(uint32_t index, char* out) {
+  snprintf(out, 13, "%06X%06X", FLEET_OUI, (opt.idBase + index) & 0xFFFFFF);
+}
+
+// Device index from a topic "xbio/<id>/<leaf>", or -1 if it is not one of ours
+static int64_t parseTopic(const char* topic, size_t length, const char** leaf) {
+  if (length < 5 + 12 + 2 || memcmp(topic, "xbio/", 5) != 0 || topic[17] != '/') return -1;
+  uint32_t mac[2] = {0, 0};
+  for (int i = 0; i < 12; i++) {
+    char c = topic[5 + i];
+    int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+    if (digit < 0) return -1;
+    mac[i / 6] = (mac[i / 6] << 4) | (uint32_t)digit;
+  }
+  if (mac[0] != FLEET_OUI) return -1;
+  uint32_t index = (mac[1] - opt.idBase) & 0xFFFFFF;
+  if (index >= opt.devices) return -1;
+  *leaf = topic + 18;
+  return index;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// MQTT 3.1.1 framing
+// ═══════════════════════════════════════════════════════════════════════════════
+static void putLength(std::string& out, size_t length) {
+  do {
+    uint8_t digit = length & 0x7F;
+    length >>= 7;
+    if (length > 0) digit |= 0x80;
+    out += (char)digit;
+  } while (length > 0);
+}
+
+static void putString(std::string& out, const char* s, size_t length) {
+  out += (char)(length >> 8);
+  out += (char)(length & 0xFF);
+  out.append(s, length);
+}
+
+static void putString(std::string& out, const char* s) { putString(out, s, strlen(s)); }
+
+static void putConnect(std::string& out, const char* clientId, const char* willTopic, const char* will) {
+  size_t remaining = 10 + 2 + strlen(clientId);
+  uint8_t flags = 0x02;                                 // Clean session, as PubSubClient
+  if (willTopic) {
+    remaining += 2 + strlen(willTopic) + 2 + strlen(will);
+    flags |= 0x04 | 0x08 | 0x20;                        // Will, QoS 1, retained
+  }
+  if (opt.user) {
+    remaining += 2 + strlen(opt.user);
+    flags |= 0x80;
+  }
+  if (opt.pass) {
+    remaining += 2 + strlen(opt.pass);
+    flags |= 0x40;
+  }
+  out += (char)0x10;
+  putLength(out, remaining);
+  putString(out, "MQTT");
+  out += (char)4;
+  out += (char)flags;
+  out += (char)(FLEET_KEEPALIVE >> 8);
+  out += (char)(FLEET_KEEPALIVE & 0xFF);
+  putString(out, clientId);
+  if (willTopic) {
+    putString(out, willTopic);
+    putString(out, will);
+  }
+  if (opt.user) putString(out, opt.user);
+  if (opt.pass) putString(out, opt.pass);
+}
+
+static void putSubscribe(std::string& out, uint16_t packetId, const char* const* filters, const uint8_t* qos,
+                         int count) {
+  size_t remaining = 2;
+  for (int i = 0; i < count; i++) remaining += 2 + strlen(filters[i]) + 1;
+  out += (char)0x82;
+  putLength(out, remaining);
+  out += (char)(packetId >> 8);
+  out += (char)(packetId & 0xFF);
+  for (int i = 0; i < count; i++) {
+    putString(out, filters[i]);
+    out += (char)qos[i];
+  }
+}
+
+static void putPublish(std::string& out, const char* topic, const char* payload, size_t length, uint8_t qos,
+                       bool retained, bool dup, uint16_t packetId) {
+  size_t topicLength = strlen(topic);
+  out += (char)(0x30 | (qos << 1) | (retained ? 0x01 : 0x00) | (dup ? 0x08 : 0x00));
+  putLength(out, 2 + topicLength + (qos ? 2 : 0) + length);
+  putString(out, topic, topicLength);
+  if (qos) {
+    out += (char)(packetId >> 8);
+    out += (char)(packetId & 0xFF);
+  }
+  out.append(payload, length);
+}
+
+static void putAck(std::string& out, uint8_t type, uint16_t packetId) {
+  out += (char)type;
+  out += (char)2;
+  out += (char)(packetId >> 8);
+  out += (char)(packetId & 0xFF);
+}
+
+/**
+ * Locate the next complete packet in a receive buffer
+ * @return total packet length, 0 if incomplete, SIZE_MAX if malformed
+ */
+static size_t nextPacket(const uint8_t* p, size_t n, size_t* body, size_t* bodyLength) {
+  size_t length = 0;
+  for (size_t i = 1; i <= 4; i++) {
+    if (i >= n) return 0;
+    length |= (size_t)(p[i] & 0x7F) << (7 * (i - 1));
+    if (!(p[i] & 0x80)) {
+      if (n < i + 1 + length) return 0;
+      *body = i + 1;
+      *bodyLength = length;
+      return i + 1 + length;
+    }
+  }
+  return SIZE_MAX;
+}
+
+// Integer value of "key": in a flat JSON payload (the encoders never add spaces)
+static bool jsonUnsigned(const char* p, size_t n, const char* key, uint32_t* value) {
+  char pattern[32];
+  int length = snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  const char* at = (const char*)memmem(p, n, pattern, length);
+  if (!at) return false;
+  at += length;
+  const char* end = p + n;
+  if (at >= end || *at < '0' || *at > '9') return false;
+  uint32_t v = 0;
+  while (at < end && *at >= '0' && *at <= '9') v = v * 10 + (uint32_t)(*at++ - '0');
+  *value = v;
+  return true;
+}
+
+static bool jsonStringIs(const char* p, size_t n, const char* key, const char* expected) {
+  char pattern[64];
+  int length = snprintf(pattern, sizeof(pattern), "\"%s\":\"%s\"", key, expected);
+  return memmem(p, n, pattern, length) != nullptr;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Virtual device
+// ═══════════════════════════════════════════════════════════════════════════════
+enum class LinkState : uint8_t { OFF, WAITING, CONNECTING, CONNACK_WAIT, ONLINE, CLOSED };
+
+// A QoS 1 slot: what to re-encode, not the encoded packet (32 x 768 B x 100k
+// devices would not fit), so resends are byte-identical to the first send
+struct QueuedMessage {
+  uint32_t timestamp;
+  uint16_t packetId;
+  uint16_t seq;
+  uint8_t kind;
+  uint8_t state;
+  uint8_t sent;
+  uint8_t pending;
+};
+
+struct FleetDevice {
+  uint32_t index;
+  char id[13];
+  LinkState state;
+  bool pingOutstanding;
+  int8_t storm;                         // Storm that dropped it, -1 once back
+  int fd;
+
+  uint64_t wakeNs;
+  uint64_t nextAttemptNs;               // _lastReconnectAttempt + MQTT_RECONNECT_INTERVAL
+  uint64_t attemptNs;
+  uint64_t deadlineNs;
+  uint64_t lastOutNs;
+  uint64_t droppedNs;
+  uint32_t nextDataMs;                  // Device clock (millis())
+  uint32_t nextStreamMs;
+  uint32_t lastTs;
+  uint32_t excursionFromMs, excursionUntilMs;
+  uint32_t alertSeq;
+  uint32_t rng;
+
+  std::string out;
+  std::string in;
+
+  QueuedMessage queue[MQTT_QUEUE_DEPTH];
+  uint32_t head, tail, next;
+  uint16_t inFlight;
+  uint16_t nextPacketId;
+};
+
+static uint32_t nextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static double uniform(uint32_t& state) { return nextRandom(state) / 4294967296.0; }
+
+static bool inExcursion(const FleetDevice& d, uint32_t ms) {
+  return ms >= d.excursionFromMs && ms < d.excursionUntilMs;
+}
+
+// Slow per-device drift; deterministic in (device, millis) so resends match
+static SensorData synthesize(const FleetDevice& d, uint32_t ms) {
+  SensorData data;
+  double s = ms / 1000.0;
+  double phase = (d.index % 97) * 0.37;
+  data.temperature = (float)(21.0 + (d.index % 7) * 0.5 + 1.5 * sin(s / 900.0 + phase));
+  data.humidity = (float)(45.0 + 8.0 * sin(s / 1300.0 + phase));
+  data.pressure = (float)(1008.0 + 4.0 * sin(s / 7200.0 + phase));
+  data.gasResistance = (float)(120000.0 + 60000.0 * sin(s / 600.0 + phase));
+  data.iaq = (uint16_t)(50.0 + 40.0 * (1.0 + sin(s / 1800.0 + phase)));
+  data.iaqAccuracy = ms > 300000 ? 3 : 1;
+  data.co2Equivalent = 500.0f + data.iaq * 4.0f;
+  data.vocEquivalent = 0.5f + data.iaq / 100.0f;
+  data.timestamp = ms;
+  data.valid = true;
+  if (inExcursion(d, ms)) data.temperature = thresholds.maxTemperature + 1.5f;
+  return data;
+}
+
+// Context for the sink bus envelope (a plain function pointer)
+static thread_local const FleetDevice* envelopeDevice = nullptr;
+static thread_local const QueuedMessage* envelopeMessage = nullptr;
+
+static void fleetEnvelope(JsonDocument& doc) {
+  const FleetDevice& d = *envelopeDevice;
+  const QueuedMessage& m = *envelopeMessage;
+  char name[12];
+  snprintf(name, sizeof(name), "xBio-%.6s", d.id);
+
+  doc["device_id"] = d.id;
+  doc["device_name"] = name;
+  doc["calibrated"] = m.timestamp > 300000;
+
+  JsonObject status = doc["status"].to<JsonObject>();
+  status["wifi_rssi"] = -48 - (int)(d.index % 30);
+  status["uptime"] = m.timestamp / 1000;
+  status["free_heap"] = 170000 + (d.index * 7919) % 20000;
+  status["battery"] = 100;
+  status["mqtt_pending"] = m.pending;
+  status["uplink_links"] = 1;
+  status["tls_heap_saved"] = 0;
+
+  SensorData now = synthesize(d, m.timestamp);
+  SensorData early = synthesize(d, m.timestamp > 60000 ? m.timestamp - 60000 : 0);
+  JsonObject window = doc["aggregates"].to<JsonObject>();
+  window["window_s"] = 60;
+  window["samples"] = 60;
+  const char* keys[] = {"temperature", "humidity", "pressure", "iaq"};
+  float a[] = {now.temperature, now.humidity, now.pressure, (float)now.iaq};
+  float b[] = {early.temperature, early.humidity, early.pressure, (float)early.iaq};
+  for (uint8_t i = 0; i < 4; i++) {
+    JsonArray range = window[keys[i]].to<JsonArray>();
+    range.add(std::min(a[i], b[i]));
+    range.add((a[i] + b[i]) / 2);
+    range.add(std::max(a[i], b[i]));
+  }
+
+  if (m.timestamp > 600000) {
+    JsonObject anomaly = doc["anomaly"].to<JsonObject>();
+    float peak = 0;
+    for (uint8_t c = 0; c < (uint8_t)AnomalyChannel::COUNT; c++) {
+      float score = (float)fabs(sin(m.timestamp / 7000.0 + c + d.index)) * 1.5f;
+      anomaly[ANOMALY_CHANNELS[c].key] = score;
+      peak = std::max(peak, score);
+    }
+    anomaly["max"] = peak;
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Device worker: one epoll loop and timer heap per thread
+// ═══════════════════════════════════════════════════════════════════════════════
+class FleetWorker {
+public:
+  FleetWorker(int id, int stride);
+  void run();
+  bool drained() const { return _drained.load(std::memory_order_acquire); }
+
+  FleetCounters counters;
+  Histogram connectUs;
+  Histogram stormUs[FLEET_MAX_STORMS];
+  uint32_t stormVictims[FLEET_MAX_STORMS] = {};
+
+private:
+  typedef std::pair<uint64_t, uint32_t> Timer;
+
+  int _epoll;
+  std::vector<FleetDevice> _devices;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> _timers;
+  XBioSinkBus _bus;
+  std::string _packet;
+  char _payload[FLEET_BUFFER_SIZE];
+  uint8_t _recv[65536];
+  uint64_t _pending;                    // Sum of queued + in-flight messages
+  int _nextStorm;
+  std::atomic<bool> _drained{false};
+
+  uint64_t deviceNs(const FleetDevice& d, uint32_t ms) const { return shared[d.index].bootNs + ms * 1000000ull; }
+  uint32_t deviceMs(const FleetDevice& d, uint64_t now) const {
+    return now > shared[d.index].bootNs ? (uint32_t)((now - shared[d.index].bootNs) / 1000000) : 0;
+  }
+  uint32_t jittered(FleetDevice& d, uint32_t interval);
+
+  void schedule(FleetDevice& d);
+  void wake(FleetDevice& d, uint64_t now);
+  void sample(FleetDevice& d, uint32_t ms);
+  void stream(FleetDevice& d, uint32_t ms);
+
+  void startConnect(FleetDevice& d, uint64_t now);
+  void onConnected(FleetDevice& d, uint64_t now);
+  void onOnline(FleetDevice& d, uint64_t now);
+  void onReadable(FleetDevice& d, uint64_t now);
+  void handlePacket(FleetDevice& d, const uint8_t* p, size_t body, size_t length, uint64_t now);
+  void lose(FleetDevice& d, uint64_t now, bool counted);
+  void closeSocket(FleetDevice& d, bool reset);
+  bool flush(FleetDevice& d, uint64_t now);
+  void storm(int index, uint64_t now);
+
+  bool enqueue(FleetDevice& d, uint8_t kind, uint32_t timestamp, uint32_t seq);
+  void pump(FleetDevice& d, uint64_t now);
+  void onPubAck(FleetDevice& d, uint16_t packetId);
+  void releaseAcked(FleetDevice& d);
+  void rewind(FleetDevice& d);
+  size_t encode(FleetDevice& d, const QueuedMessage& m);
+  uint16_t allocatePacketId(FleetDevice& d);
+};
+
+FleetWorker::FleetWorker(int id, int stride) : _pending(0), _nextStorm(0) {
+  _epoll = epoll_create1(EPOLL_CLOEXEC);
+  _bus.setEnvelope(fleetEnvelope);
+  _packet.reserve(MQTT_QUEUE_SLOT_SIZE + 64);
+
+  _devices.reserve(opt.devices / stride + 1);
+  for (uint32_t i = id; i < opt.devices; i += stride) {
+    _devices.emplace_back();
+    FleetDevice& d = _devices.back();
+    d.index = i;
+    formatDeviceId(i, d.id);
+    d.state = LinkState::OFF;
+    d.pingOutstanding = false;
+    d.storm = -1;
+    d.fd = -1;
+    d.wakeNs = 0;
+    d.nextAttemptNs = 0;
+    d.attemptNs = d.deadlineNs = d.lastOutNs = d.droppedNs = 0;
+    d.rng = (i + 1) * 2654435761u ^ opt.seed;
+    if (!d.rng) d.rng = 1;
+    d.nextDataMs = jittered(d, opt.intervalMs);
+    d.nextStreamMs = opt.streamMs ? jittered(d, opt.streamMs) : UINT32_MAX;
+    d.lastTs = 0;
+    d.excursionFromMs = d.excursionUntilMs = 0;
+    d.alertSeq = 0;
+    d.head = d.tail = d.next = 0;
+    d.inFlight = 0;
+    d.nextPacketId = 1;
+    for (QueuedMessage& m : d.queue) m.state = SLOT_FREE;
+    schedule(d);
+  }
+}
+
+uint32_t FleetWorker::jittered(FleetDevice& d, uint32_t interval) {
+  double spread = opt.jitter * (2.0 * uniform(d.rng) - 1.0);
+  return (uint32_t)std::max(1.0, interval * (1.0 + spread));
+}
+
+void FleetWorker::run() {
+  epoll_event events[1024];
+  uint64_t lastCheck = 0;
+  uint64_t closeUntil = 0;
+  int seen = PHASE_RUN;
+
+  for (;;) {
+    uint64_t now = monoNs();
+    int current = phase.load(std::memory_order_acquire);
+
+    if (current != seen) {
+      seen = current;
+      if (current == PHASE_CLOSE) {
+        // Graceful shutdown: offline status (the will would say the same), then DISCONNECT
+        for (FleetDevice& d : _devices) {
+          if (d.state == LinkState::ONLINE) {
+            char payload[96];
+            int length = snprintf(payload, sizeof(payload), "{\"status\":\"offline\",\"device_id\":\"%s\"}", d.id);
+            char topic[40];
+            snprintf(topic, sizeof(topic), "xbio/%s/status", d.id);
+            putPublish(d.out, topic, payload, length, 0, true, false, 0);
+            d.out += (char)0xE0;
+            d.out += (char)0x00;
+            shared[d.index].online.store(0, std::memory_order_relaxed);
+            onlineCount.fetch_sub(1, std::memory_order_relaxed);
+            d.state = LinkState::CLOSED;
+            flush(d, now);
+          }
+          d.state = LinkState::CLOSED;
+          if (d.out.empty()) closeSocket(d, false);
+        }
+        closeUntil = now + FLEET_SETTLE_MS * 1000000ull;
+      }
+    }
+
+    if (current == PHASE_CLOSE) {
+      bool pending = false;
+      for (FleetDevice& d : _devices) pending |= d.fd >= 0 && !d.out.empty();
+      if (!pending || now >= closeUntil) break;
+    } else {
+      while (_nextStorm < opt.stormCount &&
+             now >= startNs + (uint64_t)(opt.storms[_nextStorm].atS * 1e9)) {
+        storm(_nextStorm++, now);
+      }
+      while (!_timers.empty() && _timers.top().first <= now) {
+        Timer timer = _timers.top();
+        _timers.pop();
+        FleetDevice& d = _devices[timer.second];
+        if (timer.first == d.wakeNs) wake(d, now);
+      }
+      if (current == PHASE_DRAIN && now - lastCheck > 100000000ull) {
+        lastCheck = now;
+        _drained.store(_pending == 0, std::memory_order_release);
+      }
+    }
+
+    uint64_t until = now + 100000000ull;
+    if (current != PHASE_CLOSE) {
+      if (!_timers.empty()) until = std::min(until, _timers.top().first);
+      if (_nextStorm < opt.stormCount) {
+        until = std::min(until, startNs + (uint64_t)(opt.storms[_nextStorm].atS * 1e9));
+      }
+    }
+    uint64_t wait = until > now ? until - now : 0;
+    timespec timeout = {(time_t)(wait / 1000000000ull), (long)(wait % 1000000000ull)};
+    int n = epoll_pwait2(_epoll, events, 1024, &timeout, nullptr);
+    now = monoNs();
+
+    for (int i = 0; i < n; i++) {
+      FleetDevice& d = _devices[events[i].data.u32];
+      if (d.fd < 0) continue;
+      if (d.state == LinkState::CLOSED) {
+        // Only the goodbye is left to write; anything the broker still sends is dropped
+        if (events[i].events & EPOLLIN) recv(d.fd, _recv, sizeof(_recv), MSG_DONTWAIT);
+        if (flush(d, now) && d.out.empty()) closeSocket(d, false);
+        d.state = LinkState::CLOSED;
+        continue;
+      }
+      if (d.state == LinkState::CONNECTING) {
+        if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) onConnected(d, now);
+      } else {
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP)) onReadable(d, now);
+        if (d.fd >= 0 && (events[i].events & EPOLLOUT)) flush(d, now);
+      }
+      schedule(d);
+    }
+  }
+
+  for (FleetDevice& d : _devices) {
+    if (d.fd >= 0) closeSocket(d, false);
+  }
+  close(_epoll);
+}
+
+void FleetWorker::schedule(FleetDevice& d) {
+  uint64_t at = UINT64_MAX;
+  int current = phase.load(std::memory_order_relaxed);
+
+  switch (d.state) {
+    case LinkState::OFF: at = shared[d.index].bootNs; break;
+    case LinkState::WAITING: at = d.nextAttemptNs; break;
+    case LinkState::CONNECTING:
+    case LinkState::CONNACK_WAIT: at = d.deadlineNs; break;
+    case LinkState::ONLINE:
+      at = d.lastOutNs + FLEET_KEEPALIVE * 1000000000ull;
+      if (current == PHASE_RUN && d.nextStreamMs != UINT32_MAX) at = std::min(at, deviceNs(d, d.nextStreamMs));
+      break;
+    case LinkState::CLOSED: return;
+  }
+  if (current == PHASE_RUN && d.state != LinkState::OFF) at = std::min(at, deviceNs(d, d.nextDataMs));
+
+  if (at != d.wakeNs) {
+    d.wakeNs = at;
+    if (at != UINT64_MAX) _timers.push(Timer(at, (uint32_t)(&d - _devices.data())));
+  }
+}
+
+void FleetWorker::wake(FleetDevice& d, uint64_t now) {
+  d.wakeNs = 0;
+  int current = phase.load(std::memory_order_relaxed);
+
+  if (d.state == LinkState::OFF || (d.state == LinkState::WAITING && now >= d.nextAttemptNs)) {
+    startConnect(d, now);
+  } else if ((d.state == LinkState::CONNECTING || d.state == LinkState::CONNACK_WAIT) && now >= d.deadlineNs) {
+    FleetCounters::bump(counters.failed);
+    lose(d, now, false);
+  }
+
+  if (current == PHASE_RUN) {
+    while (deviceNs(d, d.nextDataMs) <= now) {
+      sample(d, d.nextDataMs);
+      d.nextDataMs += jittered(d, opt.intervalMs);
+    }
+    while (d.nextStreamMs != UINT32_MAX && deviceNs(d, d.nextStreamMs) <= now) {
+      if (d.state == LinkState::ONLINE) stream(d, d.nextStreamMs);
+      d.nextStreamMs += opt.streamMs;
+    }
+  }
+
+  if (d.state == LinkState::ONLINE && now >= d.lastOutNs + FLEET_KEEPALIVE * 1000000000ull) {
+    if (d.pingOutstanding) {
+      lose(d, now, true);
+    } else {
+      d.out += (char)0xC0;
+      d.out += (char)0x00;
+      d.pingOutstanding = true;
+      FleetCounters::bump(counters.pings);
+      flush(d, now);
+    }
+  }
+
+  schedule(d);
+}
+
+void FleetWorker::sample(FleetDevice& d, uint32_t ms) {
+  // Temperature excursions above max_temp: raised at the first hot sample, cleared at the first normal one
+  if (opt.alertRate > 0 && !inExcursion(d, ms) && ms >= d.excursionUntilMs &&
+      uniform(d.rng) < opt.alertRate * opt.intervalMs / 3600000.0) {
+    d.excursionFromMs = ms;
+    d.excursionUntilMs = ms + 60000 + (uint32_t)(uniform(d.rng) * 240000);
+    if (enqueue(d, MSG_ALERT_RAISED, ms, ++d.alertSeq)) FleetCounters::bump(counters.alertsQueued);
+  } else if (d.excursionUntilMs && !inExcursion(d, ms) && d.excursionFromMs < d.excursionUntilMs) {
+    if (enqueue(d, MSG_ALERT_CLEARED, ms, ++d.alertSeq)) FleetCounters::bump(counters.alertsQueued);
+    d.excursionFromMs = d.excursionUntilMs;
+  }
+
+  // A get_status answer may already have used this millisecond
+  if (ms <= d.lastTs) ms = d.lastTs + 1;
+  d.lastTs = ms;
+  if (enqueue(d, MSG_DATA, ms, 0)) FleetCounters::bump(counters.dataQueued);
+  if (d.state == LinkState::ONLINE) pump(d, monoNs());
+}
+
+void FleetWorker::stream(FleetDevice& d, uint32_t ms) {
+  char topic[40];
+  snprintf(topic, sizeof(topic), "xbio/%s/ws", d.id);
+  SensorData data = synthesize(d, ms);
+  size_t length = XBioSinkBus::encodeCompact(data, ms, _payload, sizeof(_payload));
+  if (!length) return;
+  putPublish(d.out, topic, _payload, length, 0, false, false, 0);
+  FleetCounters::bump(counters.streamSent);
+  flush(d, monoNs());
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Connection
+// ═══════════════════════════════════════════════════════════════════════════════
+void FleetWorker::startConnect(FleetDevice& d, uint64_t now) {
+  // XBioMQTTClient::loop(): one attempt per MQTT_RECONNECT_INTERVAL
+  d.attemptNs = now;
+  d.nextAttemptNs = now + FLEET_RECONNECT_INTERVAL * 1000000ull;
+  d.deadlineNs = now + FLEET_SOCKET_TIMEOUT * 1000000000ull;
+  d.state = LinkState::WAITING;
+
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    reportError("socket", errno);
+    FleetCounters::bump(counters.failed);
+    return;
+  }
+
+  // Measure the broker, not Nagle against delayed ACKs on loopback
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (opt.sourceIps > 0) {
+    setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+    sockaddr_in source = {};
+    source.sin_family = AF_INET;
+    source.sin_addr.s_addr = htonl(0x7F000002 + d.index % (uint32_t)opt.sourceIps);
+    if (bind(fd, (sockaddr*)&source, sizeof(source)) != 0) {
+      reportError("bind", errno);
+      close(fd);
+      FleetCounters::bump(counters.failed);
+      return;
+    }
+  }
+
+  if (connect(fd, (sockaddr*)&brokerAddr, sizeof(brokerAddr)) != 0 && errno != EINPROGRESS) {
+    reportError("connect", errno);
+    close(fd);
+    FleetCounters::bump(counters.failed);
+    return;
+  }
+
+  epoll_event event = {};
+  event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+  event.data.u32 = (uint32_t)(&d - _devices.data());
+  epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event);
+  d.fd = fd;
+  d.state = LinkState::CONNECTING;
+}
+
+void FleetWorker::onConnected(FleetDevice& d, uint64_t now) {
+  int error = 0;
+  socklen_t length = sizeof(error);
+  getsockopt(d.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+  if (error) {
+    reportError("connect", error);
+    FleetCounters::bump(counters.failed);
+    lose(d, now, false);
+    return;
+  }
+
+  char willTopic[40];
+  char will[96];
+  snprintf(willTopic, sizeof(willTopic), "xbio/%s/status", d.id);
+  snprintf(will, sizeof(will), "{\"status\":\"offline\",\"device_id\":\"%s\"}", d.id);
+  putConnect(d.out, d.id, willTopic, will);
+  d.state = LinkState::CONNACK_WAIT;
+  flush(d, now);
+}
+
+void FleetWorker::onOnline(FleetDevice& d, uint64_t now) {
+  d.state = LinkState::ONLINE;
+  d.pingOutstanding = false;
+  connectUs.add((now - d.attemptNs) / 1000);
+  FleetCounters::bump(counters.connects);
+  shared[d.index].online.store(1, std::memory_order_relaxed);
+  onlineCount.fetch_add(1, std::memory_order_relaxed);
+  if (d.storm >= 0) {
+    stormUs[d.storm].add((now - d.droppedNs) / 1000);
+    d.storm = -1;
+  }
+
+  // XBioMQTTClient::connect(): subscribe, announce, then resend the QoS 1 backlog
+  char topic[40];
+  snprintf(topic, sizeof(topic), "xbio/%s/cmd", d.id);
+  const char* filters[] = {topic};
+  const uint8_t qos[] = {1};
+  putSubscribe(d.out, allocatePacketId(d), filters, qos, 1);
+
+  JsonDocument doc;
+  uint32_t ms = deviceMs(d, now);
+  doc["status"] = "online";
+  doc["device_id"] = d.id;
+  doc["timestamp"] = ms;
+  doc["uptime"] = ms / 1000;
+  doc["free_heap"] = 170000 + (d.index * 7919) % 20000;
+  doc["config_hash"] = 0x5EED0000u ^ opt.seed;
+  doc["alerts_active"] = inExcursion(d, ms) ? 1 : 0;
+  doc["alert_seq"] = d.alertSeq;
+  size_t length = serializeJson(doc, _payload, sizeof(_payload));
+  snprintf(topic, sizeof(topic), "xbio/%s/status", d.id);
+  putPublish(d.out, topic, _payload, length, 0, true, false, 0);
+
+  rewind(d);
+  pump(d, now);
+  flush(d, now);
+}
+
+void FleetWorker::onReadable(FleetDevice& d, uint64_t now) {
+  for (;;) {
+    ssize_t n = recv(d.fd, _recv, sizeof(_recv), MSG_DONTWAIT);
+    if (n > 0) {
+      FleetCounters::bump(counters.bytesIn, n);
+      d.in.append((const char*)_recv, n);
+      if ((size_t)n < sizeof(_recv)) break;
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0 && errno == EINTR) continue;
+    lose(d, now, d.state == LinkState::ONLINE);
+    return;
+  }
+
+  size_t offset = 0;
+  while (d.fd >= 0) {
+    size_t body, length;
+    const uint8_t* p = (const uint8_t*)d.in.data() + offset;
+    size_t total = nextPacket(p, d.in.size() - offset, &body, &length);
+    if (total == 0) break;
+    if (total == SIZE_MAX) {
+      lose(d, now, d.state == LinkState::ONLINE);
+      return;
+    }
+    offset += total;
+    handlePacket(d, p, body, length, now);
+  }
+  if (d.fd >= 0) d.in.erase(0, offset);
+}
+
+void FleetWorker::handlePacket(FleetDevice& d, const uint8_t* p, size_t body, size_t length, uint64_t now) {
+  const uint8_t* b = p + body;
+  switch (p[0] & 0xF0) {
+    case 0x20: // CONNACK
+      if (d.state != LinkState::CONNACK_WAIT || length < 2) return;
+      if (b[1] != 0) {
+        FleetCounters::bump(counters.refused);
+        lose(d, now, false);
+        return;
+      }
+      onOnline(d, now);
+      return;
+
+    case 0x40: // PUBACK
+      if (length >= 2) onPubAck(d, (uint16_t)(b[0] << 8 | b[1]));
+      pump(d, now);
+      flush(d, now);
+      return;
+
+    case 0x30: { // PUBLISH (xbio/<id>/cmd)
+      uint8_t qos = (p[0] >> 1) & 3;
+      if (length < 2) return;
+      size_t topicLength = (size_t)(b[0] << 8 | b[1]);
+      size_t at = 2 + topicLength;
+      if (qos) {
+        if (at + 2 > length) return;
+        putAck(d.out, 0x40, (uint16_t)(b[at] << 8 | b[at + 1]));
+        at += 2;
+      }
+      if (at > length) return;
+      FleetCounters::bump(counters.commands);
+
+      // cmdGetStatus() -> publishData(): the latest sample, outside the normal rate
+      if (jsonStringIs((const char*)b + at, length - at, "command", "get_status")) {
+        uint32_t ms = std::max(deviceMs(d, now), d.lastTs + 1);
+        d.lastTs = ms;
+        shared[d.index].answerTs.store(ms, std::memory_order_release);
+        if (enqueue(d, MSG_DATA, ms, 0)) FleetCounters::bump(counters.dataQueued);
+        pump(d, now);
+      }
+      flush(d, now);
+      return;
+    }
+
+    case 0xD0: // PINGRESP
+      d.pingOutstanding = false;
+      return;
+
+    default: // SUBACK and anything else a device ignores
+      return;
+  }
+}
+
+void FleetWorker::lose(FleetDevice& d, uint64_t now, bool counted) {
+  if (counted) FleetCounters::bump(counters.lost);
+  closeSocket(d, false);
+  if (d.state == LinkState::ONLINE) {
+    shared[d.index].online.store(0, std::memory_order_relaxed);
+    onlineCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+  d.state = LinkState::WAITING;
+  rewind(d);
+  (void)now;
+}
+
+void FleetWorker::closeSocket(FleetDevice& d, bool reset) {
+  if (d.fd < 0) return;
+  if (reset) {
+    linger abort = {1, 0};
+    setsockopt(d.fd, SOL_SOCKET, SO_LINGER, &abort, sizeof(abort));
+  }
+  close(d.fd);
+  d.fd = -1;
+  d.out.clear();
+  d.in.clear();
+}
+
+bool FleetWorker::flush(FleetDevice& d, uint64_t now) {
+  if (d.fd < 0 || d.out.empty() || d.state == LinkState::CONNECTING) return true;
+
+  size_t offset = 0;
+  while (offset < d.out.size()) {
+    ssize_t n = send(d.fd, d.out.data() + offset, d.out.size() - offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0) {
+      offset += n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    lose(d, now, d.state == LinkState::ONLINE);
+    return false;
+  }
+  FleetCounters::bump(counters.bytesOut, offset);
+  d.out.erase(0, offset);
+  d.lastOutNs = now;
+
+  epoll_event event = {};
+  event.events = EPOLLIN | EPOLLRDHUP | (d.out.empty() ? 0u : (uint32_t)EPOLLOUT);
+  event.data.u32 = (uint32_t)(&d - _devices.data());
+  epoll_ctl(_epoll, EPOLL_CTL_MOD, d.fd, &event);
+  return true;
+}
+
+void FleetWorker::storm(int index, uint64_t now) {
+  // Abrupt loss (RST, no DISCONNECT): the broker publishes every victim's will
+  for (FleetDevice& d : _devices) {
+    if (d.state != LinkState::ONLINE || uniform(d.rng) >= opt.storms[index].fraction) continue;
+    closeSocket(d, true);
+    shared[d.index].online.store(0, std::memory_order_relaxed);
+    onlineCount.fetch_sub(1, std::memory_order_relaxed);
+    d.state = LinkState::WAITING;
+    d.storm = (int8_t)index;
+    d.droppedNs = now;
+    rewind(d);
+    stormVictims[index]++;
+    FleetCounters::bump(counters.stormDrops);
+    schedule(d);
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// QoS 1 queue (MQTTOutboundQueue semantics)
+// ═══════════════════════════════════════════════════════════════════════════════
+bool FleetWorker::enqueue(FleetDevice& d, uint8_t kind, uint32_t timestamp, uint32_t seq) {
+  if (d.head - d.tail >= MQTT_QUEUE_DEPTH) {
+    // Evict the oldest message only if nothing is on the wire (offline backlog)
+    QueuedMessage& oldest = d.queue[d.tail % MQTT_QUEUE_DEPTH];
+    FleetCounters::bump(counters.queueDropped);
+    if (d.next == d.tail && oldest.state == SLOT_QUEUED) {
+      oldest.state = SLOT_FREE;
+      d.tail++;
+      d.next++;
+      _pending--;
+    } else {
+      return false;
+    }
+  }
+
+  QueuedMessage& m = d.queue[d.head % MQTT_QUEUE_DEPTH];
+  m.timestamp = timestamp;
+  m.seq = (uint16_t)seq;
+  m.kind = kind;
+  m.state = SLOT_QUEUED;
+  m.sent = 0;
+  m.pending = (uint8_t)(d.head - d.tail);
+  m.packetId = allocatePacketId(d);
+  d.head++;
+  _pending++;
+  return true;
+}
+
+void FleetWorker::pump(FleetDevice& d, uint64_t now) {
+  while (d.fd >= 0 && d.inFlight < MQTT_INFLIGHT_WINDOW && d.next != d.head) {
+    QueuedMessage& m = d.queue[d.next % MQTT_QUEUE_DEPTH];
+    if (m.state == SLOT_ACKED) {
+      d.next++;
+      continue;
+    }
+    // Transport full: the rest goes after the socket drains (or after reconnect)
+    if (d.out.size() >= FLEET_SEND_BUFFER) break;
+
+    if (!encode(d, m)) {
+      // Does not fit a queue slot: mqtt_session.h refuses it at enqueue
+      FleetCounters::bump(counters.queueDropped);
+      m.state = SLOT_ACKED;
+      d.next++;
+      releaseAcked(d);
+      continue;
+    }
+    d.out += _packet;
+    FleetCounters::bump(m.sent ? counters.resent : counters.sent);
+
+    m.state = SLOT_INFLIGHT;
+    m.sent = 1;
+    d.next++;
+    d.inFlight++;
+  }
+  flush(d, now);
+}
+
+void FleetWorker::onPubAck(FleetDevice& d, uint16_t packetId) {
+  for (uint32_t seq = d.tail; seq != d.next; seq++) {
+    QueuedMessage& m = d.queue[seq % MQTT_QUEUE_DEPTH];
+    if (m.state == SLOT_INFLIGHT && m.packetId == packetId) {
+      m.state = SLOT_ACKED;
+      d.inFlight--;
+      if (m.kind == MSG_DATA) {
+        shared[d.index].acked++;
+        FleetCounters::bump(counters.dataAcked);
+      } else {
+        FleetCounters::bump(counters.alertsAcked);
+      }
+      break;
+    }
+  }
+  releaseAcked(d);
+}
+
+void FleetWorker::releaseAcked(FleetDevice& d) {
+  while (d.tail != d.next && d.queue[d.tail % MQTT_QUEUE_DEPTH].state == SLOT_ACKED) {
+    d.queue[d.tail % MQTT_QUEUE_DEPTH].state = SLOT_FREE;
+    d.tail++;
+    _pending--;
+  }
+}
+
+void FleetWorker::rewind(FleetDevice& d) {
+  for (uint32_t seq = d.tail; seq != d.head; seq++) {
+    QueuedMessage& m = d.queue[seq % MQTT_QUEUE_DEPTH];
+    if (m.state == SLOT_INFLIGHT) m.state = SLOT_QUEUED;
+  }
+  d.next = d.tail;
+  d.inFlight = 0;
+}
+
+size_t FleetWorker::encode(FleetDevice& d, const QueuedMessage& m) {
+  char topic[40];
+  size_t length;
+
+  if (m.kind == MSG_DATA) {
+    snprintf(topic, sizeof(topic), "xbio/%s/data", d.id);
+    envelopeDevice = &d;
+    envelopeMessage = &m;
+    length = _bus.encodeFull(synthesize(d, m.timestamp), m.timestamp, _payload, sizeof(_payload));
+  } else {
+    // publishAlert()
+    snprintf(topic, sizeof(topic), "xbio/%s/alerts", d.id);
+    AlertEventKind kind = m.kind == MSG_ALERT_RAISED ? AlertEventKind::RAISED : AlertEventKind::CLEARED;
+    SensorData data = synthesize(d, m.timestamp);
+    JsonDocument doc;
+    doc["type"] = AlertManager::typeName(AlertType::HIGH_TEMPERATURE);
+    doc["event"] = AlertManager::kindName(kind);
+    doc["value"] = data.temperature;
+    doc["threshold"] = thresholds.maxTemperature;
+    doc["seq"] = m.seq;
+    doc["timestamp"] = m.timestamp;
+    doc["device_id"] = d.id;
+    length = serializeJson(doc, _payload, sizeof(_payload));
+  }
+  if (length == 0 || length >= sizeof(_payload)) return 0;
+
+  _packet.clear();
+  putPublish(_packet, topic, _payload, length, 1, false, m.sent != 0, m.packetId);
+  return _packet.size() <= MQTT_QUEUE_SLOT_SIZE ? _packet.size() : 0;
+}
+
+uint16_t FleetWorker::allocatePacketId(FleetDevice& d) {
+  uint16_t id = d.nextPacketId++;
+  if (d.nextPacketId == 0) d.nextPacketId = 1;
+  return id;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Server connection: what iot_service.ts subscribes to, plus get_status commands
+// ═══════════════════════════════════════════════════════════════════════════════
+class FleetServer {
+public:
+  bool begin();
+  void run();
+
+  Histogram dataUs;                     // Sample time -> delivered to the server
+  Histogram streamUs;
+  Histogram commandUs;                  // get_status sent -> answering data delivered
+
+  std::atomic<uint64_t> dataReceived{0};
+  std::atomic<uint64_t> duplicates{0};
+  std::atomic<uint64_t> streamReceived{0};
+  std::atomic<uint64_t> alertsReceived{0};
+  std::atomic<uint64_t> alertGaps{0};
+  std::atomic<uint64_t> wills{0};
+  std::atomic<uint64_t> goodbyes{0};    // Graceful offline at the end of the run
+  std::atomic<uint64_t> onlines{0};
+  std::atomic<uint64_t> commandsSent{0};
+  std::atomic<uint64_t> commandsAnswered{0};
+  std::atomic<uint64_t> commandsLost{0};
+  std::atomic<uint64_t> reconnects{0};
+  std::atomic<bool> stop{false};
+
+private:
+  int _fd = -1;
+  std::string _out;
+  std::string _in;
+  uint16_t _packetId = 1;
+  uint64_t _lastOutNs = 0;
+  uint32_t _rng = 0x9E3779B9u;
+  std::deque<std::pair<uint32_t, uint64_t>> _commands;
+
+  bool flush();
+  void disconnect();
+  void handlePacket(const uint8_t* p, size_t body, size_t length, uint64_t now);
+  void onMessage(const char* topic, size_t topicLength, const char* payload, size_t length, uint64_t now);
+  void sendCommand(uint64_t now);
+  uint16_t packetId() {
+    uint16_t id = _packetId++;
+    if (_packetId == 0) _packetId = 1;
+    return id;
+  }
+};
+
+bool FleetServer::begin() {
+  _fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (_fd < 0 || connect(_fd, (sockaddr*)&brokerAddr, sizeof(brokerAddr)) != 0) {
+    reportError("server connection", errno);
+    disconnect();
+    return false;
+  }
+  int one = 1;
+  setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  int size = 8 << 20;
+  setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+  char clientId[32];
+  snprintf(clientId, sizeof(clientId), "xbio-fleet-server-%d", (int)getpid());
+  putConnect(_out, clientId, nullptr, nullptr);
+  static const char* const filters[] = {"xbio/+/data", "xbio/+/status", "xbio/+/alerts", "xbio/+/ws"};
+  static const uint8_t qos[] = {1, 1, 1, 0};
+  putSubscribe(_out, packetId(), filters, qos, 4);
+  if (!flush()) {
+    disconnect();
+    return false;
+  }
+
+  // Block until CONNACK and SUBACK, so the fleet starts against a live subscriber
+  bool connected = false, subscribed = false;
+  uint64_t deadline = monoNs() + 5000000000ull;
+  while (!subscribed && monoNs() < deadline) {
+    pollfd pfd = {_fd, POLLIN, 0};
+    if (poll(&pfd, 1, 100) <= 0) continue;
+    uint8_t buffer[4096];
+    ssize_t n = recv(_fd, buffer, sizeof(buffer), 0);
+    if (n <= 0) break;
+    _in.append((const char*)buffer, n);
+    size_t body, length, total;
+    while ((total = nextPacket((const uint8_t*)_in.data(), _in.size(), &body, &length)) != 0 && total != SIZE_MAX) {
+      uint8_t type = (uint8_t)_in[0] & 0xF0;
+      if (type == 0x20 && length >= 2 && _in[body + 1] == 0) connected = true;
+      if (type == 0x90 && connected) subscribed = true;
+      _in.erase(0, total);
+    }
+  }
+  if (!subscribed) {
+    fprintf(stderr, "xbio_fleet: %s:%u did not accept the server connection\n", opt.host, opt.port);
+    disconnect();
+    return false;
+  }
+  return true;
+}
+
+void FleetServer::disconnect() {
+  if (_fd >= 0) close(_fd);
+  _fd = -1;
+  _in.clear();
+  _out.clear();
+}
+
+void FleetServer::run() {
+  int epoll = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  epoll_ctl(epoll, EPOLL_CTL_ADD, _fd, &event);
+  static uint8_t buffer[1 << 20];
+
+  uint64_t nextCommand = startNs + (uint64_t)(opt.rampS * 1e9);
+  uint64_t commandPeriod = opt.cmdRate > 0 ? (uint64_t)(1e9 / opt.cmdRate) : 0;
+
+  while (!stop.load(std::memory_order_acquire)) {
+    // Broker restart: what is published until we are back counts as server-side drops
+    if (_fd < 0) {
+      if (!begin()) {
+        usleep(1000000);
+        continue;
+      }
+      reconnects.fetch_add(1, std::memory_order_relaxed);
+      epoll_ctl(epoll, EPOLL_CTL_ADD, _fd, &event);
+    }
+
+    uint64_t now = monoNs();
+    bool running = phase.load(std::memory_order_relaxed) == PHASE_RUN;
+
+    if (commandPeriod && running) {
+      while (nextCommand <= now) {
+        sendCommand(now);
+        nextCommand += commandPeriod;
+      }
+    }
+    while (!_commands.empty() && now - _commands.front().second > FLEET_COMMAND_TIMEOUT_S * 1000000000ull) {
+      DeviceShared& s = shared[_commands.front().first];
+      uint64_t expected = _commands.front().second;
+      if (s.commandNs.compare_exchange_strong(expected, 0)) commandsLost.fetch_add(1, std::memory_order_relaxed);
+      _commands.pop_front();
+    }
+    if (now - _lastOutNs > FLEET_KEEPALIVE * 500000000ull) {
+      _out += (char)0xC0;
+      _out += (char)0x00;
+    }
+    if (!flush()) {
+      disconnect();
+      continue;
+    }
+
+    uint64_t until = now + 100000000ull;
+    if (commandPeriod && running) until = std::min(until, nextCommand);
+    uint64_t wait = until > now ? until - now : 0;
+    timespec timeout = {(time_t)(wait / 1000000000ull), (long)(wait % 1000000000ull)};
+    epoll_event events[1];
+    if (epoll_pwait2(epoll, events, 1, &timeout, nullptr) <= 0) continue;
+
+    ssize_t n = recv(_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+      fprintf(stderr, "xbio_fleet: server connection lost\n");
+      disconnect();
+      continue;
+    }
+    if (n < 0) continue;
+    now = monoNs();
+    _in.append((const char*)buffer, n);
+
+    size_t offset = 0;
+    for (;;) {
+      size_t body, length;
+      const uint8_t* p = (const uint8_t*)_in.data() + offset;
+      size_t total = nextPacket(p, _in.size() - offset, &body, &length);
+      if (total == 0) break;
+      if (total == SIZE_MAX) {
+        fprintf(stderr, "xbio_fleet: malformed packet from broker\n");
+        disconnect();
+        break;
+      }
+      handlePacket(p, body, length, now);
+      offset += total;
+    }
+    if (_fd >= 0) _in.erase(0, offset);
+  }
+
+  close(epoll);
+  if (_fd < 0) return;
+  _out.clear();
+  _out += (char)0xE0;
+  _out += (char)0x00;
+  flush();
+  disconnect();
+}
+
+bool FleetServer::flush() {
+  size_t offset = 0;
+  while (offset < _out.size()) {
+    ssize_t n = send(_fd, _out.data() + offset, _out.size() - offset, MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      reportError("server connection", errno);
+      return false;
+    }
+    offset += n;
+  }
+  if (offset) _lastOutNs = monoNs();
+  _out.clear();
+  return true;
+}
+
+void FleetServer::handlePacket(const uint8_t* p, size_t body, size_t length, uint64_t now) {
+  if ((p[0] & 0xF0) != 0x30 || length < 2) return;
+
+  const uint8_t* b = p + body;
+  uint8_t qos = (p[0] >> 1) & 3;
+  size_t topicLength = (size_t)(b[0] << 8 | b[1]);
+  size_t at = 2 + topicLength;
+  if (qos) {
+    if (at + 2 > length) return;
+    putAck(_out, 0x40, (uint16_t)(b[at] << 8 | b[at + 1]));
+    at += 2;
+  }
+  if (at > length) return;
+
+  // Retained copies replayed at SUBSCRIBE belong to earlier runs
+  if (p[0] & 0x01) return;
+  onMessage((const char*)b + 2, topicLength, (const char*)b + at, length - at, now);
+}
+
+void FleetServer::onMessage(const char* topic, size_t topicLength, const char* payload, size_t length,
+                            uint64_t now) {
+  const char* leaf;
+  int64_t index = parseTopic(topic, topicLength, &leaf);
+  if (index < 0) return;
+  DeviceShared& s = shared[index];
+  size_t leafLength = topic + topicLength - leaf;
+  uint32_t ts;
+
+  if (leafLength == 4 && !memcmp(leaf, "data", 4)) {
+    if (!jsonUnsigned(payload, length, "timestamp", &ts)) return;
+    if (ts <= s.lastData && s.received) {
+      duplicates.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    s.lastData = ts;
+    s.received++;
+    dataReceived.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t sentNs = s.commandNs.load(std::memory_order_relaxed);
+    if (sentNs && s.answerTs.load(std::memory_order_acquire) == ts) {
+      if (s.commandNs.compare_exchange_strong(sentNs, 0)) {
+        commandUs.add((now - sentNs) / 1000);
+        commandsAnswered.fetch_add(1, std::memory_order_relaxed);
+      }
+      return;
+    }
+    uint64_t sampledNs = s.bootNs + ts * 1000000ull;
+    dataUs.add(now > sampledNs ? (now - sampledNs) / 1000 : 0);
+  } else if (leafLength == 2 && !memcmp(leaf, "ws", 2)) {
+    if (!jsonUnsigned(payload, length, "ts", &ts)) return;
+    streamReceived.fetch_add(1, std::memory_order_relaxed);
+    s.lastStream = ts;
+    uint64_t sampledNs = s.bootNs + ts * 1000000ull;
+    streamUs.add(now > sampledNs ? (now - sampledNs) / 1000 : 0);
+  } else if (leafLength == 6 && !memcmp(leaf, "alerts", 6)) {
+    uint32_t seq;
+    if (!jsonUnsigned(payload, length, "seq", &seq) || seq <= s.lastAlertSeq) return;
+    alertsReceived.fetch_add(1, std::memory_order_relaxed);
+    alertGaps.fetch_add(seq - s.lastAlertSeq - 1, std::memory_order_relaxed);
+    s.lastAlertSeq = seq;
+  } else if (leafLength == 6 && !memcmp(leaf, "status", 6)) {
+    if (jsonStringIs(payload, length, "status", "online")) {
+      onlines.fetch_add(1, std::memory_order_relaxed);
+    } else if (jsonStringIs(payload, length, "status", "offline")) {
+      (phase.load(std::memory_order_relaxed) >= PHASE_CLOSE ? goodbyes : wills).fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void FleetServer::sendCommand(uint64_t now) {
+  // iot_service.ts sendCommand(): {"command":"<name>", ...params} at QoS 1
+  for (int attempt = 0; attempt < 8; attempt++) {
+    uint32_t index = nextRandom(_rng) % opt.devices;
+    DeviceShared& s = shared[index];
+    uint64_t idle = 0;
+    if (!s.online.load(std::memory_order_relaxed)) continue;
+    if (!s.commandNs.compare_exchange_strong(idle, now)) continue;
+
+    char id[13];
+    char topic[40];
+    formatDeviceId(index, id);
+    snprintf(topic, sizeof(topic), "xbio/%s/cmd", id);
+    static const char payload[] = "{\"command\":\"get_status\"}";
+    putPublish(_out, topic, payload, sizeof(payload) - 1, 1, false, false, packetId());
+    _commands.emplace_back(index, now);
+    commandsSent.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Main
+// ═══════════════════════════════════════════════════════════════════════════════
+static void usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [--host H] [--port N] [--user U] [--pass P] [--devices N] [--id-base N]\n"
+          "          [--threads N] [--duration S] [--interval-ms N] [--stream-ms N] [--jitter F]\n"
+          "          [--ramp S] [--storm AT_S[:FRACTION]]... [--cmd-rate N] [--alert-rate N]\n"
+          "          [--source-ips N] [--seed N]\n", program);
+  exit(2);
+}
+
+static FleetTotals totals(const std::vector<FleetWorker*>& workers) {
+  FleetTotals sum;
+  for (FleetWorker* w : workers) sum.add(w->counters);
+  return sum;
+}
+
+static void printLatency(const char* label, const Histogram& h) {
+  if (!h.count()) {
+    printf("  %-10s none\n", label);
+    return;
+  }
+  printf("  %-10s p50 %.2f ms  p99 %.2f ms  p99.9 %.2f ms  max %.2f ms  (%llu)\n", label,
+         h.percentile(0.50) / 1000.0, h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0,
+         h.max() / 1000.0, (unsigned long long)h.count());
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) usage(argv[0]);
+    i++;
+    if (!strcmp(arg, "--host")) {
+      opt.host = value;
+    } else if (!strcmp(arg, "--port")) {
+      opt.port = (uint16_t)atoi(value);
+    } else if (!strcmp(arg, "--user")) {
+      opt.user = value;
+    } else if (!strcmp(arg, "--pass")) {
+      opt.pass = value;
+    } else if (!strcmp(arg, "--devices")) {
+      opt.devices = (uint32_t)strtoul(value, nullptr, 10);
+    } else if (!strcmp(arg, "--id-base")) {
+      opt.idBase = (uint32_t)strtoul(value, nullptr, 10);
+    } else if (!strcmp(arg, "--threads")) {
+      opt.threads = atoi(value);
+    } else if (!strcmp(arg, "--duration")) {
+      opt.durationS = atof(value);
+    } else if (!strcmp(arg, "--interval-ms")) {
+      opt.intervalMs = (uint32_t)strtoul(value, nullptr, 10);
+    } else if (!strcmp(arg, "--stream-ms")) {
+      opt.streamMs = (uint32_t)strtoul(value, nullptr, 10);
+    } else if (!strcmp(arg, "--jitter")) {
+      opt.jitter = atof(value);
+    } else if (!strcmp(arg, "--ramp")) {
+      opt.rampS = atof(value);
+    } else if (!strcmp(arg, "--storm")) {
+      if (opt.stormCount >= FLEET_MAX_STORMS) usage(argv[0]);
+      FleetStorm& s = opt.storms[opt.stormCount++];
+      s.fraction = 1.0;
+      if (sscanf(value, "%lf:%lf", &s.atS, &s.fraction) < 1 || s.fraction <= 0 || s.fraction > 1) usage(argv[0]);
+    } else if (!strcmp(arg, "--cmd-rate")) {
+      opt.cmdRate = atof(value);
+    } else if (!strcmp(arg, "--alert-rate")) {
+      opt.alertRate = atof(value);
+    } else if (!strcmp(arg, "--source-ips")) {
+      opt.sourceIps = atoi(value);
+    } else if (!strcmp(arg, "--seed")) {
+      opt.seed = (uint32_t)strtoul(value, nullptr, 10);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (opt.devices == 0 || opt.devices > 0xFFFFFF || opt.intervalMs == 0 || opt.durationS <= 0 ||
+      opt.jitter < 0 || opt.jitter >= 1 || opt.sourceIps > FLEET_MAX_SOURCE_IPS) {
+    usage(argv[0]);
+  }
+
+  addrinfo hints = {};
+  addrinfo* resolved = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(opt.host, nullptr, &hints, &resolved) != 0 || !resolved) {
+    fprintf(stderr, "xbio_fleet: cannot resolve %s\n", opt.host);
+    return 1;
+  }
+  brokerAddr = *(sockaddr_in*)resolved->ai_addr;
+  brokerAddr.sin_port = htons(opt.port);
+  freeaddrinfo(resolved);
+
+  bool loopback = (ntohl(brokerAddr.sin_addr.s_addr) >> 24) == 127;
+  if (opt.sourceIps < 0) {
+    opt.sourceIps = loopback && opt.devices > FLEET_DEVICES_PER_SOURCE_IP
+      ? (int)((opt.devices + FLEET_DEVICES_PER_SOURCE_IP - 1) / FLEET_DEVICES_PER_SOURCE_IP)
+      : 0;
+  }
+  if (opt.sourceIps > 0 && !loopback) {
+    fprintf(stderr, "xbio_fleet: --source-ips needs a loopback broker\n");
+    return 1;
+  }
+
+  if (opt.threads <= 0) opt.threads = (int)std::max(1u, std::min(16u, std::thread::hardware_concurrency()));
+  opt.threads = (int)std::min<uint32_t>((uint32_t)opt.threads, opt.devices);
+
+  rlimit files;
+  getrlimit(RLIMIT_NOFILE, &files);
+  files.rlim_cur = files.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &files);
+  if (files.rlim_cur < opt.devices + 64) {
+    fprintf(stderr, "xbio_fleet: %u devices need %u file descriptors, limit is %llu\n", opt.devices,
+            opt.devices + 64, (unsigned long long)files.rlim_cur);
+    return 1;
+  }
+
+  ConfigManager::defaults(thresholds);
+
+  printf("xBio fleet: %u devices on %d threads -> %s:%u, %.0f s, data every %u ms (+/-%.0f %%), "
+         "stream %s, ramp %.0f s\n", opt.devices, opt.threads, opt.host, opt.port, opt.durationS, opt.intervalMs,
+         opt.jitter * 100, opt.streamMs ? "on" : "off", opt.rampS);
+
+  shared = new DeviceShared[opt.devices];
+  FleetServer server;
+  if (!server.begin()) {
+    fprintf(stderr, "xbio_fleet: no MQTT broker at %s:%u\n", opt.host, opt.port);
+    return 1;
+  }
+
+  startNs = monoNs() + 100000000ull;
+  for (uint32_t i = 0; i < opt.devices; i++) {
+    shared[i].bootNs = startNs + (uint64_t)(opt.rampS * 1e9 * i / opt.devices);
+  }
+
+  std::vector<FleetWorker*> workers;
+  for (int t = 0; t < opt.threads; t++) workers.push_back(new FleetWorker(t, opt.threads));
+  std::vector<std::thread> threads;
+  for (FleetWorker* w : workers) threads.emplace_back([w]() { w->run(); });
+  std::thread serverThread([&server]() { server.run(); });
+
+  // Progress, once a second
+  uint64_t endNs = startNs + (uint64_t)(opt.durationS * 1e9);
+  FleetTotals last;
+  uint64_t lastReceived = 0;
+  for (int second = 1; monoNs() < endNs; second++) {
+    uint64_t at = startNs + second * 1000000000ull;
+    while (monoNs() < std::min(at, endNs)) usleep(std::min<uint64_t>(100000, (std::min(at, endNs) - monoNs()) / 1000 + 1));
+    FleetTotals now = totals(workers);
+    uint64_t received = server.dataReceived.load();
+    printf("%5ds  online %6d  data %6llu/s  acked %6llu/s  recv %6llu/s  resent %llu  q-drop %llu  lost %llu  "
+           "fail %llu\n", second, onlineCount.load(), (unsigned long long)(now.dataQueued - last.dataQueued),
+           (unsigned long long)(now.dataAcked - last.dataAcked), (unsigned long long)(received - lastReceived),
+           (unsigned long long)now.resent, (unsigned long long)now.queueDropped, (unsigned long long)now.lost,
+           (unsigned long long)(now.failed + now.refused));
+    fflush(stdout);
+    last = now;
+    lastReceived = received;
+  }
+
+  // Stop sampling, let every queue empty, then let the subscriber catch up
+  phase.store(PHASE_DRAIN);
+  uint64_t drainUntil = monoNs() + FLEET_DRAIN_S * 1000000000ull;
+  for (;;) {
+    bool drained = true;
+    for (FleetWorker* w : workers) drained &= w->drained();
+    if (drained || monoNs() > drainUntil) break;
+    usleep(100000);
+  }
+  usleep(FLEET_SETTLE_MS * 1000);
+  double elapsedS = (monoNs() - startNs) / 1e9;
+  phase.store(PHASE_CLOSE);
+  for (std::thread& t : threads) t.join();
+  usleep(FLEET_SETTLE_MS * 1000);
+  server.stop.store(true);
+  serverThread.join();
+
+  // ═══════════════════════════════════════════════════════════════════════════
+  // Report
+  // ═══════════════════════════════════════════════════════════════════════════
+  FleetTotals c = totals(workers);
+  Histogram connectUs;
+  for (FleetWorker* w : workers) connectUs.merge(w->connectUs);
+
+  uint64_t serverDrops = 0;
+  for (uint32_t i = 0; i < opt.devices; i++) {
+    if (shared[i].acked > shared[i].received) serverDrops += shared[i].acked - shared[i].received;
+  }
+  double runS = opt.durationS;
+
+  printf("\nconnections  %llu up, %llu lost, %llu storm-dropped, %llu refused, %llu failed\n",
+         (unsigned long long)c.connects, (unsigned long long)c.lost,
+         (unsigned long long)c.stormDrops, (unsigned long long)c.refused,
+         (unsigned long long)c.failed);
+  printLatency("connect", connectUs);
+  printf("device       data %llu queued (%.0f/s), %llu acked; alerts %llu queued, %llu acked; stream %llu\n",
+         (unsigned long long)c.dataQueued, c.dataQueued / runS, (unsigned long long)c.dataAcked,
+         (unsigned long long)c.alertsQueued, (unsigned long long)c.alertsAcked, (unsigned long long)c.streamSent);
+  printf("             QoS 1 %llu sent, %llu resent, %llu dropped on device; %llu pings; %.1f MB out, %.1f MB in\n",
+         (unsigned long long)c.sent, (unsigned long long)c.resent, (unsigned long long)c.queueDropped,
+         (unsigned long long)c.pings, c.bytesOut / 1e6, c.bytesIn / 1e6);
+  printf("server       data %llu (%.0f/s), %llu duplicate; alerts %llu (%llu gaps); stream %llu\n",
+         (unsigned long long)server.dataReceived.load(), server.dataReceived / runS,
+         (unsigned long long)server.duplicates.load(), (unsigned long long)server.alertsReceived.load(),
+         (unsigned long long)server.alertGaps.load(), (unsigned long long)server.streamReceived.load());
+  printf("             status online %llu, wills %llu (%llu connections lost), graceful offline %llu\n",
+         (unsigned long long)server.onlines.load(), (unsigned long long)server.wills.load(),
+         (unsigned long long)(c.stormDrops + c.lost), (unsigned long long)server.goodbyes.load());
+  printf("server drops %llu (PUBACKed by the broker, never delivered), %llu server reconnects\n",
+         (unsigned long long)serverDrops, (unsigned long long)server.reconnects.load());
+
+  printf("\nlatency (sample -> server)\n");
+  printLatency("data", server.dataUs);
+  if (opt.streamMs) printLatency("stream", server.streamUs);
+  if (opt.cmdRate > 0) {
+    uint64_t sent = server.commandsSent.load(), answered = server.commandsAnswered.load();
+    printf("commands     %llu sent, %llu answered, %llu unanswered (%llu after %d s)\n", (unsigned long long)sent,
+           (unsigned long long)answered, (unsigned long long)(sent - answered),
+           (unsigned long long)server.commandsLost.load(), FLEET_COMMAND_TIMEOUT_S);
+    printLatency("get_status", server.commandUs);
+  }
+
+  for (int s = 0; s < opt.stormCount; s++) {
+    Histogram back;
+    uint32_t victims = 0;
+    for (FleetWorker* w : workers) {
+      back.merge(w->stormUs[s]);
+      victims += w->stormVictims[s];
+    }
+    printf("storm %d      at %.0f s: %u dropped, %llu back (%u still out)\n", s + 1, opt.storms[s].atS, victims,
+           (unsigned long long)back.count(), victims - (uint32_t)back.count());
+    printLatency("back", back);
+  }
+  printf("\nrun %.1f s including drain\n", elapsedS);
+
+  for (FleetWorker* w : workers) delete w;
+  delete[] shared;
+  return 0;
+}
@@ -0,0 +1,470 @@
+/**
+ * ═══════════════════════════════════════════════════════════════════════════════
+ * 🧮 xBio rule compiler (host)
+ * Compiles alert rule expressions to RuleVM bytecode, checks them with the
+ * device loader, and benchmarks evaluation through the same interpreter.
+ *
+ *   g++ -std=c++17 -O2 -I../src xbio_rulec.cpp -o xbio_rulec
+ *
+ *   ./xbio_rulec compile <name> "<rule>" [slot]    # prints the rule_set command
+ *   ./xbio_rulec disasm <hex>
+ *   ./xbio_rulec eval "<rule>" [var=value ...]    # e.g. iaq=180 "rate(pressure)=-4"
+ *   ./xbio_rulec bench "<rule>" [iterations]
+ *
+ * Rule syntax:
+ *   rule    := expr [for <duration>] [clear <duration>]    duration: 30s, 5m, 1h
+ *   expr    := and ("||" and)*
+ *   and     := cmp ("&&" cmp)*
+ *   cmp     := sum [(">" | ">=" | "<" | "<=" | "==" | "!=") sum]
+ *   sum     := term (("+" | "-") term)*
+ *   term    := unary (("*" | "/") unary)*
+ *   unary   := ("-" | "!") unary | primary
+ *   primary := number | var | source "(" var ")" | abs(expr) | min(expr, expr)
+ *            | max(expr, expr) | "(" expr ")"
+ *   var     := temperature | humidity | pressure | gas | iaq | co2 | voc
+ *   source  := win_min | win_avg | win_max | rate        (rate is per hour)
+ *
+ *   ./xbio_rulec compile humid_iaq "iaq > 150 && humidity > 60 for 5m" 0
+ *   ./xbio_rulec compile storm "rate(pressure) < -3 for 10m clear 30m" 1
+ * ═══════════════════════════════════════════════════════════════════════════════
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rule_vm.h"
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Compiler
+// ═══════════════════════════════════════════════════════════════════════════════
+
+class RuleCompiler {
+public:
+  explicit RuleCompiler(const std::string& source) : _src(source), _pos(0) {}
+
+  // Throws std::runtime_error with the position on bad input
+  RuleProgram compile(const std::string& name) {
+    RuleProgram program;
+    memset(&program, 0, sizeof(program));
+    if (name.empty() || name.size() > RULE_NAME_MAX) fail("name must be 1.." + std::to_string(RULE_NAME_MAX) + " chars");
+    memcpy(program.name, name.data(), name.size());
+
+    expr();
+    while (peekWord() == "for" || peekWord() == "clear") {
+      std::string word = ident();
+      uint32_t seconds = duration();
+      (word == "for" ? program.holdSeconds : program.clearSeconds) = (uint16_t)seconds;
+    }
+    space();
+    if (_pos != _src.size()) fail("unexpected input");
+
+    if (_code.size() > RULE_MAX_CODE) fail("rule too long (" + std::to_string(_code.size()) + " bytes, max " +
+                                          std::to_string(RULE_MAX_CODE) + ")");
+    program.codeLength = (uint8_t)_code.size();
+    memcpy(program.code, _code.data(), _code.size());
+    return program;
+  }
+
+private:
+  std::string _src;
+  size_t _pos;
+  std::vector<uint8_t> _code;
+
+  [[noreturn]] void fail(const std::string& message) {
+    throw std::runtime_error(message + " at column " + std::to_string(_pos + 1));
+  }
+
+  void space() {
+    while (_pos < _src.size() && isspace((unsigned char)_src[_pos])) _pos++;
+  }
+
+  bool accept(const char* token) {
+    space();
+    size_t n = strlen(token);
+    if (_src.compare(_pos, n, token) != 0) return false;
+    // "<" must not eat the start of "<="
+    if (n == 1 && (token[0] == '<' || token[0] == '>' || token[0] == '!') &&
+        _pos + 1 < _src.size() && _src[_pos + 1] == '=') {
+      return false;
+    }
+    _pos += n;
+    return true;
+  }
+
+  void expect(const char* token) {
+    if (!accept(token)) fail(std::string("expected '") + token + "'");
+  }
+
+  std::string peekWord() {
+    space();
+    size_t end = _pos;
+    while (end < _src.size() && (isalnum((unsigned char)_src[end]) || _src[end] == '_')) end++;
+    return _src.substr(_pos, end - _pos);
+  }
+
+  std::string ident() {
+    std::string word = peekWord();
+    _pos += word.size();
+    return word;
+  }
+
+  uint32_t duration() {
+    space();
+    char* end;
+    double value = strtod(_src.c_str() + _pos, &end);
+    if (end == _src.c_str() + _pos || value < 0) fail("expected a duration");
+    _pos = end - _src.c_str();
+    double scale = 1;
+    if (_pos < _src.size() && strchr("smh", _src[_pos])) {
+      scale = _src[_pos] == 'm' ? 60 : _src[_pos] == 'h' ? 3600 : 1;
+      _pos++;
+    }
+    double seconds = value * scale;
+    if (seconds > 65535) fail("duration over 65535 s");
+    return (uint32_t)lround(seconds);
+  }
+
+  void op(RuleOp o) { _code.push_back((uint8_t)o); }
+
+  void constant(float value) {
+    op(RuleOp::CONST);
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; i++) _code.push_back((uint8_t)(bits >> (i * 8)));
+  }
+
+  void load(RuleSource source, RuleVar var) {
+    op(RuleOp::LOAD);
+    _code.push_back(RULE_SLOT(source, var));
+  }
+
+  RuleVar variable(const std::string& word) {
+    for (uint8_t v = 0; v < (uint8_t)RuleVar::COUNT; v++) {
+      if (word == RuleVM::varName((RuleVar)v)) return (RuleVar)v;
+    }
+    fail("unknown variable '" + word + "'");
+  }
+
+  void expr() {
+    andExpr();
+    while (accept("||")) {
+      andExpr();
+      op(RuleOp::OR);
+    }
+  }
+
+  void andExpr() {
+    cmp();
+    while (accept("&&")) {
+      cmp();
+      op(RuleOp::AND);
+    }
+  }
+
+  void cmp() {
+    sum();
+    static const struct { const char* token; RuleOp op; } ops[] = {
+      {">=", RuleOp::GE}, {"<=", RuleOp::LE}, {"==", RuleOp::EQ}, {"!=", RuleOp::NE},
+      {">", RuleOp::GT}, {"<", RuleOp::LT},
+    };
+    for (const auto& c : ops) {
+      if (accept(c.token)) {
+        sum();
+        op(c.op);
+        return;
+      }
+    }
+  }
+
+  void sum() {
+    term();
+    for (;;) {
+      if (accept("+")) {
+        term();
+        op(RuleOp::ADD);
+      } else if (accept("-")) {
+        term();
+        op(RuleOp::SUB);
+      } else {
+        return;
+      }
+    }
+  }
+
+  void term() {
+    unary();
+    for (;;) {
+      if (accept("*")) {
+        unary();
+        op(RuleOp::MUL);
+      } else if (accept("/")) {
+        unary();
+        op(RuleOp::DIV);
+      } else {
+        return;
+      }
+    }
+  }
+
+  void unary() {
+    if (accept("-")) {
+      // Fold -<number> into one constant
+      space();
+      if (_pos < _src.size() && (isdigit((unsigned char)_src[_pos]) || _src[_pos] == '.')) {
+        constant(-number());
+        return;
+      }
+      unary();
+      op(RuleOp::NEG);
+    } else if (accept("!")) {
+      unary();
+      op(RuleOp::NOT);
+    } else {
+      primary();
+    }
+  }
+
+  float number() {
+    char* end;
+    float value = strtof(_src.c_str() + _pos, &end);
+    if (end == _src.c_str() + _pos) fail("expected a number");
+    _pos = end - _src.c_str();
+    return value;
+  }
+
+  void primary() {
+    space();
+    if (_pos >= _src.size()) fail("unexpected end of rule");
+
+    if (accept("(")) {
+      expr();
+      expect(")");
+      return;
+    }
+    if (isdigit((unsigned char)_src[_pos]) || _src[_pos] == '.') {
+      constant(number());
+      return;
+    }
+
+    std::string word = ident();
+    if (word.empty()) fail("expected a value");
+
+    static const struct { const char* name; RuleSource source; } sources[] = {
+      {"win_min", RuleSource::WIN_MIN}, {"win_avg", RuleSource::WIN_AVG},
+      {"win_max", RuleSource::WIN_MAX}, {"rate", RuleSource::RATE},
+    };
+    for (const auto& s : sources) {
+      if (word == s.name) {
+        expect("(");
+        RuleVar var = variable(ident());
+        expect(")");
+        load(s.source, var);
+        return;
+      }
+    }
+    if (word == "abs") {
+      expect("(");
+      expr();
+      expect(")");
+      op(RuleOp::ABS);
+      return;
+    }
+    if (word == "min" || word == "max") {
+      expect("(");
+      expr();
+      expect(",");
+      expr();
+      expect(")");
+      op(word == "min" ? RuleOp::MIN : RuleOp::MAX);
+      return;
+    }
+    load(RuleSource::VALUE, variable(word));
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+static std::string toHex(const uint8_t* data, size_t length) {
+  static const char digits[] = "0123456789abcdef";
+  std::string out;
+  for (size_t i = 0; i < length; i++) {
+    out += digits[data[i] >> 4];
+    out += digits[data[i] & 15];
+  }
+  return out;
+}
+
+static bool fromHex(const char* text, std::vector<uint8_t>& out) {
+  size_t n = strlen(text);
+  if (n % 2) return false;
+  for (size_t i = 0; i < n; i += 2) {
+    char pair[3] = {text[i], text[i + 1], 0};
+    char* end;
+    long v = strtol(pair, &end, 16);
+    if (*end) return false;
+    out.push_back((uint8_t)v);
+  }
+  return true;
+}
+
+static std::string slotName(uint8_t slot) {
+  RuleSource source = (RuleSource)(slot >> 3);
+  std::string var = RuleVM::varName((RuleVar)(slot & 7));
+  return source == RuleSource::VALUE ? var : std::string(RuleVM::sourceName(source)) + "(" + var + ")";
+}
+
+static void disassemble(const RuleProgram& program) {
+  printf("rule \"%s\"  hold %us  clear %us  %u bytes  %u ops  stack %u\n", program.name, program.holdSeconds,
+         program.clearSeconds, program.codeLength, program.ops, program.stackDepth);
+  size_t pc = 0;
+  while (pc < program.codeLength) {
+    RuleOp op = (RuleOp)program.code[pc];
+    printf("  %02zu  %-5s", pc, RuleVM::opName(op));
+    pc++;
+    if (op == RuleOp::CONST) {
+      float value;
+      uint32_t bits = program.code[pc] | (program.code[pc + 1] << 8) | (program.code[pc + 2] << 16) |
+                      ((uint32_t)program.code[pc + 3] << 24);
+      memcpy(&value, &bits, sizeof(value));
+      printf(" %g", value);
+      pc += 4;
+    } else if (op == RuleOp::LOAD) {
+      printf(" %s", slotName(program.code[pc]).c_str());
+      pc++;
+    }
+    printf("\n");
+  }
+}
+
+// Round trip through the device loader so only loadable rules leave the tool
+static bool build(const std::string& name, const std::string& source, RuleProgram& program,
+                  std::vector<uint8_t>& blob) {
+  try {
+    program = RuleCompiler(source).compile(name);
+  } catch (const std::exception& e) {
+    fprintf(stderr, "Compile error: %s\n", e.what());
+    return false;
+  }
+  blob.resize(RULE_BLOB_MAX);
+  blob.resize(RuleVM::store(program, blob.data(), blob.size()));
+  const char* error = blob.empty() ? "does not fit" : RuleVM::load(blob.data(), blob.size(), &program);
+  if (error) {
+    fprintf(stderr, "Rejected by device loader: %s\n", error);
+    return false;
+  }
+  return true;
+}
+
+static bool parseAssignment(const char* text, RuleContext& context) {
+  const char* eq = strchr(text, '=');
+  if (!eq) return false;
+  std::string lhs(text, eq - text);
+  float value = strtof(eq + 1, nullptr);
+
+  for (uint8_t s = 0; s < (uint8_t)RuleSource::COUNT; s++) {
+    for (uint8_t v = 0; v < (uint8_t)RuleVar::COUNT; v++) {
+      uint8_t slot = RULE_SLOT(s, v);
+      if (lhs == slotName(slot)) {
+        context.slots[slot] = value;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// CLI
+// ═══════════════════════════════════════════════════════════════════════════════
+
+int main(int argc, char** argv) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  RuleProgram program;
+  std::vector<uint8_t> blob;
+
+  if (mode == "compile" && (argc == 4 || argc == 5)) {
+    if (!build(argv[2], argv[3], program, blob)) return 1;
+    int slot = argc == 5 ? atoi(argv[4]) : 0;
+    disassemble(program);
+    printf("\n{\"command\":\"rule_set\",\"slot\":%d,\"rule\":\"%s\"}\n", slot, toHex(blob.data(), blob.size()).c_str());
+    return 0;
+  }
+
+  if (mode == "disasm" && argc == 3) {
+    if (!fromHex(argv[2], blob)) {
+      fprintf(stderr, "Bad hex\n");
+      return 1;
+    }
+    const char* error = RuleVM::load(blob.data(), blob.size(), &program);
+    if (error) {
+      fprintf(stderr, "Rejected: %s\n", error);
+      return 1;
+    }
+    disassemble(program);
+    return 0;
+  }
+
+  if (mode == "eval" && argc >= 3) {
+    if (!build("eval", argv[2], program, blob)) return 1;
+    RuleContext context;
+    context.clear();
+    for (int i = 3; i < argc; i++) {
+      if (!parseAssignment(argv[i], context)) {
+        fprintf(stderr, "Bad assignment: %s\n", argv[i]);
+        return 2;
+      }
+    }
+    RuleResult result = RuleVM::run(program, context);
+    printf("%s  (value %g, threshold %g)\n", result.fired ? "FIRED" : "quiet", result.value, result.threshold);
+    return result.fired ? 0 : 3;
+  }
+
+  if (mode == "bench" && (argc == 3 || argc == 4)) {
+    if (!build("bench", argv[2], program, blob)) return 1;
+    long iterations = argc == 4 ? atol(argv[3]) : 10000000;
+
+    // A pool of realistic contexts so branches are not perfectly predicted
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<RuleContext> contexts(256);
+    for (auto& c : contexts) {
+      c.clear();
+      for (uint8_t s = 0; s < (uint8_t)RuleSource::COUNT; s++) {
+        c.set((RuleSource)s, RuleVar::TEMPERATURE, 24 + 8 * noise(rng));
+        c.set((RuleSource)s, RuleVar::HUMIDITY, 55 + 20 * noise(rng));
+        c.set((RuleSource)s, RuleVar::PRESSURE, 1013 + 10 * noise(rng));
+        c.set((RuleSource)s, RuleVar::IAQ, 120 + 80 * noise(rng));
+      }
+      c.set(RuleSource::RATE, RuleVar::PRESSURE, 4 * noise(rng));
+      c.set(RuleSource::VALUE, RuleVar::GAS, 50000 + 20000 * noise(rng));
+      c.set(RuleSource::VALUE, RuleVar::CO2, 600 + 200 * noise(rng));
+      c.set(RuleSource::VALUE, RuleVar::VOC, 1 + noise(rng));
+    }
+
+    disassemble(program);
+    volatile uint32_t fired = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+      fired = fired + RuleVM::run(program, contexts[i & 255]).fired;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("\n%ld evaluations  %.1f ns/rule  %.2f ns/op  fired %.1f%%\n", iterations, ns / iterations,
+           ns / iterations / program.ops, 100.0 * fired / iterations);
+    return 0;
+  }
+
+  fprintf(stderr,
+          "Usage: %s compile <name> \"<rule>\" [slot] | disasm <hex> | eval \"<rule>\" [var=value ...] | "
+          "bench \"<rule>\" [iterations]\n",
+          argv[0]);
+  return 2;
+}
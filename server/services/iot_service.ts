@@ -228,9 +228,10 @@ export class IoTService extends EventEmitter {
         console.log('   MQTT: Connected');
         
         // الاشتراك في مواضيع xBio
-        this.mqttClient!.subscribe('xbio/+/data');
+        this.mqttClient!.subscribe('xbio/+/data', { qos: 1 });
         this.mqttClient!.subscribe('xbio/+/status');
         this.mqttClient!.subscribe('xbio/+/alerts');
+        this.mqttClient!.subscribe('xbio/+/ws');
         
         resolve();
       });
@@ -274,6 +275,10 @@ export class IoTService extends EventEmitter {
         case 'alerts':
           this.handleDeviceAlert(deviceId, payload);
           break;
+        case 'ws':
+          // إطارات البث المباشر المنقولة عبر MQTT بدل اتصال WebSocket ثانٍ
+          this.broadcastToClients({ ...payload, deviceId });
+          break;
       }
     } catch (error) {
       console.error('Failed to process MQTT message:', error);
@@ -320,7 +325,10 @@ export class IoTService extends EventEmitter {
 
   // معالجة حالة الجهاز
   private async handleDeviceStatus(deviceId: string, payload: any): Promise<void> {
-    const status = payload.status === 'online' ? 'online' : 'offline';
+    // أثناء تحديث OTA يبقى الجهاز متصلاً ويرسل التقدم، فلا يُعتبر غير متصل
+    const status = payload.status === 'online' ? 'online'
+      : payload.status === 'updating' ? 'maintenance'
+      : 'offline';
     
     let device = this.devices.get(deviceId);
     
@@ -356,6 +364,26 @@ export class IoTService extends EventEmitter {
 
   // معالجة تنبيه الجهاز
   private async handleDeviceAlert(deviceId: string, payload: any): Promise<void> {
+    // الجهاز يرسل أيضاً أحداث الزوال والإقرار لنفس التنبيه - ليست تنبيهات جديدة
+    if (payload.event === 'cleared' || payload.event === 'acknowledged') {
+      if (payload.event === 'acknowledged' && supabase) {
+        await supabase
+          .from('device_alerts')
+          .update({ acknowledged: true, acknowledged_at: new Date() })
+          .eq('device_id', deviceId)
+          .eq('type', payload.type)
+          .eq('acknowledged', false);
+      }
+      this.broadcastToClients({
+        type: 'device_alert_update',
+        deviceId,
+        alertType: payload.type,
+        event: payload.event,
+        value: payload.value,
+      });
+      return;
+    }
+
     const alert: DeviceAlert = {
       id: `alert_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`,
       deviceId,
@@ -709,6 +737,8 @@ export class IoTService extends EventEmitter {
   // ═══════════════════════════════════════════════════════════════════════════
 
   private determineSeverity(type: string, value: number): 'info' | 'warning' | 'critical' {
+    // قيمة تنبيهات ANOMALY_* هي درجة الانحراف (z) وليست قراءة الحساس
+    if (type.startsWith('ANOMALY_')) return value > 20 ? 'warning' : 'info';
     if (type === 'POOR_AIR_QUALITY' && value > 300) return 'critical';
     if (type.includes('TEMPERATURE') && (value > 40 || value < 5)) return 'critical';
     if (type.includes('HUMIDITY') && (value > 90 || value < 10)) return 'critical';
@@ -722,6 +752,11 @@ export class IoTService extends EventEmitter {
       HIGH_HUMIDITY: `الرطوبة مرتفعة: ${value.toFixed(1)}%`,
       LOW_HUMIDITY: `الرطوبة منخفضة: ${value.toFixed(1)}%`,
       POOR_AIR_QUALITY: `جودة الهواء سيئة: IAQ ${value}`,
+      ANOMALY_TEMPERATURE: `سلوك غير معتاد لدرجة الحرارة (z = ${value.toFixed(1)})`,
+      ANOMALY_HUMIDITY: `سلوك غير معتاد للرطوبة (z = ${value.toFixed(1)})`,
+      ANOMALY_PRESSURE: `سلوك غير معتاد للضغط الجوي (z = ${value.toFixed(1)})`,
+      ANOMALY_IAQ: `سلوك غير معتاد لجودة الهواء (z = ${value.toFixed(1)})`,
+      ANOMALY_GAS: `سلوك غير معتاد لمقاومة الغاز (z = ${value.toFixed(1)})`,
     };
     return messages[type] || `تنبيه: ${type} = ${value}`;
   }